@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define SOA_BENCH_HAS_PERF_EVENTS
+#endif
+
+namespace soa::bench {
+
+// Keeps the compiler from optimizing away a value that is only computed for the benchmark.
+template <typename T> inline void do_not_optimize(const T &p_value) { asm volatile("" : : "r,m"(p_value) : "memory"); }
+
+struct Options {
+	uint32_t warmup = 2;
+	uint32_t repetitions = 10;
+	uint64_t min_rows = 1000;
+	uint64_t max_rows = 100000000;
+	// Only benchmarks whose name contains this run.
+	std::string filter;
+	std::string json_path;
+	bool counters = true;
+
+	// --warmup=N --repetitions=N --min-rows=N --max-rows=N --filter=name --json=path --no-counters, throws std::invalid_argument for anything else.
+	static Options parse(int p_argc, char **p_argv) {
+		Options options;
+		for (int i = 1; i < p_argc; ++i) {
+			const std::string_view argument = p_argv[i];
+			const size_t equals = argument.find('=');
+			const std::string_view key = argument.substr(0, equals);
+			const std::string_view value = equals == std::string_view::npos ? std::string_view() : argument.substr(equals + 1);
+			auto number = [&]() {
+				uint64_t result = 0;
+				const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+				if (error != std::errc() or end != value.data() + value.size()) {
+					throw std::invalid_argument("soa_bench: " + std::string(key) + " needs a number");
+				}
+				return result;
+			};
+			if (key == "--warmup") {
+				options.warmup = uint32_t(number());
+			} else if (key == "--repetitions") {
+				options.repetitions = std::max<uint32_t>(uint32_t(number()), 1);
+			} else if (key == "--min-rows") {
+				options.min_rows = number();
+			} else if (key == "--max-rows") {
+				options.max_rows = number();
+			} else if (key == "--filter") {
+				options.filter = value;
+			} else if (key == "--json") {
+				options.json_path = value;
+			} else if (key == "--no-counters") {
+				options.counters = false;
+			} else {
+				throw std::invalid_argument("soa_bench: unknown argument " + std::string(argument));
+			}
+		}
+		return options;
+	}
+
+	// 1k, 10k, ... up to 100M rows, limited to [min_rows, max_rows].
+	[[nodiscard]] std::vector<uint64_t> sizes() const {
+		std::vector<uint64_t> result;
+		for (uint64_t rows = 1000; rows <= 100000000; rows *= 10) {
+			if (rows >= min_rows and rows <= max_rows) {
+				result.push_back(rows);
+			}
+		}
+		return result;
+	}
+};
+
+// Cycles, cache misses and dTLB load misses of the calling thread from perf_event_open, read as one group so they cover exactly the same code. available() is false when
+// the kernel doesn't allow it (perf_event_paranoid, containers) or the system isn't Linux.
+class Counters {
+public:
+	static constexpr size_t count = 3;
+	static constexpr std::array<const char *, count> names = { "cycles", "cache_misses", "dtlb_misses" };
+
+private:
+	std::array<int, count> fds{ -1, -1, -1 };
+
+#ifdef SOA_BENCH_HAS_PERF_EVENTS
+	static int open_counter(uint32_t p_type, uint64_t p_config, int p_group) {
+		perf_event_attr attributes{};
+		attributes.size = sizeof(attributes);
+		attributes.type = p_type;
+		attributes.config = p_config;
+		attributes.disabled = p_group == -1 ? 1 : 0;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP;
+		return int(syscall(SYS_perf_event_open, &attributes, 0, -1, p_group, 0));
+	}
+#endif
+
+public:
+	explicit Counters(bool p_enabled) {
+#ifdef SOA_BENCH_HAS_PERF_EVENTS
+		if (!p_enabled) {
+			return;
+		}
+		fds[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+		if (fds[0] < 0) {
+			return;
+		}
+		fds[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+		fds[2] = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), fds[0]);
+		if (fds[1] < 0 or fds[2] < 0) {
+			close_all();
+		}
+#else
+		(void)p_enabled;
+#endif
+	}
+	Counters(const Counters &) = delete;
+	Counters &operator=(const Counters &) = delete;
+	~Counters() { close_all(); }
+
+	void close_all() {
+#ifdef SOA_BENCH_HAS_PERF_EVENTS
+		for (int &fd : fds) {
+			if (fd >= 0) {
+				close(fd);
+			}
+			fd = -1;
+		}
+#endif
+	}
+
+	[[nodiscard]] bool available() const { return fds[0] >= 0; }
+
+	void start() {
+#ifdef SOA_BENCH_HAS_PERF_EVENTS
+		if (available()) {
+			ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+#endif
+	}
+
+	[[nodiscard]] std::array<uint64_t, count> stop() {
+		std::array<uint64_t, count> values{};
+#ifdef SOA_BENCH_HAS_PERF_EVENTS
+		if (available()) {
+			ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+			// The group read gives the number of counters followed by each value.
+			std::array<uint64_t, count + 1> group{};
+			if (read(fds[0], group.data(), sizeof(group)) == ssize_t(sizeof(group))) {
+				std::copy(group.begin() + 1, group.end(), values.begin());
+			}
+		}
+#endif
+		return values;
+	}
+};
+
+struct Result {
+	std::string name;
+	uint64_t rows = 0;
+	// Nanoseconds of every repetition, sorted.
+	std::vector<double> times;
+	// Median of each counter over the repetitions, only set if the counters were available.
+	std::array<uint64_t, Counters::count> counters{};
+	bool has_counters = false;
+
+	// Linear interpolation between the closest ranks, p_percentile is 0-100.
+	[[nodiscard]] double percentile(double p_percentile) const {
+		const double rank = p_percentile / 100.0 * double(times.size() - 1);
+		const size_t below = size_t(rank);
+		const size_t above = std::min(below + 1, times.size() - 1);
+		return times[below] + (times[above] - times[below]) * (rank - double(below));
+	}
+	[[nodiscard]] double median() const { return percentile(50); }
+	[[nodiscard]] double mean() const {
+		double sum = 0;
+		for (const double time : times) {
+			sum += time;
+		}
+		return sum / double(times.size());
+	}
+	[[nodiscard]] double stddev() const {
+		const double average = mean();
+		double sum = 0;
+		for (const double time : times) {
+			sum += (time - average) * (time - average);
+		}
+		return times.size() > 1 ? std::sqrt(sum / double(times.size() - 1)) : 0;
+	}
+};
+
+// Runs every benchmark warmup + repetitions times and keeps the statistics of the timed repetitions. setup() runs before every repetition and isn't timed, its result is
+// passed to body() so benchmarks that change the table (push, erase) start from the same state every time.
+class Runner {
+	Options options;
+	Counters counters;
+	std::vector<Result> results;
+
+	static double to_ms(double p_nanoseconds) { return p_nanoseconds / 1e6; }
+
+	void print(const Result &p_result) const {
+		std::printf("%-28s %11llu %11.3f %11.3f %11.3f %9.2f", p_result.name.c_str(), static_cast<unsigned long long>(p_result.rows), to_ms(p_result.median()),
+				to_ms(p_result.percentile(10)), to_ms(p_result.percentile(90)), p_result.median() / double(p_result.rows));
+		if (p_result.has_counters) {
+			for (const uint64_t value : p_result.counters) {
+				std::printf(" %11.3f", double(value) / double(p_result.rows));
+			}
+		}
+		std::printf("\n");
+		std::fflush(stdout);
+	}
+
+public:
+	explicit Runner(const Options &p_options) :
+			options(p_options), counters(p_options.counters) {
+		std::printf("%-28s %11s %11s %11s %11s %9s", "benchmark", "rows", "median ms", "p10 ms", "p90 ms", "ns/row");
+		if (counters.available()) {
+			for (const char *name : Counters::names) {
+				std::printf(" %11s", (std::string(name) + "/row").c_str());
+			}
+		} else if (options.counters) {
+			std::printf("  (perf_event_open isn't available, no counters)");
+		}
+		std::printf("\n");
+	}
+
+	[[nodiscard]] const Options &get_options() const { return options; }
+
+	// False if --filter skips the benchmark, check it before building tables that are shared by every repetition.
+	[[nodiscard]] bool selected(const std::string &p_name) const { return options.filter.empty() or p_name.find(options.filter) != std::string::npos; }
+
+	template <typename Setup, typename Body> void run(const std::string &p_name, uint64_t p_rows, Setup &&p_setup, Body &&p_body) {
+		if (!selected(p_name)) {
+			return;
+		}
+		Result result{ p_name, p_rows, {}, {}, counters.available() };
+		std::array<std::vector<uint64_t>, Counters::count> counter_values;
+		for (uint32_t i = 0; i < options.warmup + options.repetitions; ++i) {
+			auto state = p_setup();
+			counters.start();
+			const auto start = std::chrono::steady_clock::now();
+			p_body(state);
+			const auto end = std::chrono::steady_clock::now();
+			const std::array<uint64_t, Counters::count> values = counters.stop();
+			if (i < options.warmup) {
+				continue;
+			}
+			result.times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+			for (size_t c = 0; c < Counters::count; ++c) {
+				counter_values[c].push_back(values[c]);
+			}
+		}
+		std::sort(result.times.begin(), result.times.end());
+		for (size_t c = 0; c < Counters::count; ++c) {
+			std::sort(counter_values[c].begin(), counter_values[c].end());
+			result.counters[c] = counter_values[c][counter_values[c].size() / 2];
+		}
+		print(result);
+		results.push_back(std::move(result));
+	}
+
+	// One object per result with every statistic in nanoseconds, so two runs can be diffed with any JSON tool.
+	void write_json(const std::string &p_path, const std::string &p_compiler) const {
+		std::ofstream file(p_path);
+		if (!file) {
+			throw std::runtime_error("soa_bench: can't open " + p_path);
+		}
+		file << std::fixed << std::setprecision(1);
+		file << "{\n  \"compiler\": \"" << p_compiler << "\",\n  \"warmup\": " << options.warmup << ",\n  \"repetitions\": " << options.repetitions << ",\n  \"results\": [";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result &result = results[i];
+			file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"rows\": " << result.rows << ", \"median_ns\": " << result.median()
+				 << ", \"p10_ns\": " << result.percentile(10) << ", \"p90_ns\": " << result.percentile(90) << ", \"min_ns\": " << result.times.front()
+				 << ", \"max_ns\": " << result.times.back() << ", \"mean_ns\": " << result.mean() << ", \"stddev_ns\": " << result.stddev();
+			if (result.has_counters) {
+				for (size_t c = 0; c < Counters::count; ++c) {
+					file << ", \"" << Counters::names[c] << "\": " << result.counters[c];
+				}
+			}
+			file << "}";
+		}
+		file << "\n  ]\n}\n";
+	}
+};
+
+} // namespace soa::bench
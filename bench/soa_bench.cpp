@@ -0,0 +1,1250 @@
+// Benchmark suite for the SOA structs, built as the soa_bench target. Every benchmark runs for 1k, 10k, ... 100M rows with warmup runs and repetitions, and prints the
+// median, 10th and 90th percentile and the cycles, cache misses and dTLB misses per row when perf_event_open is allowed.
+//   soa_bench --max-rows=10000000 --repetitions=20 --filter=scan --json=results.json
+// See SoaBench.hpp for every option.
+
+#include "../src/soa.hpp"
+#include "SoaBench.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <version>
+
+struct BenchVector2 {
+	float x;
+	float y;
+};
+
+struct BenchVector3 {
+	float x;
+	float y;
+	float z;
+};
+
+struct BenchDynamicStruct {
+	DynamicSOA(
+		BenchDynamicStruct, 4,
+		int, a,
+		BenchVector2, b,
+		float, c,
+		double, d
+	)
+};
+
+struct BenchMutableStruct {
+	MutableSOA(
+		BenchMutableStruct, 4,
+		int, a,
+		BenchVector2, b,
+		float, c,
+		double, d
+	)
+};
+
+struct BenchTombstoneStruct {
+	using soa_erase_policy = soa::TombstoneErase<>;
+	MutableSOA(
+		BenchTombstoneStruct, 4,
+		int, a,
+		BenchVector2, b,
+		float, c,
+		double, d
+	)
+};
+
+struct BenchTiledStruct {
+	TiledSOA(
+		BenchTiledStruct, 4, 16,
+		int, a,
+		BenchVector2, b,
+		float, c,
+		double, d
+	)
+};
+
+struct BenchDirtyStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	DynamicSOA(
+		BenchDirtyStruct, 4,
+		int, a,
+		BenchVector2, b,
+		float, c,
+		double, d
+	)
+};
+
+// Reserves more rows than the largest size soa_bench runs.
+struct BenchReservedStruct {
+	using soa_allocator_policy = soa::VirtualReserveAllocator<1 << 27>;
+	DynamicSOA(
+		BenchReservedStruct, 4,
+		int, a,
+		BenchVector2, b,
+		float, c,
+		double, d
+	)
+};
+
+#ifdef SOA_HAS_MMAP
+struct BenchMappedStruct {
+	MappedSOA(
+		BenchMappedStruct, 4,
+		int, a,
+		BenchVector2, b,
+		float, c,
+		double, d
+	)
+};
+#endif
+
+struct BenchParticleStruct {
+	DynamicSOA(
+		BenchParticleStruct, 2,
+		BenchVector3, position,
+		BenchVector3, velocity
+	)
+};
+
+struct BenchSimdStruct {
+	DynamicSOA(
+		BenchSimdStruct, 2,
+		float, x,
+		int, id
+	)
+};
+
+struct BenchRecordStruct {
+	DynamicSOA(
+		BenchRecordStruct, 3,
+		int, id,
+		float, value,
+		std::string, name
+	)
+};
+
+struct BenchStringStruct {
+	DynamicSOA(
+		BenchStringStruct, 1,
+		std::string, name
+	)
+};
+
+struct BenchArenaStringStruct {
+	DynamicSOA(
+		BenchArenaStringStruct, 1,
+		soa::ArenaString, name
+	)
+};
+
+struct BenchPackedStruct {
+	DynamicSOA(
+		BenchPackedStruct, 2,
+		bool, flag,
+		soa::PackedBool, packed_flag
+	)
+};
+
+struct BenchFrame {};
+
+struct BenchSmallMallocStruct {
+	DynamicSOA(
+		BenchSmallMallocStruct, 3,
+		int, a,
+		float, b,
+		BenchVector2, c
+	)
+};
+
+struct BenchSmallPoolStruct {
+	using soa_allocator_policy = soa::PoolAllocator<>;
+	DynamicSOA(
+		BenchSmallPoolStruct, 3,
+		int, a,
+		float, b,
+		BenchVector2, c
+	)
+};
+
+struct BenchSmallArenaStruct {
+	using soa_allocator_policy = soa::ArenaAllocator<BenchFrame>;
+	DynamicSOA(
+		BenchSmallArenaStruct, 3,
+		int, a,
+		float, b,
+		BenchVector2, c
+	)
+};
+
+struct BenchLargeMallocStruct {
+	DynamicSOA(
+		BenchLargeMallocStruct, 1,
+		uint64_t, value
+	)
+};
+
+struct BenchLargeHugePageStruct {
+	using soa_allocator_policy = soa::HugePageAllocator<>;
+	DynamicSOA(
+		BenchLargeHugePageStruct, 1,
+		uint64_t, value
+	)
+};
+
+// Also the row type of the soa::Table benchmarks.
+struct BenchAosRow {
+	int a;
+	BenchVector2 b;
+	float c;
+	double d;
+};
+
+namespace {
+
+// Pushes the same rows into any of the structs with the a, b, c, d members, returns the ids for a MutableSOA.
+template <typename S> auto fill(S &r_soa_struct, uint64_t p_rows) {
+	r_soa_struct.reserve(SoaVectorSizeType(p_rows));
+	if constexpr (std::is_void_v<decltype(r_soa_struct.push_row(0, BenchVector2{}, 0.0f, 0.0))>) {
+		for (uint64_t i = 0; i < p_rows; ++i) {
+			r_soa_struct.push_row(int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+		}
+	} else {
+		std::vector<SoaVectorSizeType> ids(p_rows);
+		for (uint64_t i = 0; i < p_rows; ++i) {
+			ids[i] = r_soa_struct.push_row(int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+		}
+		return ids;
+	}
+}
+
+// Setup of the benchmarks that change the table, every repetition gets a new one.
+template <typename S> auto filled_struct(uint64_t p_rows) {
+	return [p_rows]() {
+		auto soa_struct = std::make_unique<S>();
+		fill(*soa_struct, p_rows);
+		return soa_struct;
+	};
+}
+
+// p_count random rows of a table with p_rows rows.
+std::vector<SoaVectorSizeType> random_rows(uint64_t p_rows, uint64_t p_count, uint32_t p_seed) {
+	std::vector<SoaVectorSizeType> rows(p_count);
+	std::mt19937 rng(p_seed);
+	for (SoaVectorSizeType &row : rows) {
+		row = SoaVectorSizeType(rng() % p_rows);
+	}
+	return rows;
+}
+
+// False if --filter skips every one of p_names, check it before building tables that several benchmarks share.
+bool any_selected(const soa::bench::Runner &p_runner, std::initializer_list<std::string> p_names) {
+	return std::ranges::any_of(p_names, [&](const std::string &p_name) { return p_runner.selected(p_name); });
+}
+
+// Runs p_func on p_threads threads, each one gets its thread index.
+template <typename Func> void run_threads(int p_threads, Func &&p_func) {
+	std::vector<std::thread> threads;
+	for (int t = 0; t < p_threads; ++t) {
+		threads.emplace_back([&, t]() { p_func(t); });
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+// Sequential inserts, random lookups and erasing every other key of the index maps MutableSOA can use (see FlatIndexMap.hpp).
+template <typename Map> void run_index_map_benchmarks(soa::bench::Runner &r_runner, const std::string &p_name, uint64_t p_rows) {
+	const auto filled_map = [&]() {
+		auto map = std::make_unique<Map>();
+		for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+			(*map)[i] = i;
+		}
+		return map;
+	};
+
+	r_runner.run(p_name + "_insert", p_rows, []() { return std::make_unique<Map>(); },
+			[&](auto &p_map) {
+				for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+					(*p_map)[i] = i;
+				}
+			});
+
+	if (r_runner.selected(p_name + "_lookup")) {
+		const std::unique_ptr<Map> map = filled_map();
+		const std::vector<SoaVectorSizeType> keys = random_rows(p_rows, p_rows, 7);
+		r_runner.run(p_name + "_lookup", p_rows, []() { return 0; }, [&](int) {
+			uint64_t sum = 0;
+			for (const SoaVectorSizeType key : keys) {
+				sum += map->at(key);
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+	}
+
+	r_runner.run(p_name + "_erase", p_rows, filled_map, [&](auto &p_map) {
+		for (SoaVectorSizeType i = 0; i < p_rows; i += 2) {
+			p_map->erase(i);
+		}
+	});
+}
+
+const char *isa_suffix(soa::simd::Isa p_isa) {
+	switch (p_isa) {
+		case soa::simd::Isa::Scalar: return "_scalar";
+		case soa::simd::Isa::SSE2:   return "_sse2";
+		case soa::simd::Isa::AVX2:   return "_avx2";
+		case soa::simd::Isa::AVX512: return "_avx512";
+	}
+	return "";
+}
+
+// A kernel runs as p_name_loop with the plain loop it replaces and as p_name_scalar, p_name_sse2, ... with every instruction set this cpu has.
+template <typename Loop, typename Kernel> void run_simd_benchmark(soa::bench::Runner &r_runner, const std::string &p_name, uint64_t p_rows, Loop p_loop, Kernel p_kernel) {
+	using namespace soa::simd;
+	r_runner.run(p_name + "_loop", p_rows, []() { return 0; }, [&](int) { p_loop(); });
+	for (const Isa isa : { Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512 }) {
+		if (isa > detected_isa()) {
+			break;
+		}
+		set_isa(isa);
+		r_runner.run(p_name + isa_suffix(isa), p_rows, []() { return 0; }, [&](int) { p_kernel(); });
+	}
+	set_isa(detected_isa());
+}
+
+void run_simd_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	using namespace soa::simd;
+	const auto kernel_selected = [&](const std::string &p_name) {
+		return any_selected(r_runner, { p_name + "_loop", p_name + "_scalar", p_name + "_sse2", p_name + "_avx2", p_name + "_avx512" });
+	};
+	const char *const kernels[] = { "simd_float_sum", "simd_int_sum", "simd_float_max", "simd_compare", "simd_find_miss", "simd_count_equal", "simd_find_all",
+		"simd_find_any_of_miss", "simd_axpy", "simd_fill" };
+	if (std::ranges::none_of(kernels, kernel_selected)) {
+		return;
+	}
+
+	BenchSimdStruct soa_struct;
+	soa_struct.reserve(SoaVectorSizeType(p_rows));
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		soa_struct.push_row(float(i % 1000) * 0.5f, int(i % 1000));
+	}
+	const float *x = soa_struct.x.ptr();
+	const int *id = soa_struct.id.ptr();
+
+	run_simd_benchmark(r_runner, "simd_float_sum", p_rows,
+			[&]() {
+				float total = 0;
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					total += x[i];
+				}
+				soa::bench::do_not_optimize(total);
+			},
+			[&]() { soa::bench::do_not_optimize(sum(soa_struct.x)); });
+
+	run_simd_benchmark(r_runner, "simd_int_sum", p_rows,
+			[&]() {
+				int64_t total = 0;
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					total += id[i];
+				}
+				soa::bench::do_not_optimize(total);
+			},
+			[&]() { soa::bench::do_not_optimize(sum(soa_struct.id)); });
+
+	run_simd_benchmark(r_runner, "simd_float_max", p_rows,
+			[&]() {
+				float result = std::numeric_limits<float>::lowest();
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					result = x[i] > result ? x[i] : result;
+				}
+				soa::bench::do_not_optimize(result);
+			},
+			[&]() { soa::bench::do_not_optimize(max(soa_struct.x)); });
+
+	BitMask mask;
+	run_simd_benchmark(r_runner, "simd_compare", p_rows,
+			[&]() {
+				mask.assign((p_rows + 63) / 64, 0);
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					mask[i / 64] |= uint64_t(id[i] < 100) << (i % 64);
+				}
+				soa::bench::do_not_optimize(mask[0]);
+			},
+			[&]() { soa::bench::do_not_optimize(compare(soa_struct.id, Compare::Less, 100, mask)); });
+
+	// -1 isn't in the column so every search has to read all of it.
+	run_simd_benchmark(r_runner, "simd_find_miss", p_rows,
+			[&]() {
+				SoaVectorSizeType index = soa::SoaVector<int>::NOT_FOUND;
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					if (id[i] == -1) {
+						index = SoaVectorSizeType(i);
+						break;
+					}
+				}
+				soa::bench::do_not_optimize(index);
+			},
+			[&]() { soa::bench::do_not_optimize(soa_struct.id.find(-1)); });
+
+	run_simd_benchmark(r_runner, "simd_count_equal", p_rows,
+			[&]() {
+				SoaVectorSizeType matches = 0;
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					matches += id[i] == 7;
+				}
+				soa::bench::do_not_optimize(matches);
+			},
+			[&]() { soa::bench::do_not_optimize(soa_struct.id.count_equal(7)); });
+
+	run_simd_benchmark(r_runner, "simd_find_all", p_rows,
+			[&]() {
+				SelectionVector indices;
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					if (id[i] == 7) {
+						indices.push_back(SoaVectorSizeType(i));
+					}
+				}
+				soa::bench::do_not_optimize(indices.size());
+			},
+			[&]() { soa::bench::do_not_optimize(soa_struct.id.find_all(7).size()); });
+
+	const int any_of_values[] = { -1, -2, -3, -4 };
+	run_simd_benchmark(r_runner, "simd_find_any_of_miss", p_rows,
+			[&]() {
+				SoaVectorSizeType index = soa::SoaVector<int>::NOT_FOUND;
+				for (uint64_t i = 0; i < p_rows and index == soa::SoaVector<int>::NOT_FOUND; ++i) {
+					for (const int value : any_of_values) {
+						if (id[i] == value) {
+							index = SoaVectorSizeType(i);
+							break;
+						}
+					}
+				}
+				soa::bench::do_not_optimize(index);
+			},
+			[&]() { soa::bench::do_not_optimize(soa_struct.id.find_any_of(any_of_values)); });
+
+	std::vector<float> y(p_rows, 1.0f);
+	run_simd_benchmark(r_runner, "simd_axpy", p_rows,
+			[&]() {
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					y[i] = 0.5f * x[i] + y[i];
+				}
+				soa::bench::do_not_optimize(y[0]);
+			},
+			[&]() {
+				axpy(0.5f, x, y.data(), p_rows);
+				soa::bench::do_not_optimize(y[0]);
+			});
+
+	run_simd_benchmark(r_runner, "simd_fill", p_rows,
+			[&]() {
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					y[i] = 2.0f;
+				}
+				soa::bench::do_not_optimize(y[0]);
+			},
+			[&]() {
+				soa::simd::fill(y.data(), p_rows, 2.0f);
+				soa::bench::do_not_optimize(y[0]);
+			});
+}
+
+// Selects a tenth of the rows, spread over the whole table, and gathers 3 of the 4 members.
+void run_query_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	using soa::simd::Compare;
+	if (!any_selected(r_runner, { "query_aos_filter_gather", "query_where_select", "query_for_each_batch" })) {
+		return;
+	}
+
+	BenchDynamicStruct soa_struct;
+	soa_struct.reserve(SoaVectorSizeType(p_rows));
+	std::vector<BenchAosRow> aos;
+	aos.reserve(p_rows);
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		soa_struct.push_row(int(i % 1000), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+		aos.push_back(BenchAosRow{ int(i % 1000), BenchVector2{ float(i), 1 }, 2.0f, 3.0 });
+	}
+
+	r_runner.run("query_aos_filter_gather", p_rows, []() { return 0; }, [&](int) {
+		std::vector<BenchVector2> b;
+		std::vector<float> c;
+		std::vector<double> d;
+		for (const BenchAosRow &row : aos) {
+			if (row.a < 100) {
+				b.push_back(row.b);
+				c.push_back(row.c);
+				d.push_back(row.d);
+			}
+		}
+		soa::bench::do_not_optimize(b.size() + c.size() + d.size());
+	});
+	r_runner.run("query_where_select", p_rows, []() { return 0; }, [&](int) {
+		const auto [b, c, d] = soa_struct.where(&BenchDynamicStruct::a, Compare::Less, 100).select(&BenchDynamicStruct::b, &BenchDynamicStruct::c, &BenchDynamicStruct::d);
+		soa::bench::do_not_optimize(b.size() + c.size() + d.size());
+	});
+	r_runner.run("query_for_each_batch", p_rows, []() { return 0; }, [&](int) {
+		double sum = 0;
+		soa_struct.where(&BenchDynamicStruct::a, Compare::Less, 100)
+				.for_each_batch(
+						[&](std::span<const SoaVectorSizeType>, std::span<const BenchVector2> p_b, std::span<const float> p_c, std::span<const double> p_d) {
+							for (uint64_t i = 0; i < p_b.size(); ++i) {
+								sum += p_b[i].x + p_c[i] + p_d[i];
+							}
+						},
+						&BenchDynamicStruct::b, &BenchDynamicStruct::c, &BenchDynamicStruct::d);
+		soa::bench::do_not_optimize(sum);
+	});
+}
+
+// The same update pass on this thread and split over soa::default_thread_pool().
+void run_parallel_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "update_one_thread", "parallel_for_update" })) {
+		return;
+	}
+
+	BenchParticleStruct soa_struct;
+	soa_struct.reserve(SoaVectorSizeType(p_rows));
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		soa_struct.push_row(BenchVector3{ float(i), 0, 0 }, BenchVector3{ 1, 2, 3 });
+	}
+	const auto update = [](SoaVectorSizeType, SoaVectorSizeType p_count, BenchVector3 *p_position, const BenchVector3 *p_velocity) {
+		for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+			p_position[i].x += p_velocity[i].x * 0.5f;
+			p_position[i].y += p_velocity[i].y * 0.5f;
+			p_position[i].z += p_velocity[i].z * 0.5f;
+		}
+	};
+
+	r_runner.run("update_one_thread", p_rows, []() { return 0; },
+			[&](int) { update(0, soa_struct.position.size(), soa_struct.position.ptr(), soa_struct.velocity.ptr()); });
+	r_runner.run("parallel_for_update", p_rows, []() { return 0; },
+			[&](int) { soa::parallel_for(soa_struct, update, &BenchParticleStruct::position, &BenchParticleStruct::velocity); });
+}
+
+// Reading every member of random rows favours AoS, scanning 1 member favours SoA, TiledSOA is in between.
+void run_tiled_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	r_runner.run("tiled_push_row", p_rows, []() { return std::make_unique<BenchTiledStruct>(); }, [&](auto &p_tiled_struct) { fill(*p_tiled_struct, p_rows); });
+
+	if (!any_selected(r_runner, { "random_row_access", "tiled_random_row_access", "aos_random_row_access", "tiled_column_scan" })) {
+		return;
+	}
+	BenchDynamicStruct soa_struct;
+	fill(soa_struct, p_rows);
+	BenchTiledStruct tiled_struct;
+	fill(tiled_struct, p_rows);
+	std::vector<BenchAosRow> aos(p_rows);
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		aos[i] = BenchAosRow{ int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0 };
+	}
+	const std::vector<SoaVectorSizeType> rows = random_rows(p_rows, p_rows, 42);
+
+	r_runner.run("random_row_access", p_rows, []() { return 0; }, [&](int) {
+		double sum = 0;
+		for (const SoaVectorSizeType i : rows) {
+			sum += double(soa_struct.a[i]) + soa_struct.b[i].x + soa_struct.c[i] + soa_struct.d[i];
+		}
+		soa::bench::do_not_optimize(sum);
+	});
+	r_runner.run("tiled_random_row_access", p_rows, []() { return 0; }, [&](int) {
+		double sum = 0;
+		for (const SoaVectorSizeType i : rows) {
+			sum += double(tiled_struct.get_a(i)) + tiled_struct.get_b(i).x + tiled_struct.get_c(i) + tiled_struct.get_d(i);
+		}
+		soa::bench::do_not_optimize(sum);
+	});
+	r_runner.run("aos_random_row_access", p_rows, []() { return 0; }, [&](int) {
+		double sum = 0;
+		for (const SoaVectorSizeType i : rows) {
+			const BenchAosRow &row = aos[i];
+			sum += double(row.a) + row.b.x + row.c + row.d;
+		}
+		soa::bench::do_not_optimize(sum);
+	});
+	r_runner.run("tiled_column_scan", p_rows, []() { return 0; }, [&](int) {
+		int64_t sum = 0;
+		for (const auto block : tiled_struct.blocks()) {
+			const int *a = block.a();
+			for (SoaVectorSizeType i = 0; i < block.count; ++i) {
+				sum += a[i];
+			}
+		}
+		soa::bench::do_not_optimize(sum);
+	});
+}
+
+// Sorting by a random int key: an array of structs, the rows copied into tuples and back, sort_by's radix sort and sort_by with a comparator.
+void run_sort_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "sort_aos_stable_sort", "sort_copy_to_tuples", "sort_by_radix", "sort_by_comparison" })) {
+		return;
+	}
+
+	std::vector<int> keys(p_rows);
+	std::mt19937 rng(11);
+	for (int &key : keys) {
+		key = int(rng());
+	}
+	std::vector<BenchAosRow> aos(p_rows);
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		aos[i] = BenchAosRow{ keys[i], BenchVector2{ float(i), 1 }, 2.0f, double(i) };
+	}
+	const auto unsorted_struct = [&]() {
+		auto soa_struct = std::make_unique<BenchDynamicStruct>();
+		soa_struct->reserve(SoaVectorSizeType(p_rows));
+		for (uint64_t i = 0; i < p_rows; ++i) {
+			soa_struct->push_row(keys[i], BenchVector2{ float(i), 1 }, 2.0f, double(i));
+		}
+		return soa_struct;
+	};
+
+	r_runner.run("sort_aos_stable_sort", p_rows, [&]() { return aos; }, [](std::vector<BenchAosRow> &r_aos) { std::ranges::stable_sort(r_aos, {}, &BenchAosRow::a); });
+	r_runner.run("sort_copy_to_tuples", p_rows, unsorted_struct, [&](auto &p_soa_struct) {
+		BenchDynamicStruct &s = *p_soa_struct;
+		std::vector<std::tuple<int, BenchVector2, float, double>> rows;
+		rows.reserve(p_rows);
+		for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+			rows.emplace_back(s.a[i], s.b[i], s.c[i], s.d[i]);
+		}
+		std::ranges::stable_sort(rows, [](const auto &p_a, const auto &p_b) { return std::get<0>(p_a) < std::get<0>(p_b); });
+		for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+			std::tie(s.a[i], s.b[i], s.c[i], s.d[i]) = rows[i];
+		}
+	});
+	r_runner.run("sort_by_radix", p_rows, unsorted_struct, [](auto &p_soa_struct) { p_soa_struct->sort_by(&BenchDynamicStruct::a); });
+	r_runner.run("sort_by_comparison", p_rows, unsorted_struct,
+			[](auto &p_soa_struct) { p_soa_struct->sort_by(&BenchDynamicStruct::a, [](int p_a, int p_b) { return p_a < p_b; }); });
+}
+
+// Erases a random tenth of the rows one id at a time, with erase_batch and as tombstones, and skips or compacts the tombstones.
+void run_erase_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "mutable_erase", "mutable_erase_batch", "tombstone_erase", "tombstone_for_each_row", "tombstone_compact" })) {
+		return;
+	}
+
+	std::vector<SoaVectorSizeType> erase_ids(p_rows);
+	std::iota(erase_ids.begin(), erase_ids.end(), 0);
+	std::shuffle(erase_ids.begin(), erase_ids.end(), std::mt19937(7));
+	erase_ids.resize(p_rows / 10);
+	const auto erased_struct = [&]() {
+		auto soa_struct = filled_struct<BenchTombstoneStruct>(p_rows)();
+		for (const SoaVectorSizeType id : erase_ids) {
+			soa_struct->erase(id);
+		}
+		return soa_struct;
+	};
+	const auto erase_loop = [&](auto &p_soa_struct) {
+		for (const SoaVectorSizeType id : erase_ids) {
+			p_soa_struct->erase(id);
+		}
+	};
+
+	r_runner.run("mutable_erase", p_rows, filled_struct<BenchMutableStruct>(p_rows), erase_loop);
+	r_runner.run("mutable_erase_batch", p_rows, filled_struct<BenchMutableStruct>(p_rows), [&](auto &p_soa_struct) { p_soa_struct->erase_batch(erase_ids); });
+	r_runner.run("tombstone_erase", p_rows, filled_struct<BenchTombstoneStruct>(p_rows), erase_loop);
+	r_runner.run("tombstone_for_each_row", p_rows, erased_struct, [](auto &p_soa_struct) {
+		int64_t sum = 0;
+		p_soa_struct->for_each_row([&](SoaVectorSizeType p_index) { sum += p_soa_struct->a[p_index]; });
+		soa::bench::do_not_optimize(sum);
+	});
+	r_runner.run("tombstone_compact", p_rows, erased_struct, [](auto &p_soa_struct) { p_soa_struct->compact(); });
+}
+
+#ifdef SOA_HAS_MMAP
+// Restarting from disk: opening a MappedSOA and scanning a member of it vs fread-ing every column into a DynamicSOA.
+void run_mapped_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "mapped_open", "mapped_column_scan", "fread_columns" })) {
+		return;
+	}
+
+	const std::string path = (std::filesystem::temp_directory_path() / "soa_bench_mapped.bin").string();
+	const std::string raw_path = (std::filesystem::temp_directory_path() / "soa_bench_mapped.raw").string();
+	{
+		BenchMappedStruct soa_struct;
+		soa_struct.create(path.c_str(), SoaVectorSizeType(p_rows));
+		fill(soa_struct, p_rows);
+		FILE *file = std::fopen(raw_path.c_str(), "wb");
+		std::fwrite(soa_struct.a.ptr(), sizeof(int), p_rows, file);
+		std::fwrite(soa_struct.b.ptr(), sizeof(BenchVector2), p_rows, file);
+		std::fwrite(soa_struct.c.ptr(), sizeof(float), p_rows, file);
+		std::fwrite(soa_struct.d.ptr(), sizeof(double), p_rows, file);
+		std::fclose(file);
+	}
+
+	r_runner.run("mapped_open", p_rows, []() { return std::make_unique<BenchMappedStruct>(); }, [&](auto &p_soa_struct) { p_soa_struct->open(path.c_str()); });
+	if (r_runner.selected("mapped_column_scan")) {
+		BenchMappedStruct mapped_struct;
+		mapped_struct.open(path.c_str());
+		r_runner.run("mapped_column_scan", p_rows, []() { return 0; }, [&](int) {
+			int64_t sum = 0;
+			for (const int value : mapped_struct.a) {
+				sum += value;
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+	}
+	// Every row is pushed first so the columns have p_rows rows, then overwritten with the file.
+	r_runner.run("fread_columns", p_rows, []() { return std::make_unique<BenchDynamicStruct>(); }, [&](auto &p_soa_struct) {
+		p_soa_struct->reserve(SoaVectorSizeType(p_rows));
+		for (uint64_t i = 0; i < p_rows; ++i) {
+			p_soa_struct->push_row(0, BenchVector2{}, 0.0f, 0.0);
+		}
+		FILE *file = std::fopen(raw_path.c_str(), "rb");
+		size_t read = std::fread(p_soa_struct->a.ptr(), sizeof(int), p_rows, file);
+		read += std::fread(p_soa_struct->b.ptr(), sizeof(BenchVector2), p_rows, file);
+		read += std::fread(p_soa_struct->c.ptr(), sizeof(float), p_rows, file);
+		read += std::fread(p_soa_struct->d.ptr(), sizeof(double), p_rows, file);
+		std::fclose(file);
+		soa::bench::do_not_optimize(read);
+	});
+	std::remove(path.c_str());
+	std::remove(raw_path.c_str());
+}
+#endif
+
+// A stream and the table loaded from it.
+template <typename S> struct BenchLoad {
+	std::stringstream stream;
+	S soa_struct;
+};
+
+// Writing every member of every row on its own vs save/load to a stringstream, strings as their length and characters.
+void run_serialize_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "save_per_row", "load_per_row", "save", "load" })) {
+		return;
+	}
+
+	BenchRecordStruct soa_struct;
+	soa_struct.reserve(SoaVectorSizeType(p_rows));
+	std::mt19937 rng(3);
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		soa_struct.push_row(int(i), float(rng() % 1000) * 0.1f, "entity_" + std::to_string(rng() % 100000));
+	}
+	const auto save_per_row = [&](std::stringstream &r_stream) {
+		for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+			const uint32_t length = uint32_t(soa_struct.name[i].size());
+			r_stream.write(reinterpret_cast<const char *>(&soa_struct.id[i]), sizeof(int));
+			r_stream.write(reinterpret_cast<const char *>(&soa_struct.value[i]), sizeof(float));
+			r_stream.write(reinterpret_cast<const char *>(&length), sizeof(uint32_t));
+			r_stream.write(soa_struct.name[i].data(), length);
+		}
+	};
+	std::stringstream row_stream;
+	save_per_row(row_stream);
+	const std::string row_data = row_stream.str();
+	std::stringstream column_stream;
+	soa_struct.save(column_stream);
+	const std::string column_data = column_stream.str();
+	const auto load_setup = [](const std::string &p_data) {
+		return [&]() {
+			auto load = std::make_unique<BenchLoad<BenchRecordStruct>>();
+			load->stream.str(p_data);
+			return load;
+		};
+	};
+
+	r_runner.run("save_per_row", p_rows, []() { return std::make_unique<std::stringstream>(); }, [&](auto &p_stream) { save_per_row(*p_stream); });
+	r_runner.run("load_per_row", p_rows, load_setup(row_data), [](auto &p_load) {
+		int id;
+		float value;
+		uint32_t length;
+		std::string name;
+		while (p_load->stream.read(reinterpret_cast<char *>(&id), sizeof(int))) {
+			p_load->stream.read(reinterpret_cast<char *>(&value), sizeof(float));
+			p_load->stream.read(reinterpret_cast<char *>(&length), sizeof(uint32_t));
+			name.resize(length);
+			p_load->stream.read(name.data(), length);
+			p_load->soa_struct.push_row(id, value, name);
+		}
+	});
+	r_runner.run("save", p_rows, []() { return std::make_unique<std::stringstream>(); }, [&](auto &p_stream) { soa_struct.save(*p_stream); });
+	r_runner.run("load", p_rows, load_setup(column_data), [](auto &p_load) { p_load->soa_struct.load(p_load->stream); });
+}
+
+// Finding and replicating a random hundredth of the rows that changed, with and without dirty tracking.
+void run_dirty_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "untracked_set", "dirty_set", "compare_every_row", "for_each_dirty", "dirty_full_save", "export_apply_delta" })) {
+		return;
+	}
+
+	const std::vector<SoaVectorSizeType> changed_rows = random_rows(p_rows, p_rows / 100, 17);
+	BenchDynamicStruct untracked_struct;
+	fill(untracked_struct, p_rows);
+	BenchDirtyStruct soa_struct;
+	fill(soa_struct, p_rows);
+	BenchDirtyStruct replica;
+	std::stringstream full_delta;
+	soa_struct.export_delta(full_delta);
+	replica.apply_delta(full_delta);
+	soa_struct.clear_dirty();
+	// Without dirty tracking a consumer has to compare every row with its own copy to find the changes.
+	const std::vector<int> shadow(soa_struct.a.begin(), soa_struct.a.end());
+	for (const SoaVectorSizeType row : changed_rows) {
+		soa_struct.set_a(row, -1);
+	}
+
+	r_runner.run("untracked_set", p_rows, []() { return 0; }, [&](int) {
+		for (const SoaVectorSizeType row : changed_rows) {
+			untracked_struct.set_a(row, -1);
+		}
+	});
+	r_runner.run("dirty_set", p_rows, []() { return 0; }, [&](int) {
+		for (const SoaVectorSizeType row : changed_rows) {
+			soa_struct.set_a(row, -1);
+		}
+	});
+	r_runner.run("compare_every_row", p_rows, [&]() { return shadow; }, [&](std::vector<int> &r_shadow) {
+		SoaVectorSizeType found = 0;
+		for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+			if (soa_struct.a[i] != r_shadow[i]) {
+				r_shadow[i] = soa_struct.a[i];
+				found++;
+			}
+		}
+		soa::bench::do_not_optimize(found);
+	});
+	r_runner.run("for_each_dirty", p_rows, []() { return 0; }, [&](int) {
+		SoaVectorSizeType found = 0;
+		soa_struct.for_each_dirty(&BenchDirtyStruct::a, [&](SoaVectorSizeType) { found++; });
+		soa::bench::do_not_optimize(found);
+	});
+	r_runner.run("dirty_full_save", p_rows, []() { return std::make_unique<std::stringstream>(); }, [&](auto &p_stream) { soa_struct.save(*p_stream); });
+	// The dirty rows aren't cleared, so every repetition sends the same delta.
+	r_runner.run("export_apply_delta", p_rows, []() { return 0; }, [&](int) {
+		std::stringstream delta;
+		soa_struct.export_delta(delta);
+		replica.apply_delta(delta);
+	});
+}
+
+// Sharing a table with readers: a copy of every column made under a lock vs BufferedSOA::publish, a hundredth of the rows change every tick.
+void run_buffered_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "copy_under_lock", "buffered_publish", "buffered_read" })) {
+		return;
+	}
+
+	const std::vector<SoaVectorSizeType> changed_rows = random_rows(p_rows, p_rows / 100, 23);
+	int tick = 0;
+	if (r_runner.selected("copy_under_lock")) {
+		BenchDirtyStruct locked_struct;
+		fill(locked_struct, p_rows);
+		std::vector<int> locked_a;
+		std::vector<BenchVector2> locked_b;
+		std::vector<float> locked_c;
+		std::vector<double> locked_d;
+		std::mutex locked_mutex;
+		r_runner.run("copy_under_lock", p_rows, []() { return 0; }, [&](int) {
+			tick++;
+			for (const SoaVectorSizeType row : changed_rows) {
+				locked_struct.set_a(row, tick);
+			}
+			std::lock_guard lock(locked_mutex);
+			locked_a.assign(locked_struct.a.begin(), locked_struct.a.end());
+			locked_b.assign(locked_struct.b.begin(), locked_struct.b.end());
+			locked_c.assign(locked_struct.c.begin(), locked_struct.c.end());
+			locked_d.assign(locked_struct.d.begin(), locked_struct.d.end());
+		});
+	}
+
+	if (!any_selected(r_runner, { "buffered_publish", "buffered_read" })) {
+		return;
+	}
+	soa::BufferedSOA<BenchDirtyStruct> buffered;
+	fill(buffered.back(), p_rows);
+	buffered.publish();
+	r_runner.run("buffered_publish", p_rows, []() { return 0; }, [&](int) {
+		tick++;
+		for (const SoaVectorSizeType row : changed_rows) {
+			buffered.back().set_a(row, tick);
+		}
+		buffered.publish();
+	});
+
+	// p_rows reads while another thread reads too.
+	if (r_runner.selected("buffered_read")) {
+		std::atomic<bool> done = false;
+		std::thread reader_thread([&]() {
+			auto thread_reader = buffered.reader();
+			uint64_t reads = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				reads += thread_reader.read()->a.size() != 0;
+			}
+			soa::bench::do_not_optimize(reads);
+		});
+		auto reader = buffered.reader();
+		r_runner.run("buffered_read", p_rows, []() { return 0; }, [&](int) {
+			uint64_t reads = 0;
+			for (uint64_t i = 0; i < p_rows; ++i) {
+				reads += reader.read()->a.size() != 0;
+			}
+			soa::bench::do_not_optimize(reads);
+		});
+		done = true;
+		reader_thread.join();
+	}
+}
+
+// An appender and the table it drains into.
+struct BenchAppend {
+	soa::ConcurrentAppendSOA<BenchDynamicStruct> appender;
+	BenchDynamicStruct target;
+};
+
+// 4 threads append p_rows rows: push_row under a mutex, ConcurrentAppendSOA::push_row and 64 row batches, the last two drained into a DynamicSOA.
+void run_concurrent_append_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	const int thread_count = 4;
+	const uint64_t rows_per_thread = p_rows / thread_count;
+	const uint64_t batch_size = 64;
+
+	r_runner.run("mutex_push_row", p_rows, []() { return std::make_unique<BenchDynamicStruct>(); }, [&](auto &p_soa_struct) {
+		std::mutex mutex;
+		run_threads(thread_count, [&](int p_thread) {
+			for (uint64_t i = 0; i < rows_per_thread; ++i) {
+				std::lock_guard lock(mutex);
+				p_soa_struct->push_row(p_thread, BenchVector2{ float(i), 0 }, 2.0f, 3.0);
+			}
+		});
+	});
+	r_runner.run("concurrent_push_row", p_rows, []() { return std::make_unique<BenchAppend>(); }, [&](auto &p_append) {
+		run_threads(thread_count, [&](int p_thread) {
+			for (uint64_t i = 0; i < rows_per_thread; ++i) {
+				p_append->appender.push_row(p_thread, BenchVector2{ float(i), 0 }, 2.0f, 3.0);
+			}
+		});
+		p_append->appender.drain_into(p_append->target);
+	});
+	r_runner.run("concurrent_batch_push", p_rows, []() { return std::make_unique<BenchAppend>(); }, [&](auto &p_append) {
+		run_threads(thread_count, [&](int p_thread) {
+			for (uint64_t i = 0; i < rows_per_thread; i += batch_size) {
+				const uint64_t end = std::min(i + batch_size, rows_per_thread);
+				auto batch = p_append->appender.reserve_rows(end - i);
+				for (uint64_t j = i; j < end; ++j) {
+					batch.emplace_row(p_thread, BenchVector2{ float(j), 0 }, 2.0f, 3.0);
+				}
+			}
+		});
+		p_append->appender.drain_into(p_append->target);
+	});
+}
+
+// Creates, fills and destroys p_rows / 40 tables of 40 rows, each one grows a few times while it's filled. The arena is reset every 1000 tables, the end of a frame.
+template <typename S> void run_small_tables_benchmark(soa::bench::Runner &r_runner, const std::string &p_name, uint64_t p_rows) {
+	const uint64_t rows = 40;
+	r_runner.run(p_name, p_rows, []() { return 0; }, [&](int) {
+		uint64_t checksum = 0;
+		for (uint64_t t = 0; t < p_rows / rows; ++t) {
+			{
+				S soa_struct;
+				for (uint64_t i = 0; i < rows; ++i) {
+					soa_struct.push_row(int(i), float(i), BenchVector2{ 1, 2 });
+				}
+				checksum += uint64_t(soa_struct.a[rows - 1]);
+			}
+			if constexpr (std::is_same_v<S, BenchSmallArenaStruct>) {
+				if (t % 1000 == 999) {
+					soa::ArenaAllocator<BenchFrame>::reset();
+				}
+			}
+		}
+		if constexpr (std::is_same_v<S, BenchSmallArenaStruct>) {
+			soa::ArenaAllocator<BenchFrame>::reset();
+		}
+		soa::bench::do_not_optimize(checksum);
+	});
+}
+
+// p_rows random reads from a column of p_rows rows, past a few MB nearly every one of them misses the TLB with 4 KB pages.
+template <typename S> void run_random_reads_benchmark(soa::bench::Runner &r_runner, const std::string &p_name, uint64_t p_rows) {
+	if (!r_runner.selected(p_name)) {
+		return;
+	}
+	S soa_struct;
+	soa_struct.reserve(SoaVectorSizeType(p_rows));
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		soa_struct.push_row(i);
+	}
+	const std::vector<SoaVectorSizeType> rows = random_rows(p_rows, p_rows, 29);
+	r_runner.run(p_name, p_rows, []() { return 0; }, [&](int) {
+		uint64_t sum = 0;
+		for (const SoaVectorSizeType row : rows) {
+			sum += soa_struct.value[row];
+		}
+		soa::bench::do_not_optimize(sum);
+	});
+}
+
+void run_allocator_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	run_small_tables_benchmark<BenchSmallMallocStruct>(r_runner, "small_tables_malloc", p_rows);
+	run_small_tables_benchmark<BenchSmallPoolStruct>(r_runner, "small_tables_pool", p_rows);
+	run_small_tables_benchmark<BenchSmallArenaStruct>(r_runner, "small_tables_arena", p_rows);
+	soa::ArenaAllocator<BenchFrame>::release();
+	run_random_reads_benchmark<BenchLargeMallocStruct>(r_runner, "random_reads_malloc", p_rows);
+	run_random_reads_benchmark<BenchLargeHugePageStruct>(r_runner, "random_reads_huge_pages", p_rows);
+}
+
+// soa::Table with the same members as BenchDynamicStruct, compare with push_row_with_growth and column_scan.
+void run_table_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	r_runner.run("table_emplace_row", p_rows, []() { return std::make_unique<soa::Table<BenchAosRow>>(); }, [&](auto &p_table) {
+		for (uint64_t i = 0; i < p_rows; ++i) {
+			p_table->emplace_row(int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+		}
+	});
+	if (r_runner.selected("table_column_scan")) {
+		soa::Table<BenchAosRow> table;
+		for (uint64_t i = 0; i < p_rows; ++i) {
+			table.emplace_row(int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+		}
+		r_runner.run("table_column_scan", p_rows, []() { return 0; }, [&](int) {
+			int64_t sum = 0;
+			for (const int value : table.column<0>()) {
+				sum += value;
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+	}
+}
+
+// Counting the set flags of a bool column vs a soa::PackedBool column.
+void run_packed_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "bool_count_equal", "packed_bool_count" })) {
+		return;
+	}
+
+	BenchPackedStruct soa_struct;
+	soa_struct.reserve(SoaVectorSizeType(p_rows));
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		soa_struct.push_row(i % 7 == 0, i % 7 == 0);
+	}
+	r_runner.run("bool_count_equal", p_rows, []() { return 0; }, [&](int) { soa::bench::do_not_optimize(soa_struct.flag.count_equal(true)); });
+	r_runner.run("packed_bool_count", p_rows, []() { return 0; }, [&](int) { soa::bench::do_not_optimize(soa_struct.packed_flag.count()); });
+}
+
+// Pushing short strings into a std::string and a soa::ArenaString column and counting one of them.
+void run_string_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	if (!any_selected(r_runner, { "string_push", "arena_string_push", "string_count_equal", "arena_string_count_equal" })) {
+		return;
+	}
+
+	std::vector<std::string> names(p_rows);
+	for (uint64_t i = 0; i < p_rows; ++i) {
+		names[i] = "name_" + std::to_string(i % 100000);
+	}
+	const auto push_names = [&](auto &p_soa_struct) {
+		for (const std::string &name : names) {
+			p_soa_struct->push_name(name);
+		}
+	};
+	r_runner.run("string_push", p_rows, []() { return std::make_unique<BenchStringStruct>(); }, push_names);
+	r_runner.run("arena_string_push", p_rows, []() { return std::make_unique<BenchArenaStringStruct>(); }, push_names);
+
+	BenchStringStruct string_struct;
+	BenchArenaStringStruct arena_struct;
+	for (const std::string &name : names) {
+		string_struct.push_name(name);
+		arena_struct.push_name(name);
+	}
+	r_runner.run("string_count_equal", p_rows, []() { return 0; }, [&](int) { soa::bench::do_not_optimize(string_struct.name.count_equal("name_4242")); });
+	r_runner.run("arena_string_count_equal", p_rows, []() { return 0; }, [&](int) { soa::bench::do_not_optimize(arena_struct.name.count_equal("name_4242")); });
+}
+
+void run_benchmarks(soa::bench::Runner &r_runner, uint64_t p_rows) {
+	const auto no_setup = []() { return 0; };
+
+	r_runner.run("push_row", p_rows,
+			[&]() {
+				auto soa_struct = std::make_unique<BenchDynamicStruct>();
+				soa_struct->reserve(SoaVectorSizeType(p_rows));
+				return soa_struct;
+			},
+			[&](auto &p_soa_struct) {
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					p_soa_struct->push_row(int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+				}
+			});
+
+	r_runner.run("push_row_with_growth", p_rows, []() { return std::make_unique<BenchDynamicStruct>(); },
+			[&](auto &p_soa_struct) {
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					p_soa_struct->push_row(int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+				}
+			});
+
+	// Growing without moving the columns, see VirtualReserveAllocator.
+	r_runner.run("virtual_reserve_push_row", p_rows, []() { return std::make_unique<BenchReservedStruct>(); },
+			[&](auto &p_soa_struct) {
+				for (uint64_t i = 0; i < p_rows; ++i) {
+					p_soa_struct->push_row(int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0);
+				}
+			});
+
+	// One soa_realloc of a full table, which moves every column.
+	r_runner.run("realloc", p_rows, filled_struct<BenchDynamicStruct>(p_rows), [](auto &p_soa_struct) { p_soa_struct->reserve(p_soa_struct->capacity() + 1); });
+
+	if (r_runner.selected("mutable_lookup")) {
+		BenchMutableStruct lookup_struct;
+		std::vector<SoaVectorSizeType> ids = fill(lookup_struct, p_rows);
+		std::shuffle(ids.begin(), ids.end(), std::mt19937(5));
+		r_runner.run("mutable_lookup", p_rows, no_setup, [&](int) {
+			int64_t sum = 0;
+			for (const SoaVectorSizeType id : ids) {
+				sum += lookup_struct.get_a(id);
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+	}
+
+	run_erase_benchmarks(r_runner, p_rows);
+
+	if (any_selected(r_runner, { "column_scan", "row_access", "rows_iteration", "zip_iteration", "set_all_members", "set_one_member" })) {
+		BenchDynamicStruct soa_struct;
+		fill(soa_struct, p_rows);
+		r_runner.run("column_scan", p_rows, no_setup, [&](int) {
+			int64_t sum = 0;
+			for (const int value : soa_struct.a) {
+				sum += value;
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+		r_runner.run("row_access", p_rows, no_setup, [&](int) {
+			double sum = 0;
+			for (SoaVectorSizeType i = 0; i < soa_struct.a.size(); ++i) {
+				sum += double(soa_struct.a[i]) + soa_struct.b[i].x + soa_struct.c[i] + soa_struct.d[i];
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+		r_runner.run("rows_iteration", p_rows, no_setup, [&](int) {
+			double sum = 0;
+			for (const auto row : soa_struct.rows()) {
+				sum += double(row.a) + row.b.x + row.c + row.d;
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+#ifdef __cpp_lib_ranges_zip
+		r_runner.run("zip_iteration", p_rows, no_setup, [&](int) {
+			double sum = 0;
+			for (const auto [a, b, c, d] : std::views::zip(soa_struct.a, soa_struct.b, soa_struct.c, soa_struct.d)) {
+				sum += double(a) + b.x + c + d;
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+#endif
+		r_runner.run("set_all_members", p_rows, no_setup, [&](int) {
+			for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+				soa_struct.set_a(i, int(i));
+				soa_struct.set_b(i, BenchVector2{ float(i), 2 });
+				soa_struct.set_c(i, 3.0f);
+				soa_struct.set_d(i, 4.0);
+			}
+		});
+		r_runner.run("set_one_member", p_rows, no_setup, [&](int) {
+			for (SoaVectorSizeType i = 0; i < p_rows; ++i) {
+				soa_struct.set_a(i, int(i));
+			}
+		});
+	}
+
+	// std::unordered_map takes several GB past 10M keys.
+	if (p_rows <= 10000000) {
+		run_index_map_benchmarks<soa::FlatIndexMap>(r_runner, "flat_index_map", p_rows);
+		run_index_map_benchmarks<std::unordered_map<SoaVectorSizeType, SoaVectorSizeType>>(r_runner, "unordered_map", p_rows);
+	}
+
+	// The same scans over an array of structs for comparison.
+	if (any_selected(r_runner, { "aos_column_scan", "aos_row_access", "aos_set_all_members", "aos_set_one_member" })) {
+		std::vector<BenchAosRow> aos(p_rows);
+		for (uint64_t i = 0; i < p_rows; ++i) {
+			aos[i] = BenchAosRow{ int(i), BenchVector2{ float(i), 1 }, 2.0f, 3.0 };
+		}
+		r_runner.run("aos_column_scan", p_rows, no_setup, [&](int) {
+			int64_t sum = 0;
+			for (const BenchAosRow &row : aos) {
+				sum += row.a;
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+		r_runner.run("aos_row_access", p_rows, no_setup, [&](int) {
+			double sum = 0;
+			for (const BenchAosRow &row : aos) {
+				sum += double(row.a) + row.b.x + row.c + row.d;
+			}
+			soa::bench::do_not_optimize(sum);
+		});
+		r_runner.run("aos_set_all_members", p_rows, no_setup, [&](int) {
+			for (uint64_t i = 0; i < p_rows; ++i) {
+				aos[i] = BenchAosRow{ int(i), BenchVector2{ float(i), 2 }, 3.0f, 4.0 };
+			}
+			soa::bench::do_not_optimize(aos[0]);
+		});
+		r_runner.run("aos_set_one_member", p_rows, no_setup, [&](int) {
+			for (uint64_t i = 0; i < p_rows; ++i) {
+				aos[i].a = int(i);
+			}
+			soa::bench::do_not_optimize(aos[0]);
+		});
+	}
+
+	run_simd_benchmarks(r_runner, p_rows);
+	run_query_benchmarks(r_runner, p_rows);
+	run_parallel_benchmarks(r_runner, p_rows);
+	run_tiled_benchmarks(r_runner, p_rows);
+	run_table_benchmarks(r_runner, p_rows);
+	run_packed_benchmarks(r_runner, p_rows);
+	run_allocator_benchmarks(r_runner, p_rows);
+	run_dirty_benchmarks(r_runner, p_rows);
+
+	// These keep 2 or more copies of the table, past 10M rows that's several GB. ConcurrentAppendSOA holds at most 16M undrained rows.
+	if (p_rows <= 10000000) {
+		run_sort_benchmarks(r_runner, p_rows);
+		run_serialize_benchmarks(r_runner, p_rows);
+		run_buffered_benchmarks(r_runner, p_rows);
+		run_string_benchmarks(r_runner, p_rows);
+#ifdef SOA_HAS_MMAP
+		run_mapped_benchmarks(r_runner, p_rows);
+#endif
+		run_concurrent_append_benchmarks(r_runner, p_rows);
+	}
+}
+
+} // namespace
+
+int main(int p_argc, char **p_argv) {
+	try {
+		const soa::bench::Options options = soa::bench::Options::parse(p_argc, p_argv);
+		soa::bench::Runner runner(options);
+#ifndef __cpp_lib_ranges_zip
+		std::printf("zip_iteration is skipped, the standard library doesn't have std::views::zip\n");
+#endif
+		for (const uint64_t rows : options.sizes()) {
+			run_benchmarks(runner, rows);
+		}
+		if (!options.json_path.empty()) {
+#ifdef __VERSION__
+			runner.write_json(options.json_path, __VERSION__);
+#else
+			runner.write_json(options.json_path, "unknown");
+#endif
+		}
+	} catch (const std::exception &p_error) {
+		std::cerr << p_error.what() << "\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace soa {
+
+// Probe lengths of the entries of a FlatIndexMap, the probe length of an entry is how many slots past its home slot it is so a lookup of it reads probe length + 1 slots.
+struct ProbeStats {
+	uint64_t entries = 0;
+	uint64_t total_probe_length = 0;
+	uint64_t max_probe_length = 0;
+
+	[[nodiscard]] double mean() const { return entries == 0 ? 0 : double(total_probe_length) / double(entries); }
+};
+
+// Open addressing entity id -> index map used by MutableSOA.
+// All slots are stored in a single contiguous array and collisions are resolved with robin hood linear probing, so a lookup is usually 1 cache line instead of a pointer chase per
+// node like std::unordered_map. Erase uses backward shift deletion so there are no tombstones and probe lengths stay short no matter how many times ids are erased.
+// Only implements the parts of the std::unordered_map interface that the SOA macros use so it can be swapped with SOA_MAP_TYPE.
+class FlatIndexMap {
+public:
+	// Reserved key used to mark empty slots, this id can't be stored in the map.
+	static constexpr SoaVectorSizeType EMPTY_KEY = UINT32_MAX;
+
+	struct Slot {
+		SoaVectorSizeType first = EMPTY_KEY;
+		SoaVectorSizeType second = 0;
+	};
+
+private:
+	static constexpr SoaVectorSizeType MIN_CAPACITY = 16;
+
+	std::vector<Slot> slots;
+	SoaVectorSizeType count = 0;
+	SoaVectorSizeType mask = 0;
+	SoaVectorSizeType bits = 0;
+
+	// Entity ids are handed out sequentially so keep the low bits as they are, that way ids pushed together land in neighbouring slots and walking ids in order walks memory in order.
+	// The high bits are folded in so ids that only differ above the mask still spread out.
+	[[nodiscard]] SoaVectorSizeType home_slot(SoaVectorSizeType p_key) const { return (p_key ^ (p_key >> bits)) & mask; }
+
+	// Max load factor is 3/4.
+	[[nodiscard]] bool needs_grow(SoaVectorSizeType p_count) const { return slots.empty() or uint64_t(p_count) * 4 > uint64_t(slots.size()) * 3; }
+
+	void rehash(SoaVectorSizeType p_capacity) {
+		SoaVectorSizeType new_capacity = MIN_CAPACITY;
+		while (uint64_t(new_capacity) * 3 < uint64_t(p_capacity) * 4) {
+			new_capacity *= 2;
+		}
+
+		std::vector<Slot> old_slots(new_capacity);
+		old_slots.swap(slots);
+		mask = new_capacity - 1;
+		bits = std::countr_zero(new_capacity);
+
+		for (const Slot &slot : old_slots) {
+			if (slot.first != EMPTY_KEY) {
+				insert_unique(slot.first, slot.second);
+			}
+		}
+	}
+
+	[[nodiscard]] SoaVectorSizeType probe_distance(SoaVectorSizeType p_slot) const { return (p_slot - home_slot(slots[p_slot].first)) & mask; }
+
+	// Robin hood insertion: an element that is further from its home slot takes the place of one that is closer to its home, which keeps every probe run sorted by distance.
+	Slot &insert_unique(SoaVectorSizeType p_key, SoaVectorSizeType p_value) {
+		Slot entry = { p_key, p_value };
+		Slot *inserted = nullptr;
+		SoaVectorSizeType distance = 0;
+		for (SoaVectorSizeType i = home_slot(p_key);; i = (i + 1) & mask, distance++) {
+			if (slots[i].first == EMPTY_KEY) {
+				slots[i] = entry;
+				return inserted != nullptr ? *inserted : slots[i];
+			}
+
+			const SoaVectorSizeType existing_distance = probe_distance(i);
+			if (existing_distance < distance) {
+				std::swap(entry, slots[i]);
+				distance = existing_distance;
+				if (inserted == nullptr) {
+					inserted = &slots[i];
+				}
+			}
+		}
+	}
+
+	// EMPTY_KEY is never stored, without the check it would match the first empty slot it probes.
+	[[nodiscard]] SoaVectorSizeType find_slot(SoaVectorSizeType p_key) const {
+		if (slots.empty() or p_key == EMPTY_KEY) {
+			return EMPTY_KEY;
+		}
+
+		for (SoaVectorSizeType i = home_slot(p_key), distance = 0;; i = (i + 1) & mask, distance++) {
+			if (slots[i].first == p_key) {
+				return i;
+			}
+			// Because probe runs are sorted by distance the key can't be past an element that is closer to its home than the key would be.
+			if (slots[i].first == EMPTY_KEY or probe_distance(i) < distance) {
+				return EMPTY_KEY;
+			}
+		}
+	}
+
+public:
+	void reserve(SoaVectorSizeType p_count) {
+		if (needs_grow(p_count)) {
+			rehash(p_count);
+		}
+	}
+
+	// Returns nullptr (which is what end() returns) if the key is not in the map.
+	Slot *find(SoaVectorSizeType p_key) {
+		const SoaVectorSizeType i = find_slot(p_key);
+		return i == EMPTY_KEY ? nullptr : &slots[i];
+	}
+	[[nodiscard]] const Slot *find(SoaVectorSizeType p_key) const {
+		const SoaVectorSizeType i = find_slot(p_key);
+		return i == EMPTY_KEY ? nullptr : &slots[i];
+	}
+
+	Slot *end() { return nullptr; }
+	[[nodiscard]] const Slot *end() const { return nullptr; }
+
+	[[nodiscard]] bool contains(SoaVectorSizeType p_key) const { return find_slot(p_key) != EMPTY_KEY; }
+
+	SoaVectorSizeType &at(SoaVectorSizeType p_key) {
+		Slot *slot = find(p_key);
+		if (slot == nullptr) [[unlikely]] {
+			throw std::out_of_range("soa::FlatIndexMap::at");
+		}
+		return slot->second;
+	}
+	[[nodiscard]] const SoaVectorSizeType &at(SoaVectorSizeType p_key) const {
+		const Slot *slot = find(p_key);
+		if (slot == nullptr) [[unlikely]] {
+			throw std::out_of_range("soa::FlatIndexMap::at");
+		}
+		return slot->second;
+	}
+
+	// Throws std::invalid_argument for EMPTY_KEY.
+	SoaVectorSizeType &operator[](SoaVectorSizeType p_key) {
+		Slot *slot = find(p_key);
+		if (slot != nullptr) {
+			return slot->second;
+		}
+		if (p_key == EMPTY_KEY) [[unlikely]] {
+			throw std::invalid_argument("soa::FlatIndexMap: EMPTY_KEY can't be stored in the map");
+		}
+
+		if (needs_grow(count + 1)) [[unlikely]] {
+			rehash(count + 1);
+		}
+		count++;
+		return insert_unique(p_key, 0).second;
+	}
+
+	SoaVectorSizeType erase(SoaVectorSizeType p_key) {
+		SoaVectorSizeType hole = find_slot(p_key);
+		if (hole == EMPTY_KEY) {
+			return 0;
+		}
+
+		// Backward shift deletion: pull the following elements of the probe run back by 1 until reaching one that is already in its home slot.
+		for (SoaVectorSizeType i = (hole + 1) & mask; slots[i].first != EMPTY_KEY and probe_distance(i) != 0; i = (i + 1) & mask) {
+			slots[hole] = slots[i];
+			hole = i;
+		}
+		slots[hole] = Slot();
+		count--;
+		return 1;
+	}
+
+	void clear() {
+		slots.clear();
+		count = 0;
+		mask = 0;
+		bits = 0;
+	}
+
+	[[nodiscard]] SoaVectorSizeType size() const { return count; }
+	[[nodiscard]] bool empty() const { return count == 0; }
+	[[nodiscard]] SoaVectorSizeType bucket_count() const { return static_cast<SoaVectorSizeType>(slots.size()); }
+	[[nodiscard]] uint64_t memory_bytes() const { return slots.capacity() * sizeof(Slot); }
+
+	// Walks every slot, nothing is counted while the map is used.
+	[[nodiscard]] ProbeStats probe_stats() const {
+		ProbeStats stats;
+		for (SoaVectorSizeType i = 0; i < slots.size(); ++i) {
+			if (slots[i].first != EMPTY_KEY) {
+				const uint64_t distance = probe_distance(i);
+				stats.entries++;
+				stats.total_probe_length += distance;
+				stats.max_probe_length = std::max(stats.max_probe_length, distance);
+			}
+		}
+		return stats;
+	}
+};
+
+} // namespace soa
@@ -22,3 +22,9 @@
 #define FOR_EACH_TWO_ARGS(macro, ...) __VA_OPT__(EXPAND(FOR_EACH_HELPER_TWO_ARGS(macro, __VA_ARGS__)))
 #define FOR_EACH_HELPER_TWO_ARGS(macro, a1, a2, ...) macro(a1, a2) __VA_OPT__(FOR_EACH_AGAIN_TWO_ARGS PARENS(macro, __VA_ARGS__))
 #define FOR_EACH_AGAIN_TWO_ARGS() FOR_EACH_HELPER_TWO_ARGS
+
+// Same as FOR_EACH_TWO_ARGS but separates each expansion with a comma, for generating parameter and argument lists.
+// Example Usage: void f(FOR_EACH_TWO_ARGS_LIST(F, X, __VA_OPT__(__VA_ARGS__,)))
+#define FOR_EACH_TWO_ARGS_LIST(macro, ...) __VA_OPT__(EXPAND(FOR_EACH_HELPER_TWO_ARGS_LIST(macro, __VA_ARGS__)))
+#define FOR_EACH_HELPER_TWO_ARGS_LIST(macro, a1, a2, ...) macro(a1, a2) __VA_OPT__(, FOR_EACH_AGAIN_TWO_ARGS_LIST PARENS(macro, __VA_ARGS__))
+#define FOR_EACH_AGAIN_TWO_ARGS_LIST() FOR_EACH_HELPER_TWO_ARGS_LIST
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+// Every column in an SOA struct starts on a multiple of this many bytes. The default of 64 is a cache line (and an AVX-512 register), so column loops can use aligned vector loads
+// and the tail of one column never shares a cache line with the start of the next one when different threads write them. Set it to 32 before including soa.hpp to trade some of that
+// for less padding when only AVX2 loads are needed. Must be a power of 2.
+#ifndef SOA_COLUMN_ALIGNMENT
+#define SOA_COLUMN_ALIGNMENT 64
+#endif
+
+static_assert((SOA_COLUMN_ALIGNMENT & (SOA_COLUMN_ALIGNMENT - 1)) == 0, "SOA_COLUMN_ALIGNMENT must be a power of 2");
+
+using SoaVectorSizeType = uint32_t;
+
+namespace soa {
+
+constexpr uint64_t align_up(uint64_t p_value, uint64_t p_alignment) { return (p_value + p_alignment - 1) & ~(p_alignment - 1); }
+
+// Alignment of the start of a column of T's.
+template <typename T> constexpr uint64_t column_alignment() { return std::max<uint64_t>(SOA_COLUMN_ALIGNMENT, alignof(T)); }
+
+// FNV-1a of "type name", stored with each column in files and streams to check that they were written by a struct with the same member names and types.
+constexpr uint64_t column_name_hash(std::string_view p_name) {
+	uint64_t hash = 0xcbf29ce484222325;
+	for (const char c : p_name) {
+		hash = (hash ^ uint64_t(uint8_t(c))) * 0x100000001b3;
+	}
+	return hash;
+}
+
+// Allocates the memory block that holds every column of an SOA struct. Free it with free().
+inline void *aligned_malloc(uint64_t p_alignment, uint64_t p_size) {
+	// aligned_alloc needs the size to be a multiple of the alignment.
+	return std::aligned_alloc(p_alignment, align_up(std::max<uint64_t>(p_size, 1), p_alignment));
+}
+
+// Same as aligned_malloc but zeroes the memory.
+inline void *aligned_calloc(uint64_t p_alignment, uint64_t p_size) {
+	void *data = aligned_malloc(p_alignment, p_size);
+	if (data != nullptr) {
+		memset(data, 0, align_up(std::max<uint64_t>(p_size, 1), p_alignment));
+	}
+	return data;
+}
+
+} // namespace soa
@@ -0,0 +1,338 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SOA_HAS_VIRTUAL_RESERVE
+#ifdef MADV_HUGEPAGE
+#define SOA_HAS_HUGE_PAGES
+#endif
+#endif
+
+// Allocator policy used for the column block of MutableSOA, SparseSOA, DynamicSOA, FixedSizeSOA and TiledSOA. Define it before including soa.hpp to change the default for every
+// SOA struct, or add `using soa_allocator_policy = soa::PoolAllocator<>;` (or any of the other policies) inside a single struct to change it for only that struct.
+// A policy is any type with static allocate(alignment, size) and deallocate(data, alignment, size) functions, deallocate gets the same alignment and size that allocate got.
+#ifndef SOA_ALLOCATOR_POLICY
+#define SOA_ALLOCATOR_POLICY soa::MallocAllocator
+#endif
+
+namespace soa {
+
+// aligned_alloc and free, what every SOA used before allocator policies.
+struct MallocAllocator {
+	static void *allocate(uint64_t p_alignment, uint64_t p_size) { return aligned_malloc(p_alignment, p_size); }
+	static void deallocate(void *p_data, uint64_t /*p_alignment*/, uint64_t /*p_size*/) { free(p_data); }
+};
+
+// Bump allocator for tables that all die at the same time, like the ones made and thrown away every frame. allocate is a pointer bump into BlockSize byte blocks and deallocate
+// does nothing, reset() makes every block reusable at once. Every thread has its own arena for each Tag so they never lock, use a different Tag for every group of tables that is
+// reset together. Every table using the arena must be destroyed or cleared before reset().
+template <typename Tag = void, uint64_t BlockSize = uint64_t(1) << 20> class ArenaAllocator {
+	struct Arena {
+		std::vector<void *> blocks;
+		std::vector<uint64_t> block_sizes;
+		// Block that allocations are bumped from, blocks before it are full.
+		uint64_t current = 0;
+		uint64_t offset = 0;
+		uint64_t system_allocations = 0;
+
+		~Arena() {
+			for (void *block : blocks) {
+				free(block);
+			}
+		}
+	};
+
+	static Arena &arena() {
+		thread_local Arena thread_arena;
+		return thread_arena;
+	}
+
+public:
+	static void *allocate(uint64_t p_alignment, uint64_t p_size) {
+		Arena &state = arena();
+		while (state.current < state.blocks.size()) {
+			// The address is aligned instead of the offset, a block that was made for a smaller alignment can be reused for a bigger one after reset().
+			const uint64_t block_address = reinterpret_cast<uint64_t>(state.blocks[state.current]);
+			const uint64_t start = align_up(block_address + state.offset, p_alignment) - block_address;
+			if (start + p_size <= state.block_sizes[state.current]) {
+				state.offset = start + p_size;
+				return static_cast<std::byte *>(state.blocks[state.current]) + start;
+			}
+			state.current++;
+			state.offset = 0;
+		}
+		// New blocks are at least page aligned and start with this allocation.
+		const uint64_t block_alignment = std::max<uint64_t>(p_alignment, 4096);
+		const uint64_t block_size = align_up(std::max(BlockSize, p_size), block_alignment);
+		void *block = aligned_malloc(block_alignment, block_size);
+		if (block == nullptr) {
+			throw std::bad_alloc();
+		}
+		state.blocks.push_back(block);
+		state.block_sizes.push_back(block_size);
+		state.system_allocations++;
+		state.current = state.blocks.size() - 1;
+		state.offset = p_size;
+		return block;
+	}
+
+	static void deallocate(void * /*p_data*/, uint64_t /*p_alignment*/, uint64_t /*p_size*/) {}
+
+	// Makes every block of this thread's arena reusable without freeing them.
+	static void reset() {
+		arena().current = 0;
+		arena().offset = 0;
+	}
+
+	// Frees every block of this thread's arena.
+	static void release() {
+		Arena &state = arena();
+		for (void *block : state.blocks) {
+			free(block);
+		}
+		state.blocks.clear();
+		state.block_sizes.clear();
+		reset();
+	}
+
+	// Number of blocks this thread's arena got from aligned_alloc.
+	[[nodiscard]] static uint64_t system_allocations() { return arena().system_allocations; }
+
+	// Bytes this thread's arena got from the system.
+	[[nodiscard]] static uint64_t reserved_bytes() {
+		uint64_t total = 0;
+		for (const uint64_t size : arena().block_sizes) {
+			total += size;
+		}
+		return total;
+	}
+};
+
+// Keeps freed blocks of up to MaxPooledSize bytes in free lists, one per power of 2 size class, so creating and destroying many small tables doesn't go through malloc every time.
+// Bigger blocks and alignments over SOA_COLUMN_ALIGNMENT go straight to aligned_alloc. The free lists are per thread and per Tag, a block freed on another thread than the one that
+// allocated it just goes to that thread's lists. release() frees every cached block of the calling thread.
+template <typename Tag = void, uint64_t MaxPooledSize = uint64_t(1) << 16> class PoolAllocator {
+	static_assert(std::has_single_bit(MaxPooledSize) and MaxPooledSize >= SOA_COLUMN_ALIGNMENT, "PoolAllocator max pooled size has to be a power of 2");
+
+	static constexpr uint64_t min_class_size = std::max<uint64_t>(SOA_COLUMN_ALIGNMENT, sizeof(void *));
+	static constexpr uint32_t class_count = uint32_t(std::countr_zero(MaxPooledSize) - std::countr_zero(min_class_size)) + 1;
+
+	struct Pool {
+		// The first bytes of a free block point to the next free block of the same class.
+		std::array<void *, class_count> free_lists{};
+		uint64_t system_allocations = 0;
+
+		~Pool() {
+			for (void *block : free_lists) {
+				while (block != nullptr) {
+					void *next = *static_cast<void **>(block);
+					free(block);
+					block = next;
+				}
+			}
+		}
+	};
+
+	static Pool &pool() {
+		thread_local Pool thread_pool;
+		return thread_pool;
+	}
+
+	static uint32_t size_class(uint64_t p_size) { return uint32_t(std::countr_zero(std::bit_ceil(std::max(p_size, min_class_size))) - std::countr_zero(min_class_size)); }
+
+	static bool pooled(uint64_t p_alignment, uint64_t p_size) { return p_size <= MaxPooledSize and p_alignment <= SOA_COLUMN_ALIGNMENT; }
+
+public:
+	static void *allocate(uint64_t p_alignment, uint64_t p_size) {
+		if (!pooled(p_alignment, p_size)) {
+			return aligned_malloc(p_alignment, p_size);
+		}
+		const uint32_t index = size_class(p_size);
+		void *&free_list = pool().free_lists[index];
+		if (free_list != nullptr) {
+			void *block = free_list;
+			free_list = *static_cast<void **>(block);
+			return block;
+		}
+		pool().system_allocations++;
+		return aligned_malloc(SOA_COLUMN_ALIGNMENT, min_class_size << index);
+	}
+
+	static void deallocate(void *p_data, uint64_t p_alignment, uint64_t p_size) {
+		if (p_data == nullptr) {
+			return;
+		}
+		if (!pooled(p_alignment, p_size)) {
+			free(p_data);
+			return;
+		}
+		void *&free_list = pool().free_lists[size_class(p_size)];
+		*static_cast<void **>(p_data) = free_list;
+		free_list = p_data;
+	}
+
+	// Number of pooled blocks this thread had to get from aligned_alloc because their free list was empty.
+	[[nodiscard]] static uint64_t system_allocations() { return pool().system_allocations; }
+
+	// Frees every cached block of this thread's pool.
+	static void release() {
+		for (void *&block : pool().free_lists) {
+			while (block != nullptr) {
+				void *next = *static_cast<void **>(block);
+				free(block);
+				block = next;
+			}
+		}
+	}
+};
+
+// Maps blocks of at least Threshold bytes straight from the OS on 2 MB boundaries and asks for transparent huge pages with madvise(MADV_HUGEPAGE), so a multi GB table needs 512
+// times fewer TLB entries than with 4 KB pages. Smaller blocks and systems without MADV_HUGEPAGE use aligned_alloc. Throws std::bad_alloc if the mapping fails.
+template <uint64_t Threshold = uint64_t(1) << 21> struct HugePageAllocator {
+	static constexpr uint64_t huge_page_size = uint64_t(1) << 21;
+
+	static void *allocate(uint64_t p_alignment, uint64_t p_size) {
+#ifdef SOA_HAS_HUGE_PAGES
+		if (p_size >= Threshold and p_alignment <= huge_page_size) {
+			// Map an extra huge page so the block can start on a huge page boundary, then give back the parts before and after it.
+			const uint64_t size = align_up(p_size, huge_page_size);
+			void *mapping = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mapping == MAP_FAILED) {
+				throw std::bad_alloc();
+			}
+			const uint64_t address = uint64_t(reinterpret_cast<uintptr_t>(mapping));
+			const uint64_t start = align_up(address, huge_page_size);
+			if (start != address) {
+				munmap(mapping, start - address);
+			}
+			if (start + size != address + size + huge_page_size) {
+				munmap(reinterpret_cast<void *>(uintptr_t(start + size)), address + huge_page_size - start);
+			}
+			void *data = reinterpret_cast<void *>(uintptr_t(start));
+			madvise(data, size, MADV_HUGEPAGE);
+			return data;
+		}
+#endif
+		return aligned_malloc(p_alignment, p_size);
+	}
+
+	static void deallocate(void *p_data, uint64_t p_alignment, uint64_t p_size) {
+#ifdef SOA_HAS_HUGE_PAGES
+		if (p_data != nullptr and p_size >= Threshold and p_alignment <= huge_page_size) {
+			munmap(p_data, align_up(p_size, huge_page_size));
+			return;
+		}
+#endif
+		free(p_data);
+	}
+};
+
+// Reserves address space for MaxRows rows of every column up front with mmap(PROT_NONE) and only makes pages readable and writable with mprotect once the capacity reaches
+// them, so DynamicSOA, MutableSOA and SparseSOA never move a column when they grow. Growing costs only the new pages and ptr(), iterators and spans stay valid until clear().
+// Shrinking gives the pages past the new capacity back to the OS. Only address space is reserved, so MaxRows can be far more rows than fit in RAM. The capacity stops at
+// MaxRows and pushing to a table with MaxRows rows throws std::length_error. Systems without mmap allocate every reserved row up front instead. FixedSizeSOA and TiledSOA
+// can't use it.
+template <SoaVectorSizeType MaxRows> struct VirtualReserveAllocator {
+	static constexpr SoaVectorSizeType max_rows = MaxRows;
+
+	[[nodiscard]] static uint64_t page_size() {
+#ifdef SOA_HAS_VIRTUAL_RESERVE
+		static const uint64_t size = uint64_t(sysconf(_SC_PAGESIZE));
+		return size;
+#else
+		return 4096;
+#endif
+	}
+
+	static void *allocate(uint64_t p_alignment, uint64_t p_size) {
+#ifdef SOA_HAS_VIRTUAL_RESERVE
+		// Columns with an alignment over a page need the extra space to start the block on it, the parts before and after it are given back.
+		const uint64_t extra = p_alignment > page_size() ? p_alignment : 0;
+		void *mapping = mmap(nullptr, p_size + extra, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (mapping == MAP_FAILED) {
+			throw std::bad_alloc();
+		}
+		const uint64_t address = uint64_t(reinterpret_cast<uintptr_t>(mapping));
+		const uint64_t start = align_up(address, std::max(p_alignment, page_size()));
+		if (start != address) {
+			munmap(mapping, start - address);
+		}
+		const uint64_t end = align_up(start + p_size, page_size());
+		if (end < address + p_size + extra) {
+			munmap(reinterpret_cast<void *>(uintptr_t(end)), address + p_size + extra - end);
+		}
+		return reinterpret_cast<void *>(uintptr_t(start));
+#else
+		void *data = aligned_malloc(p_alignment, p_size);
+		if (data == nullptr) {
+			throw std::bad_alloc();
+		}
+		return data;
+#endif
+	}
+
+	static void deallocate(void *p_data, uint64_t /*p_alignment*/, uint64_t p_size) {
+#ifdef SOA_HAS_VIRTUAL_RESERVE
+		if (p_data != nullptr) {
+			munmap(p_data, align_up(p_size, page_size()));
+		}
+#else
+		free(p_data);
+#endif
+	}
+
+	// Commits the pages of a column that start at a page boundary and hold bytes [p_old_size, p_new_size) of it, or decommits the ones past p_new_size if it's smaller.
+	static void commit(void *p_column, uint64_t p_old_size, uint64_t p_new_size) {
+#ifdef SOA_HAS_VIRTUAL_RESERVE
+		std::byte *column = static_cast<std::byte *>(p_column);
+		const uint64_t old_end = align_up(p_old_size, page_size());
+		const uint64_t new_end = align_up(p_new_size, page_size());
+		if (new_end > old_end) {
+			if (mprotect(column + old_end, new_end - old_end, PROT_READ | PROT_WRITE) != 0) {
+				throw std::bad_alloc();
+			}
+		} else if (new_end < old_end) {
+			madvise(column + new_end, old_end - new_end, MADV_DONTNEED);
+			mprotect(column + new_end, old_end - new_end, PROT_NONE);
+		}
+#else
+		(void)p_column;
+		(void)p_old_size;
+		(void)p_new_size;
+#endif
+	}
+};
+
+// Allocator policies that reserve rows instead of handing out a new block every time the capacity changes.
+template <typename P>
+concept reserves_rows = requires(void *p_column, uint64_t p_size) {
+	{ P::max_rows } -> std::convertible_to<SoaVectorSizeType>;
+	P::page_size();
+	P::commit(p_column, p_size, p_size);
+};
+
+// Picks T::soa_allocator_policy if the SOA struct declares one and SOA_ALLOCATOR_POLICY otherwise.
+template <typename T> struct allocator_policy_of {
+	using type = SOA_ALLOCATOR_POLICY;
+};
+
+template <typename T>
+	requires requires { typename T::soa_allocator_policy; }
+struct allocator_policy_of<T> {
+	using type = typename T::soa_allocator_policy;
+};
+
+} // namespace soa
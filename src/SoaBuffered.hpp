@@ -0,0 +1,140 @@
+#pragma once
+
+#include "SoaDirty.hpp"
+#include "SoaParallel.hpp"
+#include "SoaVector.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace soa {
+
+// Keeps Buffers copies of a SOA struct so one writer thread can change the back buffer while any number of reader threads read the last published one without locks.
+// publish() makes the back buffer the front one with a single atomic store and then takes the oldest buffer as the new back buffer. Before that buffer is written to again
+// publish() waits until every reader that could still see it is done (epoch based reclamation, readers pin the epoch they started in) and copies only the rows that were
+// dirtied since that buffer was last the back one, so S has to track dirty rows (see TrackDirty). With more buffers a publish rarely has to wait for a slow reader, with 2
+// it waits for the readers of the buffer that was just replaced, so the writer thread must not hold a Snapshot over a publish() then.
+// Readers claim one of MaxReaders slots with reader() and keep it, every read() on it returns a Snapshot that stays valid and unchanged until it's destroyed.
+// Everything except reader() and read() is for the writer thread only and direct writes to back() have to be marked with mark_dirty().
+template <typename S, uint32_t Buffers = 2, uint32_t MaxReaders = 64> class BufferedSOA {
+	static_assert(Buffers >= 2, "BufferedSOA needs at least 2 buffers");
+	static_assert(tracks_dirty_rows<S>, "BufferedSOA needs a SOA struct with a TrackDirty soa_dirty_policy");
+
+	// Slot values besides the pinned epoch.
+	static constexpr uint64_t slot_free = std::numeric_limits<uint64_t>::max();
+	static constexpr uint64_t slot_idle = 0;
+
+	// Own cache line each so readers don't slow each other down.
+	struct alignas(cache_line_size) ReaderSlot {
+		std::atomic<uint64_t> epoch = slot_free;
+	};
+
+	std::array<S, Buffers> buffers;
+	std::atomic<uint32_t> front_index = 0;
+	// Goes up by one every publish, epoch 0 is slot_idle.
+	std::atomic<uint64_t> epoch = 1;
+	std::array<ReaderSlot, MaxReaders> reader_slots;
+	// First epoch in which no new reader can get the buffer, readers that pinned an older epoch might still be using it.
+	std::array<uint64_t, Buffers> retired_epoch{};
+	uint32_t back_index = 1;
+
+	void wait_for_readers(uint64_t p_retired_epoch) const {
+		for (const ReaderSlot &slot : reader_slots) {
+			uint64_t pinned = slot.epoch.load();
+			while (pinned != slot_free and pinned != slot_idle and pinned < p_retired_epoch) {
+				std::this_thread::yield();
+				pinned = slot.epoch.load();
+			}
+		}
+	}
+
+public:
+	class Reader;
+
+	// A consistent view of the front buffer at the time of read(), the writer won't reuse it until this is destroyed.
+	class Snapshot {
+		friend class Reader;
+
+		const S &soa;
+		std::atomic<uint64_t> &slot_epoch;
+
+		Snapshot(const S &p_soa, std::atomic<uint64_t> &r_slot_epoch) :
+				soa(p_soa), slot_epoch(r_slot_epoch) {}
+
+	public:
+		Snapshot(const Snapshot &) = delete;
+		Snapshot &operator=(const Snapshot &) = delete;
+		~Snapshot() { slot_epoch.store(slot_idle, std::memory_order_release); }
+
+		[[nodiscard]] const S &operator*() const { return soa; }
+		[[nodiscard]] const S *operator->() const { return &soa; }
+	};
+
+	// One reader slot, a reader thread keeps it for as long as it reads and only has one Snapshot from it at a time.
+	class Reader {
+		friend class BufferedSOA;
+
+		BufferedSOA *owner;
+		ReaderSlot *slot;
+
+		Reader(BufferedSOA &r_owner, ReaderSlot &r_slot) :
+				owner(&r_owner), slot(&r_slot) {}
+
+	public:
+		Reader(const Reader &) = delete;
+		Reader &operator=(const Reader &) = delete;
+		~Reader() { slot->epoch.store(slot_free, std::memory_order_release); }
+
+		// Pins the current epoch before loading the front index, a publish that doesn't see the pin stored the new front index before this loads it.
+		[[nodiscard]] Snapshot read() {
+			slot->epoch.store(owner->epoch.load());
+			return Snapshot(owner->buffers[owner->front_index.load()], slot->epoch);
+		}
+	};
+
+	BufferedSOA() = default;
+	BufferedSOA(const BufferedSOA &) = delete;
+	BufferedSOA &operator=(const BufferedSOA &) = delete;
+
+	// Claims a free reader slot, throws std::runtime_error if all MaxReaders of them are taken.
+	[[nodiscard]] Reader reader() {
+		for (ReaderSlot &slot : reader_slots) {
+			uint64_t expected = slot_free;
+			if (slot.epoch.compare_exchange_strong(expected, slot_idle)) {
+				return Reader(*this, slot);
+			}
+		}
+		throw std::runtime_error("soa::BufferedSOA: all reader slots are taken");
+	}
+
+	// The buffer the writer changes, it has every change up to the last publish().
+	[[nodiscard]] S &back() { return buffers[back_index]; }
+	[[nodiscard]] const S &back() const { return buffers[back_index]; }
+
+	// Makes every change to back() visible to readers that call read() after this and brings the next back buffer up to date with it.
+	void publish() {
+		const uint32_t published = back_index;
+		const uint32_t retired = front_index.load(std::memory_order_relaxed);
+		S &published_soa = buffers[published];
+		// Every other buffer is now missing the rows changed in this one, their dirty rows are the ones to copy when they become the back buffer again.
+		for (uint32_t i = 0; i < Buffers; ++i) {
+			if (i != published) {
+				buffers[i].merge_dirty(published_soa);
+			}
+		}
+		published_soa.clear_dirty();
+
+		front_index.store(published);
+		retired_epoch[retired] = epoch.fetch_add(1) + 1;
+
+		back_index = (published + 1) % Buffers;
+		wait_for_readers(retired_epoch[back_index]);
+		buffers[back_index].pull_dirty(published_soa);
+	}
+};
+
+} // namespace soa
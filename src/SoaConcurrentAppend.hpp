@@ -0,0 +1,182 @@
+#pragma once
+
+#include "SoaParallel.hpp"
+#include "SoaVector.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace soa {
+
+// Lets any number of producer threads append rows to a DynamicSOA struct S without a lock while one consumer thread moves them into a normal S with drain_into().
+// Producers reserve a range of rows with one atomic fetch_add (reserve_rows), construct them in place and publish them, they never wait for each other. Rows live in segments
+// of SegmentRows rows that are never reallocated, so growing never moves a row another producer is still writing. Publishing stores the number of rows in the batch at its
+// first row (one store per segment the batch is in) and drain_into follows those counts from the last drained row, so the consumer only ever takes a gap free prefix of fully
+// written rows and a batch published early waits for the ones reserved before it.
+// The consumer reuses a segment once every row in it was drained. Producers can be at most MaxSegments segments ahead of the consumer, past that they wait for it, so the
+// consumer must not be one of the producers.
+template <typename S, SoaVectorSizeType SegmentRows = 16384, uint32_t MaxSegments = 1024> class ConcurrentAppendSOA {
+	static_assert(std::has_single_bit(SegmentRows), "ConcurrentAppendSOA segment rows has to be a power of 2");
+
+	struct Segment {
+		S soa;
+		// ready[row] is the number of rows starting at row that were published together, 0 until they are.
+		std::unique_ptr<std::atomic<SoaVectorSizeType>[]> ready = std::make_unique<std::atomic<SoaVectorSizeType>[]>(SegmentRows);
+		// The segment number that is using this one right now, goes up by MaxSegments every time the consumer empties it.
+		std::atomic<uint64_t> number = 0;
+	};
+
+	std::array<std::atomic<Segment *>, MaxSegments> segments{};
+	// Own cache line so producers reserving rows don't slow down the consumer.
+	alignas(cache_line_size) std::atomic<uint64_t> reserved_rows = 0;
+	alignas(cache_line_size) uint64_t drained_rows = 0;
+
+	// Waits until the segment slot is free for p_number, creating the segment the first time the slot is used.
+	Segment &segment_for(uint64_t p_number) {
+		std::atomic<Segment *> &slot = segments[p_number % MaxSegments];
+		Segment *segment = slot.load(std::memory_order_acquire);
+		if (segment == nullptr) {
+			Segment *created = new Segment;
+			created->soa.reserve(SegmentRows);
+			created->number.store(p_number % MaxSegments, std::memory_order_relaxed);
+			if (slot.compare_exchange_strong(segment, created, std::memory_order_acq_rel)) {
+				segment = created;
+			} else {
+				delete created;
+			}
+		}
+		while (segment->number.load(std::memory_order_acquire) != p_number) {
+			std::this_thread::yield();
+		}
+		return *segment;
+	}
+
+public:
+	// Rows reserved by one producer. Fill them in order with emplace_row, the destructor publishes them and default constructs any row that wasn't written. Rows
+	// reserved after this one aren't drained until it's published, so don't keep it around.
+	class Batch {
+		friend class ConcurrentAppendSOA;
+
+		ConcurrentAppendSOA *owner;
+		uint64_t first;
+		uint64_t count;
+		uint64_t written = 0;
+		// First row that isn't published yet, every row from it to the next row to write is in segment.
+		uint64_t piece_first;
+		Segment *segment = nullptr;
+
+		Batch(ConcurrentAppendSOA &r_owner, uint64_t p_first, uint64_t p_count) :
+				owner(&r_owner), first(p_first), count(p_count), piece_first(p_first) {}
+
+		void publish_piece(uint64_t p_end) {
+			if (segment != nullptr and p_end > piece_first) {
+				segment->ready[piece_first % SegmentRows].store(SoaVectorSizeType(p_end - piece_first), std::memory_order_release);
+			}
+			piece_first = p_end;
+		}
+
+		S &next_row_segment() {
+			const uint64_t row = first + written;
+			if (segment == nullptr or row % SegmentRows == 0) {
+				publish_piece(row);
+				segment = &owner->segment_for(row / SegmentRows);
+			}
+			return segment->soa;
+		}
+
+	public:
+		Batch(const Batch &) = delete;
+		Batch &operator=(const Batch &) = delete;
+
+		~Batch() {
+			for (; written < count; ++written) {
+				next_row_segment().emplace_default_row_at(SoaVectorSizeType((first + written) % SegmentRows));
+			}
+			publish_piece(first + count);
+		}
+
+		// Row number of the first row, counting every row ever appended.
+		[[nodiscard]] uint64_t first_row() const { return first; }
+
+		// Constructs the next row of the batch from one argument per member, throws std::out_of_range if every row was already written.
+		template <typename... Args> void emplace_row(Args &&...p_args) {
+			if (written == count) {
+				throw std::out_of_range("soa::ConcurrentAppendSOA::Batch::emplace_row: every reserved row was already written");
+			}
+			next_row_segment().emplace_row_at(SoaVectorSizeType((first + written) % SegmentRows), std::forward<Args>(p_args)...);
+			written++;
+		}
+	};
+
+	ConcurrentAppendSOA() = default;
+	ConcurrentAppendSOA(const ConcurrentAppendSOA &) = delete;
+	ConcurrentAppendSOA &operator=(const ConcurrentAppendSOA &) = delete;
+
+	// Destroys the rows that were published but not drained, no producer can be running anymore.
+	~ConcurrentAppendSOA() {
+		S discarded;
+		drain_into(discarded);
+		for (std::atomic<Segment *> &slot : segments) {
+			delete slot.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Producer side, thread safe. Reserves p_count rows after every row reserved before.
+	[[nodiscard]] Batch reserve_rows(uint64_t p_count) { return Batch(*this, reserved_rows.fetch_add(p_count, std::memory_order_relaxed), p_count); }
+
+	// Producer side, thread safe. Appends one row from one argument per member and publishes it, returns its row number.
+	template <typename... Args> uint64_t push_row(Args &&...p_args) {
+		Batch batch = reserve_rows(1);
+		batch.emplace_row(std::forward<Args>(p_args)...);
+		return batch.first_row();
+	}
+
+	// Consumer side, only from one thread at a time. Number of rows drained so far.
+	[[nodiscard]] uint64_t drained_size() const { return drained_rows; }
+
+	// Consumer side, only from one thread at a time. Moves every published row after the last drained one up to the first one that isn't published yet to the end of
+	// r_target, in the order they were reserved, and returns how many that were.
+	uint64_t drain_into(S &r_target) {
+		const uint64_t drained_before = drained_rows;
+		while (true) {
+			const uint64_t number = drained_rows / SegmentRows;
+			Segment *segment = segments[number % MaxSegments].load(std::memory_order_acquire);
+			if (segment == nullptr or segment->number.load(std::memory_order_acquire) != number) {
+				break;
+			}
+			const SoaVectorSizeType offset = SoaVectorSizeType(drained_rows % SegmentRows);
+			SoaVectorSizeType end = offset;
+			while (end < SegmentRows) {
+				const SoaVectorSizeType rows = segment->ready[end].load(std::memory_order_acquire);
+				if (rows == 0) {
+					break;
+				}
+				end += rows;
+			}
+			if (end == offset) {
+				break;
+			}
+			segment->soa.commit_rows(end - offset);
+			r_target.append_rows(segment->soa, offset, end - offset);
+			drained_rows += end - offset;
+			if (end != SegmentRows) {
+				break;
+			}
+			segment->soa.clear();
+			segment->soa.reserve(SegmentRows);
+			for (SoaVectorSizeType row = 0; row < SegmentRows; ++row) {
+				segment->ready[row].store(0, std::memory_order_relaxed);
+			}
+			segment->number.store(number + MaxSegments, std::memory_order_release);
+		}
+		return drained_rows - drained_before;
+	}
+};
+
+} // namespace soa
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "SoaSerialize.hpp"
+#include "SoaSimd.hpp"
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Dirty tracking policy used by MutableSOA, SparseSOA, DynamicSOA, MappedSOA and FixedSizeSOA. Define it before including soa.hpp to change the default for every SOA struct, or
+// add `using soa_dirty_policy = soa::TrackDirty<>;` inside a single struct to only track that one.
+#ifndef SOA_DIRTY_POLICY
+#define SOA_DIRTY_POLICY soa::NoDirtyTracking
+#endif
+
+namespace soa {
+
+// Nothing is recorded, set_X and push_X cost the same as without dirty tracking.
+struct NoDirtyTracking {
+	static constexpr bool tracking = false;
+	static constexpr SoaVectorSizeType rows_per_bit = 1;
+};
+
+// Every column has a bitmask with 1 bit per RowsPerBit rows that set_X, push_X, push_row, erase, sort and load set for the rows they change. RowsPerBit = 1 tracks exact rows,
+// bigger blocks make the masks RowsPerBit times smaller and cheaper to clear at the cost of visiting the unchanged rows in a dirty block.
+template <SoaVectorSizeType RowsPerBit = 1> struct TrackDirty {
+	static_assert(std::has_single_bit(RowsPerBit), "TrackDirty rows per bit has to be a power of 2");
+
+	static constexpr bool tracking = true;
+	static constexpr SoaVectorSizeType rows_per_bit = RowsPerBit;
+};
+
+// Picks T::soa_dirty_policy if the SOA struct declares one and SOA_DIRTY_POLICY otherwise.
+template <typename T> struct dirty_policy_of {
+	using type = SOA_DIRTY_POLICY;
+};
+
+template <typename T>
+	requires requires { typename T::soa_dirty_policy; }
+struct dirty_policy_of<T> {
+	using type = typename T::soa_dirty_policy;
+};
+
+// Dependent is only there to delay static_asserts on this until the function template they are in is used.
+template <typename T, typename Dependent = void> constexpr bool tracks_dirty_rows = dirty_policy_of<T>::type::tracking;
+
+// The dirty bits of one column, bit i covers rows [i * rows_per_bit, (i + 1) * rows_per_bit). Grows when a bit past the end is set and keeps its memory when cleared.
+class DirtyMask {
+	simd::BitMask words;
+
+public:
+	void set(SoaVectorSizeType p_bit) {
+		if (p_bit / 64 >= words.size()) {
+			words.resize(p_bit / 64 + 1);
+		}
+		words[p_bit / 64] |= uint64_t(1) << (p_bit % 64);
+	}
+
+	// Sets the bits [p_first_bit, p_end_bit).
+	void set_range(SoaVectorSizeType p_first_bit, SoaVectorSizeType p_end_bit) {
+		if (p_first_bit >= p_end_bit) {
+			return;
+		}
+		if ((p_end_bit + 63) / 64 > words.size()) {
+			words.resize((p_end_bit + 63) / 64);
+		}
+		SoaVectorSizeType bit = p_first_bit;
+		for (; bit < p_end_bit and bit % 64 != 0; ++bit) {
+			words[bit / 64] |= uint64_t(1) << (bit % 64);
+		}
+		for (; p_end_bit - bit >= 64; bit += 64) {
+			words[bit / 64] = ~uint64_t(0);
+		}
+		for (; bit < p_end_bit; ++bit) {
+			words[bit / 64] |= uint64_t(1) << (bit % 64);
+		}
+	}
+
+	void merge(const DirtyMask &p_other) {
+		if (p_other.words.size() > words.size()) {
+			words.resize(p_other.words.size());
+		}
+		for (uint64_t i = 0; i < p_other.words.size(); ++i) {
+			words[i] |= p_other.words[i];
+		}
+	}
+
+	void clear() { std::ranges::fill(words, 0); }
+
+	[[nodiscard]] bool test(SoaVectorSizeType p_bit) const { return p_bit / 64 < words.size() and ((words[p_bit / 64] >> (p_bit % 64)) & 1); }
+
+	// Calls p_func(row) in order for every row below p_size that is in a set block.
+	template <typename Func> void for_each_row(SoaVectorSizeType p_rows_per_bit, SoaVectorSizeType p_size, Func &&p_func) const {
+		for (uint64_t word = 0; word < words.size(); ++word) {
+			for (uint64_t bits = words[word]; bits != 0; bits &= bits - 1) {
+				const uint64_t first = (word * 64 + uint64_t(std::countr_zero(bits))) * p_rows_per_bit;
+				if (first >= p_size) {
+					return;
+				}
+				const uint64_t end = std::min<uint64_t>(first + p_rows_per_bit, p_size);
+				for (uint64_t row = first; row < end; ++row) {
+					p_func(SoaVectorSizeType(row));
+				}
+			}
+		}
+	}
+};
+
+// Delta format written by export_delta and read by apply_delta: a header like the save() one with its own magic and then for every column its size, the number of dirty rows,
+// the dirty row indices (sorted so they delta encode to a few bits each) and their values, both written with write_column so they get the same encodings as save().
+constexpr uint32_t DELTA_MAGIC = 0x44414f53; // "SOAD" in little endian.
+
+inline void write_delta_header(std::ostream &p_stream, uint32_t p_column_count, SoaVectorSizeType p_rows) {
+	detail::write_value(p_stream, DELTA_MAGIC);
+	detail::write_value(p_stream, STREAM_VERSION);
+	detail::write_value(p_stream, p_column_count);
+	detail::write_value(p_stream, p_rows);
+}
+
+inline SoaVectorSizeType read_delta_header(std::istream &p_stream, uint32_t p_column_count) {
+	if (detail::read_value<uint32_t>(p_stream) != DELTA_MAGIC or detail::read_value<uint32_t>(p_stream) != STREAM_VERSION) {
+		throw std::runtime_error("soa::apply_delta: not a SOA delta or an unsupported version");
+	}
+	if (detail::read_value<uint32_t>(p_stream) != p_column_count) {
+		throw std::runtime_error("soa::apply_delta: the delta has a different number of columns");
+	}
+	return detail::read_value<SoaVectorSizeType>(p_stream);
+}
+
+// Writes p_size and p_value_of(row) for every row below p_size in a block set in p_dirty.
+template <typename T, typename Func>
+void write_delta_rows(std::ostream &p_stream, std::string_view p_name, const DirtyMask &p_dirty, SoaVectorSizeType p_rows_per_bit, SoaVectorSizeType p_size, Func &&p_value_of) {
+	std::vector<SoaVectorSizeType> rows;
+	p_dirty.for_each_row(p_rows_per_bit, p_size, [&](SoaVectorSizeType p_row) { rows.push_back(p_row); });
+	const SoaVectorSizeType count = SoaVectorSizeType(rows.size());
+	detail::UninitializedBuffer<T> values(count);
+	for (; values.constructed < count; ++values.constructed) {
+		new (values.data() + values.constructed) T(p_value_of(rows[values.constructed]));
+	}
+	detail::write_value(p_stream, p_size);
+	detail::write_value(p_stream, count);
+	write_column(p_stream, p_name, rows.data(), count);
+	write_column(p_stream, p_name, values.data(), count);
+}
+
+// Reads what write_delta_rows wrote and calls p_apply(row, T &&value) for each row in order. Returns the size that was written.
+template <typename T, typename Func> SoaVectorSizeType read_delta_rows(std::istream &p_stream, std::string_view p_name, Func &&p_apply) {
+	const SoaVectorSizeType size = detail::read_value<SoaVectorSizeType>(p_stream);
+	const SoaVectorSizeType count = detail::read_value<SoaVectorSizeType>(p_stream);
+	if (count > size) {
+		throw std::runtime_error("soa::apply_delta: corrupt delta");
+	}
+	std::vector<SoaVectorSizeType> rows(count);
+	detail::UninitializedBuffer<T> values(count);
+	if (read_column(p_stream, p_name, rows.data(), count) != count) {
+		throw std::runtime_error("soa::apply_delta: corrupt delta");
+	}
+	values.constructed = read_column(p_stream, p_name, values.data(), count);
+	if (values.constructed != count) {
+		throw std::runtime_error("soa::apply_delta: corrupt delta");
+	}
+	for (SoaVectorSizeType i = 0; i < count; ++i) {
+		if (rows[i] >= size or (i != 0 and rows[i] <= rows[i - 1])) {
+			throw std::runtime_error("soa::apply_delta: corrupt delta");
+		}
+	}
+	for (SoaVectorSizeType i = 0; i < count; ++i) {
+		p_apply(rows[i], std::move(values.data()[i]));
+	}
+	return size;
+}
+
+// Values a delta of a SoaVector<T> column is written with, the string columns (see SoaString.hpp) hand out views into the column so they are copied into std::string's.
+template <typename T> struct delta_value {
+	using type = typename SoaVector<T>::value_type;
+};
+template <typename T>
+	requires requires { typename SoaVector<T>::owning_value_type; }
+struct delta_value<T> {
+	using type = typename SoaVector<T>::owning_value_type;
+};
+
+template <typename T>
+void write_delta_column(std::ostream &p_stream, std::string_view p_name, const SoaVector<T> &p_column, const DirtyMask &p_dirty, SoaVectorSizeType p_rows_per_bit) {
+	using Value = typename delta_value<T>::type;
+	write_delta_rows<Value>(p_stream, p_name, p_dirty, p_rows_per_bit, p_column.size(),
+			[&](SoaVectorSizeType p_row) -> typename SoaVector<T>::const_reference { return p_column[p_row]; });
+}
+
+// Overwrites the changed rows of r_column, pushes the new ones and destroys the ones the exporter doesn't have anymore. r_column has to have room for p_capacity rows and the
+// rows the exporter had at its last clear_dirty(), every row past that is new so it's always in the delta.
+template <typename T> void read_delta_column(std::istream &p_stream, std::string_view p_name, SoaVector<T> &r_column, SoaVectorSizeType p_capacity) {
+	const SoaVectorSizeType old_size = r_column.size();
+	using Value = typename delta_value<T>::type;
+	const SoaVectorSizeType new_size = read_delta_rows<Value>(p_stream, p_name, [&](SoaVectorSizeType p_row, Value &&p_value) {
+		if (p_row < old_size) {
+			r_column[p_row] = std::move(p_value);
+		} else if (p_row == r_column.size() and p_row < p_capacity) {
+			r_column.emplace_soa_member(std::move(p_value));
+		} else {
+			throw std::runtime_error("soa::apply_delta: the delta skips rows the table doesn't have");
+		}
+	});
+	if (new_size > r_column.size()) {
+		throw std::runtime_error("soa::apply_delta: the table is missing rows the delta expects");
+	}
+	r_column.truncate_soa_member(new_size);
+}
+
+// Copies the rows of p_from that are set in p_dirty into r_column and makes it p_from's size, rows r_column doesn't have yet are copied even if they aren't set.
+// r_column has to have room for p_from.size() rows.
+template <typename T> void copy_dirty_column(SoaVector<T> &r_column, const SoaVector<T> &p_from, const DirtyMask &p_dirty, SoaVectorSizeType p_rows_per_bit) {
+	p_dirty.for_each_row(p_rows_per_bit, std::min(r_column.size(), p_from.size()), [&](SoaVectorSizeType p_row) { r_column[p_row] = p_from[p_row]; });
+	r_column.truncate_soa_member(p_from.size());
+	for (SoaVectorSizeType row = r_column.size(); row < p_from.size(); ++row) {
+		r_column.push_soa_member(p_from[row]);
+	}
+}
+
+} // namespace soa
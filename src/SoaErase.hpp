@@ -0,0 +1,110 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+#include "SoaSimd.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Erase policy used by MutableSOA. Define it before including soa.hpp to change the default for every MutableSOA struct, or add
+// `using soa_erase_policy = soa::TombstoneErase<>;` inside a single struct to change it for only that struct.
+#ifndef SOA_ERASE_POLICY
+#define SOA_ERASE_POLICY soa::ImmediateErase
+#endif
+
+namespace soa {
+
+// erase moves the last row into the erased one right away, the columns never have holes.
+struct ImmediateErase {
+	static constexpr bool tombstones = false;
+
+	// erase_batch compacts before returning.
+	static bool should_compact(SoaVectorSizeType /*p_tombstones*/, SoaVectorSizeType /*p_rows*/) { return true; }
+};
+
+// erase only marks the row as a tombstone and removes its entity id, the row stays in the columns until compact() runs. compact() runs on its own once at least
+// ThresholdPercent % of the rows (and at least MinTombstones rows) are tombstones. Until then rows(), where() and the columns still contain the tombstoned rows, use for_each_row
+// or is_tombstone to skip them.
+template <uint32_t ThresholdPercent = 25, uint32_t MinTombstones = 64> struct TombstoneErase {
+	static_assert(ThresholdPercent > 0 and ThresholdPercent <= 100, "TombstoneErase threshold is a percentage of the rows");
+
+	static constexpr bool tombstones = true;
+
+	static bool should_compact(SoaVectorSizeType p_tombstones, SoaVectorSizeType p_rows) {
+		return p_tombstones >= MinTombstones and uint64_t(p_tombstones) * 100 >= uint64_t(p_rows) * ThresholdPercent;
+	}
+};
+
+// Picks T::soa_erase_policy if the SOA struct declares one and SOA_ERASE_POLICY otherwise.
+template <typename T> struct erase_policy_of {
+	using type = SOA_ERASE_POLICY;
+};
+
+template <typename T>
+	requires requires { typename T::soa_erase_policy; }
+struct erase_policy_of<T> {
+	using type = typename T::soa_erase_policy;
+};
+
+// A row that has to move to fill an erased one while compacting.
+struct RowMove {
+	SoaVectorSizeType to;
+	SoaVectorSizeType from;
+};
+
+// Plans how to remove the rows set in p_erased from a table with p_size rows. Erased rows that are left below the new size are filled with the rows that are still alive after
+// it, last one first like erase does, so only as many rows move as there are holes and every column can be compacted with the same r_moves. Returns the new size.
+// p_erased can be shorter than p_size rows, the missing words count as 0.
+inline SoaVectorSizeType plan_compaction(const simd::BitMask &p_erased, SoaVectorSizeType p_size, std::vector<RowMove> &r_moves) {
+	r_moves.clear();
+	const auto erased_word = [&](uint64_t p_word) -> uint64_t {
+		if (p_word >= p_erased.size()) {
+			return 0;
+		}
+		const uint64_t bits_left = uint64_t(p_size) - p_word * 64;
+		return bits_left >= 64 ? p_erased[p_word] : p_erased[p_word] & ((uint64_t(1) << bits_left) - 1);
+	};
+
+	const uint64_t word_count = (uint64_t(p_size) + 63) / 64;
+	SoaVectorSizeType erased_count = 0;
+	for (uint64_t word = 0; word < word_count; ++word) {
+		erased_count += SoaVectorSizeType(std::popcount(erased_word(word)));
+	}
+	const SoaVectorSizeType new_size = p_size - erased_count;
+
+	// Holes are found going up from the start and alive rows going down from the end, both only ever look at each word once.
+	SoaVectorSizeType from = p_size;
+	for (uint64_t word = 0; word * 64 < new_size; ++word) {
+		uint64_t holes = erased_word(word);
+		while (holes != 0) {
+			const SoaVectorSizeType to = SoaVectorSizeType(word * 64 + uint64_t(std::countr_zero(holes)));
+			holes &= holes - 1;
+			if (to >= new_size) {
+				break;
+			}
+			do {
+				from--;
+			} while ((erased_word(from / 64) >> (from % 64)) & 1);
+			r_moves.push_back({ to, from });
+		}
+	}
+	return new_size;
+}
+
+// Calls p_func(row) for every row below p_size that isn't set in p_tombstones, 64 rows at a time.
+template <typename Func> void for_each_unset_row(const simd::BitMask &p_tombstones, SoaVectorSizeType p_size, Func &&p_func) {
+	for (uint64_t word = 0; word * 64 < p_size; ++word) {
+		uint64_t alive = word < p_tombstones.size() ? ~p_tombstones[word] : ~uint64_t(0);
+		const uint64_t bits_left = uint64_t(p_size) - word * 64;
+		if (bits_left < 64) {
+			alive &= (uint64_t(1) << bits_left) - 1;
+		}
+		while (alive != 0) {
+			p_func(SoaVectorSizeType(word * 64 + uint64_t(std::countr_zero(alive))));
+			alive &= alive - 1;
+		}
+	}
+}
+
+} // namespace soa
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+// Growth policy used by DynamicSOA, MutableSOA and SparseSOA when push_X runs out of capacity. Define it before including soa.hpp to change the default for every SOA struct, or add
+// `using soa_growth_policy = soa::PowerOfTwoGrowth<>;` (or any of the other policies) inside a single struct to change it for only that struct.
+// A policy is any type with a static grow(current_capacity, required_capacity) function that returns a capacity >= required_capacity.
+#ifndef SOA_GROWTH_POLICY
+#define SOA_GROWTH_POLICY soa::GeometricGrowth<>
+#endif
+
+namespace soa {
+
+namespace detail {
+inline uint32_t clamp_capacity(uint64_t p_capacity) { return static_cast<uint32_t>(std::min<uint64_t>(p_capacity, UINT32_MAX)); }
+} // namespace detail
+
+// Multiplies the capacity by Numerator / Denominator (1.5 by default). Never grows to less than MinCapacity so small structs don't realloc on every push.
+template <uint32_t Numerator = 3, uint32_t Denominator = 2, uint32_t MinCapacity = 8> struct GeometricGrowth {
+	static_assert(Numerator > Denominator, "GeometricGrowth has to grow");
+
+	static uint32_t grow(uint32_t p_capacity, uint32_t p_required) {
+		const uint64_t capacity = uint64_t(p_capacity) * Numerator / Denominator;
+		return detail::clamp_capacity(std::max<uint64_t>({ capacity, p_required, MinCapacity }));
+	}
+};
+
+// Rounds the capacity up to the next power of 2.
+template <uint32_t MinCapacity = 8> struct PowerOfTwoGrowth {
+	static uint32_t grow(uint32_t /*p_capacity*/, uint32_t p_required) { return detail::clamp_capacity(std::bit_ceil(std::max<uint64_t>(p_required, MinCapacity))); }
+};
+
+// Grows by ChunkSize rows at a time. Wastes at most ChunkSize rows of memory but every growth copies the whole table, so only use it when the final size is roughly known.
+template <uint32_t ChunkSize> struct FixedChunkGrowth {
+	static_assert(ChunkSize > 0, "FixedChunkGrowth needs a chunk size");
+
+	static uint32_t grow(uint32_t /*p_capacity*/, uint32_t p_required) { return detail::clamp_capacity((uint64_t(p_required) + ChunkSize - 1) / ChunkSize * ChunkSize); }
+};
+
+// Picks T::soa_growth_policy if the SOA struct declares one and SOA_GROWTH_POLICY otherwise.
+template <typename T> struct growth_policy_of {
+	using type = SOA_GROWTH_POLICY;
+};
+
+template <typename T>
+	requires requires { typename T::soa_growth_policy; }
+struct growth_policy_of<T> {
+	using type = typename T::soa_growth_policy;
+};
+
+} // namespace soa
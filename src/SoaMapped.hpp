@@ -0,0 +1,169 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#define SOA_HAS_MMAP
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace soa {
+
+// File layout of a MappedSOA: a MappedHeader, then a MappedColumn for each member, padded to MappedHeader::header_size and then the columns at the same offsets from the end of
+// the header that the other macros use inside their memory block. Everything is stored in the native byte order.
+struct MappedHeader {
+	static constexpr uint64_t MAGIC = 0x31414f5350414d53; // "SMAPSOA1" in little endian.
+	static constexpr uint32_t VERSION = 1;
+
+	uint64_t magic;
+	uint32_t version;
+	uint32_t column_count;
+	uint64_t capacity;
+	uint64_t header_size;
+};
+
+struct MappedColumn {
+	uint64_t offset;
+	uint64_t count;
+	uint64_t name_hash;
+	uint32_t element_size;
+	uint32_t alignment;
+};
+
+// Size of the header + column table, rounded up so the first column starts on a page (and on its column_alignment).
+constexpr uint64_t mapped_header_size(uint64_t p_column_count, uint64_t p_block_alignment) {
+	return align_up(sizeof(MappedHeader) + sizeof(MappedColumn) * p_column_count, std::max<uint64_t>(4096, p_block_alignment));
+}
+
+#ifdef SOA_HAS_MMAP
+
+// Owns a file and a shared read/write mapping of all of it. Errors from the OS throw std::system_error.
+class MappedFile {
+	int fd = -1;
+	void *mapping = nullptr;
+	uint64_t mapped_size = 0;
+
+	static void throw_errno(const char *p_what) { throw std::system_error(errno, std::generic_category(), p_what); }
+
+	void map(uint64_t p_size) {
+		mapping = mmap(nullptr, p_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED) {
+			mapping = nullptr;
+			mapped_size = 0;
+			throw_errno("soa::MappedFile mmap");
+		}
+		mapped_size = p_size;
+	}
+
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	MappedFile(MappedFile &&p_other) noexcept :
+			fd(std::exchange(p_other.fd, -1)), mapping(std::exchange(p_other.mapping, nullptr)), mapped_size(std::exchange(p_other.mapped_size, 0)) {}
+	MappedFile &operator=(MappedFile &&p_other) noexcept {
+		if (this != &p_other) {
+			close();
+			fd = std::exchange(p_other.fd, -1);
+			mapping = std::exchange(p_other.mapping, nullptr);
+			mapped_size = std::exchange(p_other.mapped_size, 0);
+		}
+		return *this;
+	}
+	~MappedFile() { close(); }
+
+	// Opens (p_create = false) or creates/truncates (p_create = true) p_path and maps all of it. A new file is p_size bytes of zeros.
+	void open(const char *p_path, bool p_create, uint64_t p_size = 0) {
+		close();
+		fd = ::open(p_path, p_create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+		if (fd < 0) {
+			throw_errno("soa::MappedFile open");
+		}
+		uint64_t size = p_size;
+		if (p_create) {
+			if (ftruncate(fd, off_t(p_size)) != 0) {
+				throw_errno("soa::MappedFile ftruncate");
+			}
+		} else {
+			struct stat file_stat{};
+			if (fstat(fd, &file_stat) != 0) {
+				throw_errno("soa::MappedFile fstat");
+			}
+			size = uint64_t(file_stat.st_size);
+		}
+		if (size != 0) {
+			map(size);
+		}
+	}
+
+	// Grows or shrinks the file to p_size bytes and remaps it, pointers into the old mapping are invalid afterwards. New bytes are zero.
+	void resize(uint64_t p_size) {
+		const uint64_t old_size = mapped_size;
+		if (p_size == old_size) {
+			return;
+		}
+		if (p_size > old_size and ftruncate(fd, off_t(p_size)) != 0) {
+			throw_errno("soa::MappedFile ftruncate");
+		}
+#ifdef __linux__
+		if (mapping != nullptr) {
+			void *new_mapping = mremap(mapping, mapped_size, p_size, MREMAP_MAYMOVE);
+			if (new_mapping == MAP_FAILED) {
+				throw_errno("soa::MappedFile mremap");
+			}
+			mapping = new_mapping;
+			mapped_size = p_size;
+		} else {
+			map(p_size);
+		}
+#else
+		if (mapping != nullptr) {
+			munmap(mapping, mapped_size);
+			mapping = nullptr;
+		}
+		map(p_size);
+#endif
+		if (p_size < old_size and ftruncate(fd, off_t(p_size)) != 0) {
+			throw_errno("soa::MappedFile ftruncate");
+		}
+	}
+
+	// Writes the dirty pages back to the file. The OS does this on its own eventually, this is only needed to be sure they are on disk.
+	void sync() {
+		if (mapping != nullptr and msync(mapping, mapped_size, MS_SYNC) != 0) {
+			throw_errno("soa::MappedFile msync");
+		}
+	}
+
+	void close() {
+		if (mapping != nullptr) {
+			munmap(mapping, mapped_size);
+		}
+		if (fd >= 0) {
+			::close(fd);
+		}
+		fd = -1;
+		mapping = nullptr;
+		mapped_size = 0;
+	}
+
+	[[nodiscard]] bool is_open() const { return fd >= 0; }
+	[[nodiscard]] std::byte *data() const { return static_cast<std::byte *>(mapping); }
+	[[nodiscard]] uint64_t size() const { return mapped_size; }
+};
+
+#endif // SOA_HAS_MMAP
+
+} // namespace soa
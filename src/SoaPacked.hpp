@@ -0,0 +1,361 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+#include "SoaErase.hpp"
+#include "SoaSerialize.hpp"
+#include "SoaSimd.hpp"
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace soa {
+
+// Member type of a bit packed column: soa::PackedBool stores every row in 1 bit, soa::Packed<State, 2> an enum with values 0-3 in 2 bits, so a flag or small state column is 8x
+// (or 4x) smaller than a bool/uint8_t one and count/any/all/find_first/equal_mask check 64 bits of it at a time. The struct API uses the value type, push_x(true), get_x(i) and
+// soa.x.count(State::Done), but x[i] is a proxy and ptr() points at PackedWord's instead of values. Values are masked to Bits bits when they are stored.
+// Packed columns work in DynamicSOA, FixedSizeSOA, MutableSOA and SparseSOA, the macros that hand out raw column pointers (MappedSOA, TiledSOA, soa::Table, parallel_for) don't
+// support them.
+template <typename T, uint32_t Bits = 1> struct Packed {
+	static_assert(std::is_same_v<T, bool> or std::is_enum_v<T> or std::is_unsigned_v<T>, "soa::Packed columns hold bool, enum or unsigned integer values");
+	static_assert(std::has_single_bit(Bits) and Bits <= 32, "soa::Packed values have to be 1, 2, 4, 8, 16 or 32 bits so they never cross a word");
+	static_assert(!std::is_same_v<T, bool> or Bits == 1, "soa::Packed bool columns use 1 bit per value");
+};
+
+using PackedBool = Packed<bool, 1>;
+
+template <typename T, uint32_t Bits> constexpr bool is_encoded_column_v<Packed<T, Bits>> = true;
+
+// 64 / Bits values of a packed column, value i of the word in bits [i * Bits, (i + 1) * Bits).
+template <typename T, uint32_t Bits> struct PackedWord {
+	uint64_t bits;
+
+	static constexpr uint32_t values_per_word = 64 / Bits;
+
+	// Used by soa::permute_columns, row i gets the old row p_permutation[i].
+	template <typename Permutation> static void permute(PackedWord *p_words, const Permutation &p_permutation, std::vector<std::byte> &r_scratch) {
+		const uint64_t word_count = (p_permutation.size() + values_per_word - 1) / values_per_word;
+		r_scratch.assign(word_count * sizeof(uint64_t), std::byte(0));
+		uint64_t *scratch = reinterpret_cast<uint64_t *>(r_scratch.data());
+		constexpr uint64_t mask = (uint64_t(1) << Bits) - 1;
+		for (uint64_t i = 0; i < p_permutation.size(); ++i) {
+			const uint64_t from = p_permutation[i];
+			const uint64_t value = (p_words[from / values_per_word].bits >> (from % values_per_word * Bits)) & mask;
+			scratch[i / values_per_word] |= value << (i % values_per_word * Bits);
+		}
+		// The rows after the permuted ones keep their bits.
+		const uint64_t tail = p_permutation.size() % values_per_word;
+		if (tail != 0) {
+			const uint64_t kept = ~uint64_t(0) << (tail * Bits);
+			scratch[word_count - 1] |= p_words[word_count - 1].bits & kept;
+		}
+		memcpy(static_cast<void *>(p_words), scratch, word_count * sizeof(uint64_t));
+	}
+};
+
+template <typename T, uint32_t Bits> class SoaVector<Packed<T, Bits>> {
+public:
+	using value_type = T;
+	using word_type = PackedWord<T, Bits>;
+
+	static constexpr uint32_t values_per_word = word_type::values_per_word;
+
+private:
+	static constexpr uint64_t value_mask = (uint64_t(1) << Bits) - 1;
+	// Bit 0 of every value in a word, multiplying a value by it repeats the value in every lane.
+	static constexpr uint64_t lane_ones = ~uint64_t(0) / value_mask;
+	static constexpr uint64_t lane_high_bits = lane_ones << (Bits - 1);
+
+	SoaVectorSizeType row_count = 0;
+	word_type *data = nullptr;
+
+	static word_type *column_ptr(void *p_data, uint64_t p_memory_offset) { return reinterpret_cast<word_type *>(static_cast<std::byte *>(p_data) + p_memory_offset); }
+
+	static uint64_t encode(T p_value) {
+		if constexpr (std::is_enum_v<T>) {
+			return uint64_t(std::underlying_type_t<T>(p_value)) & value_mask;
+		} else {
+			return uint64_t(p_value) & value_mask;
+		}
+	}
+	static T decode(uint64_t p_bits) {
+		if constexpr (std::is_same_v<T, bool>) {
+			return p_bits != 0;
+		} else {
+			return static_cast<T>(p_bits);
+		}
+	}
+
+	[[nodiscard]] uint64_t get_bits(SoaVectorSizeType p_index) const { return (data[p_index / values_per_word].bits >> (p_index % values_per_word * Bits)) & value_mask; }
+	void set_bits(SoaVectorSizeType p_index, uint64_t p_bits) {
+		uint64_t &word = data[p_index / values_per_word].bits;
+		const uint32_t shift = p_index % values_per_word * Bits;
+		word = (word & ~(value_mask << shift)) | (p_bits << shift);
+	}
+
+	// The high bit of every value of p_word that equals p_value (SWAR zero lane test on word ^ p_value in every lane, it can't carry into the next lane).
+	static uint64_t equal_lanes(uint64_t p_word, T p_value) {
+		if constexpr (Bits == 1) {
+			return encode(p_value) != 0 ? p_word : ~p_word;
+		} else {
+			const uint64_t difference = p_word ^ (encode(p_value) * lane_ones);
+			const uint64_t low_bits = ~lane_high_bits;
+			return ~(((difference & low_bits) + low_bits) | difference) & lane_high_bits;
+		}
+	}
+	// Lane high bits of the values that exist in word p_word.
+	[[nodiscard]] uint64_t valid_lanes(uint64_t p_word) const {
+		const uint64_t values = std::min<uint64_t>(row_count - p_word * values_per_word, values_per_word);
+		const uint64_t bits = values == values_per_word ? ~uint64_t(0) : (uint64_t(1) << (values * Bits)) - 1;
+		return bits & lane_high_bits;
+	}
+	[[nodiscard]] uint64_t word_count() const { return words_for(row_count); }
+
+	// Calls p_func(word index, lane high bits of the values equal to p_value) for every word, the full words first in a loop the compiler can vectorize and then the last
+	// partial one.
+	template <typename Func> void for_each_equal_lanes(T p_value, Func &&p_func) const {
+		const uint64_t full_words = row_count / values_per_word;
+		for (uint64_t word = 0; word < full_words; ++word) {
+			p_func(word, equal_lanes(data[word].bits, p_value) & lane_high_bits);
+		}
+		if (full_words != word_count()) {
+			p_func(full_words, equal_lanes(data[full_words].bits, p_value) & valid_lanes(full_words));
+		}
+	}
+
+public:
+	// What x[i] returns, reads and writes one value inside its word.
+	class Reference {
+		word_type *word;
+		uint32_t shift;
+
+	public:
+		Reference(word_type *p_word, uint32_t p_shift) : word(p_word), shift(p_shift) {}
+		Reference(const Reference &) = default;
+
+		operator T() const { return decode((word->bits >> shift) & value_mask); }
+		Reference &operator=(T p_value) {
+			word->bits = (word->bits & ~(value_mask << shift)) | (encode(p_value) << shift);
+			return *this;
+		}
+		Reference &operator=(const Reference &p_other) { return *this = T(p_other); }
+	};
+
+	using reference = Reference;
+	using const_reference = T;
+
+	static constexpr uint64_t words_for(uint64_t p_rows) { return (p_rows + values_per_word - 1) / values_per_word; }
+	// Used by the SOA macros instead of sizeof(T) * rows to lay out the columns.
+	static constexpr uint64_t column_bytes(uint64_t p_rows) { return words_for(p_rows) * sizeof(uint64_t); }
+
+	// Do not use this directly, it has to be public. Use push_X in the SOA struct instead.
+	SoaVectorSizeType push_soa_member(T p_elem) {
+		// The memory of a dynamic SOA isn't zeroed, the first value of a word sets all of it.
+		if (row_count % values_per_word == 0) {
+			data[row_count / values_per_word].bits = encode(p_elem);
+		} else {
+			set_bits(row_count, encode(p_elem));
+		}
+		return ++row_count;
+	}
+
+	template <typename... Args> SoaVectorSizeType emplace_soa_member(Args &&...p_args) { return push_soa_member(T(std::forward<Args>(p_args)...)); }
+
+	// Values share words so threads filling neighbouring rows update the word atomically.
+	template <typename... Args> void emplace_soa_member_at(SoaVectorSizeType p_index, Args &&...p_args) {
+		std::atomic_ref<uint64_t> word(data[p_index / values_per_word].bits);
+		const uint32_t shift = p_index % values_per_word * Bits;
+		word.fetch_and(~(value_mask << shift), std::memory_order_relaxed);
+		word.fetch_or(encode(T(std::forward<Args>(p_args)...)) << shift, std::memory_order_relaxed);
+	}
+
+	void commit_soa_members(SoaVectorSizeType p_count) { row_count += p_count; }
+
+	void truncate_soa_member(SoaVectorSizeType p_size) { row_count = std::min(row_count, p_size); }
+
+	void soa_realloc(void *new_data, uint64_t p_memory_offset) {
+		word_type *new_column_data = column_ptr(new_data, p_memory_offset);
+		if (row_count > 0) {
+			memcpy(static_cast<void *>(new_column_data), static_cast<const void *>(data), column_bytes(row_count));
+		}
+		data = new_column_data;
+	}
+
+	void destroy_at(SoaVectorSizeType /*p_index*/) {}
+
+	void post_erase(SoaVectorSizeType p_index_to_erase, SoaVectorSizeType p_end_index) {
+		if (p_index_to_erase >= row_count) {
+			return;
+		}
+		if (p_end_index >= row_count) {
+			set_bits(p_index_to_erase, 0);
+		} else if (p_index_to_erase != p_end_index) {
+			set_bits(p_index_to_erase, get_bits(p_end_index));
+		}
+		if (row_count - 1 == p_end_index) {
+			row_count--;
+		}
+	}
+
+	void compact_soa_member(const simd::BitMask & /*p_erased*/, std::span<const RowMove> p_moves, SoaVectorSizeType p_new_size) {
+		for (const RowMove &move : p_moves) {
+			set_bits(move.to, get_bits(move.from));
+		}
+		row_count = p_new_size;
+	}
+
+	void init(void *p_data, SoaVectorSizeType /*p_size*/, uint64_t p_memory_offset) { data = column_ptr(p_data, p_memory_offset); }
+
+	void init_fixed(void *p_data, SoaVectorSizeType p_size, uint64_t p_memory_offset) {
+		data = column_ptr(p_data, p_memory_offset);
+		row_count = p_size;
+	}
+
+	void *get_data() { return data; }
+	word_type *ptr() { return data; }
+	[[nodiscard]] const word_type *ptr() const { return data; }
+
+	// The words of the column, bits after the last value are undefined.
+	[[nodiscard]] std::span<const uint64_t> words() const { return { reinterpret_cast<const uint64_t *>(data), word_count() }; }
+
+	void clear() { row_count = 0; }
+
+	void reset() {
+		row_count = 0;
+		data = nullptr;
+	}
+
+	[[nodiscard]] bool is_empty() const { return row_count == 0; }
+
+	[[nodiscard]] SoaVectorSizeType size() const { return row_count; }
+
+	T operator[](SoaVectorSizeType p_index) const { return decode(get_bits(p_index)); }
+	Reference operator[](SoaVectorSizeType p_index) { return Reference(&data[p_index / values_per_word], p_index % values_per_word * Bits); }
+
+	static constexpr SoaVectorSizeType NOT_FOUND = SoaVector<uint8_t>::NOT_FOUND;
+
+	// Every search compares a whole word at a time.
+
+	[[nodiscard]] SoaVectorSizeType count_equal(T p_value) const {
+		uint64_t matches = 0;
+		for_each_equal_lanes(p_value, [&](uint64_t, uint64_t p_lanes) { matches += uint64_t(std::popcount(p_lanes)); });
+		return SoaVectorSizeType(matches);
+	}
+
+	[[nodiscard]] SoaVectorSizeType find(T p_value, SoaVectorSizeType p_from = 0) const {
+		if (p_from >= row_count) {
+			return NOT_FOUND;
+		}
+		uint64_t word = p_from / values_per_word;
+		// Skips the values of the first word before p_from.
+		uint64_t skip = ~uint64_t(0) << (p_from % values_per_word * Bits);
+		for (; word < word_count(); ++word) {
+			const uint64_t matches = equal_lanes(data[word].bits, p_value) & valid_lanes(word) & skip;
+			if (matches != 0) {
+				return SoaVectorSizeType(word * values_per_word + uint64_t(std::countr_zero(matches)) / Bits);
+			}
+			skip = ~uint64_t(0);
+		}
+		return NOT_FOUND;
+	}
+
+	[[nodiscard]] bool has(T p_value) const { return find(p_value) != NOT_FOUND; }
+
+	[[nodiscard]] SoaVectorSizeType count(T p_value) const { return count_equal(p_value); }
+	[[nodiscard]] bool any(T p_value) const { return has(p_value); }
+	[[nodiscard]] bool all(T p_value) const {
+		for (uint64_t word = 0; word < word_count(); ++word) {
+			if ((equal_lanes(data[word].bits, p_value) & valid_lanes(word)) != valid_lanes(word)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	[[nodiscard]] SoaVectorSizeType find_first(T p_value, SoaVectorSizeType p_from = 0) const { return find(p_value, p_from); }
+
+	// The bool column versions check for true.
+	[[nodiscard]] SoaVectorSizeType count() const
+		requires std::is_same_v<T, bool>
+	{
+		return count_equal(true);
+	}
+	[[nodiscard]] bool any() const
+		requires std::is_same_v<T, bool>
+	{
+		return has(true);
+	}
+	[[nodiscard]] bool all() const
+		requires std::is_same_v<T, bool>
+	{
+		return all(true);
+	}
+	[[nodiscard]] bool none() const
+		requires std::is_same_v<T, bool>
+	{
+		return !has(true);
+	}
+	[[nodiscard]] SoaVectorSizeType find_first() const
+		requires std::is_same_v<T, bool>
+	{
+		return find(true);
+	}
+
+	// Sets bit i of r_mask for every value i equal to p_value and returns how many, the same mask soa::simd::compare fills so it can go straight into a query. A bool column
+	// compared to true is its own words.
+	uint64_t equal_mask(T p_value, simd::BitMask &r_mask) const {
+		r_mask.assign((uint64_t(row_count) + 63) / 64, 0);
+		uint64_t matches = 0;
+		for_each_equal_lanes(p_value, [&](uint64_t p_word, uint64_t p_lanes) {
+			if constexpr (Bits == 1) {
+				r_mask[p_word] = p_lanes;
+			} else {
+				const uint64_t first_row = p_word * values_per_word;
+				for (uint64_t bits = p_lanes; bits != 0; bits &= bits - 1) {
+					const uint64_t row = first_row + uint64_t(std::countr_zero(bits)) / Bits;
+					r_mask[row / 64] |= uint64_t(1) << (row % 64);
+				}
+			}
+			matches += uint64_t(std::popcount(p_lanes));
+		});
+		return matches;
+	}
+
+	[[nodiscard]] simd::BitMask to_mask(T p_value) const {
+		simd::BitMask mask;
+		equal_mask(p_value, mask);
+		return mask;
+	}
+
+	[[nodiscard]] IndexIterator<SoaVector, T> begin() const { return { this, 0 }; }
+	[[nodiscard]] IndexIterator<SoaVector, T> end() const { return { this, row_count }; }
+};
+
+// save/load write the words of a packed column as an integer column, so runs of equal flags still end up Rle encoded.
+template <typename T, uint32_t Bits> void write_column(std::ostream &p_stream, std::string_view p_name, const PackedWord<T, Bits> *p_data, SoaVectorSizeType p_count) {
+	detail::write_value(p_stream, column_name_hash(p_name));
+	detail::write_value(p_stream, p_count);
+	detail::write_payload(p_stream, reinterpret_cast<const uint64_t *>(p_data), SoaVectorSizeType(SoaVector<Packed<T, Bits>>::words_for(p_count)));
+}
+
+template <typename T, uint32_t Bits> SoaVectorSizeType read_column(std::istream &p_stream, std::string_view p_name, PackedWord<T, Bits> *r_data, SoaVectorSizeType p_capacity) {
+	if (detail::read_value<uint64_t>(p_stream) != column_name_hash(p_name)) {
+		throw std::runtime_error(std::string("soa::load: the stream doesn't have the column ") + std::string(p_name));
+	}
+	const SoaVectorSizeType count = detail::read_value<SoaVectorSizeType>(p_stream);
+	if (count > p_capacity) {
+		throw std::runtime_error("soa::load: column has more rows than the table");
+	}
+	detail::read_payload(p_stream, reinterpret_cast<uint64_t *>(r_data), SoaVectorSizeType(SoaVector<Packed<T, Bits>>::words_for(count)));
+	return count;
+}
+
+} // namespace soa
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace soa {
+
+// Size of a cache line, parallel_for never splits one between 2 chunks.
+constexpr uint64_t cache_line_size = 64;
+
+// Fixed set of worker threads that parallel_for runs its chunks on. The thread calling run() works on tasks too, so a pool with N threads has N - 1 workers.
+// Only one run() happens at a time, a run() from inside a task or from another thread while the pool is busy runs all of its tasks on the calling thread instead of waiting.
+// Tasks must not throw.
+class ThreadPool {
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	// The current job, only changed by run() while every worker is waiting.
+	void (*job)(void *, uint64_t) = nullptr;
+	void *job_context = nullptr;
+	uint64_t task_count = 0;
+	std::atomic<uint64_t> next_task = 0;
+	uint64_t generation = 0;
+	uint32_t active_workers = 0;
+	bool stopping = false;
+	// Set while a run() is using the workers.
+	std::atomic<bool> busy = false;
+
+	void work() {
+		for (uint64_t task = next_task.fetch_add(1, std::memory_order_relaxed); task < task_count; task = next_task.fetch_add(1, std::memory_order_relaxed)) {
+			job(job_context, task);
+		}
+	}
+
+	void worker_loop() {
+		uint64_t seen_generation = 0;
+		std::unique_lock lock(mutex);
+		while (true) {
+			wake.wait(lock, [&] { return stopping or generation != seen_generation; });
+			if (stopping) {
+				return;
+			}
+
+			seen_generation = generation;
+			lock.unlock();
+			work();
+			lock.lock();
+			if (--active_workers == 0) {
+				done.notify_one();
+			}
+		}
+	}
+
+public:
+	explicit ThreadPool(uint32_t p_thread_count = std::max(1u, std::thread::hardware_concurrency())) {
+		workers.reserve(p_thread_count - 1);
+		for (uint32_t i = 1; i < p_thread_count; ++i) {
+			workers.emplace_back([this] { worker_loop(); });
+		}
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	~ThreadPool() {
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+	}
+
+	// Number of threads that run tasks, including the one calling run().
+	[[nodiscard]] uint32_t thread_count() const { return uint32_t(workers.size()) + 1; }
+
+	// Calls p_func(task_index) for every task in [0, p_task_count) and returns once all of them are done.
+	template <typename Func> void run(uint64_t p_task_count, Func &&p_func) {
+		if (workers.empty() or p_task_count <= 1 or busy.exchange(true, std::memory_order_acquire)) {
+			for (uint64_t task = 0; task < p_task_count; ++task) {
+				p_func(task);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard lock(mutex);
+			job = [](void *p_context, uint64_t p_task) { (*static_cast<std::remove_reference_t<Func> *>(p_context))(p_task); };
+			job_context = &p_func;
+			task_count = p_task_count;
+			next_task.store(0, std::memory_order_relaxed);
+			active_workers = uint32_t(workers.size());
+			generation++;
+		}
+		wake.notify_all();
+		work();
+
+		{
+			std::unique_lock lock(mutex);
+			done.wait(lock, [&] { return active_workers == 0; });
+		}
+		busy.store(false, std::memory_order_release);
+	}
+};
+
+// Pool used by parallel_for when none is passed in, it has a thread for every hardware thread and is created on first use.
+inline ThreadPool &default_thread_pool() {
+	static ThreadPool pool;
+	return pool;
+}
+
+namespace detail {
+
+// Smallest number of rows that is a whole number of cache lines for a column of T's.
+template <typename T> constexpr uint64_t cache_line_rows() { return cache_line_size / std::gcd(cache_line_size, sizeof(T)); }
+
+template <typename S, typename T> using column_pointer_t = std::conditional_t<std::is_const_v<S>, const T *, T *>;
+
+} // namespace detail
+
+// Runs p_func(first_row, row_count, column_pointers...) over every row of p_members on p_pool, column_pointers point at first_row of each member.
+// soa::parallel_for(soa_struct, [](SoaVectorSizeType first, SoaVectorSizeType count, float *x, const float *v) { for (...) x[i] += v[i]; }, &S::x, &S::v);
+// Chunks are at least MinChunkRows rows and every chunk starts on a cache line in each of the member columns, so 2 threads writing neighbouring chunks never share a cache line.
+// With a SOA_COLUMN_ALIGNMENT smaller than a cache line that is only true relative to the start of the column.
+// The rows processed are the rows that exist in all of p_members. Pushing or erasing rows from p_func is not allowed, writing to existing rows of the given members is.
+template <SoaVectorSizeType MinChunkRows = 4096, typename S, typename Func, typename... T>
+void parallel_for(ThreadPool &p_pool, S &p_soa, Func p_func, SoaVector<T> std::remove_const_t<S>::*...p_members) {
+	static_assert(sizeof...(T) > 0, "parallel_for needs at least one member");
+
+	const uint64_t row_count = std::min({ uint64_t((p_soa.*p_members).size())... });
+	uint64_t granularity = 1;
+	((granularity = std::lcm(granularity, detail::cache_line_rows<T>())), ...);
+
+	// A few chunks per thread so a thread that gets descheduled doesn't hold up the whole loop.
+	const uint64_t target_chunks = uint64_t(p_pool.thread_count()) * 4;
+	uint64_t chunk_rows = std::max<uint64_t>(MinChunkRows, (row_count + target_chunks - 1) / target_chunks);
+	chunk_rows = (chunk_rows + granularity - 1) / granularity * granularity;
+	const uint64_t chunk_count = (row_count + chunk_rows - 1) / chunk_rows;
+
+	p_pool.run(chunk_count, [&](uint64_t p_chunk) {
+		const uint64_t first = p_chunk * chunk_rows;
+		const uint64_t count = std::min(chunk_rows, row_count - first);
+		p_func(SoaVectorSizeType(first), SoaVectorSizeType(count), static_cast<detail::column_pointer_t<S, T>>((p_soa.*p_members).ptr() + first)...);
+	});
+}
+
+// Same as above on default_thread_pool().
+template <SoaVectorSizeType MinChunkRows = 4096, typename S, typename Func, typename... T> void parallel_for(S &p_soa, Func p_func, SoaVector<T> std::remove_const_t<S>::*...p_members) {
+	parallel_for<MinChunkRows>(default_thread_pool(), p_soa, p_func, p_members...);
+}
+
+} // namespace soa
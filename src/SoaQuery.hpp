@@ -0,0 +1,169 @@
+#pragma once
+
+#include "SoaSimd.hpp"
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace soa {
+
+namespace detail {
+
+// Calls p_func with a predicate lambda for p_op so the comparison isn't switched on for every row.
+template <typename T, typename Func> void with_compare_predicate(simd::Compare p_op, const T &p_value, Func p_func) {
+	switch (p_op) {
+		case simd::Compare::Equal:        p_func([&p_value](const T &p_elem) { return p_elem == p_value; }); break;
+		case simd::Compare::NotEqual:     p_func([&p_value](const T &p_elem) { return p_elem != p_value; }); break;
+		case simd::Compare::Less:         p_func([&p_value](const T &p_elem) { return p_elem < p_value; }); break;
+		case simd::Compare::LessEqual:    p_func([&p_value](const T &p_elem) { return p_elem <= p_value; }); break;
+		case simd::Compare::Greater:      p_func([&p_value](const T &p_elem) { return p_elem > p_value; }); break;
+		case simd::Compare::GreaterEqual: p_func([&p_value](const T &p_elem) { return p_elem >= p_value; }); break;
+	}
+}
+
+// r_out is an iterator so std::vector<bool> works for soa::PackedBool columns.
+template <typename T, typename Out> void gather(const SoaVector<T> &p_column, std::span<const SoaVectorSizeType> p_rows, Out r_out) {
+	for (uint64_t i = 0; i < p_rows.size(); ++i) {
+		r_out[i] = p_column[p_rows[i]];
+	}
+}
+
+} // namespace detail
+
+// Rows of an SOA struct picked by where(). Only the row indices are stored, the other columns are read when select() or for_each_batch() gathers them.
+// The indices are row indices (not MutableSOA entity ids or SparseSOA handles) so anything that moves rows, like erase, invalidates the selection.
+// Every selected column has to have all the rows of the column the selection was built from, which is always true for rows added with push_row.
+template <typename S> class Selection {
+	const S *soa = nullptr;
+	simd::SelectionVector rows;
+
+	template <typename T, typename Pred> void filter(const SoaVector<T> &p_column, Pred p_pred) {
+		// Branchless compaction, every row is written and the write position only moves if it matched.
+		uint64_t kept = 0;
+		for (const SoaVectorSizeType row : rows) {
+			rows[kept] = row;
+			kept += bool(p_pred(p_column[row]));
+		}
+		rows.resize(kept);
+	}
+
+public:
+	Selection(const S &p_soa, simd::SelectionVector p_rows) : soa(&p_soa), rows(std::move(p_rows)) {}
+
+	// Only keeps the selected rows where p_pred(p_member value) is true.
+	template <typename T, typename Pred> Selection &where(SoaVector<T> S::*p_member, Pred p_pred) {
+		filter(soa->*p_member, p_pred);
+		return *this;
+	}
+
+	// Only keeps the selected rows where the p_member value <p_op> p_value.
+	template <typename T> Selection &where(SoaVector<T> S::*p_member, simd::Compare p_op, const typename SoaVector<T>::value_type &p_value) {
+		detail::with_compare_predicate<typename SoaVector<T>::value_type>(p_op, p_value, [&](auto p_pred) { filter(soa->*p_member, p_pred); });
+		return *this;
+	}
+
+	[[nodiscard]] const simd::SelectionVector &indices() const { return rows; }
+	[[nodiscard]] SoaVectorSizeType size() const { return SoaVectorSizeType(rows.size()); }
+	[[nodiscard]] bool empty() const { return rows.empty(); }
+
+	// Gathers the selected rows of each column into a dense vector, in row order. Encoded columns give their value type, std::string_view for the string columns.
+	// auto [b, c] = soa.where(&S::a, soa::simd::Compare::Less, 10).select(&S::b, &S::c);
+	template <typename... T>
+	[[nodiscard]] std::tuple<std::vector<typename SoaVector<T>::value_type>...> select(SoaVector<T> S::*...p_members) const {
+		std::tuple<std::vector<typename SoaVector<T>::value_type>...> columns{ std::vector<typename SoaVector<T>::value_type>(rows.size())... };
+		[&]<size_t... I>(std::index_sequence<I...>) { (detail::gather(soa->*p_members, rows, std::get<I>(columns).begin()), ...); }(std::index_sequence_for<T...>{});
+		return columns;
+	}
+
+	// Same as select() but gathers BatchSize rows at a time into reused buffers and calls p_func(row_indices, column_values...) with a std::span for each batch.
+	// Use it when the selection is big, the gathered batch stays in cache while p_func uses it instead of writing out every column first and reading it back.
+	// The buffers are arrays instead of std::vector so bool and soa::PackedBool columns get a span too.
+	template <SoaVectorSizeType BatchSize = 1024, typename Func, typename... T> void for_each_batch(Func p_func, SoaVector<T> S::*...p_members) const {
+		const uint64_t buffer_size = std::min<uint64_t>(BatchSize, rows.size());
+		std::tuple<std::unique_ptr<typename SoaVector<T>::value_type[]>...> buffers{ std::make_unique<typename SoaVector<T>::value_type[]>(buffer_size)... };
+		for (uint64_t first = 0; first < rows.size(); first += BatchSize) {
+			const std::span<const SoaVectorSizeType> batch(rows.data() + first, std::min<uint64_t>(BatchSize, rows.size() - first));
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				(detail::gather(soa->*p_members, batch, std::get<I>(buffers).get()), ...);
+				p_func(batch, std::span<const typename SoaVector<T>::value_type>(std::get<I>(buffers).get(), batch.size())...);
+			}(std::index_sequence_for<T...>{});
+		}
+	}
+};
+
+// Selects the rows of p_soa where p_pred(p_member value) is true. Builds a bitmask 64 rows at a time without branches, so simple predicates get vectorized by the compiler,
+// then turns the set bits into row indices.
+template <typename S, typename T, typename Pred> [[nodiscard]] Selection<S> where(const S &p_soa, SoaVector<T> S::*p_member, Pred p_pred) {
+	const SoaVector<T> &column = p_soa.*p_member;
+	const uint64_t count = column.size();
+
+	simd::BitMask mask((count + 63) / 64);
+	for (uint64_t row = 0; row < count; row += 64) {
+		const uint64_t block = std::min<uint64_t>(64, count - row);
+		uint64_t bits = 0;
+		if constexpr (is_encoded_column_v<T>) {
+			for (uint64_t i = 0; i < block; ++i) {
+				bits |= uint64_t(bool(p_pred(column[SoaVectorSizeType(row + i)]))) << i;
+			}
+		} else {
+			const T *data = column.ptr();
+			for (uint64_t i = 0; i < block; ++i) {
+				bits |= uint64_t(bool(p_pred(data[row + i]))) << i;
+			}
+		}
+		mask[row / 64] = bits;
+	}
+
+	simd::SelectionVector rows;
+	simd::mask_to_selection(mask, rows);
+	return Selection<S>(p_soa, std::move(rows));
+}
+
+// Selects the rows of p_soa where the p_member value <p_op> p_value with the soa::simd kernels. Equal and NotEqual use the column's equal_mask if it has one
+// (soa::Packed and the string columns).
+template <typename S, typename T>
+[[nodiscard]] Selection<S> where(const S &p_soa, SoaVector<T> S::*p_member, simd::Compare p_op, const typename SoaVector<T>::value_type &p_value) {
+	using Value = typename SoaVector<T>::value_type;
+	const SoaVector<T> &column = p_soa.*p_member;
+	simd::SelectionVector rows;
+	if constexpr (requires(simd::BitMask &r_mask) { column.equal_mask(p_value, r_mask); }) {
+		if (p_op == simd::Compare::Equal or p_op == simd::Compare::NotEqual) {
+			simd::BitMask mask;
+			column.equal_mask(p_value, mask);
+			if (p_op == simd::Compare::NotEqual) {
+				for (uint64_t &word : mask) {
+					word = ~word;
+				}
+				if (column.size() % 64 != 0) {
+					mask.back() &= (uint64_t(1) << (column.size() % 64)) - 1;
+				}
+			}
+			simd::mask_to_selection(mask, rows);
+			return Selection<S>(p_soa, std::move(rows));
+		}
+	} else if constexpr (simd::Searchable<T>) {
+		if (p_op == simd::Compare::Equal) {
+			simd::find_all(column.ptr(), column.size(), p_value, rows);
+			return Selection<S>(p_soa, std::move(rows));
+		}
+	}
+	if constexpr (simd::Arithmetic<T>) {
+		simd::BitMask mask;
+		simd::compare(column, p_op, p_value, mask);
+		simd::mask_to_selection(mask, rows);
+		return Selection<S>(p_soa, std::move(rows));
+	} else {
+		Selection<S> selection(p_soa, {});
+		detail::with_compare_predicate<Value>(p_op, p_value, [&](auto p_pred) { selection = where(p_soa, p_member, p_pred); });
+		return selection;
+	}
+}
+
+} // namespace soa
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+
+namespace soa {
+
+// Iterator over the rows of an SOA struct. Dereferencing it returns the struct's row proxy (a struct of references to each member of the row) so nothing is copied.
+template <typename Soa, typename Row> class RowIterator {
+	Soa *soa = nullptr;
+	SoaVectorSizeType index = 0;
+
+public:
+	using iterator_concept = std::random_access_iterator_tag;
+	using iterator_category = std::input_iterator_tag;
+	using value_type = Row;
+	using difference_type = std::ptrdiff_t;
+
+	RowIterator() = default;
+	RowIterator(Soa *p_soa, SoaVectorSizeType p_index) : soa(p_soa), index(p_index) {}
+
+	Row operator*() const { return soa->soa_row_at(index); }
+	Row operator[](difference_type p_offset) const { return soa->soa_row_at(SoaVectorSizeType(index + p_offset)); }
+
+	RowIterator &operator++() {
+		index++;
+		return *this;
+	}
+	RowIterator operator++(int) {
+		RowIterator old = *this;
+		index++;
+		return old;
+	}
+	RowIterator &operator--() {
+		index--;
+		return *this;
+	}
+	RowIterator operator--(int) {
+		RowIterator old = *this;
+		index--;
+		return old;
+	}
+	RowIterator &operator+=(difference_type p_offset) {
+		index = SoaVectorSizeType(index + p_offset);
+		return *this;
+	}
+	RowIterator &operator-=(difference_type p_offset) {
+		index = SoaVectorSizeType(index - p_offset);
+		return *this;
+	}
+
+	friend RowIterator operator+(RowIterator p_it, difference_type p_offset) { return p_it += p_offset; }
+	friend RowIterator operator+(difference_type p_offset, RowIterator p_it) { return p_it += p_offset; }
+	friend RowIterator operator-(RowIterator p_it, difference_type p_offset) { return p_it -= p_offset; }
+	friend difference_type operator-(const RowIterator &p_a, const RowIterator &p_b) { return difference_type(p_a.index) - difference_type(p_b.index); }
+
+	bool operator==(const RowIterator &p_other) const { return index == p_other.index; }
+	auto operator<=>(const RowIterator &p_other) const { return index <=> p_other.index; }
+};
+
+// What rows() returns, a random access range of row proxies.
+template <typename Soa, typename Row> class RowRange {
+	Soa *soa = nullptr;
+	SoaVectorSizeType count = 0;
+
+public:
+	RowRange(Soa *p_soa, SoaVectorSizeType p_count) : soa(p_soa), count(p_count) {}
+
+	[[nodiscard]] RowIterator<Soa, Row> begin() const { return { soa, 0 }; }
+	[[nodiscard]] RowIterator<Soa, Row> end() const { return { soa, count }; }
+	[[nodiscard]] SoaVectorSizeType size() const { return count; }
+	[[nodiscard]] bool empty() const { return count == 0; }
+	Row operator[](SoaVectorSizeType p_index) const { return soa->soa_row_at(p_index); }
+};
+
+} // namespace soa
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace soa {
+
+// Stream format written by save() and read by load(): a table header (magic, version, column count, row count) and then every column on its own as its name hash, element count,
+// ColumnEncoding and the encoded elements. Everything is stored in the native byte order.
+// The encoding of each column is picked from its type and data:
+// - integers, enums and bools: Rle when runs of equal values make it less than half the raw size, DeltaBitPack (zigzag deltas bit packed in blocks of 128) otherwise.
+// - other trivially copyable types (floats, structs): Rle under the same rule, Raw otherwise.
+// - std::string and std::vector of a trivially copyable type: LengthPrefixed, the lengths as an integer column followed by all the elements.
+// - soa::ArenaString: LengthPrefixed. soa::DictString: Dictionary, the number of distinct strings, the strings LengthPrefixed and then the code of every row as an integer column.
+enum class ColumnEncoding : uint8_t {
+	Raw,
+	Rle,
+	DeltaBitPack,
+	LengthPrefixed,
+	Dictionary,
+};
+
+constexpr uint32_t STREAM_MAGIC = 0x31414f53; // "SOA1" in little endian.
+constexpr uint32_t STREAM_VERSION = 1;
+
+namespace detail {
+
+template <typename T> struct is_std_vector : std::false_type {};
+template <typename T, typename A> struct is_std_vector<std::vector<T, A>> : std::true_type {};
+
+template <typename T>
+concept IntegerColumn = std::integral<T> or std::is_enum_v<T>;
+
+template <typename T>
+concept LengthPrefixedColumn = std::same_as<T, std::string> or (is_std_vector<T>::value and std::is_trivially_copyable_v<typename T::value_type> and
+		!std::same_as<typename T::value_type, bool>);
+
+template <typename T> using column_unsigned_t = std::make_unsigned_t<std::conditional_t<sizeof(T) == 1, uint8_t, std::conditional_t<sizeof(T) == 2, uint16_t,
+		std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>>;
+
+// std::vector<bool> has no data(), Rle keeps the values of bool runs as bytes.
+template <typename T> using rle_value_t = std::conditional_t<std::same_as<T, bool>, uint8_t, T>;
+
+constexpr SoaVectorSizeType BIT_PACK_BLOCK = 128;
+
+inline void write_bytes(std::ostream &p_stream, const void *p_data, uint64_t p_size) {
+	if (p_size != 0) {
+		p_stream.write(static_cast<const char *>(p_data), std::streamsize(p_size));
+	}
+}
+
+inline void read_bytes(std::istream &p_stream, void *r_data, uint64_t p_size) {
+	if (p_size != 0 and !p_stream.read(static_cast<char *>(r_data), std::streamsize(p_size))) {
+		throw std::runtime_error("soa::load: unexpected end of stream");
+	}
+}
+
+template <typename T> void write_value(std::ostream &p_stream, T p_value) { write_bytes(p_stream, &p_value, sizeof(T)); }
+
+template <typename T> T read_value(std::istream &p_stream) {
+	T value;
+	read_bytes(p_stream, &value, sizeof(T));
+	return value;
+}
+
+template <typename T> SoaVectorSizeType count_runs(const T *p_data, SoaVectorSizeType p_count) {
+	SoaVectorSizeType runs = p_count != 0;
+	for (SoaVectorSizeType i = 1; i < p_count; ++i) {
+		runs += memcmp(&p_data[i], &p_data[i - 1], sizeof(T)) != 0;
+	}
+	return runs;
+}
+
+template <typename T> bool rle_is_smaller(SoaVectorSizeType p_runs, SoaVectorSizeType p_count) {
+	return uint64_t(p_runs) * (sizeof(uint32_t) + sizeof(T)) * 2 <= uint64_t(p_count) * sizeof(T);
+}
+
+// Run lengths first and then the value of each run.
+template <typename T> void write_rle(std::ostream &p_stream, const T *p_data, SoaVectorSizeType p_count, SoaVectorSizeType p_runs) {
+	std::vector<uint32_t> lengths;
+	std::vector<rle_value_t<T>> values;
+	lengths.reserve(p_runs);
+	values.reserve(p_runs);
+	for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+		if (i == 0 or memcmp(&p_data[i], &p_data[i - 1], sizeof(T)) != 0) {
+			lengths.push_back(0);
+			values.push_back(p_data[i]);
+		}
+		lengths.back()++;
+	}
+	write_value(p_stream, p_runs);
+	write_bytes(p_stream, lengths.data(), lengths.size() * sizeof(uint32_t));
+	write_bytes(p_stream, values.data(), values.size() * sizeof(rle_value_t<T>));
+}
+
+template <typename T> void read_rle(std::istream &p_stream, T *r_data, SoaVectorSizeType p_count) {
+	const SoaVectorSizeType runs = read_value<SoaVectorSizeType>(p_stream);
+	if (runs > p_count) {
+		throw std::runtime_error("soa::load: corrupt Rle column");
+	}
+	std::vector<uint32_t> lengths(runs);
+	std::vector<rle_value_t<T>> values(runs);
+	read_bytes(p_stream, lengths.data(), lengths.size() * sizeof(uint32_t));
+	read_bytes(p_stream, values.data(), values.size() * sizeof(rle_value_t<T>));
+	SoaVectorSizeType row = 0;
+	for (SoaVectorSizeType run = 0; run < runs; ++run) {
+		if (lengths[run] > p_count - row) {
+			throw std::runtime_error("soa::load: corrupt Rle column");
+		}
+		std::uninitialized_fill_n(r_data + row, lengths[run], T(values[run]));
+		row += lengths[run];
+	}
+	if (row != p_count) {
+		throw std::runtime_error("soa::load: corrupt Rle column");
+	}
+}
+
+// Every value is stored as the zigzag encoded difference to the previous one, so sorted or slowly changing columns need only a few bits per value. Each block of 128 values is
+// packed with the bit width of its largest difference. The widths of all blocks are written first and then the packed 64 bit words.
+template <typename T> void write_delta_bit_pack(std::ostream &p_stream, const T *p_data, SoaVectorSizeType p_count) {
+	using U = column_unsigned_t<T>;
+	constexpr uint32_t bits = sizeof(U) * 8;
+	const SoaVectorSizeType block_count = (p_count + BIT_PACK_BLOCK - 1) / BIT_PACK_BLOCK;
+	std::vector<uint8_t> widths(block_count);
+	std::vector<uint64_t> words;
+	words.reserve(uint64_t(p_count) * sizeof(U) / 8 + block_count);
+
+	U previous = 0;
+	std::array<uint64_t, BIT_PACK_BLOCK> zigzags{};
+	for (SoaVectorSizeType block = 0; block < block_count; ++block) {
+		const SoaVectorSizeType first = block * BIT_PACK_BLOCK;
+		const SoaVectorSizeType block_size = std::min(BIT_PACK_BLOCK, p_count - first);
+		uint64_t used_bits = 0;
+		for (SoaVectorSizeType i = 0; i < block_size; ++i) {
+			U value;
+			memcpy(&value, &p_data[first + i], sizeof(U));
+			const U delta = U(value - previous);
+			zigzags[i] = U(U(delta << 1) ^ U(0 - U(delta >> (bits - 1))));
+			used_bits |= zigzags[i];
+			previous = value;
+		}
+
+		const uint32_t width = uint32_t(std::bit_width(used_bits));
+		widths[block] = uint8_t(width);
+		const uint64_t word_offset = words.size();
+		words.resize(word_offset + (uint64_t(block_size) * width + 63) / 64);
+		uint64_t *block_words = words.data() + word_offset;
+		for (SoaVectorSizeType i = 0; i < block_size and width != 0; ++i) {
+			const uint64_t position = uint64_t(i) * width;
+			const uint64_t shift = position % 64;
+			block_words[position / 64] |= zigzags[i] << shift;
+			if (shift + width > 64) {
+				block_words[position / 64 + 1] |= zigzags[i] >> (64 - shift);
+			}
+		}
+	}
+
+	write_bytes(p_stream, widths.data(), widths.size());
+	write_value(p_stream, uint64_t(words.size()));
+	write_bytes(p_stream, words.data(), words.size() * sizeof(uint64_t));
+}
+
+template <typename T> void read_delta_bit_pack(std::istream &p_stream, T *r_data, SoaVectorSizeType p_count) {
+	using U = column_unsigned_t<T>;
+	const SoaVectorSizeType block_count = (p_count + BIT_PACK_BLOCK - 1) / BIT_PACK_BLOCK;
+	std::vector<uint8_t> widths(block_count);
+	read_bytes(p_stream, widths.data(), widths.size());
+	const uint64_t word_count = read_value<uint64_t>(p_stream);
+	uint64_t expected_words = 0;
+	for (SoaVectorSizeType block = 0; block < block_count; ++block) {
+		if (widths[block] > sizeof(U) * 8) {
+			throw std::runtime_error("soa::load: corrupt DeltaBitPack column");
+		}
+		expected_words += (uint64_t(std::min(BIT_PACK_BLOCK, p_count - block * BIT_PACK_BLOCK)) * widths[block] + 63) / 64;
+	}
+	if (word_count != expected_words) {
+		throw std::runtime_error("soa::load: corrupt DeltaBitPack column");
+	}
+	std::vector<uint64_t> words(word_count);
+	read_bytes(p_stream, words.data(), words.size() * sizeof(uint64_t));
+
+	U previous = 0;
+	const uint64_t *block_words = words.data();
+	for (SoaVectorSizeType block = 0; block < block_count; ++block) {
+		const SoaVectorSizeType first = block * BIT_PACK_BLOCK;
+		const SoaVectorSizeType block_size = std::min(BIT_PACK_BLOCK, p_count - first);
+		const uint32_t width = widths[block];
+		const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+		for (SoaVectorSizeType i = 0; i < block_size; ++i) {
+			uint64_t zigzag = 0;
+			if (width != 0) {
+				const uint64_t position = uint64_t(i) * width;
+				const uint64_t shift = position % 64;
+				zigzag = block_words[position / 64] >> shift;
+				if (shift + width > 64) {
+					zigzag |= block_words[position / 64 + 1] << (64 - shift);
+				}
+				zigzag &= mask;
+			}
+			const U delta = U(U(zigzag >> 1) ^ U(0 - U(zigzag & 1)));
+			previous = U(previous + delta);
+			memcpy(static_cast<void *>(&r_data[first + i]), &previous, sizeof(U));
+		}
+		block_words += (uint64_t(block_size) * width + 63) / 64;
+	}
+}
+
+template <typename T> void write_payload(std::ostream &p_stream, const T *p_data, SoaVectorSizeType p_count);
+template <typename T> void read_payload(std::istream &p_stream, T *r_data, SoaVectorSizeType p_count);
+
+template <LengthPrefixedColumn T> void write_length_prefixed(std::ostream &p_stream, const T *p_data, SoaVectorSizeType p_count) {
+	using Element = typename T::value_type;
+	std::vector<uint32_t> lengths(p_count);
+	uint64_t total_length = 0;
+	for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+		lengths[i] = uint32_t(p_data[i].size());
+		total_length += lengths[i];
+	}
+	write_payload(p_stream, lengths.data(), p_count);
+	write_value(p_stream, total_length);
+	for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+		write_bytes(p_stream, p_data[i].data(), p_data[i].size() * sizeof(Element));
+	}
+}
+
+template <LengthPrefixedColumn T> void read_length_prefixed(std::istream &p_stream, T *r_data, SoaVectorSizeType p_count) {
+	using Element = typename T::value_type;
+	std::vector<uint32_t> lengths(p_count);
+	read_payload(p_stream, lengths.data(), p_count);
+	uint64_t total_length = 0;
+	for (const uint32_t length : lengths) {
+		total_length += length;
+	}
+	if (read_value<uint64_t>(p_stream) != total_length) {
+		throw std::runtime_error("soa::load: corrupt LengthPrefixed column");
+	}
+
+	// All elements are read at once and then copied into each row's own string/vector. If one of them throws, the rows constructed before it are destroyed.
+	std::vector<Element> elements(total_length);
+	read_bytes(p_stream, elements.data(), total_length * sizeof(Element));
+	const Element *element = elements.data();
+	SoaVectorSizeType constructed = 0;
+	try {
+		for (; constructed < p_count; ++constructed) {
+			new (&r_data[constructed]) T(element, element + lengths[constructed]);
+			element += lengths[constructed];
+		}
+	} catch (...) {
+		std::destroy_n(r_data, constructed);
+		throw;
+	}
+}
+
+template <typename T> void write_payload(std::ostream &p_stream, const T *p_data, SoaVectorSizeType p_count) {
+	if constexpr (LengthPrefixedColumn<T>) {
+		write_value(p_stream, ColumnEncoding::LengthPrefixed);
+		write_length_prefixed(p_stream, p_data, p_count);
+	} else if constexpr (std::is_trivially_copyable_v<T>) {
+		const SoaVectorSizeType runs = count_runs(p_data, p_count);
+		if (rle_is_smaller<T>(runs, p_count)) {
+			write_value(p_stream, ColumnEncoding::Rle);
+			write_rle(p_stream, p_data, p_count, runs);
+		} else if constexpr (IntegerColumn<T>) {
+			write_value(p_stream, ColumnEncoding::DeltaBitPack);
+			write_delta_bit_pack(p_stream, p_data, p_count);
+		} else {
+			write_value(p_stream, ColumnEncoding::Raw);
+			write_bytes(p_stream, p_data, uint64_t(p_count) * sizeof(T));
+		}
+	} else {
+		static_assert(std::is_trivially_copyable_v<T>, "save/load only support trivially copyable members, std::string and std::vector of a trivially copyable type");
+	}
+}
+
+template <typename T> void read_payload(std::istream &p_stream, T *r_data, SoaVectorSizeType p_count) {
+	const ColumnEncoding encoding = read_value<ColumnEncoding>(p_stream);
+	if constexpr (LengthPrefixedColumn<T>) {
+		if (encoding == ColumnEncoding::LengthPrefixed) {
+			read_length_prefixed(p_stream, r_data, p_count);
+			return;
+		}
+	} else if constexpr (std::is_trivially_copyable_v<T>) {
+		if (encoding == ColumnEncoding::Raw) {
+			read_bytes(p_stream, static_cast<void *>(r_data), uint64_t(p_count) * sizeof(T));
+			return;
+		} else if (encoding == ColumnEncoding::Rle) {
+			read_rle(p_stream, r_data, p_count);
+			return;
+		} else if (IntegerColumn<T> and encoding == ColumnEncoding::DeltaBitPack) {
+			read_delta_bit_pack(p_stream, r_data, p_count);
+			return;
+		}
+	}
+	throw std::runtime_error("soa::load: unsupported column encoding");
+}
+
+// Uninitialized memory for p_count T's, destroys the first constructed ones when it goes away.
+template <typename T> class UninitializedBuffer {
+	std::allocator<T> allocator;
+	T *data_ptr = nullptr;
+	SoaVectorSizeType size = 0;
+
+public:
+	SoaVectorSizeType constructed = 0;
+
+	explicit UninitializedBuffer(SoaVectorSizeType p_size) : data_ptr(allocator.allocate(std::max<SoaVectorSizeType>(p_size, 1))), size(p_size) {}
+	UninitializedBuffer(const UninitializedBuffer &) = delete;
+	UninitializedBuffer &operator=(const UninitializedBuffer &) = delete;
+	~UninitializedBuffer() {
+		std::destroy_n(data_ptr, constructed);
+		allocator.deallocate(data_ptr, std::max<SoaVectorSizeType>(size, 1));
+	}
+
+	T *data() { return data_ptr; }
+};
+
+} // namespace detail
+
+inline void write_table_header(std::ostream &p_stream, uint32_t p_column_count, SoaVectorSizeType p_rows) {
+	detail::write_value(p_stream, STREAM_MAGIC);
+	detail::write_value(p_stream, STREAM_VERSION);
+	detail::write_value(p_stream, p_column_count);
+	detail::write_value(p_stream, p_rows);
+}
+
+// Returns the row count written by write_table_header, the most rows any column has.
+inline SoaVectorSizeType read_table_header(std::istream &p_stream, uint32_t p_column_count) {
+	if (detail::read_value<uint32_t>(p_stream) != STREAM_MAGIC or detail::read_value<uint32_t>(p_stream) != STREAM_VERSION) {
+		throw std::runtime_error("soa::load: not a SOA stream or an unsupported version");
+	}
+	if (detail::read_value<uint32_t>(p_stream) != p_column_count) {
+		throw std::runtime_error("soa::load: the stream has a different number of columns");
+	}
+	return detail::read_value<SoaVectorSizeType>(p_stream);
+}
+
+// Writes the first p_count elements of a column.
+template <typename T> void write_column(std::ostream &p_stream, std::string_view p_name, const T *p_data, SoaVectorSizeType p_count) {
+	detail::write_value(p_stream, column_name_hash(p_name));
+	detail::write_value(p_stream, p_count);
+	detail::write_payload(p_stream, p_data, p_count);
+}
+
+// Constructs the elements of a column written by write_column in r_data, which has to be uninitialized memory for at least p_capacity elements. Returns how many were
+// constructed. Throws std::runtime_error if the column has a different name or type, more than p_capacity elements, or the stream is corrupt.
+template <typename T> SoaVectorSizeType read_column(std::istream &p_stream, std::string_view p_name, T *r_data, SoaVectorSizeType p_capacity) {
+	if (detail::read_value<uint64_t>(p_stream) != column_name_hash(p_name)) {
+		throw std::runtime_error(std::string("soa::load: the stream doesn't have the column ") + std::string(p_name));
+	}
+	const SoaVectorSizeType count = detail::read_value<SoaVectorSizeType>(p_stream);
+	if (count > p_capacity) {
+		throw std::runtime_error("soa::load: column has more rows than the table");
+	}
+	detail::read_payload(p_stream, r_data, count);
+	return count;
+}
+
+// What save/load of the SOA macros use: writes a whole column and reads it back into an empty one with room for p_capacity rows. The string columns (see SoaString.hpp) have
+// their own overloads because their ptr() isn't the values.
+template <typename T> void save_column(std::ostream &p_stream, std::string_view p_name, const SoaVector<T> &p_column) {
+	write_column(p_stream, p_name, p_column.ptr(), p_column.size());
+}
+
+template <typename T> void load_column(std::istream &p_stream, std::string_view p_name, SoaVector<T> &r_column, SoaVectorSizeType p_capacity) {
+	r_column.commit_soa_members(read_column(p_stream, p_name, r_column.ptr(), p_capacity));
+}
+
+} // namespace soa
@@ -0,0 +1,680 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// The SSE2/AVX2/AVX-512 kernels need GCC style vector extensions, target attributes and __builtin_cpu_supports. Everywhere else only the scalar kernels exist.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SOA_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Vectorized kernels over SoaVector columns (or any contiguous array) of integer, float or double elements.
+// The best instruction set the cpu supports is picked at runtime so the library can be built for baseline x86-64 and still use AVX2 or AVX-512 when they exist.
+namespace soa {
+
+template <typename T> class SoaVector;
+
+namespace simd {
+
+enum class Isa : uint8_t {
+	Scalar,
+	SSE2,
+	AVX2,
+	AVX512, // AVX-512 F + BW + DQ
+};
+
+enum class Compare : uint8_t {
+	Equal,
+	NotEqual,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual,
+};
+
+template <typename T>
+concept Arithmetic = (std::is_integral_v<T> and !std::is_same_v<T, bool>) or std::is_same_v<T, float> or std::is_same_v<T, double>;
+
+namespace detail {
+template <typename T> struct search_type {
+	using type = T;
+};
+template <typename T>
+	requires std::is_enum_v<T>
+struct search_type<T> {
+	using type = std::underlying_type_t<T>;
+};
+template <> struct search_type<bool> {
+	using type = uint8_t;
+};
+} // namespace detail
+
+// Element types the search kernels (find, count_equal, find_all, find_any_of) work on. Enums are searched as their underlying type and bools as bytes.
+template <typename T>
+concept Searchable = Arithmetic<typename detail::search_type<T>::type>;
+
+// Indices of the rows that matched a search, in order.
+using SelectionVector = std::vector<SoaVectorSizeType>;
+
+// Integers are summed in 64 bits so summing a large int column doesn't overflow, floats are summed in their own type.
+template <Arithmetic T> using sum_type = std::conditional_t<std::is_floating_point_v<T>, T, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+// Result of compare(). Bit i % 64 of word i / 64 is set if row i matched, bits after the last row are always 0.
+using BitMask = std::vector<uint64_t>;
+
+namespace detail {
+
+inline Isa detect_isa() {
+#ifdef SOA_SIMD_X86
+	__builtin_cpu_init();
+	// Every AVX2 cpu has popcnt but check anyway since the AVX2 and AVX-512 kernels are compiled with it.
+	const bool popcnt = __builtin_cpu_supports("popcnt");
+	if (popcnt and __builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512bw") and __builtin_cpu_supports("avx512dq")) {
+		return Isa::AVX512;
+	}
+	if (popcnt and __builtin_cpu_supports("avx2")) {
+		return Isa::AVX2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return Isa::SSE2;
+	}
+#endif
+	return Isa::Scalar;
+}
+
+inline std::atomic<Isa> &isa_storage() {
+	static std::atomic<Isa> isa{ detect_isa() };
+	return isa;
+}
+
+} // namespace detail
+
+// Best instruction set this cpu supports.
+inline Isa detected_isa() {
+	static const Isa isa = detail::detect_isa();
+	return isa;
+}
+
+// Instruction set the kernels currently use, detected_isa() unless set_isa() was called.
+inline Isa active_isa() { return detail::isa_storage().load(std::memory_order_relaxed); }
+
+// Forces the kernels to use p_isa (clamped to detected_isa()), mostly useful to benchmark or test the slower paths.
+inline void set_isa(Isa p_isa) { detail::isa_storage().store(std::min(p_isa, detected_isa()), std::memory_order_relaxed); }
+
+namespace detail {
+
+// Scalar fallback, also handles the tails that don't fill a whole vector.
+
+template <Arithmetic T> sum_type<T> sum_scalar(const T *p_data, uint64_t p_count) {
+	sum_type<T> total = 0;
+	for (uint64_t i = 0; i < p_count; ++i) {
+		total += p_data[i];
+	}
+	return total;
+}
+
+template <bool IsMax, Arithmetic T> T min_max_scalar(const T *p_data, uint64_t p_count, T p_init) {
+	T result = p_init;
+	for (uint64_t i = 0; i < p_count; ++i) {
+		if constexpr (IsMax) {
+			result = p_data[i] > result ? p_data[i] : result;
+		} else {
+			result = p_data[i] < result ? p_data[i] : result;
+		}
+	}
+	return result;
+}
+
+template <Arithmetic T> T min_scalar(const T *p_data, uint64_t p_count) { return min_max_scalar<false>(p_data, p_count, std::numeric_limits<T>::max()); }
+template <Arithmetic T> T max_scalar(const T *p_data, uint64_t p_count) { return min_max_scalar<true>(p_data, p_count, std::numeric_limits<T>::lowest()); }
+
+template <Arithmetic T> void fill_scalar(T *p_data, uint64_t p_count, T p_value) {
+	for (uint64_t i = 0; i < p_count; ++i) {
+		p_data[i] = p_value;
+	}
+}
+
+// Integers wrap around on overflow instead of being UB.
+template <Arithmetic T> using wrap_type = typename std::conditional_t<std::is_integral_v<T>, std::make_unsigned<T>, std::type_identity<T>>::type;
+
+template <Arithmetic T> void axpy_scalar(T p_a, const T *p_x, T *p_y, uint64_t p_count) {
+	// Small unsigned types get promoted to int so do the scalar math in at least 32 bit unsigned.
+	using S = std::conditional_t<std::is_integral_v<T> and sizeof(T) < 4, uint32_t, wrap_type<T>>;
+	for (uint64_t i = 0; i < p_count; ++i) {
+		p_y[i] = static_cast<T>(S(p_a) * S(p_x[i]) + S(p_y[i]));
+	}
+}
+
+template <Compare Op, Arithmetic T> bool compare_op(T p_a, T p_b) {
+	if constexpr (Op == Compare::Equal) {
+		return p_a == p_b;
+	} else if constexpr (Op == Compare::NotEqual) {
+		return p_a != p_b;
+	} else if constexpr (Op == Compare::Less) {
+		return p_a < p_b;
+	} else if constexpr (Op == Compare::LessEqual) {
+		return p_a <= p_b;
+	} else if constexpr (Op == Compare::Greater) {
+		return p_a > p_b;
+	} else {
+		return p_a >= p_b;
+	}
+}
+
+template <Compare Op, Arithmetic T> uint64_t compare_bits_scalar(const T *p_data, uint64_t p_count, T p_value) {
+	uint64_t bits = 0;
+	for (uint64_t i = 0; i < p_count; ++i) {
+		bits |= uint64_t(compare_op<Op>(p_data[i], p_value)) << i;
+	}
+	return bits;
+}
+
+template <Compare Op, Arithmetic T> uint64_t compare_scalar(const T *p_data, uint64_t p_count, T p_value, uint64_t *r_words) {
+	uint64_t matches = 0;
+	for (uint64_t row = 0; row < p_count; row += 64) {
+		const uint64_t bits = compare_bits_scalar<Op>(p_data + row, std::min<uint64_t>(64, p_count - row), p_value);
+		r_words[row / 64] = bits;
+		matches += std::popcount(bits);
+	}
+	return matches;
+}
+
+template <Arithmetic T> uint64_t compare_scalar(const T *p_data, uint64_t p_count, Compare p_op, T p_value, uint64_t *r_words) {
+	switch (p_op) {
+		case Compare::Equal:        return compare_scalar<Compare::Equal>(p_data, p_count, p_value, r_words);
+		case Compare::NotEqual:     return compare_scalar<Compare::NotEqual>(p_data, p_count, p_value, r_words);
+		case Compare::Less:         return compare_scalar<Compare::Less>(p_data, p_count, p_value, r_words);
+		case Compare::LessEqual:    return compare_scalar<Compare::LessEqual>(p_data, p_count, p_value, r_words);
+		case Compare::Greater:      return compare_scalar<Compare::Greater>(p_data, p_count, p_value, r_words);
+		case Compare::GreaterEqual: return compare_scalar<Compare::GreaterEqual>(p_data, p_count, p_value, r_words);
+	}
+	return 0;
+}
+
+template <Arithmetic T> uint64_t find_scalar(const T *p_data, uint64_t p_count, T p_value) {
+	for (uint64_t i = 0; i < p_count; ++i) {
+		if (p_data[i] == p_value) {
+			return i;
+		}
+	}
+	return p_count;
+}
+
+template <Arithmetic T> uint64_t count_equal_scalar(const T *p_data, uint64_t p_count, T p_value) {
+	uint64_t matches = 0;
+	for (uint64_t i = 0; i < p_count; ++i) {
+		matches += p_data[i] == p_value;
+	}
+	return matches;
+}
+
+// Appends the index of every set bit in p_bits to r_indices.
+inline void append_bits(uint64_t p_bits, uint64_t p_first_row, SelectionVector &r_indices) {
+	uint64_t out = r_indices.size();
+	r_indices.resize(out + std::popcount(p_bits));
+	while (p_bits != 0) {
+		r_indices[out++] = SoaVectorSizeType(p_first_row + std::countr_zero(p_bits));
+		p_bits &= p_bits - 1;
+	}
+}
+
+template <Arithmetic T> void find_all_scalar(const T *p_data, uint64_t p_count, T p_value, SelectionVector &r_indices) {
+	for (uint64_t row = 0; row < p_count; row += 64) {
+		append_bits(compare_bits_scalar<Compare::Equal>(p_data + row, std::min<uint64_t>(64, p_count - row), p_value), row, r_indices);
+	}
+}
+
+template <Arithmetic T> bool any_of_scalar(T p_value, const T *p_values, uint64_t p_values_count) {
+	for (uint64_t k = 0; k < p_values_count; ++k) {
+		if (p_value == p_values[k]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <Arithmetic T> uint64_t find_any_of_scalar(const T *p_data, uint64_t p_count, const T *p_values, uint64_t p_values_count) {
+	for (uint64_t i = 0; i < p_count; ++i) {
+		if (any_of_scalar(p_data[i], p_values, p_values_count)) {
+			return i;
+		}
+	}
+	return p_count;
+}
+
+#ifdef SOA_SIMD_X86
+
+// The kernels are written once with GCC vector extensions and instantiated for each register width. They don't have a target attribute themselves, the per instruction set
+// entry points below do and use flatten to inline the whole kernel so the vector code gets compiled for that instruction set.
+// Only turning a compare result into a bitmask needs intrinsics, that is what the Ops structs are for.
+
+// Only aligned to T and may_alias so any row of a column can be read or written through it.
+// Helpers only ever take or return these by reference, passing them by value from a function without the target attribute makes GCC warn about the vector ABI.
+template <typename T, int Bytes> struct Vec {
+	typedef T type __attribute__((vector_size(Bytes), aligned(alignof(T)), may_alias));
+};
+
+struct Sse2Ops {
+	static constexpr int BYTES = 16;
+
+	template <typename M> [[gnu::target("sse2")]] static uint64_t movemask(const M &p_mask) {
+		const auto mask = (__m128i)p_mask;
+		if constexpr (sizeof(p_mask[0]) == 1) {
+			return uint32_t(_mm_movemask_epi8(mask));
+		} else if constexpr (sizeof(p_mask[0]) == 2) {
+			return uint32_t(_mm_movemask_epi8(_mm_packs_epi16(mask, _mm_setzero_si128())));
+		} else if constexpr (sizeof(p_mask[0]) == 4) {
+			return uint32_t(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+		} else {
+			return uint32_t(_mm_movemask_pd(_mm_castsi128_pd(mask)));
+		}
+	}
+};
+
+struct Avx2Ops {
+	static constexpr int BYTES = 32;
+
+	template <typename M> [[gnu::target("avx2")]] static uint64_t movemask(const M &p_mask) {
+		const auto mask = (__m256i)p_mask;
+		if constexpr (sizeof(p_mask[0]) == 1) {
+			return uint32_t(_mm256_movemask_epi8(mask));
+		} else if constexpr (sizeof(p_mask[0]) == 2) {
+			// packs works within 128 bit lanes so pack the 2 halves together instead of with each other to keep the rows in order.
+			return uint32_t(_mm_movemask_epi8(_mm_packs_epi16(_mm256_castsi256_si128(mask), _mm256_extracti128_si256(mask, 1))));
+		} else if constexpr (sizeof(p_mask[0]) == 4) {
+			return uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+		} else {
+			return uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+		}
+	}
+};
+
+struct Avx512Ops {
+	static constexpr int BYTES = 64;
+
+	template <typename M> [[gnu::target("avx512f,avx512bw,avx512dq")]] static uint64_t movemask(const M &p_mask) {
+		const auto mask = (__m512i)p_mask;
+		if constexpr (sizeof(p_mask[0]) == 1) {
+			return _mm512_movepi8_mask(mask);
+		} else if constexpr (sizeof(p_mask[0]) == 2) {
+			return _mm512_movepi16_mask(mask);
+		} else if constexpr (sizeof(p_mask[0]) == 4) {
+			return _mm512_movepi32_mask(mask);
+		} else {
+			return _mm512_movepi64_mask(mask);
+		}
+	}
+};
+
+template <typename V, typename T> const V &load(const T *p_src) { return *reinterpret_cast<const V *>(p_src); }
+
+template <typename V, typename T> void store(T *p_dst, const V &p_v) { *reinterpret_cast<V *>(p_dst) = p_v; }
+
+template <typename Ops, Compare Op, typename V> uint64_t compare_movemask(const V &p_a, const V &p_b) {
+	if constexpr (Op == Compare::Equal) {
+		return Ops::movemask(p_a == p_b);
+	} else if constexpr (Op == Compare::NotEqual) {
+		return Ops::movemask(p_a != p_b);
+	} else if constexpr (Op == Compare::Less) {
+		return Ops::movemask(p_a < p_b);
+	} else if constexpr (Op == Compare::LessEqual) {
+		return Ops::movemask(p_a <= p_b);
+	} else if constexpr (Op == Compare::Greater) {
+		return Ops::movemask(p_a > p_b);
+	} else {
+		return Ops::movemask(p_a >= p_b);
+	}
+}
+
+template <typename Ops, Arithmetic T> sum_type<T> sum_kernel(const T *p_data, uint64_t p_count) {
+	// The accumulators fill a whole register and each step loads as many T's as they have lanes, so for small integers a load is less than a register.
+	constexpr uint64_t LANES = Ops::BYTES / sizeof(sum_type<T>);
+	using Acc = typename Vec<sum_type<T>, Ops::BYTES>::type;
+	using V = typename Vec<T, LANES * sizeof(T)>::type;
+
+	// 4 accumulators so the adds don't wait on each other.
+	Acc acc0 = {}, acc1 = {}, acc2 = {}, acc3 = {};
+	uint64_t i = 0;
+	for (; i + 4 * LANES <= p_count; i += 4 * LANES) {
+		acc0 += __builtin_convertvector(load<V>(p_data + i), Acc);
+		acc1 += __builtin_convertvector(load<V>(p_data + i + LANES), Acc);
+		acc2 += __builtin_convertvector(load<V>(p_data + i + 2 * LANES), Acc);
+		acc3 += __builtin_convertvector(load<V>(p_data + i + 3 * LANES), Acc);
+	}
+	for (; i + LANES <= p_count; i += LANES) {
+		acc0 += __builtin_convertvector(load<V>(p_data + i), Acc);
+	}
+
+	const Acc total = (acc0 + acc1) + (acc2 + acc3);
+	sum_type<T> result = 0;
+	for (uint64_t lane = 0; lane < LANES; ++lane) {
+		result += total[lane];
+	}
+	return result + sum_scalar(p_data + i, p_count - i);
+}
+
+template <bool IsMax, typename V> void min_max_into(V &r_acc, const V &p_v) {
+	if constexpr (IsMax) {
+		r_acc = p_v > r_acc ? p_v : r_acc;
+	} else {
+		r_acc = p_v < r_acc ? p_v : r_acc;
+	}
+}
+
+template <typename Ops, bool IsMax, Arithmetic T> T min_max_kernel(const T *p_data, uint64_t p_count, T p_init) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+	constexpr uint64_t LANES = Ops::BYTES / sizeof(T);
+
+	V acc0 = V{} + p_init;
+	V acc1 = acc0;
+	uint64_t i = 0;
+	for (; i + 2 * LANES <= p_count; i += 2 * LANES) {
+		min_max_into<IsMax>(acc0, load<V>(p_data + i));
+		min_max_into<IsMax>(acc1, load<V>(p_data + i + LANES));
+	}
+	min_max_into<IsMax>(acc0, acc1);
+
+	T result = min_max_scalar<IsMax>(p_data + i, p_count - i, p_init);
+	for (uint64_t lane = 0; lane < LANES; ++lane) {
+		result = min_max_scalar<IsMax>(&acc0[lane], 1, result);
+	}
+	return result;
+}
+
+template <typename Ops, Arithmetic T> void fill_kernel(T *p_data, uint64_t p_count, T p_value) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+	constexpr uint64_t LANES = Ops::BYTES / sizeof(T);
+
+	const V value = V{} + p_value;
+	uint64_t i = 0;
+	for (; i + LANES <= p_count; i += LANES) {
+		store(p_data + i, value);
+	}
+	fill_scalar(p_data + i, p_count - i, p_value);
+}
+
+template <typename Ops, Arithmetic T> void axpy_kernel(T p_a, const T *p_x, T *p_y, uint64_t p_count) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+	constexpr uint64_t LANES = Ops::BYTES / sizeof(T);
+
+	// Signed overflow is UB for vectors too, do integer math in the unsigned type so it wraps like the scalar version.
+	using W = typename Vec<wrap_type<T>, Ops::BYTES>::type;
+	const W a = W{} + wrap_type<T>(p_a);
+	uint64_t i = 0;
+	for (; i + LANES <= p_count; i += LANES) {
+		store(p_y + i, (V)(a * (W)load<V>(p_x + i) + (W)load<V>(p_y + i)));
+	}
+	axpy_scalar(p_a, p_x + i, p_y + i, p_count - i);
+}
+
+// Compares the 64 rows starting at p_data.
+template <typename Ops, Compare Op, Arithmetic T, typename V> uint64_t compare_block(const T *p_data, const V &p_value) {
+	constexpr uint64_t LANES = Ops::BYTES / sizeof(T);
+	uint64_t bits = 0;
+	for (uint64_t k = 0; k < 64; k += LANES) {
+		bits |= compare_movemask<Ops, Op>(load<V>(p_data + k), p_value) << k;
+	}
+	return bits;
+}
+
+template <typename Ops, Compare Op, Arithmetic T> uint64_t compare_kernel(const T *p_data, uint64_t p_count, T p_value, uint64_t *r_words) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+
+	const V value = V{} + p_value;
+	uint64_t matches = 0;
+	uint64_t row = 0;
+	for (; row + 64 <= p_count; row += 64) {
+		const uint64_t bits = compare_block<Ops, Op>(p_data + row, value);
+		r_words[row / 64] = bits;
+		matches += std::popcount(bits);
+	}
+	if (row < p_count) {
+		const uint64_t bits = compare_bits_scalar<Op>(p_data + row, p_count - row, p_value);
+		r_words[row / 64] = bits;
+		matches += std::popcount(bits);
+	}
+	return matches;
+}
+
+template <typename Ops, Arithmetic T> uint64_t compare_kernel(const T *p_data, uint64_t p_count, Compare p_op, T p_value, uint64_t *r_words) {
+	switch (p_op) {
+		case Compare::Equal:        return compare_kernel<Ops, Compare::Equal>(p_data, p_count, p_value, r_words);
+		case Compare::NotEqual:     return compare_kernel<Ops, Compare::NotEqual>(p_data, p_count, p_value, r_words);
+		case Compare::Less:         return compare_kernel<Ops, Compare::Less>(p_data, p_count, p_value, r_words);
+		case Compare::LessEqual:    return compare_kernel<Ops, Compare::LessEqual>(p_data, p_count, p_value, r_words);
+		case Compare::Greater:      return compare_kernel<Ops, Compare::Greater>(p_data, p_count, p_value, r_words);
+		case Compare::GreaterEqual: return compare_kernel<Ops, Compare::GreaterEqual>(p_data, p_count, p_value, r_words);
+	}
+	return 0;
+}
+
+template <typename Ops, Arithmetic T> uint64_t find_kernel(const T *p_data, uint64_t p_count, T p_value) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+	constexpr uint64_t LANES = Ops::BYTES / sizeof(T);
+
+	const V value = V{} + p_value;
+	uint64_t i = 0;
+	// Check 4 registers per branch while nothing matches, then find the exact row 1 register at a time.
+	// The masks are combined after movemask, GCC 12 scalarizes ORing the compare results of 2 AVX-512 registers.
+	for (; i + 4 * LANES <= p_count; i += 4 * LANES) {
+		const uint64_t any = compare_movemask<Ops, Compare::Equal>(load<V>(p_data + i), value) | compare_movemask<Ops, Compare::Equal>(load<V>(p_data + i + LANES), value) |
+				compare_movemask<Ops, Compare::Equal>(load<V>(p_data + i + 2 * LANES), value) | compare_movemask<Ops, Compare::Equal>(load<V>(p_data + i + 3 * LANES), value);
+		if (any != 0) {
+			break;
+		}
+	}
+	for (; i + LANES <= p_count; i += LANES) {
+		const uint64_t bits = compare_movemask<Ops, Compare::Equal>(load<V>(p_data + i), value);
+		if (bits != 0) {
+			return i + std::countr_zero(bits);
+		}
+	}
+	return i + find_scalar(p_data + i, p_count - i, p_value);
+}
+
+template <typename Ops, Arithmetic T> uint64_t count_equal_kernel(const T *p_data, uint64_t p_count, T p_value) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+
+	// 1 popcount per 64 rows, SSE2 doesn't have a popcount instruction.
+	const V value = V{} + p_value;
+	uint64_t matches = 0;
+	uint64_t row = 0;
+	for (; row + 64 <= p_count; row += 64) {
+		matches += std::popcount(compare_block<Ops, Compare::Equal>(p_data + row, value));
+	}
+	return matches + count_equal_scalar(p_data + row, p_count - row, p_value);
+}
+
+template <typename Ops, Arithmetic T> void find_all_kernel(const T *p_data, uint64_t p_count, T p_value, SelectionVector &r_indices) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+
+	const V value = V{} + p_value;
+	uint64_t row = 0;
+	for (; row + 64 <= p_count; row += 64) {
+		const uint64_t bits = compare_block<Ops, Compare::Equal>(p_data + row, value);
+		if (bits != 0) {
+			append_bits(bits, row, r_indices);
+		}
+	}
+	if (row < p_count) {
+		append_bits(compare_bits_scalar<Compare::Equal>(p_data + row, p_count - row, p_value), row, r_indices);
+	}
+}
+
+template <typename Ops, Arithmetic T> uint64_t find_any_of_kernel(const T *p_data, uint64_t p_count, const T *p_values, uint64_t p_values_count) {
+	using V = typename Vec<T, Ops::BYTES>::type;
+	constexpr uint64_t LANES = Ops::BYTES / sizeof(T);
+	constexpr uint64_t MAX_VALUES = 8;
+
+	// Compares against up to 8 values per pass over the data. Every pass only has to search in front of the first match found by the earlier passes.
+	uint64_t end = p_count;
+	for (uint64_t first = 0; first < p_values_count; first += MAX_VALUES) {
+		const uint64_t values_count = std::min(MAX_VALUES, p_values_count - first);
+		const T *values = p_values + first;
+		V splats[MAX_VALUES];
+		for (uint64_t k = 0; k < values_count; ++k) {
+			splats[k] = V{} + values[k];
+		}
+
+		uint64_t i = 0;
+		uint64_t found = end;
+		for (; i + LANES <= end; i += LANES) {
+			const V &v = load<V>(p_data + i);
+			uint64_t bits = 0;
+			for (uint64_t k = 0; k < values_count; ++k) {
+				bits |= compare_movemask<Ops, Compare::Equal>(v, splats[k]);
+			}
+			if (bits != 0) {
+				found = i + std::countr_zero(bits);
+				break;
+			}
+		}
+		if (found == end) {
+			found = i + find_any_of_scalar(p_data + i, end - i, values, values_count);
+		}
+		end = found;
+	}
+	return end;
+}
+
+// Generates the entry points of every kernel for 1 instruction set.
+#define SOA_SIMD_ISA_KERNELS(m_isa, m_ops, m_target)                                                                                                                                         \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] sum_type<T> sum_##m_isa(const T *p_data, uint64_t p_count) { return sum_kernel<m_ops>(p_data, p_count); }                \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] T min_##m_isa(const T *p_data, uint64_t p_count) {                                                                       \
+		return min_max_kernel<m_ops, false>(p_data, p_count, std::numeric_limits<T>::max());                                                                                                 \
+	}                                                                                                                                                                                        \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] T max_##m_isa(const T *p_data, uint64_t p_count) {                                                                       \
+		return min_max_kernel<m_ops, true>(p_data, p_count, std::numeric_limits<T>::lowest());                                                                                               \
+	}                                                                                                                                                                                        \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] void fill_##m_isa(T *p_data, uint64_t p_count, T p_value) { fill_kernel<m_ops>(p_data, p_count, p_value); }              \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] void axpy_##m_isa(T p_a, const T *p_x, T *p_y, uint64_t p_count) { axpy_kernel<m_ops>(p_a, p_x, p_y, p_count); }         \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] uint64_t compare_##m_isa(const T *p_data, uint64_t p_count, Compare p_op, T p_value, uint64_t *r_words) {                \
+		return compare_kernel<m_ops>(p_data, p_count, p_op, p_value, r_words);                                                                                                               \
+	}                                                                                                                                                                                        \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] uint64_t find_##m_isa(const T *p_data, uint64_t p_count, T p_value) {                                                    \
+		return find_kernel<m_ops>(p_data, p_count, p_value);                                                                                                                                 \
+	}                                                                                                                                                                                        \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] uint64_t count_equal_##m_isa(const T *p_data, uint64_t p_count, T p_value) {                                             \
+		return count_equal_kernel<m_ops>(p_data, p_count, p_value);                                                                                                                          \
+	}                                                                                                                                                                                        \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] void find_all_##m_isa(const T *p_data, uint64_t p_count, T p_value, SelectionVector &r_indices) {                        \
+		find_all_kernel<m_ops>(p_data, p_count, p_value, r_indices);                                                                                                                         \
+	}                                                                                                                                                                                        \
+	template <Arithmetic T> [[gnu::target(m_target), gnu::flatten]] uint64_t find_any_of_##m_isa(const T *p_data, uint64_t p_count, const T *p_values, uint64_t p_values_count) {            \
+		return find_any_of_kernel<m_ops>(p_data, p_count, p_values, p_values_count);                                                                                                         \
+	}
+
+SOA_SIMD_ISA_KERNELS(sse2, Sse2Ops, "sse2")
+SOA_SIMD_ISA_KERNELS(avx2, Avx2Ops, "avx2,popcnt")
+SOA_SIMD_ISA_KERNELS(avx512, Avx512Ops, "avx512f,avx512bw,avx512dq,popcnt")
+
+#undef SOA_SIMD_ISA_KERNELS
+
+// Calls m_kernel##_avx512/_avx2/_sse2/_scalar depending on active_isa().
+#define SOA_SIMD_DISPATCH(m_kernel, ...)                                                                                                                                                     \
+	switch (active_isa()) {                                                                                                                                                                  \
+		case Isa::AVX512: return detail::m_kernel##_avx512(__VA_ARGS__);                                                                                                                     \
+		case Isa::AVX2:   return detail::m_kernel##_avx2(__VA_ARGS__);                                                                                                                       \
+		case Isa::SSE2:   return detail::m_kernel##_sse2(__VA_ARGS__);                                                                                                                       \
+		case Isa::Scalar: break;                                                                                                                                                             \
+	}                                                                                                                                                                                        \
+	return detail::m_kernel##_scalar(__VA_ARGS__);
+
+#else
+
+#define SOA_SIMD_DISPATCH(m_kernel, ...) return detail::m_kernel##_scalar(__VA_ARGS__);
+
+#endif
+
+} // namespace detail
+
+template <Arithmetic T> sum_type<T> sum(const T *p_data, uint64_t p_count) { SOA_SIMD_DISPATCH(sum, p_data, p_count) }
+
+// Returns std::numeric_limits<T>::max() if p_count is 0.
+template <Arithmetic T> T min(const T *p_data, uint64_t p_count) { SOA_SIMD_DISPATCH(min, p_data, p_count) }
+
+// Returns std::numeric_limits<T>::lowest() if p_count is 0.
+template <Arithmetic T> T max(const T *p_data, uint64_t p_count) { SOA_SIMD_DISPATCH(max, p_data, p_count) }
+
+template <Arithmetic T> void fill(T *p_data, uint64_t p_count, T p_value) { SOA_SIMD_DISPATCH(fill, p_data, p_count, p_value) }
+
+// p_y[i] = p_a * p_x[i] + p_y[i], integers wrap around on overflow.
+template <Arithmetic T> void axpy(T p_a, const T *p_x, T *p_y, uint64_t p_count) { SOA_SIMD_DISPATCH(axpy, p_a, p_x, p_y, p_count) }
+
+// Sets bit i of r_mask if p_data[i] <p_op> p_value and returns how many rows matched.
+template <Arithmetic T> uint64_t compare(const T *p_data, uint64_t p_count, Compare p_op, T p_value, BitMask &r_mask) {
+	r_mask.resize((p_count + 63) / 64);
+	SOA_SIMD_DISPATCH(compare, p_data, p_count, p_op, p_value, r_mask.data())
+}
+
+namespace detail {
+
+template <typename T> using search_t = typename search_type<T>::type;
+
+template <Searchable T> const search_t<T> *search_ptr(const T *p_data) { return reinterpret_cast<const search_t<T> *>(p_data); }
+template <Searchable T> search_t<T> search_value(T p_value) { return static_cast<search_t<T>>(p_value); }
+
+template <Arithmetic T> uint64_t find(const T *p_data, uint64_t p_count, T p_value) { SOA_SIMD_DISPATCH(find, p_data, p_count, p_value) }
+template <Arithmetic T> uint64_t count_equal(const T *p_data, uint64_t p_count, T p_value) { SOA_SIMD_DISPATCH(count_equal, p_data, p_count, p_value) }
+template <Arithmetic T> void find_all(const T *p_data, uint64_t p_count, T p_value, SelectionVector &r_indices) {
+	SOA_SIMD_DISPATCH(find_all, p_data, p_count, p_value, r_indices)
+}
+template <Arithmetic T> uint64_t find_any_of(const T *p_data, uint64_t p_count, const T *p_values, uint64_t p_values_count) {
+	SOA_SIMD_DISPATCH(find_any_of, p_data, p_count, p_values, p_values_count)
+}
+
+} // namespace detail
+
+// Index of the first row equal to p_value, p_count if there is none. Stops reading at the first match.
+template <Searchable T> uint64_t find(const T *p_data, uint64_t p_count, T p_value) { return detail::find(detail::search_ptr(p_data), p_count, detail::search_value(p_value)); }
+
+template <Searchable T> uint64_t count_equal(const T *p_data, uint64_t p_count, T p_value) {
+	return detail::count_equal(detail::search_ptr(p_data), p_count, detail::search_value(p_value));
+}
+
+// Appends the index of every row equal to p_value to r_indices. p_count has to fit in a SoaVectorSizeType.
+template <Searchable T> void find_all(const T *p_data, uint64_t p_count, T p_value, SelectionVector &r_indices) {
+	detail::find_all(detail::search_ptr(p_data), p_count, detail::search_value(p_value), r_indices);
+}
+
+// Index of the first row equal to any of p_values, p_count if there is none.
+template <Searchable T> uint64_t find_any_of(const T *p_data, uint64_t p_count, const T *p_values, uint64_t p_values_count) {
+	return detail::find_any_of(detail::search_ptr(p_data), p_count, detail::search_ptr(p_values), p_values_count);
+}
+
+#undef SOA_SIMD_DISPATCH
+
+// Appends the index of every set bit in p_mask to r_indices.
+inline void mask_to_selection(const BitMask &p_mask, SelectionVector &r_indices) {
+	for (uint64_t word = 0; word < p_mask.size(); ++word) {
+		if (p_mask[word] != 0) {
+			detail::append_bits(p_mask[word], word * 64, r_indices);
+		}
+	}
+}
+
+// Column versions, these run over the size() elements that were pushed (or all of them for a FixedSizeSOA).
+
+template <Arithmetic T> sum_type<T> sum(const SoaVector<T> &p_column) { return sum(p_column.ptr(), p_column.size()); }
+template <Arithmetic T> T min(const SoaVector<T> &p_column) { return min(p_column.ptr(), p_column.size()); }
+template <Arithmetic T> T max(const SoaVector<T> &p_column) { return max(p_column.ptr(), p_column.size()); }
+template <Arithmetic T> void fill(SoaVector<T> &p_column, T p_value) { fill(p_column.ptr(), p_column.size(), p_value); }
+
+// Only the rows that exist in both columns are updated.
+template <Arithmetic T> void axpy(T p_a, const SoaVector<T> &p_x, SoaVector<T> &r_y) { axpy(p_a, p_x.ptr(), r_y.ptr(), std::min(p_x.size(), r_y.size())); }
+
+template <Arithmetic T> uint64_t compare(const SoaVector<T> &p_column, Compare p_op, T p_value, BitMask &r_mask) {
+	return compare(p_column.ptr(), p_column.size(), p_op, p_value, r_mask);
+}
+
+} // namespace simd
+
+} // namespace soa
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+#include "SoaParallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// SOA structs with at least this many rows are sorted with soa::default_thread_pool(): the comparison sort sorts a chunk per thread and merges them and the columns are
+// permuted in parallel (1 column per task). Define it before including soa.hpp to change it.
+#ifndef SOA_PARALLEL_SORT_ROWS
+#define SOA_PARALLEL_SORT_ROWS (1u << 20)
+#endif
+
+namespace soa {
+
+// Row order produced by sort_permutation, row i of the sorted table is row permutation[i] of the unsorted one.
+using Permutation = std::vector<SoaVectorSizeType>;
+
+// True if p_permutation has p_rows entries and every row index below p_rows is one of them.
+inline bool is_permutation_of_rows(const Permutation &p_permutation, SoaVectorSizeType p_rows) {
+	if (p_permutation.size() != p_rows) {
+		return false;
+	}
+	std::vector<bool> seen(p_rows);
+	for (const SoaVectorSizeType row : p_permutation) {
+		if (row >= p_rows or seen[row]) {
+			return false;
+		}
+		seen[row] = true;
+	}
+	return true;
+}
+
+// The cycles of a Permutation, computed once and then used to permute every non trivially copyable column in place. Rows that don't move are left out.
+class PermutationCycles {
+	// Each cycle is a run of row indices i0, i1, i2... where row i0 gets the value of row i1, i1 gets i2 and the last one gets the old value of i0.
+	std::vector<SoaVectorSizeType> order;
+	std::vector<SoaVectorSizeType> cycle_ends;
+
+public:
+	explicit PermutationCycles(const Permutation &p_permutation) {
+		std::vector<bool> visited(p_permutation.size());
+		order.reserve(p_permutation.size());
+		for (SoaVectorSizeType start = 0; start < p_permutation.size(); ++start) {
+			if (visited[start] or p_permutation[start] == start) {
+				continue;
+			}
+			SoaVectorSizeType row = start;
+			do {
+				visited[row] = true;
+				order.push_back(row);
+				row = p_permutation[row];
+			} while (row != start);
+			cycle_ends.push_back(SoaVectorSizeType(order.size()));
+		}
+	}
+
+	// Moves every element of p_column to its sorted position. Each element is moved once plus 1 extra move per cycle.
+	template <typename T> void apply(T *p_column) const {
+		SoaVectorSizeType begin = 0;
+		for (const SoaVectorSizeType end : cycle_ends) {
+			T first = std::move(p_column[order[begin]]);
+			for (SoaVectorSizeType i = begin; i + 1 < end; ++i) {
+				p_column[order[i]] = std::move(p_column[order[i + 1]]);
+			}
+			p_column[order[end - 1]] = std::move(first);
+			begin = end;
+		}
+	}
+
+	[[nodiscard]] bool empty() const { return cycle_ends.empty(); }
+};
+
+namespace detail {
+
+template <typename T>
+concept RadixSortable = (std::integral<T> and !std::same_as<T, bool>) or std::same_as<T, float> or std::same_as<T, double>;
+
+template <typename Compare, typename T>
+concept Ascending = std::same_as<Compare, std::less<>> or std::same_as<Compare, std::less<T>> or std::same_as<Compare, std::ranges::less>;
+
+template <typename Compare, typename T>
+concept Descending = std::same_as<Compare, std::greater<>> or std::same_as<Compare, std::greater<T>> or std::same_as<Compare, std::ranges::greater>;
+
+template <typename T>
+using radix_key_type = std::conditional_t<sizeof(T) == 1, uint8_t, std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+// Maps p_value to an unsigned key with the same order so the radix sort only has to deal with unsigned bytes.
+template <typename T> radix_key_type<T> radix_key(T p_value) {
+	using Key = radix_key_type<T>;
+	constexpr Key sign_bit = Key(Key(1) << (sizeof(T) * 8 - 1));
+	if constexpr (std::floating_point<T>) {
+		// Negative floats are ordered backwards so all of their bits get flipped, positive ones only need the sign bit set to go after the negative ones.
+		const Key bits = std::bit_cast<Key>(p_value);
+		return (bits & sign_bit) ? Key(~bits) : Key(bits | sign_bit);
+	} else if constexpr (std::is_signed_v<T>) {
+		return Key(Key(p_value) ^ sign_bit);
+	} else {
+		return Key(p_value);
+	}
+}
+
+// Stable LSD radix sort of the row indices by p_keys, 1 byte per pass. Passes where every key has the same byte are skipped so small keys in a wide type stay cheap.
+template <bool Descending, typename T> void radix_sort_permutation(const T *p_keys, SoaVectorSizeType p_count, Permutation &r_permutation) {
+	using Key = radix_key_type<T>;
+	constexpr uint32_t passes = sizeof(Key);
+
+	std::vector<Key> keys(p_count);
+	std::array<std::array<SoaVectorSizeType, 256>, passes> histograms{};
+	for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+		keys[i] = Descending ? Key(~radix_key(p_keys[i])) : radix_key(p_keys[i]);
+		for (uint32_t pass = 0; pass < passes; ++pass) {
+			histograms[pass][(keys[i] >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	r_permutation.resize(p_count);
+	std::iota(r_permutation.begin(), r_permutation.end(), SoaVectorSizeType(0));
+	std::vector<Key> scratch_keys(p_count);
+	Permutation scratch_rows(p_count);
+	for (uint32_t pass = 0; pass < passes; ++pass) {
+		std::array<SoaVectorSizeType, 256> &histogram = histograms[pass];
+		if (std::ranges::find(histogram, p_count) != histogram.end()) {
+			continue;
+		}
+
+		SoaVectorSizeType offset = 0;
+		for (SoaVectorSizeType &bucket : histogram) {
+			offset += std::exchange(bucket, offset);
+		}
+		for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+			const SoaVectorSizeType destination = histogram[(keys[i] >> (pass * 8)) & 0xFF]++;
+			scratch_keys[destination] = keys[i];
+			scratch_rows[destination] = r_permutation[i];
+		}
+		keys.swap(scratch_keys);
+		r_permutation.swap(scratch_rows);
+	}
+}
+
+// Stable comparison sort of the row indices. Big tables are split into a chunk per thread that are sorted in parallel and then merged in parallel passes.
+template <typename T, typename Compare> void comparison_sort_permutation(const T *p_keys, SoaVectorSizeType p_count, Compare p_compare, Permutation &r_permutation) {
+	r_permutation.resize(p_count);
+	std::iota(r_permutation.begin(), r_permutation.end(), SoaVectorSizeType(0));
+	const auto compare_rows = [&](SoaVectorSizeType p_a, SoaVectorSizeType p_b) { return p_compare(p_keys[p_a], p_keys[p_b]); };
+
+	ThreadPool &pool = default_thread_pool();
+	const uint64_t chunk_count = p_count >= SOA_PARALLEL_SORT_ROWS ? pool.thread_count() : 1;
+	const uint64_t chunk_rows = (p_count + chunk_count - 1) / std::max<uint64_t>(chunk_count, 1);
+	if (chunk_count <= 1) {
+		std::stable_sort(r_permutation.begin(), r_permutation.end(), compare_rows);
+		return;
+	}
+
+	const auto chunk_begin = [&](uint64_t p_chunk) { return r_permutation.begin() + std::ptrdiff_t(std::min<uint64_t>(p_chunk * chunk_rows, p_count)); };
+	pool.run(chunk_count, [&](uint64_t p_chunk) { std::stable_sort(chunk_begin(p_chunk), chunk_begin(p_chunk + 1), compare_rows); });
+	for (uint64_t width = 1; width < chunk_count; width *= 2) {
+		pool.run((chunk_count + width * 2 - 1) / (width * 2), [&](uint64_t p_merge) {
+			const uint64_t first = p_merge * width * 2;
+			std::inplace_merge(chunk_begin(first), chunk_begin(first + width), chunk_begin(first + width * 2), compare_rows);
+		});
+	}
+}
+
+} // namespace detail
+
+// Returns the order that sorts p_keys by p_compare, ties keep their original order. std::less/std::greater on integer, float and double keys use a radix sort.
+template <typename T, typename Compare = std::less<>> [[nodiscard]] Permutation sort_permutation(const T *p_keys, SoaVectorSizeType p_count, Compare p_compare = {}) {
+	Permutation permutation;
+	if constexpr (detail::RadixSortable<T> and detail::Ascending<Compare, T>) {
+		detail::radix_sort_permutation<false>(p_keys, p_count, permutation);
+	} else if constexpr (detail::RadixSortable<T> and detail::Descending<Compare, T>) {
+		detail::radix_sort_permutation<true>(p_keys, p_count, permutation);
+	} else {
+		detail::comparison_sort_permutation(p_keys, p_count, p_compare, permutation);
+	}
+	return permutation;
+}
+
+// Same for the first p_count rows of a column. Encoded columns (soa::Packed, the string columns) are read into a vector of their values first, bools as bytes because
+// std::vector<bool> has no data().
+template <typename T, typename Compare = std::less<>> [[nodiscard]] Permutation sort_permutation(const SoaVector<T> &p_column, SoaVectorSizeType p_count, Compare p_compare = {}) {
+	if constexpr (is_encoded_column_v<T>) {
+		using Value = typename SoaVector<T>::value_type;
+		const std::vector<std::conditional_t<std::is_same_v<Value, bool>, uint8_t, Value>> keys(p_column.begin(), p_column.begin() + p_count);
+		return sort_permutation(keys.data(), p_count, p_compare);
+	} else {
+		return sort_permutation(p_column.ptr(), p_count, p_compare);
+	}
+}
+
+namespace detail {
+
+// Trivially copyable columns are gathered into r_scratch in sorted order and copied back. Following the cycles would be a chain of dependent cache misses (every step needs the
+// previous one's index) while the gather's loads are independent, and it doesn't need the cycles at all.
+template <typename T> void permute_column(T *p_column, const Permutation &p_permutation, const PermutationCycles *p_cycles, std::vector<std::byte> &r_scratch) {
+	if constexpr (requires { T::permute(p_column, p_permutation, r_scratch); }) {
+		// Columns that aren't one element per row (soa::PackedWord) permute themselves.
+		T::permute(p_column, p_permutation, r_scratch);
+	} else if constexpr (std::is_trivially_copyable_v<T>) {
+		r_scratch.resize(p_permutation.size() * sizeof(T));
+		T *scratch = reinterpret_cast<T *>(r_scratch.data());
+		for (uint64_t i = 0; i < p_permutation.size(); ++i) {
+			memcpy(static_cast<void *>(scratch + i), static_cast<const void *>(p_column + p_permutation[i]), sizeof(T));
+		}
+		memcpy(static_cast<void *>(p_column), r_scratch.data(), p_permutation.size() * sizeof(T));
+	} else {
+		p_cycles->apply(p_column);
+	}
+}
+
+} // namespace detail
+
+// Reorders the first p_permutation.size() rows of every column so row i gets the old row p_permutation[i]. Non trivially copyable columns are permuted in place by following
+// the cycles of the permutation so each element is only moved, the rest go through a scratch buffer. Each column is a separate task on the default thread pool when there
+// are at least SOA_PARALLEL_SORT_ROWS rows.
+template <typename... T> void permute_columns(const Permutation &p_permutation, T *...p_columns) {
+	std::optional<PermutationCycles> cycles;
+	if constexpr ((!std::is_trivially_copyable_v<T> or ...)) {
+		cycles.emplace(p_permutation);
+		if (cycles->empty()) {
+			return;
+		}
+	}
+
+	const PermutationCycles *cycles_ptr = cycles ? &*cycles : nullptr;
+	const uint64_t column_count = sizeof...(T);
+	if (p_permutation.size() >= SOA_PARALLEL_SORT_ROWS) {
+		default_thread_pool().run(column_count, [&](uint64_t p_column) {
+			std::vector<std::byte> scratch;
+			uint64_t column = 0;
+			((column++ == p_column ? detail::permute_column(p_columns, p_permutation, cycles_ptr, scratch) : void()), ...);
+		});
+	} else {
+		std::vector<std::byte> scratch;
+		(detail::permute_column(p_columns, p_permutation, cycles_ptr, scratch), ...);
+	}
+}
+
+} // namespace soa
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "FlatIndexMap.hpp"
+#include "SoaVector.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+// Allocation statistics of the SOA macros. Define SOA_ENABLE_STATS before including soa.hpp to give every SOA struct stats(), reset_stats() and set_growth_hook(). Without it the
+// counters aren't members of the structs and the code that updates them isn't compiled, so it costs nothing. memory_report() is always there, it only reads the current columns.
+#ifdef SOA_ENABLE_STATS
+#define SOA_STATS_CALL(...) __VA_ARGS__
+#else
+#define SOA_STATS_CALL(...)
+#endif
+
+namespace soa {
+
+// Counted since the struct was created or since reset_stats(). realloc_calls counts every new column block including the first one from init, with an allocator policy that
+// reserves rows (see soa::VirtualReserveAllocator) it counts every commit instead and bytes_allocated is the bytes committed while bytes_moved stays 0.
+// peak_size is sampled when the struct reallocates, erases or clears and by stats(), so rows that were pushed and erased in between can be missed.
+struct SoaStats {
+	uint64_t init_calls = 0;
+	uint64_t realloc_calls = 0;
+	uint64_t bytes_allocated = 0;
+	uint64_t bytes_moved = 0;
+	uint64_t erase_calls = 0;
+	uint64_t erased_rows = 0;
+	SoaVectorSizeType capacity = 0;
+	SoaVectorSizeType size = 0;
+	SoaVectorSizeType peak_capacity = 0;
+	SoaVectorSizeType peak_size = 0;
+	// Only filled by MutableSOA with a map that has probe_stats(), like the default soa::FlatIndexMap.
+	ProbeStats index_probes;
+};
+
+// Passed to the growth hook after every soa_realloc, size is the row count at that point.
+struct GrowthEvent {
+	const char *table;
+	SoaVectorSizeType old_capacity;
+	SoaVectorSizeType new_capacity;
+	SoaVectorSizeType size;
+	uint64_t bytes_allocated;
+	uint64_t bytes_moved;
+};
+
+using GrowthHook = std::function<void(const GrowthEvent &)>;
+
+struct ColumnMemory {
+	// "type name" of the member, the same string save() writes.
+	const char *name;
+	SoaVectorSizeType size;
+	SoaVectorSizeType capacity;
+	// The bytes of size and capacity rows, not always a multiple of the rows for soa::Packed columns.
+	uint64_t size_bytes;
+	uint64_t capacity_bytes;
+
+	[[nodiscard]] uint64_t used_bytes() const { return size_bytes; }
+	[[nodiscard]] uint64_t reserved_bytes() const { return capacity_bytes; }
+};
+
+// block_bytes is the size of the block every column lives in (the file for MappedSOA, the whole reservation for soa::VirtualReserveAllocator) and index_bytes the entity id
+// map and id arrays of MutableSOA and SparseSOA. Memory the members own themselves (the characters of a std::string) isn't counted.
+struct MemoryReport {
+	std::vector<ColumnMemory> columns;
+	uint64_t block_bytes = 0;
+	uint64_t index_bytes = 0;
+
+	[[nodiscard]] uint64_t used_bytes() const {
+		uint64_t bytes = 0;
+		for (const ColumnMemory &column : columns) {
+			bytes += column.used_bytes();
+		}
+		return bytes;
+	}
+	[[nodiscard]] uint64_t reserved_bytes() const {
+		uint64_t bytes = 0;
+		for (const ColumnMemory &column : columns) {
+			bytes += column.reserved_bytes();
+		}
+		return bytes;
+	}
+	// Capacity that no row uses.
+	[[nodiscard]] uint64_t wasted_bytes() const { return reserved_bytes() - used_bytes(); }
+
+	// One line per column and the totals, for logs.
+	void print(std::ostream &p_stream) const {
+		for (const ColumnMemory &column : columns) {
+			p_stream << column.name << ": " << column.size << " / " << column.capacity << " rows, " << column.used_bytes() << " / " << column.reserved_bytes() << " bytes\n";
+		}
+		p_stream << "used " << used_bytes() << " bytes, block " << block_bytes << " bytes, index " << index_bytes << " bytes, wasted " << wasted_bytes() << " bytes\n";
+	}
+};
+
+// SOA_MAP_TYPE can be any map, only the ones that have them report probe lengths and memory.
+template <typename Map> [[nodiscard]] ProbeStats index_probe_stats(const Map &p_map) {
+	if constexpr (requires { p_map.probe_stats(); }) {
+		return p_map.probe_stats();
+	} else {
+		return {};
+	}
+}
+
+template <typename Map> [[nodiscard]] uint64_t index_memory_bytes(const Map &p_map) {
+	if constexpr (requires { p_map.memory_bytes(); }) {
+		return p_map.memory_bytes();
+	} else {
+		return 0;
+	}
+}
+
+} // namespace soa
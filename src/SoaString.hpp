@@ -0,0 +1,613 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+#include "SoaErase.hpp"
+#include "SoaSerialize.hpp"
+#include "SoaSimd.hpp"
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace soa {
+
+// Member types of the string columns. A std::string column stores 32 bytes per row plus a heap allocation for every string that doesn't fit in its SSO buffer, these store
+// every row in 8 (soa::ArenaString) or 4 (soa::DictString) bytes of the SOA block and the characters somewhere else:
+// - soa::ArenaString keeps the characters of every row back to back in one arena owned by the column, so pushing a string is a memcpy and scanning the column reads the arena
+//   in order. Overwriting a row with a longer string or erasing rows leaves the old characters in the arena, they are compacted once they are more than half of it.
+// - soa::DictString stores a 32 bit code per row and every distinct string once, for columns with few distinct values (names, tags, categories). find/count_equal/where
+//   look the string up once and then compare codes with the soa::simd kernels.
+// The struct API uses std::string_view, push_x("name"), get_x(i) and soa.x.count_equal("name"), x[i] is a proxy that can be assigned a string_view. The views point into the
+// column and are valid until it changes. Like soa::Packed (see SoaPacked.hpp) they work in DynamicSOA, FixedSizeSOA, MutableSOA and SparseSOA but not in the macros that hand out raw
+// column pointers (MappedSOA, TiledSOA, soa::Table) or in ConcurrentAppendSOA.
+struct ArenaString {};
+struct DictString {};
+
+template <> constexpr bool is_encoded_column_v<ArenaString> = true;
+template <> constexpr bool is_encoded_column_v<DictString> = true;
+
+// Where the characters of an ArenaString row are in the arena.
+struct StringSlot {
+	uint32_t offset;
+	uint32_t length;
+};
+
+// What x[i] of a string column returns, reads the row as a string_view and writes it with the column's assign.
+template <typename Column> class StringReference {
+	Column *column;
+	SoaVectorSizeType index;
+
+public:
+	StringReference(Column *p_column, SoaVectorSizeType p_index) : column(p_column), index(p_index) {}
+	StringReference(const StringReference &) = default;
+
+	operator std::string_view() const { return std::as_const(*column)[index]; }
+	StringReference &operator=(std::string_view p_value) {
+		column->assign(index, p_value);
+		return *this;
+	}
+	StringReference &operator=(const StringReference &p_other) { return *this = std::string_view(p_other); }
+
+	friend bool operator==(const StringReference &p_reference, std::string_view p_value) { return std::string_view(p_reference) == p_value; }
+};
+
+template <> class SoaVector<ArenaString> {
+public:
+	using value_type = std::string_view;
+	using reference = StringReference<SoaVector>;
+	using const_reference = std::string_view;
+	// What the rows are copied into when they have to outlive the column (deltas).
+	using owning_value_type = std::string;
+
+	// The arena isn't compacted before it has this many bytes.
+	static constexpr uint64_t MIN_COMPACT_BYTES = 4096;
+
+private:
+	SoaVectorSizeType count = 0;
+	StringSlot *data = nullptr;
+	std::vector<char> arena;
+	// Bytes of the arena no row points at anymore.
+	uint64_t garbage = 0;
+
+	static StringSlot *column_ptr(void *p_data, uint64_t p_memory_offset) { return reinterpret_cast<StringSlot *>(static_cast<std::byte *>(p_data) + p_memory_offset); }
+
+	[[nodiscard]] bool in_arena(std::string_view p_value) const {
+		return !arena.empty() and std::less_equal<const char *>()(arena.data(), p_value.data()) and std::less<const char *>()(p_value.data(), arena.data() + arena.size());
+	}
+
+	// Copies p_value to the end of the arena. p_value can be a row of this column, the arena is grown before it's copied.
+	StringSlot append(std::string_view p_value) {
+		if (arena.size() + p_value.size() > std::numeric_limits<uint32_t>::max()) {
+			throw std::length_error("soa::ArenaString: a column can't hold more than 4 GiB of characters");
+		}
+		const StringSlot slot{ uint32_t(arena.size()), uint32_t(p_value.size()) };
+		if (in_arena(p_value)) {
+			const uint64_t offset = uint64_t(p_value.data() - arena.data());
+			arena.resize(arena.size() + p_value.size());
+			memcpy(arena.data() + slot.offset, arena.data() + offset, p_value.size());
+		} else {
+			arena.insert(arena.end(), p_value.begin(), p_value.end());
+		}
+		return slot;
+	}
+
+	// Called with the bytes rows stopped pointing at, compacts the arena once they are more than half of it.
+	void free_bytes(uint64_t p_bytes) {
+		garbage += p_bytes;
+		if (garbage * 2 > arena.size() and arena.size() >= MIN_COMPACT_BYTES) {
+			compact();
+		}
+	}
+
+public:
+	// Do not use this directly, it has to be public. Use set_X in the SOA struct instead.
+	// Overwrites the characters of the row if p_value fits in them and appends it to the arena otherwise.
+	void assign(SoaVectorSizeType p_index, std::string_view p_value) {
+		StringSlot &slot = data[p_index];
+		if (p_value.size() <= slot.length) {
+			if (!p_value.empty()) {
+				memmove(arena.data() + slot.offset, p_value.data(), p_value.size());
+			}
+			const uint32_t freed = slot.length - uint32_t(p_value.size());
+			slot.length = uint32_t(p_value.size());
+			free_bytes(freed);
+		} else {
+			const uint32_t freed = slot.length;
+			slot = append(p_value);
+			free_bytes(freed);
+		}
+	}
+
+	// Do not use this directly, it has to be public. Use load in the SOA struct instead.
+	// Replaces the rows with p_lengths.size() rows whose characters are back to back in p_arena.
+	void load_arena(std::vector<char> &&p_arena, const std::vector<uint32_t> &p_lengths) {
+		arena = std::move(p_arena);
+		garbage = 0;
+		uint32_t offset = 0;
+		for (SoaVectorSizeType i = 0; i < p_lengths.size(); ++i) {
+			data[i] = { offset, p_lengths[i] };
+			offset += p_lengths[i];
+		}
+		count = SoaVectorSizeType(p_lengths.size());
+	}
+
+	// Copies the characters of every row into a new arena in row order and drops the garbage. Happens on its own once garbage_bytes() is more than half of arena_bytes().
+	void compact() {
+		std::vector<char> compacted;
+		compacted.reserve(arena.size() - garbage);
+		for (SoaVectorSizeType i = 0; i < count; ++i) {
+			const uint32_t offset = uint32_t(compacted.size());
+			compacted.insert(compacted.end(), arena.begin() + data[i].offset, arena.begin() + data[i].offset + data[i].length);
+			data[i].offset = offset;
+		}
+		arena = std::move(compacted);
+		garbage = 0;
+	}
+
+	// Used by the SOA macros instead of sizeof(T) * rows to lay out the columns, the arena isn't part of the SOA block.
+	static constexpr uint64_t column_bytes(uint64_t p_rows) { return sizeof(StringSlot) * p_rows; }
+
+	// Do not use this directly, it has to be public. Use push_X in the SOA struct instead.
+	SoaVectorSizeType push_soa_member(std::string_view p_elem) {
+		data[count] = append(p_elem);
+		return ++count;
+	}
+
+	template <typename... Args> SoaVectorSizeType emplace_soa_member(Args &&...p_args) { return push_soa_member(std::string_view(std::forward<Args>(p_args)...)); }
+
+	// Rows filled by different threads would append to the same arena.
+	template <typename... Args> void emplace_soa_member_at(SoaVectorSizeType /*p_index*/, Args &&.../*p_args*/) {
+		static_assert(sizeof...(Args) < 0, "soa::ArenaString columns can't be filled from multiple threads");
+	}
+
+	void commit_soa_members(SoaVectorSizeType p_count) { count += p_count; }
+
+	void truncate_soa_member(SoaVectorSizeType p_size) {
+		uint64_t freed = 0;
+		for (SoaVectorSizeType i = p_size; i < count; i++) {
+			freed += data[i].length;
+		}
+		count = std::min(count, p_size);
+		free_bytes(freed);
+	}
+
+	// Only the slots are in the SOA block so growing never copies the characters.
+	void soa_realloc(void *new_data, uint64_t p_memory_offset) {
+		StringSlot *new_column_data = column_ptr(new_data, p_memory_offset);
+		if (count > 0) {
+			memcpy(new_column_data, data, column_bytes(count));
+		}
+		data = new_column_data;
+	}
+
+	void destroy_at(SoaVectorSizeType /*p_index*/) {}
+
+	void post_erase(SoaVectorSizeType p_index_to_erase, SoaVectorSizeType p_end_index) {
+		if (p_index_to_erase >= count) {
+			return;
+		}
+		const uint32_t freed = data[p_index_to_erase].length;
+		if (p_end_index >= count) {
+			data[p_index_to_erase] = { 0, 0 };
+		} else {
+			data[p_index_to_erase] = data[p_end_index];
+		}
+		if (count - 1 == p_end_index) {
+			count--;
+		}
+		free_bytes(freed);
+	}
+
+	void compact_soa_member(const simd::BitMask &p_erased, std::span<const RowMove> p_moves, SoaVectorSizeType p_new_size) {
+		uint64_t freed = 0;
+		for (uint64_t word = 0; word < p_erased.size() and word * 64 < count; ++word) {
+			for (uint64_t bits = p_erased[word]; bits != 0; bits &= bits - 1) {
+				const uint64_t index = word * 64 + uint64_t(std::countr_zero(bits));
+				if (index < count) {
+					freed += data[index].length;
+				}
+			}
+		}
+		for (const RowMove &move : p_moves) {
+			data[move.to] = data[move.from];
+		}
+		count = p_new_size;
+		free_bytes(freed);
+	}
+
+	void init(void *p_data, SoaVectorSizeType /*p_size*/, uint64_t p_memory_offset) { data = column_ptr(p_data, p_memory_offset); }
+
+	// FixedSizeSOA zeroes the slots, every row starts as an empty string.
+	void init_fixed(void *p_data, SoaVectorSizeType p_size, uint64_t p_memory_offset) {
+		data = column_ptr(p_data, p_memory_offset);
+		count = p_size;
+		arena.clear();
+		garbage = 0;
+	}
+
+	void *get_data() { return data; }
+	StringSlot *ptr() { return data; }
+	[[nodiscard]] const StringSlot *ptr() const { return data; }
+
+	void clear() {
+		count = 0;
+		arena.clear();
+		garbage = 0;
+	}
+
+	void reset() {
+		clear();
+		arena.shrink_to_fit();
+		data = nullptr;
+	}
+
+	[[nodiscard]] bool is_empty() const { return count == 0; }
+
+	[[nodiscard]] SoaVectorSizeType size() const { return count; }
+
+	[[nodiscard]] uint64_t arena_bytes() const { return arena.size(); }
+	[[nodiscard]] uint64_t garbage_bytes() const { return garbage; }
+
+	std::string_view operator[](SoaVectorSizeType p_index) const { return { arena.data() + data[p_index].offset, data[p_index].length }; }
+	reference operator[](SoaVectorSizeType p_index) { return reference(this, p_index); }
+
+	static constexpr SoaVectorSizeType NOT_FOUND = SoaVector<uint8_t>::NOT_FOUND;
+
+	// The searches compare the lengths first and only memcmp the rows with the same length.
+
+	[[nodiscard]] SoaVectorSizeType find(std::string_view p_value, SoaVectorSizeType p_from = 0) const {
+		for (SoaVectorSizeType i = p_from; i < count; i++) {
+			if (data[i].length == p_value.size() and (*this)[i] == p_value) {
+				return i;
+			}
+		}
+		return NOT_FOUND;
+	}
+
+	[[nodiscard]] bool has(std::string_view p_value) const { return find(p_value) != NOT_FOUND; }
+
+	[[nodiscard]] SoaVectorSizeType count_equal(std::string_view p_value) const {
+		SoaVectorSizeType matches = 0;
+		for (SoaVectorSizeType i = 0; i < count; i++) {
+			matches += data[i].length == p_value.size() and (*this)[i] == p_value;
+		}
+		return matches;
+	}
+
+	// Sets bit i of r_mask for every row equal to p_value and returns how many, the same mask soa::simd::compare fills so where uses it for Equal and NotEqual.
+	uint64_t equal_mask(std::string_view p_value, simd::BitMask &r_mask) const {
+		r_mask.assign((uint64_t(count) + 63) / 64, 0);
+		uint64_t matches = 0;
+		for (SoaVectorSizeType i = 0; i < count; i++) {
+			if (data[i].length == p_value.size() and (*this)[i] == p_value) {
+				r_mask[i / 64] |= uint64_t(1) << (i % 64);
+				matches++;
+			}
+		}
+		return matches;
+	}
+
+	[[nodiscard]] IndexIterator<SoaVector, std::string_view> begin() const { return { this, 0 }; }
+	[[nodiscard]] IndexIterator<SoaVector, std::string_view> end() const { return { this, count }; }
+};
+
+template <> class SoaVector<DictString> {
+public:
+	using value_type = std::string_view;
+	using reference = StringReference<SoaVector>;
+	using const_reference = std::string_view;
+	using owning_value_type = std::string;
+
+private:
+	SoaVectorSizeType count = 0;
+	uint32_t *data = nullptr;
+	// Every distinct string pushed since the last clear() in the order they were first seen, code 0 is "" so zeroed codes are empty strings. A deque never moves its
+	// elements so the keys of codes can point into it.
+	std::deque<std::string> dictionary;
+	std::unordered_map<std::string_view, uint32_t> codes;
+
+	static uint32_t *column_ptr(void *p_data, uint64_t p_memory_offset) { return reinterpret_cast<uint32_t *>(static_cast<std::byte *>(p_data) + p_memory_offset); }
+
+	void reset_dictionary() {
+		dictionary.assign(1, std::string());
+		codes.clear();
+		codes.emplace(dictionary.front(), 0);
+	}
+
+	void rebuild_codes() {
+		codes.clear();
+		for (uint32_t code = 0; code < dictionary.size(); ++code) {
+			codes.emplace(dictionary[code], code);
+		}
+	}
+
+public:
+	static constexpr uint32_t NO_CODE = std::numeric_limits<uint32_t>::max();
+
+	SoaVector() { reset_dictionary(); }
+	SoaVector(const SoaVector &p_other) : count(p_other.count), data(p_other.data), dictionary(p_other.dictionary) { rebuild_codes(); }
+	SoaVector &operator=(const SoaVector &p_other) {
+		if (this != &p_other) {
+			count = p_other.count;
+			data = p_other.data;
+			dictionary = p_other.dictionary;
+			rebuild_codes();
+		}
+		return *this;
+	}
+	SoaVector(SoaVector &&) = default;
+	SoaVector &operator=(SoaVector &&) = default;
+
+	// Code of p_value, NO_CODE if no row ever had it.
+	[[nodiscard]] uint32_t find_code(std::string_view p_value) const {
+		const auto it = codes.find(p_value);
+		return it == codes.end() ? NO_CODE : it->second;
+	}
+
+	// Code of p_value, adds it to the dictionary if it isn't there yet.
+	uint32_t code_of(std::string_view p_value) {
+		const uint32_t code = find_code(p_value);
+		if (code != NO_CODE) {
+			return code;
+		}
+		if (dictionary.size() == NO_CODE) {
+			throw std::length_error("soa::DictString: a column can't have more than 2^32 - 1 distinct strings");
+		}
+		dictionary.emplace_back(p_value);
+		codes.emplace(dictionary.back(), uint32_t(dictionary.size() - 1));
+		return uint32_t(dictionary.size() - 1);
+	}
+
+	// Do not use this directly, it has to be public. Use set_X in the SOA struct instead.
+	void assign(SoaVectorSizeType p_index, std::string_view p_value) { data[p_index] = code_of(p_value); }
+
+	// Do not use this directly, it has to be public. Use load in the SOA struct instead.
+	// Replaces the dictionary with the strings whose characters are back to back in p_characters.
+	void load_dictionary(const std::vector<char> &p_characters, const std::vector<uint32_t> &p_lengths) {
+		if (p_lengths.empty() or p_lengths[0] != 0) {
+			throw std::runtime_error("soa::load: corrupt Dictionary column");
+		}
+		dictionary.clear();
+		const char *characters = p_characters.data();
+		for (const uint32_t length : p_lengths) {
+			dictionary.emplace_back(characters, length);
+			characters += length;
+		}
+		rebuild_codes();
+		if (codes.size() != dictionary.size()) {
+			throw std::runtime_error("soa::load: corrupt Dictionary column");
+		}
+	}
+
+	static constexpr uint64_t column_bytes(uint64_t p_rows) { return sizeof(uint32_t) * p_rows; }
+
+	// Do not use this directly, it has to be public. Use push_X in the SOA struct instead.
+	SoaVectorSizeType push_soa_member(std::string_view p_elem) {
+		data[count] = code_of(p_elem);
+		return ++count;
+	}
+
+	template <typename... Args> SoaVectorSizeType emplace_soa_member(Args &&...p_args) { return push_soa_member(std::string_view(std::forward<Args>(p_args)...)); }
+
+	// Rows filled by different threads would add to the same dictionary.
+	template <typename... Args> void emplace_soa_member_at(SoaVectorSizeType /*p_index*/, Args &&.../*p_args*/) {
+		static_assert(sizeof...(Args) < 0, "soa::DictString columns can't be filled from multiple threads");
+	}
+
+	void commit_soa_members(SoaVectorSizeType p_count) { count += p_count; }
+
+	void truncate_soa_member(SoaVectorSizeType p_size) { count = std::min(count, p_size); }
+
+	void soa_realloc(void *new_data, uint64_t p_memory_offset) {
+		uint32_t *new_column_data = column_ptr(new_data, p_memory_offset);
+		if (count > 0) {
+			memcpy(new_column_data, data, column_bytes(count));
+		}
+		data = new_column_data;
+	}
+
+	void destroy_at(SoaVectorSizeType /*p_index*/) {}
+
+	void post_erase(SoaVectorSizeType p_index_to_erase, SoaVectorSizeType p_end_index) {
+		if (p_index_to_erase >= count) {
+			return;
+		}
+		data[p_index_to_erase] = p_end_index >= count ? 0 : data[p_end_index];
+		if (count - 1 == p_end_index) {
+			count--;
+		}
+	}
+
+	void compact_soa_member(const simd::BitMask & /*p_erased*/, std::span<const RowMove> p_moves, SoaVectorSizeType p_new_size) {
+		for (const RowMove &move : p_moves) {
+			data[move.to] = data[move.from];
+		}
+		count = p_new_size;
+	}
+
+	void init(void *p_data, SoaVectorSizeType /*p_size*/, uint64_t p_memory_offset) { data = column_ptr(p_data, p_memory_offset); }
+
+	// FixedSizeSOA zeroes the codes, every row starts as an empty string.
+	void init_fixed(void *p_data, SoaVectorSizeType p_size, uint64_t p_memory_offset) {
+		data = column_ptr(p_data, p_memory_offset);
+		count = p_size;
+		reset_dictionary();
+	}
+
+	void *get_data() { return data; }
+	uint32_t *ptr() { return data; }
+	[[nodiscard]] const uint32_t *ptr() const { return data; }
+
+	// The codes of the rows, row i is dictionary_entry(row_codes()[i]). Useful to group or join on the column without comparing strings.
+	[[nodiscard]] std::span<const uint32_t> row_codes() const { return { data, count }; }
+	[[nodiscard]] std::string_view dictionary_entry(uint32_t p_code) const { return dictionary[p_code]; }
+	// Strings stay in the dictionary after the rows that had them change, it only shrinks on clear().
+	[[nodiscard]] uint32_t dictionary_size() const { return uint32_t(dictionary.size()); }
+
+	void clear() {
+		count = 0;
+		reset_dictionary();
+	}
+
+	void reset() {
+		clear();
+		data = nullptr;
+	}
+
+	[[nodiscard]] bool is_empty() const { return count == 0; }
+
+	[[nodiscard]] SoaVectorSizeType size() const { return count; }
+
+	std::string_view operator[](SoaVectorSizeType p_index) const { return dictionary[data[p_index]]; }
+	reference operator[](SoaVectorSizeType p_index) { return reference(this, p_index); }
+
+	static constexpr SoaVectorSizeType NOT_FOUND = SoaVector<uint8_t>::NOT_FOUND;
+
+	// The searches look p_value up once and then search the codes with the soa::simd kernels, a string that isn't in the dictionary can't be in any row.
+
+	[[nodiscard]] SoaVectorSizeType find(std::string_view p_value, SoaVectorSizeType p_from = 0) const {
+		const uint32_t code = find_code(p_value);
+		if (code == NO_CODE or p_from >= count) {
+			return NOT_FOUND;
+		}
+		const uint64_t index = simd::find(data + p_from, count - p_from, code);
+		return index == count - p_from ? NOT_FOUND : SoaVectorSizeType(p_from + index);
+	}
+
+	[[nodiscard]] bool has(std::string_view p_value) const { return find(p_value) != NOT_FOUND; }
+
+	[[nodiscard]] SoaVectorSizeType count_equal(std::string_view p_value) const {
+		const uint32_t code = find_code(p_value);
+		return code == NO_CODE ? 0 : SoaVectorSizeType(simd::count_equal(data, count, code));
+	}
+
+	uint64_t equal_mask(std::string_view p_value, simd::BitMask &r_mask) const {
+		const uint32_t code = find_code(p_value);
+		if (code == NO_CODE) {
+			r_mask.assign((uint64_t(count) + 63) / 64, 0);
+			return 0;
+		}
+		return simd::compare(data, count, simd::Compare::Equal, code, r_mask);
+	}
+
+	[[nodiscard]] IndexIterator<SoaVector, std::string_view> begin() const { return { this, 0 }; }
+	[[nodiscard]] IndexIterator<SoaVector, std::string_view> end() const { return { this, count }; }
+};
+
+namespace detail {
+
+// The lengths as an integer column, their total and then the characters, the same as a LengthPrefixed std::string column.
+template <typename Strings> void write_strings(std::ostream &p_stream, const Strings &p_strings, SoaVectorSizeType p_count) {
+	std::vector<uint32_t> lengths(p_count);
+	uint64_t total_length = 0;
+	for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+		lengths[i] = uint32_t(std::string_view(p_strings[i]).size());
+		total_length += lengths[i];
+	}
+	write_payload(p_stream, lengths.data(), p_count);
+	write_value(p_stream, total_length);
+	for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+		const std::string_view string = p_strings[i];
+		write_bytes(p_stream, string.data(), string.size());
+	}
+}
+
+// Reads what write_strings wrote into r_lengths and r_characters.
+inline void read_strings(std::istream &p_stream, SoaVectorSizeType p_count, std::vector<uint32_t> &r_lengths, std::vector<char> &r_characters) {
+	r_lengths.resize(p_count);
+	read_payload(p_stream, r_lengths.data(), p_count);
+	uint64_t total_length = 0;
+	for (const uint32_t length : r_lengths) {
+		total_length += length;
+	}
+	if (read_value<uint64_t>(p_stream) != total_length) {
+		throw std::runtime_error("soa::load: corrupt LengthPrefixed column");
+	}
+	r_characters.resize(total_length);
+	read_bytes(p_stream, r_characters.data(), total_length);
+}
+
+inline SoaVectorSizeType read_string_column_header(std::istream &p_stream, std::string_view p_name, SoaVectorSizeType p_capacity, ColumnEncoding p_encoding) {
+	if (read_value<uint64_t>(p_stream) != column_name_hash(p_name)) {
+		throw std::runtime_error(std::string("soa::load: the stream doesn't have the column ") + std::string(p_name));
+	}
+	const SoaVectorSizeType count = read_value<SoaVectorSizeType>(p_stream);
+	if (count > p_capacity) {
+		throw std::runtime_error("soa::load: column has more rows than the table");
+	}
+	if (read_value<ColumnEncoding>(p_stream) != p_encoding) {
+		throw std::runtime_error("soa::load: unsupported column encoding");
+	}
+	return count;
+}
+
+} // namespace detail
+
+// An ArenaString column is written like a std::string column and read straight into the arena.
+inline void save_column(std::ostream &p_stream, std::string_view p_name, const SoaVector<ArenaString> &p_column) {
+	detail::write_value(p_stream, column_name_hash(p_name));
+	detail::write_value(p_stream, p_column.size());
+	detail::write_value(p_stream, ColumnEncoding::LengthPrefixed);
+	detail::write_strings(p_stream, p_column, p_column.size());
+}
+
+inline void load_column(std::istream &p_stream, std::string_view p_name, SoaVector<ArenaString> &r_column, SoaVectorSizeType p_capacity) {
+	const SoaVectorSizeType count = detail::read_string_column_header(p_stream, p_name, p_capacity, ColumnEncoding::LengthPrefixed);
+	std::vector<uint32_t> lengths;
+	std::vector<char> characters;
+	detail::read_strings(p_stream, count, lengths, characters);
+	if (characters.size() > std::numeric_limits<uint32_t>::max()) {
+		throw std::length_error("soa::ArenaString: a column can't hold more than 4 GiB of characters");
+	}
+	r_column.load_arena(std::move(characters), lengths);
+}
+
+// A DictString column writes its dictionary and then the codes as an integer column.
+inline void save_column(std::ostream &p_stream, std::string_view p_name, const SoaVector<DictString> &p_column) {
+	detail::write_value(p_stream, column_name_hash(p_name));
+	detail::write_value(p_stream, p_column.size());
+	detail::write_value(p_stream, ColumnEncoding::Dictionary);
+	const uint32_t dictionary_size = p_column.dictionary_size();
+	detail::write_value(p_stream, dictionary_size);
+	std::vector<std::string_view> dictionary(dictionary_size);
+	for (uint32_t code = 0; code < dictionary_size; ++code) {
+		dictionary[code] = p_column.dictionary_entry(code);
+	}
+	detail::write_strings(p_stream, dictionary, dictionary_size);
+	detail::write_payload(p_stream, p_column.ptr(), p_column.size());
+}
+
+inline void load_column(std::istream &p_stream, std::string_view p_name, SoaVector<DictString> &r_column, SoaVectorSizeType p_capacity) {
+	const SoaVectorSizeType count = detail::read_string_column_header(p_stream, p_name, p_capacity, ColumnEncoding::Dictionary);
+	const uint32_t dictionary_size = detail::read_value<uint32_t>(p_stream);
+	if (dictionary_size == 0 or dictionary_size == SoaVector<DictString>::NO_CODE) {
+		throw std::runtime_error("soa::load: corrupt Dictionary column");
+	}
+	std::vector<uint32_t> lengths;
+	std::vector<char> characters;
+	detail::read_strings(p_stream, dictionary_size, lengths, characters);
+	r_column.load_dictionary(characters, lengths);
+	detail::read_payload(p_stream, r_column.ptr(), count);
+	for (SoaVectorSizeType i = 0; i < count; ++i) {
+		if (r_column.ptr()[i] >= dictionary_size) {
+			throw std::runtime_error("soa::load: corrupt Dictionary column");
+		}
+	}
+	r_column.commit_soa_members(count);
+}
+
+} // namespace soa
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+#include "SoaAllocatorPolicy.hpp"
+#include "SoaGrowthPolicy.hpp"
+#include "SoaVector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace soa {
+
+// Column types of a soa::Table that doesn't use an aggregate struct as its schema. Derive from it to give the table a growth or allocator policy:
+// struct Particles : soa::Columns<Vector2, Vector2, float> { using soa_growth_policy = soa::PowerOfTwoGrowth<>; };
+template <typename... Ts> struct Columns {};
+
+namespace detail {
+
+// Aggregate schemas can have at most this many fields, one for each structured binding in visit_fields. soa::Columns has no limit.
+inline constexpr size_t max_aggregate_fields = 32;
+
+// Converts to a reference of any type, so brace initializing an aggregate with more and more of them finds how many fields it has. Only used in unevaluated contexts.
+struct AnyField {
+	template <typename T> operator T &() const;
+};
+
+template <typename T, typename... Fields> consteval size_t aggregate_field_count() {
+	if constexpr (requires { T{ std::declval<Fields>()..., std::declval<AnyField>() }; }) {
+		return aggregate_field_count<T, Fields..., AnyField>();
+	} else {
+		return sizeof...(Fields);
+	}
+}
+
+// Calls p_func with every field of the aggregate p_value in declaration order.
+template <typename T, typename Func> constexpr decltype(auto) visit_fields(T &p_value, Func &&p_func) {
+	constexpr size_t count = aggregate_field_count<std::remove_cv_t<T>>();
+	static_assert(count <= max_aggregate_fields, "soa::Table aggregate schemas can have at most 32 fields, use soa::Columns for more");
+	if constexpr (count == 0) {
+		return p_func();
+	} else if constexpr (count == 1) {
+		auto &[f0] = p_value;
+		return p_func(f0);
+	} else if constexpr (count == 2) {
+		auto &[f0, f1] = p_value;
+		return p_func(f0, f1);
+	} else if constexpr (count == 3) {
+		auto &[f0, f1, f2] = p_value;
+		return p_func(f0, f1, f2);
+	} else if constexpr (count == 4) {
+		auto &[f0, f1, f2, f3] = p_value;
+		return p_func(f0, f1, f2, f3);
+	} else if constexpr (count == 5) {
+		auto &[f0, f1, f2, f3, f4] = p_value;
+		return p_func(f0, f1, f2, f3, f4);
+	} else if constexpr (count == 6) {
+		auto &[f0, f1, f2, f3, f4, f5] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5);
+	} else if constexpr (count == 7) {
+		auto &[f0, f1, f2, f3, f4, f5, f6] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6);
+	} else if constexpr (count == 8) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7);
+	} else if constexpr (count == 9) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+	} else if constexpr (count == 10) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+	} else if constexpr (count == 11) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+	} else if constexpr (count == 12) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+	} else if constexpr (count == 13) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+	} else if constexpr (count == 14) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+	} else if constexpr (count == 15) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+	} else if constexpr (count == 16) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+	} else if constexpr (count == 17) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16);
+	} else if constexpr (count == 18) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17);
+	} else if constexpr (count == 19) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18);
+	} else if constexpr (count == 20) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19);
+	} else if constexpr (count == 21) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20);
+	} else if constexpr (count == 22) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21);
+	} else if constexpr (count == 23) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22);
+	} else if constexpr (count == 24) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23);
+	} else if constexpr (count == 25) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24);
+	} else if constexpr (count == 26) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25);
+	} else if constexpr (count == 27) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26);
+	} else if constexpr (count == 28) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27);
+	} else if constexpr (count == 29) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28);
+	} else if constexpr (count == 30) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29);
+	} else if constexpr (count == 31) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30);
+	} else if constexpr (count == 32) {
+		auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30, f31] = p_value;
+		return p_func(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30, f31);
+	}
+}
+
+// Declared and never defined, field_index only compares the addresses of its fields.
+template <typename T> struct fake_object {
+	static const T value;
+};
+
+template <typename C, typename M> C member_class_of(M C::*);
+
+template <auto Member, typename Schema>
+concept field_of = std::is_member_object_pointer_v<decltype(Member)> and std::is_same_v<decltype(member_class_of(Member)), Schema>;
+
+// Index of the field Member points to in its aggregate, in declaration order.
+template <auto Member> consteval size_t field_index() {
+	using Schema = decltype(member_class_of(Member));
+	const Schema &object = fake_object<Schema>::value;
+	return visit_fields(object, [&](const auto &...p_fields) {
+		const void *field = &(object.*Member);
+		size_t index = 0;
+		size_t result = 0;
+		((result = static_cast<const void *>(&p_fields) == field ? index : result, ++index), ...);
+		return result;
+	});
+}
+
+template <typename... Ts> Columns<Ts...> column_list_of(const Columns<Ts...> &);
+
+template <typename Schema>
+concept column_list = requires(const Schema &p_schema) { column_list_of(p_schema); };
+
+template <typename Schema> struct schema_columns {
+	static_assert(std::is_aggregate_v<Schema>, "soa::Table schema has to be an aggregate struct or derive from soa::Columns");
+	using type = decltype(visit_fields(std::declval<Schema &>(), [](auto &...p_fields) { return Columns<std::remove_cvref_t<decltype(p_fields)>...>{}; }));
+};
+
+template <column_list Schema> struct schema_columns<Schema> {
+	using type = decltype(column_list_of(std::declval<const Schema &>()));
+};
+
+} // namespace detail
+
+// Structure of arrays table with the row API of DynamicSOA, built from templates instead of the FOR_EACH macros so it has no column limit and no macro expansion in error
+// messages. Schema is an aggregate struct whose fields are the columns (at most 32 of them, no C arrays, references or bit fields) or a type derived from soa::Columns<Ts...>.
+// Columns are used by index: get<0>(row), set<1>(row, value), column<2>().find(value). Aggregate schemas can also use the field: get<&Particle::position>(row).
+// The layout is computed at compile time. Every column takes capacity * sizeof(T) bytes of one block and the capacity is always a multiple of capacity_step rows, so the
+// offset of column I is capacity * row_offsets[I] and already aligned, growing doesn't compute any offsets. Growth and allocator policies come from soa_growth_policy and
+// soa_allocator_policy in the schema like they do for the macros, soa::VirtualReserveAllocator isn't supported.
+template <typename Schema, typename ColumnList = typename detail::schema_columns<Schema>::type> class Table;
+
+template <typename Schema, typename... Ts> class Table<Schema, Columns<Ts...>> {
+	static_assert(sizeof...(Ts) > 0, "soa::Table needs at least 1 column");
+	static_assert((!is_encoded_column_v<Ts> and ...), "soa::Table columns can't be encoded columns (soa::Packed, soa::ArenaString, soa::DictString)");
+
+	using growth_policy = typename growth_policy_of<Schema>::type;
+	using allocator_policy = typename allocator_policy_of<Schema>::type;
+	static_assert(!reserves_rows<allocator_policy>, "soa::Table can't use an allocator policy that reserves rows");
+
+public:
+	static constexpr size_t column_count = sizeof...(Ts);
+	template <size_t I> using column_type = std::tuple_element_t<I, std::tuple<Ts...>>;
+	// What get_row returns and push_row takes, the schema itself for aggregates.
+	using row_type = std::conditional_t<detail::column_list<Schema>, std::tuple<Ts...>, Schema>;
+
+	// The biggest column alignment, in rows. Any capacity that is a multiple of it is a multiple of every column's alignment in bytes.
+	static constexpr SoaVectorSizeType capacity_step = SoaVectorSizeType(std::max({ column_alignment<Ts>()... }));
+	static constexpr uint64_t row_size = (sizeof(Ts) + ...);
+	// Bytes before column I in the block for each row of capacity.
+	static constexpr std::array<uint64_t, column_count> row_offsets = [] {
+		const std::array<uint64_t, column_count> sizes = { sizeof(Ts)... };
+		std::array<uint64_t, column_count> offsets{};
+		for (size_t i = 1; i < column_count; ++i) {
+			offsets[i] = offsets[i - 1] + sizes[i - 1];
+		}
+		return offsets;
+	}();
+
+private:
+	std::tuple<SoaVector<Ts>...> columns;
+	void *data = nullptr;
+	SoaVectorSizeType soa_capacity = 0;
+
+	void soa_release_block() {
+		if (data != nullptr) {
+			allocator_policy::deallocate(data, capacity_step, uint64_t(soa_capacity) * row_size);
+			data = nullptr;
+		}
+	}
+
+	template <size_t... Is> void soa_move_columns(void *p_new_data, SoaVectorSizeType p_capacity, std::index_sequence<Is...>) {
+		(std::get<Is>(columns).soa_realloc(p_new_data, uint64_t(p_capacity) * row_offsets[Is]), ...);
+	}
+
+	void soa_realloc(SoaVectorSizeType p_capacity) {
+		constexpr uint64_t max_capacity = uint64_t(UINT32_MAX) / capacity_step * capacity_step;
+		const SoaVectorSizeType capacity = SoaVectorSizeType(std::min(align_up(p_capacity, capacity_step), max_capacity));
+		void *new_data = allocator_policy::allocate(capacity_step, uint64_t(capacity) * row_size);
+		soa_move_columns(new_data, capacity, std::index_sequence_for<Ts...>{});
+		soa_release_block();
+		data = new_data;
+		soa_capacity = capacity;
+	}
+
+	void soa_grow() { soa_realloc(growth_policy::grow(soa_capacity, soa_capacity + 1)); }
+
+	template <size_t... Is, typename... Args> void soa_emplace_columns(std::index_sequence<Is...>, Args &&...p_args) {
+		(std::get<Is>(columns).emplace_soa_member(std::forward<Args>(p_args)), ...);
+	}
+
+	template <size_t... Is> row_type soa_get_row(SoaVectorSizeType p_index, std::index_sequence<Is...>) const { return row_type{ std::get<Is>(columns)[p_index]... }; }
+
+public:
+	Table() = default;
+	Table(const Table &) = delete;
+	Table &operator=(const Table &) = delete;
+	Table(Table &&p_other) noexcept :
+			columns(std::exchange(p_other.columns, {})), data(std::exchange(p_other.data, nullptr)), soa_capacity(std::exchange(p_other.soa_capacity, 0)) {}
+	Table &operator=(Table &&p_other) noexcept {
+		if (this != &p_other) {
+			clear();
+			columns = std::exchange(p_other.columns, {});
+			data = std::exchange(p_other.data, nullptr);
+			soa_capacity = std::exchange(p_other.soa_capacity, 0);
+		}
+		return *this;
+	}
+	~Table() { clear(); }
+
+	template <size_t I> [[nodiscard]] SoaVector<column_type<I>> &column() { return std::get<I>(columns); }
+	template <size_t I> [[nodiscard]] const SoaVector<column_type<I>> &column() const { return std::get<I>(columns); }
+
+	template <size_t I> [[nodiscard]] const column_type<I> &get(SoaVectorSizeType p_index) const { return std::get<I>(columns)[p_index]; }
+	template <size_t I> void set(SoaVectorSizeType p_index, const column_type<I> &p_value) { std::get<I>(columns)[p_index] = p_value; }
+
+	// Appends to one column, like push_X. Mixing it with push_row has the same caveat as the macros: the columns have to stay the same size.
+	template <size_t I> void push(const column_type<I> &p_value) {
+		if (std::get<I>(columns).size() == soa_capacity) [[unlikely]] {
+			soa_grow();
+		}
+		std::get<I>(columns).push_soa_member(p_value);
+	}
+
+	// The same functions by field for aggregate schemas, column<&Particle::velocity>() is column<1>().
+	template <auto Member>
+		requires detail::field_of<Member, Schema>
+	[[nodiscard]] SoaVector<column_type<detail::field_index<Member>()>> &column() {
+		return std::get<detail::field_index<Member>()>(columns);
+	}
+	template <auto Member>
+		requires detail::field_of<Member, Schema>
+	[[nodiscard]] const SoaVector<column_type<detail::field_index<Member>()>> &column() const {
+		return std::get<detail::field_index<Member>()>(columns);
+	}
+	template <auto Member>
+		requires detail::field_of<Member, Schema>
+	[[nodiscard]] const column_type<detail::field_index<Member>()> &get(SoaVectorSizeType p_index) const {
+		return get<detail::field_index<Member>()>(p_index);
+	}
+	template <auto Member>
+		requires detail::field_of<Member, Schema>
+	void set(SoaVectorSizeType p_index, const column_type<detail::field_index<Member>()> &p_value) {
+		set<detail::field_index<Member>()>(p_index, p_value);
+	}
+	template <auto Member>
+		requires detail::field_of<Member, Schema>
+	void push(const column_type<detail::field_index<Member>()> &p_value) {
+		push<detail::field_index<Member>()>(p_value);
+	}
+
+	void push_row(const Ts &...p_values) { emplace_row(p_values...); }
+
+	void push_row(const row_type &p_row)
+		requires(!detail::column_list<Schema>)
+	{
+		detail::visit_fields(p_row, [&](const auto &...p_fields) { emplace_row(p_fields...); });
+	}
+
+	template <typename... Args>
+		requires(sizeof...(Args) == column_count)
+	void emplace_row(Args &&...p_args) {
+		if (size() == soa_capacity) [[unlikely]] {
+			soa_grow();
+		}
+		soa_emplace_columns(std::index_sequence_for<Ts...>{}, std::forward<Args>(p_args)...);
+	}
+
+	[[nodiscard]] row_type get_row(SoaVectorSizeType p_index) const { return soa_get_row(p_index, std::index_sequence_for<Ts...>{}); }
+
+	// Moves the last row into p_index, throws std::out_of_range if there is no such row.
+	void erase(SoaVectorSizeType p_index) {
+		const SoaVectorSizeType row_count = size();
+		if (p_index >= row_count) {
+			throw std::out_of_range("soa::Table::erase: row index out of range");
+		}
+		std::apply(
+				[&](auto &...p_columns) {
+					(p_columns.destroy_at(p_index), ...);
+					(p_columns.post_erase(p_index, row_count - 1), ...);
+				},
+				columns);
+	}
+
+	// Rows in the longest column.
+	[[nodiscard]] SoaVectorSizeType size() const {
+		return std::apply([](const auto &...p_columns) { return std::max({ p_columns.size()... }); }, columns);
+	}
+	[[nodiscard]] SoaVectorSizeType capacity() const { return soa_capacity; }
+
+	void reserve(SoaVectorSizeType p_capacity) {
+		if (p_capacity > soa_capacity) {
+			soa_realloc(p_capacity);
+		}
+	}
+	void shrink_to_fit() {
+		if (align_up(size(), capacity_step) < soa_capacity) {
+			soa_realloc(size());
+		}
+	}
+	void clear() {
+		std::apply([](auto &...p_columns) { (p_columns.reset(), ...); }, columns);
+		soa_release_block();
+		soa_capacity = 0;
+	}
+};
+
+} // namespace soa
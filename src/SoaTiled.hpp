@@ -0,0 +1,113 @@
+#pragma once
+
+#include "SoaAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace soa {
+
+// Alignment of one column inside a TiledSOA tile. Tiles are small so columns are only aligned up to the size of the column (8 floats = 32 bytes), a 64 byte alignment for
+// every column would pad a tile of 8 floats to 64 bytes.
+template <typename T, SoaVectorSizeType BlockSize> constexpr uint64_t tile_column_alignment() {
+	return std::max<uint64_t>(alignof(T), std::min<uint64_t>(SOA_COLUMN_ALIGNMENT, std::bit_floor(sizeof(T) * BlockSize)));
+}
+
+// BlockSize rows of a single TiledSOA member. Only raw storage, the TiledSOA macro constructs and destroys the elements.
+template <typename T, SoaVectorSizeType BlockSize> struct TileColumn {
+	static constexpr uint64_t alignment = tile_column_alignment<T, BlockSize>();
+
+	alignas(alignment) std::byte storage[sizeof(T) * BlockSize];
+
+	T *ptr() { return std::assume_aligned<alignment>(reinterpret_cast<T *>(storage)); }
+	[[nodiscard]] const T *ptr() const { return std::assume_aligned<alignment>(reinterpret_cast<const T *>(storage)); }
+
+	T &operator[](SoaVectorSizeType p_index) { return ptr()[p_index]; }
+	const T &operator[](SoaVectorSizeType p_index) const { return ptr()[p_index]; }
+
+	template <typename... Args> void construct_at(SoaVectorSizeType p_index, Args &&...p_args) { new (ptr() + p_index) T(std::forward<Args>(p_args)...); }
+};
+
+namespace detail {
+
+// Number of constructed elements in tile p_tile of a column with p_count elements.
+template <SoaVectorSizeType BlockSize> SoaVectorSizeType tile_count_in(SoaVectorSizeType p_count, uint64_t p_tile) {
+	return SoaVectorSizeType(std::min<uint64_t>(BlockSize, p_count - std::min<uint64_t>(p_count, p_tile * BlockSize)));
+}
+
+} // namespace detail
+
+// Moves the first p_count elements of p_member from the p_from tiles to the p_to tiles and destroys the old ones, used when a TiledSOA reallocates.
+template <typename Tile, typename T, SoaVectorSizeType BlockSize>
+void tiled_move_column(Tile *p_from, Tile *p_to, TileColumn<T, BlockSize> Tile::*p_member, SoaVectorSizeType p_count) {
+	for (uint64_t tile = 0; tile * BlockSize < p_count; ++tile) {
+		TileColumn<T, BlockSize> &from = p_from[tile].*p_member;
+		TileColumn<T, BlockSize> &to = p_to[tile].*p_member;
+		const SoaVectorSizeType count = detail::tile_count_in<BlockSize>(p_count, tile);
+		if constexpr (std::is_trivially_copyable_v<T>) {
+			memcpy(to.storage, from.storage, count * sizeof(T));
+		} else {
+			for (SoaVectorSizeType i = 0; i < count; ++i) {
+				to.construct_at(i, std::move(from[i]));
+				from[i].~T();
+			}
+		}
+	}
+}
+
+// Destroys the first p_count elements of p_member.
+template <typename Tile, typename T, SoaVectorSizeType BlockSize> void tiled_destroy_column(Tile *p_tiles, TileColumn<T, BlockSize> Tile::*p_member, SoaVectorSizeType p_count) {
+	if constexpr (!std::is_trivially_destructible_v<T>) {
+		for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+			(p_tiles[i / BlockSize].*p_member)[i % BlockSize].~T();
+		}
+	}
+}
+
+// Range over the tiles of a TiledSOA, each element is a Block{ tile, first_row, count } that has a function per member returning a pointer to that member's column in the tile.
+template <typename Block, typename Tile, SoaVectorSizeType BlockSize> class TiledBlockRange {
+	Tile *tiles = nullptr;
+	SoaVectorSizeType rows = 0;
+
+public:
+	class iterator {
+		Tile *tiles = nullptr;
+		SoaVectorSizeType rows = 0;
+		SoaVectorSizeType tile = 0;
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Block;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		iterator(Tile *p_tiles, SoaVectorSizeType p_rows, SoaVectorSizeType p_tile) : tiles(p_tiles), rows(p_rows), tile(p_tile) {}
+
+		Block operator*() const { return Block{ tiles + tile, tile * BlockSize, detail::tile_count_in<BlockSize>(rows, tile) }; }
+		iterator &operator++() {
+			tile++;
+			return *this;
+		}
+		iterator operator++(int) {
+			iterator old = *this;
+			tile++;
+			return old;
+		}
+		bool operator==(const iterator &p_other) const { return tile == p_other.tile; }
+	};
+
+	TiledBlockRange(Tile *p_tiles, SoaVectorSizeType p_rows) : tiles(p_tiles), rows(p_rows) {}
+
+	[[nodiscard]] iterator begin() const { return iterator(tiles, rows, 0); }
+	[[nodiscard]] iterator end() const { return iterator(tiles, rows, (rows + BlockSize - 1) / BlockSize); }
+	[[nodiscard]] SoaVectorSizeType size() const { return (rows + BlockSize - 1) / BlockSize; }
+};
+
+} // namespace soa
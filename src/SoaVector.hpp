@@ -1,13 +1,21 @@
 #pragma once
 
+#include "SoaAllocator.hpp"
+#include "SoaErase.hpp"
+#include "SoaSimd.hpp"
+
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <initializer_list>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <span>
 #include <type_traits>
-
-using SoaVectorSizeType = uint32_t;
+#include <vector>
 
 namespace soa {
 
@@ -17,50 +25,98 @@ private:
 	SoaVectorSizeType count = 0;
 	T *data = nullptr;
 
-	T *align_ptr(void *p_data, SoaVectorSizeType p_size, uint64_t p_memory_offset) {
-		// Has to be aligned to avoid UB: https://lesleylai.info/en/std-align/
-		void *offset_data = static_cast<std::byte *>(p_data) + p_memory_offset;
-		size_t space = p_size * sizeof(T);
-		void *aligned_pointer = std::align(alignof(T), sizeof(T), offset_data, space);
-		return reinterpret_cast<T *>(aligned_pointer);
-	}
+	// The SOA macros already align every memory offset to soa::column_alignment<T>() so the column can start exactly at the offset.
+	static T *column_ptr(void *p_data, uint64_t p_memory_offset) { return reinterpret_cast<T *>(static_cast<std::byte *>(p_data) + p_memory_offset); }
 
 public:
+	// What the SOA macros use for the values of the column, soa::Packed columns (see SoaPacked.hpp) store something else than they return.
+	using value_type = T;
+	using reference = T &;
+	using const_reference = const T &;
+
+	// Bytes a column of p_rows elements needs in the SOA block.
+	static constexpr uint64_t column_bytes(uint64_t p_rows) { return sizeof(T) * p_rows; }
+
 	// Do not use this directly, it has to be public. Use push_X in the SOA struct instead.
 	// Invalidates pointers if additional memory is needed.
 	SoaVectorSizeType push_soa_member(const T &p_elem) {
-		if constexpr (!std::is_trivially_constructible_v<T>) {
-			new (&data[count++]) T(p_elem);
-		} else {
-			data[count++] = std::move(p_elem);
-		}
+		// Dynamic SOAs don't construct their elements up front so this always has to construct instead of assign.
+		new (&data[count++]) T(p_elem);
+		return count;
+	}
 
+	// Do not use this directly, it has to be public. Use emplace_row in the SOA struct instead.
+	// Constructs the new element in place from p_args instead of copying it in.
+	template <typename... Args> SoaVectorSizeType emplace_soa_member(Args &&...p_args) {
+		new (&data[count++]) T(std::forward<Args>(p_args)...);
 		return count;
 	}
 
+	// Do not use this directly, it has to be public. Use soa::ConcurrentAppendSOA instead.
+	// Constructs element p_index in the spare capacity without changing size(), so different threads can fill different elements at once. commit_soa_members adds them later.
+	template <typename... Args> void emplace_soa_member_at(SoaVectorSizeType p_index, Args &&...p_args) { new (&data[p_index]) T(std::forward<Args>(p_args)...); }
+
+	// Do not use this directly, it has to be public. Use load in the SOA struct instead.
+	// Adds p_count elements that were already constructed in place after the last one (see soa::read_column).
+	void commit_soa_members(SoaVectorSizeType p_count) { count += p_count; }
+
+	// Do not use this directly, it has to be public. Use apply_delta in the SOA struct instead.
+	// Destroys the elements from p_size on, does nothing if the column doesn't have more than p_size elements.
+	void truncate_soa_member(SoaVectorSizeType p_size) {
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			for (SoaVectorSizeType i = p_size; i < count; i++) {
+				data[i].~T();
+			}
+		}
+		count = std::min(count, p_size);
+	}
+
 	// This can't do a normal realloc, it has to either memcpy or move the bytes otherwise the offsets break.
-	void soa_realloc(void *new_data, uint64_t p_memory_offset, SoaVectorSizeType p_new_capacity) {
+	// Only the size() constructed elements are moved so the new block can also be smaller than the old one.
+	void soa_realloc(void *new_data, uint64_t p_memory_offset) {
+		T *new_column_data = column_ptr(new_data, p_memory_offset);
 		if constexpr (std::is_trivially_copyable_v<T>) {
-			data = reinterpret_cast<T *>(memcpy(static_cast<std::byte *>(new_data) + p_memory_offset, data, p_new_capacity * sizeof(T)));
+			if (count > 0) {
+				memcpy(new_column_data, data, count * sizeof(T));
+			}
 		} else {
-			T *new_column_data = align_ptr(new_data, p_new_capacity, p_memory_offset);
-			for (SoaVectorSizeType i = 0; i < size(); i++) {
+			for (SoaVectorSizeType i = 0; i < count; i++) {
 				new (&new_column_data[i]) T(std::move(data[i]));
+				data[i].~T();
 			}
-			data = new_column_data;
 		}
+		data = new_column_data;
 	}
 
 	void destroy_at(SoaVectorSizeType p_index) {
 		if constexpr (!std::is_trivially_destructible_v<T>) {
-			data[p_index].~T();
+			// The row might not exist in this column if it's shorter than the others.
+			if (p_index < count) {
+				data[p_index].~T();
+			}
 		}
 	}
 
+	// Moves the element at p_end_index into the already destroyed p_index_to_erase slot.
 	void post_erase(SoaVectorSizeType p_index_to_erase, SoaVectorSizeType p_end_index) {
-		void *destination = &data[p_index_to_erase];
-		const void *source = &data[p_end_index];
-		memcpy(destination, source, sizeof(T));
+		if (p_index_to_erase >= count) {
+			return;
+		}
+
+		if (p_end_index >= count) {
+			// This column is shorter than the others so there is nothing to move into the erased slot, leave a default value there instead of a destroyed object.
+			new (&data[p_index_to_erase]) T();
+		} else if (p_index_to_erase != p_end_index) {
+			if constexpr (std::is_trivially_copyable_v<T>) {
+				void *destination = &data[p_index_to_erase];
+				const void *source = &data[p_end_index];
+				memcpy(destination, source, sizeof(T));
+			} else {
+				// Non trivially copyable types (like std::string with SSO) can point into themselves so they can't be memcpy'd.
+				new (&data[p_index_to_erase]) T(std::move(data[p_end_index]));
+				data[p_end_index].~T();
+			}
+		}
 
 		// Only update count if the index is last value in this vector. Its possible that another SoaVector member has a larger size so the end index might not be this Vectors end index.
 		if (count - 1 == p_end_index) {
@@ -68,20 +124,34 @@ public:
 		}
 	}
 
-	void init(void *p_data, SoaVectorSizeType p_size, uint64_t p_memory_offset) {
-		if constexpr (std::is_trivially_constructible_v<T>) {
-			data = reinterpret_cast<T *>(static_cast<std::byte *>(p_data) + p_memory_offset);
-		} else {
-			data = align_ptr(p_data, p_size, p_memory_offset);
+	// Do not use this directly, it has to be public. Use erase_batch or compact in the SOA struct instead.
+	// Destroys the rows set in p_erased and fills the holes with p_moves (see soa::plan_compaction). Like push_row this expects the column to have all p_new_size + erased rows.
+	void compact_soa_member(const simd::BitMask &p_erased, std::span<const RowMove> p_moves, SoaVectorSizeType p_new_size) {
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			for (uint64_t word = 0; word < p_erased.size() and word * 64 < count; ++word) {
+				for (uint64_t bits = p_erased[word]; bits != 0; bits &= bits - 1) {
+					const uint64_t index = word * 64 + uint64_t(std::countr_zero(bits));
+					if (index < count) {
+						data[index].~T();
+					}
+				}
+			}
+		}
+		for (const RowMove &move : p_moves) {
+			if constexpr (std::is_trivially_copyable_v<T>) {
+				memcpy(static_cast<void *>(&data[move.to]), static_cast<const void *>(&data[move.from]), sizeof(T));
+			} else {
+				new (&data[move.to]) T(std::move(data[move.from]));
+				data[move.from].~T();
+			}
 		}
+		count = p_new_size;
 	}
 
+	void init(void *p_data, SoaVectorSizeType /*p_size*/, uint64_t p_memory_offset) { data = column_ptr(p_data, p_memory_offset); }
+
 	void init_fixed(void *p_data, SoaVectorSizeType p_size, uint64_t p_memory_offset) {
-		if constexpr (std::is_trivially_constructible_v<T>) {
-			data = reinterpret_cast<T *>(static_cast<std::byte *>(p_data) + p_memory_offset);
-		} else {
-			data = align_ptr(p_data, p_size, p_memory_offset);
-		}
+		data = column_ptr(p_data, p_memory_offset);
 		count = p_size; // for dynamic Vectors count updates when you push_back, init count for fixed vectors.
 	}
 
@@ -89,6 +159,11 @@ public:
 	T *ptr() { return data; }
 	[[nodiscard]] const T *ptr() const { return data; }
 
+	// Same as ptr() but tells the compiler the column starts on a SOA_COLUMN_ALIGNMENT boundary so it can use aligned vector loads.
+	// Only valid for columns owned by one of the SOA macros, they align every column when allocating.
+	T *aligned_ptr() { return std::assume_aligned<SOA_COLUMN_ALIGNMENT>(data); }
+	[[nodiscard]] const T *aligned_ptr() const { return std::assume_aligned<SOA_COLUMN_ALIGNMENT>(data); }
+
 	void clear() {
 		SoaVectorSizeType p_size = 0;
 		if (data == nullptr) {
@@ -120,16 +195,80 @@ public:
 	const T &operator[](SoaVectorSizeType p_index) const { return data[p_index]; }
 	T &operator[](SoaVectorSizeType p_index) { return data[p_index]; }
 
+	// Returned by find and find_any_of when nothing matches.
+	static constexpr SoaVectorSizeType NOT_FOUND = std::numeric_limits<SoaVectorSizeType>::max();
+
+	// The search functions use the soa::simd kernels for integer, float, double, enum and bool elements and a normal loop for everything else.
+
 	[[nodiscard]] SoaVectorSizeType find(const T &p_val, SoaVectorSizeType p_from = 0) const {
-		for (SoaVectorSizeType i = p_from; i < count; i++) {
-			if (data[i] == p_val) {
-				return i;
+		if (p_from >= count) {
+			return NOT_FOUND;
+		}
+		if constexpr (simd::Searchable<T>) {
+			const uint64_t index = simd::find(data + p_from, count - p_from, p_val);
+			return index == count - p_from ? NOT_FOUND : SoaVectorSizeType(p_from + index);
+		} else {
+			for (SoaVectorSizeType i = p_from; i < count; i++) {
+				if (data[i] == p_val) {
+					return i;
+				}
+			}
+			return NOT_FOUND;
+		}
+	}
+
+	[[nodiscard]] bool has(const T &p_val) const { return find(p_val) != NOT_FOUND; }
+
+	[[nodiscard]] SoaVectorSizeType count_equal(const T &p_val) const {
+		if constexpr (simd::Searchable<T>) {
+			return SoaVectorSizeType(simd::count_equal(data, count, p_val));
+		} else {
+			SoaVectorSizeType matches = 0;
+			for (SoaVectorSizeType i = 0; i < count; i++) {
+				matches += data[i] == p_val;
 			}
+			return matches;
 		}
-		return -1;
 	}
 
-	[[nodiscard]] bool has(const T &p_val) const { return find(p_val) != -1; }
+	// Selection vector with the index of every element equal to p_val.
+	[[nodiscard]] simd::SelectionVector find_all(const T &p_val) const {
+		simd::SelectionVector indices;
+		if constexpr (simd::Searchable<T>) {
+			simd::find_all(data, count, p_val, indices);
+		} else {
+			for (SoaVectorSizeType i = 0; i < count; i++) {
+				if (data[i] == p_val) {
+					indices.push_back(i);
+				}
+			}
+		}
+		return indices;
+	}
+
+	// Index of the first element equal to any of p_values.
+	[[nodiscard]] SoaVectorSizeType find_any_of(std::span<const T> p_values, SoaVectorSizeType p_from = 0) const {
+		if (p_from >= count) {
+			return NOT_FOUND;
+		}
+		if constexpr (simd::Searchable<T>) {
+			const uint64_t index = simd::find_any_of(data + p_from, count - p_from, p_values.data(), p_values.size());
+			return index == count - p_from ? NOT_FOUND : SoaVectorSizeType(p_from + index);
+		} else {
+			for (SoaVectorSizeType i = p_from; i < count; i++) {
+				for (const T &value : p_values) {
+					if (data[i] == value) {
+						return i;
+					}
+				}
+			}
+			return NOT_FOUND;
+		}
+	}
+
+	[[nodiscard]] SoaVectorSizeType find_any_of(std::initializer_list<T> p_values, SoaVectorSizeType p_from = 0) const {
+		return find_any_of(std::span<const T>(p_values.begin(), p_values.size()), p_from);
+	}
 
 	// Iterator API (satisfies std::ranges::contiguous_range constraints https://stackoverflow.com/a/75061822)
 	template <bool IsConst> class Iterator {
@@ -206,4 +345,58 @@ public:
 	[[nodiscard]] Iterator<true> end() const { return Iterator<true>(ptr() + size()); }
 };
 
+// Member types that SoaVector doesn't store as an array of themselves (soa::Packed, soa::ArenaString, soa::DictString). ptr() of their column doesn't point at the values, so
+// the code that needs raw values (MappedSOA, TiledSOA, soa::Table, the simd kernels) can't use them.
+template <typename T> constexpr bool is_encoded_column_v = false;
+
+// Read only random access iterator over the values of an encoded column, it calls Column::operator[] const for every value. Writes go through the column's operator[].
+template <typename Column, typename Value> class IndexIterator {
+public:
+	using difference_type = std::ptrdiff_t;
+	using value_type = Value;
+	using iterator_concept = std::random_access_iterator_tag;
+
+	IndexIterator(const Column *p_column, SoaVectorSizeType p_index) : column(p_column), index(p_index) {}
+	IndexIterator() = default;
+
+	Value operator*() const { return (*column)[index]; }
+	Value operator[](const difference_type n) const { return (*column)[SoaVectorSizeType(difference_type(index) + n)]; }
+
+	IndexIterator &operator++() {
+		++index;
+		return *this;
+	}
+	IndexIterator operator++(int) {
+		IndexIterator temp = *this;
+		++index;
+		return temp;
+	}
+	IndexIterator &operator--() {
+		--index;
+		return *this;
+	}
+	IndexIterator operator--(int) {
+		IndexIterator temp = *this;
+		--index;
+		return temp;
+	}
+
+	IndexIterator &operator+=(const difference_type n) {
+		index = SoaVectorSizeType(difference_type(index) + n);
+		return *this;
+	}
+	IndexIterator &operator-=(const difference_type n) { return *this += -n; }
+	IndexIterator operator+(const difference_type n) const { return IndexIterator(column, SoaVectorSizeType(difference_type(index) + n)); }
+	friend IndexIterator operator+(const difference_type n, const IndexIterator &p_other) { return p_other + n; }
+	IndexIterator operator-(const difference_type n) const { return *this + -n; }
+	difference_type operator-(const IndexIterator &p_other) const { return difference_type(index) - difference_type(p_other.index); }
+
+	bool operator==(const IndexIterator &p_other) const { return index == p_other.index; }
+	auto operator<=>(const IndexIterator &p_other) const { return index <=> p_other.index; }
+
+private:
+	const Column *column = nullptr;
+	SoaVectorSizeType index = 0;
+};
+
 } // namespace soa
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "SoaSerialize.hpp"
+#include "SoaSort.hpp"
+#include "SoaVector.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace soa {
+
+// Generational handle to a SparseSOA row. The generation of a slot is bumped every time its row is erased so handles to erased rows are detected instead of aliasing whatever row
+// reuses the slot.
+struct SoaHandle {
+	SoaVectorSizeType index = UINT32_MAX;
+	SoaVectorSizeType generation = 0;
+
+	bool operator==(const SoaHandle &) const = default;
+};
+
+// Sparse set used by SparseSOA instead of a hashmap. sparse maps handle index -> dense (row) index and dense_slots maps row index -> handle index, so a lookup is a single array read
+// plus a generation compare and erase can swap the last row into the erased one in O(1) the same way MutableSOA does.
+// Free sparse slots are kept in an intrusive free list that reuses the dense field.
+class SparseSet {
+	static constexpr SoaVectorSizeType NO_FREE_SLOT = UINT32_MAX;
+
+	struct Entry {
+		SoaVectorSizeType dense;
+		SoaVectorSizeType generation;
+	};
+
+	std::vector<Entry> sparse;
+	std::vector<SoaVectorSizeType> dense_slots;
+	SoaVectorSizeType free_head = NO_FREE_SLOT;
+
+public:
+	void reserve(SoaVectorSizeType p_size) {
+		sparse.reserve(p_size);
+		dense_slots.reserve(p_size);
+	}
+
+	// Adds a new row at the end of the dense array and returns its handle.
+	SoaHandle insert() {
+		const auto dense = static_cast<SoaVectorSizeType>(dense_slots.size());
+		SoaVectorSizeType slot = free_head;
+		if (slot != NO_FREE_SLOT) {
+			free_head = sparse[slot].dense;
+			sparse[slot].dense = dense;
+		} else {
+			slot = static_cast<SoaVectorSizeType>(sparse.size());
+			sparse.push_back({ dense, 0 });
+		}
+		dense_slots.push_back(slot);
+		return { slot, sparse[slot].generation };
+	}
+
+	// A free slot already has the generation its next handle will get, so the generation alone isn't enough. Its dense field is the free list link, which never points at a row
+	// that points back at the slot. Handles come from saved streams too, so they aren't trusted.
+	[[nodiscard]] bool contains(SoaHandle p_handle) const {
+		if (p_handle.index >= sparse.size()) {
+			return false;
+		}
+		const Entry &entry = sparse[p_handle.index];
+		return entry.generation == p_handle.generation and entry.dense < dense_slots.size() and dense_slots[entry.dense] == p_handle.index;
+	}
+
+	// Row index of p_handle. Throws std::out_of_range if the row was erased.
+	[[nodiscard]] SoaVectorSizeType at(SoaHandle p_handle) const {
+		if (!contains(p_handle)) [[unlikely]] {
+			throw std::out_of_range("soa::SparseSet::at");
+		}
+		return sparse[p_handle.index].dense;
+	}
+
+	[[nodiscard]] SoaHandle handle_at(SoaVectorSizeType p_index) const {
+		const SoaVectorSizeType slot = dense_slots[p_index];
+		return { slot, sparse[slot].generation };
+	}
+
+	// Removes p_handle and moves the handle of the last row into its row index. r_index_to_erase is set to the row the caller has to fill with its last row.
+	// Returns false if p_handle was already erased.
+	bool erase(SoaHandle p_handle, SoaVectorSizeType &r_index_to_erase) {
+		if (!contains(p_handle)) {
+			return false;
+		}
+
+		Entry &entry = sparse[p_handle.index];
+		r_index_to_erase = entry.dense;
+
+		const SoaVectorSizeType slot_to_move = dense_slots.back();
+		dense_slots[r_index_to_erase] = slot_to_move;
+		sparse[slot_to_move].dense = r_index_to_erase;
+		dense_slots.pop_back();
+
+		entry.generation++;
+		entry.dense = free_head;
+		free_head = p_handle.index;
+		return true;
+	}
+
+	// The rows were reordered by p_permutation, moves the handles with them.
+	void permute(const Permutation &p_permutation) {
+		permute_columns(p_permutation, dense_slots.data());
+		for (SoaVectorSizeType i = 0; i < dense_slots.size(); ++i) {
+			sparse[dense_slots[i]].dense = i;
+		}
+	}
+
+	// Used by SparseSOA's save/load, handles saved with the rows stay valid after loading them.
+	void save(std::ostream &p_stream) const {
+		const SoaVectorSizeType header[2] = { static_cast<SoaVectorSizeType>(sparse.size()), free_head };
+		write_column(p_stream, "sparse_header", header, 2);
+		write_column(p_stream, "sparse", sparse.data(), header[0]);
+		write_column(p_stream, "dense_slots", dense_slots.data(), size());
+	}
+	void load(std::istream &p_stream) {
+		SoaVectorSizeType header[2];
+		if (read_column(p_stream, "sparse_header", header, 2) != 2) {
+			throw std::runtime_error("soa::SparseSet::load: corrupt stream");
+		}
+		sparse.resize(header[0]);
+		dense_slots.resize(header[0]);
+		free_head = header[1];
+		read_column(p_stream, "sparse", sparse.data(), header[0]);
+		dense_slots.resize(read_column(p_stream, "dense_slots", dense_slots.data(), header[0]));
+	}
+
+	void clear() {
+		sparse.clear();
+		dense_slots.clear();
+		free_head = NO_FREE_SLOT;
+	}
+
+	[[nodiscard]] SoaVectorSizeType size() const { return static_cast<SoaVectorSizeType>(dense_slots.size()); }
+	[[nodiscard]] uint64_t memory_bytes() const { return sparse.capacity() * sizeof(Entry) + dense_slots.capacity() * sizeof(SoaVectorSizeType); }
+};
+
+} // namespace soa
@@ -1,11 +1,48 @@
 #pragma once
 
+#include "FlatIndexMap.hpp"
 #include "ForEachMacro.hpp"
+#include "SoaAllocatorPolicy.hpp"
+#include "SoaBuffered.hpp"
+#include "SoaConcurrentAppend.hpp"
+#include "SoaDirty.hpp"
+#include "SoaErase.hpp"
+#include "SoaGrowthPolicy.hpp"
+#include "SoaMapped.hpp"
+#include "SoaPacked.hpp"
+#include "SoaParallel.hpp"
+#include "SoaQuery.hpp"
+#include "SoaRows.hpp"
+#include "SoaSerialize.hpp"
+#include "SoaSort.hpp"
+#include "SoaStats.hpp"
+#include "SoaString.hpp"
+#include "SoaTable.hpp"
+#include "SoaTiled.hpp"
+#include "SparseSet.hpp"
 #include "SoaVector.hpp"
 
-#define SOA_MAP_TYPE std::unordered_map<SoaVectorSizeType, SoaVectorSizeType>
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// The entity id -> index map used by MutableSOA. Define these before including soa.hpp to use a different map type, the map needs find, end, contains, at, operator[], erase and
+// reserve. For example to use the std one:
+// #define SOA_MAP_TYPE std::unordered_map<SoaVectorSizeType, SoaVectorSizeType>
+#ifndef SOA_MAP_TYPE
+#define SOA_MAP_TYPE soa::FlatIndexMap
+#endif
+#ifndef SOA_MAP_AT_FUNC
 #define SOA_MAP_AT_FUNC(m_entity_id) index_map.at(m_entity_id)
+#endif
+#ifndef SOA_MAP_VALUE_NAME
 #define SOA_MAP_VALUE_NAME ->second
+#endif
 
 #define SOA_FIXED_VECTOR_TYPE(m_type) soa::SoaVector<m_type>
 #define SOA_DYNAMIC_VECTOR_TYPE(m_type) soa::SoaVector<m_type>
@@ -14,65 +51,325 @@
 
 #define SOA_DYNAMIC_TYPES(m_type, m_name) SOA_DYNAMIC_VECTOR_TYPE(m_type) m_name;
 
-#define SOA_INIT(m_type, m_name)                                                                                                                                                             \
-	m_name.init(data, p_size, memory_offsets[current_column]);                                                                                                                               \
-	current_column++;
-
 #define SOA_INIT_FIXED(m_type, m_name)                                                                                                                                                       \
 	m_name.init_fixed(data, p_size, memory_offsets[current_column]);                                                                                                                         \
 	current_column++;
 
 #define SOA_GET_MALLOC_SIZE(m_type, m_name)                                                                                                                                                  \
+	total_size = soa::align_up(total_size, soa::column_alignment<m_type>());                                                                                                                 \
+	block_alignment = std::max(block_alignment, soa::column_alignment<m_type>());                                                                                                            \
 	memory_offsets[mem_offset_idx] = total_size;                                                                                                                                             \
-	total_size += sizeof(m_type) * p_size;                                                                                                                                                   \
+	total_size += soa::SoaVector<m_type>::column_bytes(p_size);                                                                                                                              \
 	mem_offset_idx++;
 
 #define SOA_SETGET(m_type, m_name)                                                                                                                                                           \
-	void set_##m_name(SoaVectorSizeType p_index, const m_type &p_item) { m_name[p_index] = p_item; }                                                                                         \
-	[[nodiscard]] m_type get_##m_name(SoaVectorSizeType p_index) { return m_name[p_index]; }                                                                                                 \
-	[[nodiscard]] const m_type &get_##m_name(SoaVectorSizeType p_index) const { return m_name[p_index]; }
+	void set_##m_name(SoaVectorSizeType p_index, const soa::SoaVector<m_type>::value_type &p_item) {                                                                                         \
+		m_name[p_index] = p_item;                                                                                                                                                            \
+		soa_mark_dirty(soa_dirty_##m_name, p_index);                                                                                                                                         \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] soa::SoaVector<m_type>::value_type get_##m_name(SoaVectorSizeType p_index) { return m_name[p_index]; }                                                                     \
+	[[nodiscard]] soa::SoaVector<m_type>::const_reference get_##m_name(SoaVectorSizeType p_index) const { return m_name[p_index]; }
 
 #define SOA_PUSH(m_type, m_name)                                                                                                                                                             \
-	void push_##m_name(const m_type &p_elem) {                                                                                                                                               \
+	void push_##m_name(const soa::SoaVector<m_type>::value_type &p_elem) {                                                                                                                   \
 		if (m_name.size() == soa_capacity) [[unlikely]] {                                                                                                                                    \
-			soa_realloc();                                                                                                                                                                   \
+			soa_grow();                                                                                                                                                                      \
 		}                                                                                                                                                                                    \
-		m_name.push_soa_member(p_elem);                                                                                                                                                      \
+		soa_mark_dirty(soa_dirty_##m_name, m_name.push_soa_member(p_elem) - 1);                                                                                                              \
 	}
 
 #define SOA_MUTABLE_SETGET(m_type, m_name)                                                                                                                                                   \
-	void set_##m_name(SoaVectorSizeType p_entity_id, const m_type &p_item) {                                                                                                                 \
+	void set_##m_name(SoaVectorSizeType p_entity_id, const soa::SoaVector<m_type>::value_type &p_item) {                                                                                     \
 		const SoaVectorSizeType &index = SOA_MAP_AT_FUNC(p_entity_id);                                                                                                                       \
 		m_name[index] = p_item;                                                                                                                                                              \
+		soa_mark_dirty(soa_dirty_##m_name, index);                                                                                                                                           \
 	}                                                                                                                                                                                        \
-	[[nodiscard]] m_type get_##m_name(SoaVectorSizeType p_entity_id) {                                                                                                                       \
+	[[nodiscard]] soa::SoaVector<m_type>::value_type get_##m_name(SoaVectorSizeType p_entity_id) {                                                                                           \
 		const SoaVectorSizeType &index = SOA_MAP_AT_FUNC(p_entity_id);                                                                                                                       \
 		return m_name[index];                                                                                                                                                                \
 	}                                                                                                                                                                                        \
-	[[nodiscard]] const m_type &get_##m_name(SoaVectorSizeType p_entity_id) const {                                                                                                          \
+	[[nodiscard]] soa::SoaVector<m_type>::const_reference get_##m_name(SoaVectorSizeType p_entity_id) const {                                                                                \
 		const SoaVectorSizeType &index = SOA_MAP_AT_FUNC(p_entity_id);                                                                                                                       \
 		return m_name[index];                                                                                                                                                                \
 	}
 
 #define SOA_MUTABLE_PUSH(m_type, m_name)                                                                                                                                                     \
-	void push_##m_name(const m_type &p_elem) {                                                                                                                                               \
+	void push_##m_name(const soa::SoaVector<m_type>::value_type &p_elem) {                                                                                                                   \
 		if (m_name.size() == soa_capacity) [[unlikely]] {                                                                                                                                    \
-			soa_realloc();                                                                                                                                                                   \
+			soa_grow();                                                                                                                                                                      \
+		}                                                                                                                                                                                    \
+		const SoaVectorSizeType new_index = m_name.push_soa_member(p_elem) - 1;                                                                                                              \
+		soa_mark_dirty(soa_dirty_##m_name, new_index);                                                                                                                                       \
+		if (new_index == soa_size) {                                                                                                                                                         \
+			soa_insert_entity();                                                                                                                                                             \
+		}                                                                                                                                                                                    \
+	}
+
+#define SOA_SPARSE_SETGET(m_type, m_name)                                                                                                                                                    \
+	void set_##m_name(soa::SoaHandle p_handle, const soa::SoaVector<m_type>::value_type &p_item) {                                                                                           \
+		const SoaVectorSizeType index = index_set.at(p_handle);                                                                                                                              \
+		m_name[index] = p_item;                                                                                                                                                              \
+		soa_mark_dirty(soa_dirty_##m_name, index);                                                                                                                                           \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] soa::SoaVector<m_type>::value_type get_##m_name(soa::SoaHandle p_handle) { return m_name[index_set.at(p_handle)]; }                                                        \
+	[[nodiscard]] soa::SoaVector<m_type>::const_reference get_##m_name(soa::SoaHandle p_handle) const { return m_name[index_set.at(p_handle)]; }
+
+#define SOA_ROW_PARAM(m_type, m_name) const soa::SoaVector<m_type>::value_type &p_##m_name
+#define SOA_ROW_ARG(m_type, m_name) p_##m_name
+#define SOA_ROW_TEMPLATE_PARAM(m_type, m_name) typename P_##m_name
+#define SOA_ROW_FORWARD_PARAM(m_type, m_name) P_##m_name &&p_##m_name
+#define SOA_ROW_SIZE(m_type, m_name) row_size = std::max(row_size, m_name.size());
+#define SOA_EMPLACE_ROW_MEMBER(m_type, m_name) m_name.emplace_soa_member(std::forward<P_##m_name>(p_##m_name));
+
+// push_row/emplace_row do a single capacity check and at most one soa_realloc for the whole row instead of one per column.
+// They assume every column has the same size, mixing them with push_X calls that leave the columns uneven will misalign the rows.
+#define SOA_PUSH_ROW(...)                                                                                                                                                                    \
+	void push_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_PARAM, __VA_OPT__(__VA_ARGS__, ))) { emplace_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_ARG, __VA_OPT__(__VA_ARGS__, ))); }                         \
+	template <FOR_EACH_TWO_ARGS_LIST(SOA_ROW_TEMPLATE_PARAM, __VA_OPT__(__VA_ARGS__, ))> void emplace_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_FORWARD_PARAM, __VA_OPT__(__VA_ARGS__, ))) {        \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		if (row_size == soa_capacity) [[unlikely]] {                                                                                                                                         \
+			soa_grow();                                                                                                                                                                      \
+		}                                                                                                                                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_EMPLACE_ROW_MEMBER, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+		soa_mark_row_dirty(row_size);                                                                                                                                                        \
+	}
+
+// Same as SOA_PUSH_ROW but also inserts the index_map entry for the new row. Returns the entity id (or handle for SparseSOA) of the new row.
+#define SOA_MUTABLE_PUSH_ROW(...)                                                                                                                                                            \
+	soa_id_type push_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_PARAM, __VA_OPT__(__VA_ARGS__, ))) {                                                                                                 \
+		return emplace_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_ARG, __VA_OPT__(__VA_ARGS__, )));                                                                                                  \
+	}                                                                                                                                                                                        \
+	template <FOR_EACH_TWO_ARGS_LIST(SOA_ROW_TEMPLATE_PARAM, __VA_OPT__(__VA_ARGS__, ))>                                                                                                     \
+	soa_id_type emplace_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_FORWARD_PARAM, __VA_OPT__(__VA_ARGS__, ))) {                                                                                      \
+		if (soa_size == soa_capacity) [[unlikely]] {                                                                                                                                         \
+			soa_grow();                                                                                                                                                                      \
+		}                                                                                                                                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_EMPLACE_ROW_MEMBER, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+		soa_mark_row_dirty(soa_size);                                                                                                                                                        \
+		return soa_insert_entity();                                                                                                                                                          \
+	}
+
+// where() starts a query (see SoaQuery.hpp): soa.where(&S::a, soa::simd::Compare::Less, 10).select(&S::b, &S::c)
+#define SOA_QUERY(m_class_name)                                                                                                                                                              \
+	template <typename T, typename... Args> [[nodiscard]] soa::Selection<m_class_name> where(soa::SoaVector<T> m_class_name::*p_member, Args &&...p_args) const {                            \
+		return soa::where(*this, p_member, std::forward<Args>(p_args)...);                                                                                                                   \
+	}
+
+// row(id) returns a proxy holding a reference to each member of the row, so nothing is copied and it works with structured bindings: auto [a, b] = soa.row(i);
+// rows() is a random access range of the same proxies for every row that exists in all members: for (auto [a, b] : soa.rows()) { ... }
+// m_id_to_index turns the row(p_id) argument into a row index, m_row_element is the expression for one member of row p_index and m_min_row_size shrinks row_count to the size
+// of one member.
+#define SOA_ROW_REFERENCE(m_type, m_name) std::conditional_t<Const, typename soa::SoaVector<m_type>::const_reference, typename soa::SoaVector<m_type>::reference> m_name;
+#define SOA_ROW_ELEMENT(m_type, m_name) m_name[p_index]
+#define SOA_MIN_ROW_SIZE(m_type, m_name) row_count = std::min(row_count, m_name.size());
+#define SOA_ROWS(m_class_name, m_id_type, m_id_to_index, m_row_element, m_min_row_size, ...)                                                                                                 \
+	template <bool Const> struct soa_row {                                                                                                                                                   \
+		FOR_EACH_TWO_ARGS(SOA_ROW_REFERENCE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                      \
+	};                                                                                                                                                                                       \
+	template <typename, typename> friend class soa::RowIterator;                                                                                                                             \
+	template <typename, typename> friend class soa::RowRange;                                                                                                                                \
+                                                                                                                                                                                             \
+private:                                                                                                                                                                                     \
+	soa_row<false> soa_row_at(SoaVectorSizeType p_index) { return { FOR_EACH_TWO_ARGS_LIST(m_row_element, __VA_OPT__(__VA_ARGS__, )) }; }                                                    \
+	soa_row<true> soa_row_at(SoaVectorSizeType p_index) const { return { FOR_EACH_TWO_ARGS_LIST(m_row_element, __VA_OPT__(__VA_ARGS__, )) }; }                                               \
+	[[nodiscard]] SoaVectorSizeType soa_row_count() const {                                                                                                                                  \
+		SoaVectorSizeType row_count = std::numeric_limits<SoaVectorSizeType>::max();                                                                                                         \
+		FOR_EACH_TWO_ARGS(m_min_row_size, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
+		return row_count;                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+                                                                                                                                                                                             \
+public:                                                                                                                                                                                      \
+	[[nodiscard]] soa_row<false> row(m_id_type p_id) { return soa_row_at(m_id_to_index); }                                                                                                   \
+	[[nodiscard]] soa_row<true> row(m_id_type p_id) const { return soa_row_at(m_id_to_index); }                                                                                              \
+	[[nodiscard]] soa::RowRange<m_class_name, soa_row<false>> rows() { return { this, soa_row_count() }; }                                                                                   \
+	[[nodiscard]] soa::RowRange<const m_class_name, soa_row<true>> rows() const { return { this, soa_row_count() }; }
+
+// sort_by(&S::key, compare) sorts the rows by one member. The row order is computed once (a radix sort for std::less/std::greater on integer and float keys, a stable
+// comparison sort otherwise) and then every column is permuted on its own (see soa::permute_columns) instead of copying every row into a tuple and back.
+// permute(permutation) applies any order, for example one from soa::sort_permutation or one computed from multiple keys. It throws std::invalid_argument
+// unless the permutation holds every row index exactly once, since a short or repeating one would read past the columns or lose rows.
+// m_permute_ids is run with the permutation in p_permutation to keep entity ids/handles pointing at their rows.
+#define SOA_COLUMN_PTR(m_type, m_name) m_name.ptr()
+#define SOA_SORT(m_class_name, m_permute_ids, ...)                                                                                                                                           \
+	template <typename T, typename Compare = std::less<>> void sort_by(soa::SoaVector<T> m_class_name::*p_member, Compare p_compare = {}) {                                                  \
+		soa_permute(soa::sort_permutation(this->*p_member, soa_row_count(), p_compare));                                                                                                     \
+	}                                                                                                                                                                                        \
+	void permute(const soa::Permutation &p_permutation) {                                                                                                                                    \
+		if (!soa::is_permutation_of_rows(p_permutation, soa_row_count())) {                                                                                                                  \
+			throw std::invalid_argument(#m_class_name "::permute: the permutation has to hold every row index exactly once");                                                                \
+		}                                                                                                                                                                                    \
+		soa_permute(p_permutation);                                                                                                                                                          \
+	}                                                                                                                                                                                        \
+	void soa_permute(const soa::Permutation &p_permutation) {                                                                                                                                \
+		soa::permute_columns(p_permutation, FOR_EACH_TWO_ARGS_LIST(SOA_COLUMN_PTR, __VA_OPT__(__VA_ARGS__, )));                                                                              \
+		m_permute_ids;                                                                                                                                                                       \
+		soa_mark_all_dirty();                                                                                                                                                                \
+	}
+
+// save(stream) writes every column with the encoding that fits its data (see SoaSerialize.hpp) and load(stream) replaces the whole table with what save wrote. load reserves all
+// rows once with m_prepare_load and then decodes each column straight into its memory. m_save_ids/m_load_ids write and read the entity ids/handles of MutableSOA and SparseSOA.
+// load throws std::runtime_error if the stream was written by a struct with other members or is corrupt. A stream that fails after the header leaves the table cleared, so no
+// column (or the ids/handles) is left with rows the others don't have.
+// Both are templates so structs with members save can't encode still compile as long as they don't call them.
+#define SOA_SAVE_COLUMN(m_type, m_name) soa::save_column(p_stream, #m_type " " #m_name, m_name);
+#define SOA_LOAD_COLUMN(m_type, m_name) soa::load_column(p_stream, #m_type " " #m_name, m_name, rows);
+#define SOA_CLEAR_COLUMN(m_type, m_name) m_name.clear();
+#define SOA_SERIALIZE(m_total_columns, m_prepare_load, m_save_ids, m_load_ids, ...)                                                                                                          \
+	template <std::derived_from<std::ostream> Stream> void save(Stream &p_stream) const {                                                                                                    \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		soa::write_table_header(p_stream, m_total_columns, row_size);                                                                                                                        \
+		FOR_EACH_TWO_ARGS(SOA_SAVE_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                        \
+		m_save_ids;                                                                                                                                                                          \
+	}                                                                                                                                                                                        \
+	template <std::derived_from<std::istream> Stream> void load(Stream &p_stream) {                                                                                                          \
+		const SoaVectorSizeType rows = soa::read_table_header(p_stream, m_total_columns);                                                                                                    \
+		try {                                                                                                                                                                                \
+			m_prepare_load;                                                                                                                                                                  \
+			FOR_EACH_TWO_ARGS(SOA_CLEAR_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                   \
+			FOR_EACH_TWO_ARGS(SOA_LOAD_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                    \
+			m_load_ids;                                                                                                                                                                      \
+		} catch (...) {                                                                                                                                                                      \
+			clear();                                                                                                                                                                         \
+			throw;                                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+		soa_mark_all_dirty();                                                                                                                                                                \
+	}
+
+// Dirty tracking, only active with `using soa_dirty_policy = soa::TrackDirty<>;` (see SoaDirty.hpp). set_X, push_X, push_row, erase, sort and load mark the rows they change in
+// soa_dirty_X, writes straight into a column (soa.x[i] = ...) or through row() aren't seen so call mark_dirty(&S::x, i) after them.
+// for_each_dirty(&S::x, func) calls func(row) for every dirty row of x that still exists and clear_dirty() starts over, usually once every consumer has seen the rows.
+// export_delta(stream) writes the dirty rows of every column (and the size of each column) and apply_delta(stream) writes them into a copy of the table that matched this one at
+// the last clear_dirty(), so a replica only pays for the changed rows. m_prepare_apply makes room for the rows of the delta and m_export_ids/m_apply_ids keep the entity ids or
+// handles of MutableSOA and SparseSOA in sync. apply_delta doesn't mark the rows it writes.
+// merge_dirty(other) adds the dirty rows of another table of the same struct to this one and pull_dirty(from) copies the rows that are dirty in this table from another one,
+// makes every column from's size and clears the dirty rows, m_pull_ids does the same for the ids/handles. soa::BufferedSOA uses them to only copy what changed between buffers.
+#define SOA_DIRTY_MASK(m_type, m_name) soa::DirtyMask soa_dirty_##m_name;
+#define SOA_MARK_ROW_DIRTY(m_type, m_name) soa_dirty_##m_name.set(p_row / policy::rows_per_bit);
+#define SOA_MARK_ALL_DIRTY(m_type, m_name) soa_dirty_##m_name.set_range(0, (m_name.size() + policy::rows_per_bit - 1) / policy::rows_per_bit);
+#define SOA_CLEAR_DIRTY(m_type, m_name) soa_dirty_##m_name.clear();
+#define SOA_MERGE_DIRTY(m_type, m_name) r_rows.merge(soa_dirty_##m_name);
+#define SOA_DIRTY_MASK_OF(m_type, m_name)                                                                                                                                                    \
+	if (p_column == &p_self.m_name) {                                                                                                                                                        \
+		return p_self.soa_dirty_##m_name;                                                                                                                                                    \
+	}
+#define SOA_EXPORT_DIRTY_COLUMN(m_type, m_name) soa::write_delta_column(p_stream, #m_type " " #m_name, m_name, soa_dirty_##m_name, policy::rows_per_bit);
+#define SOA_APPLY_DIRTY_COLUMN(m_type, m_name) soa::read_delta_column(p_stream, #m_type " " #m_name, m_name, rows);
+#define SOA_MERGE_OTHER_DIRTY(m_type, m_name) soa_dirty_##m_name.merge(p_other.soa_dirty_##m_name);
+#define SOA_FROM_ROW_SIZE(m_type, m_name) rows = std::max(rows, p_from.m_name.size());
+#define SOA_PULL_DIRTY_COLUMN(m_type, m_name) soa::copy_dirty_column(m_name, p_from.m_name, soa_dirty_##m_name, policy::rows_per_bit);
+#define SOA_DIRTY(m_class_name, m_total_columns, m_prepare_apply, m_export_ids, m_apply_ids, m_pull_ids, ...)                                                                                \
+private:                                                                                                                                                                                     \
+	FOR_EACH_TWO_ARGS(SOA_DIRTY_MASK, __VA_OPT__(__VA_ARGS__, ))                                                                                                                             \
+	void soa_mark_dirty(soa::DirtyMask &r_mask, SoaVectorSizeType p_row) {                                                                                                                   \
+		using policy = soa::dirty_policy_of<m_class_name>::type;                                                                                                                             \
+		if constexpr (policy::tracking) {                                                                                                                                                    \
+			r_mask.set(p_row / policy::rows_per_bit);                                                                                                                                        \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void soa_mark_row_dirty(SoaVectorSizeType p_row) {                                                                                                                                       \
+		using policy = soa::dirty_policy_of<m_class_name>::type;                                                                                                                             \
+		if constexpr (policy::tracking) {                                                                                                                                                    \
+			FOR_EACH_TWO_ARGS(SOA_MARK_ROW_DIRTY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void soa_mark_all_dirty() {                                                                                                                                                              \
+		using policy = soa::dirty_policy_of<m_class_name>::type;                                                                                                                             \
+		if constexpr (policy::tracking) {                                                                                                                                                    \
+			FOR_EACH_TWO_ARGS(SOA_MARK_ALL_DIRTY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
 		}                                                                                                                                                                                    \
-		SoaVectorSizeType new_index = m_name.push_soa_member(p_elem) - 1;                                                                                                                    \
-		soa_size = std::max(soa_size, new_index + 1);                                                                                                                                        \
-		index_map[new_index] = new_index;                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void soa_dirty_rows(soa::DirtyMask &r_rows) const { FOR_EACH_TWO_ARGS(SOA_MERGE_DIRTY, __VA_OPT__(__VA_ARGS__, )) }                                                                      \
+	template <typename Self> static auto &soa_dirty_mask(Self &p_self, const void *p_column) {                                                                                               \
+		FOR_EACH_TWO_ARGS(SOA_DIRTY_MASK_OF, __VA_OPT__(__VA_ARGS__, ))                                                                                                                      \
+		throw std::logic_error("not a member of " #m_class_name);                                                                                                                            \
+	}                                                                                                                                                                                        \
+                                                                                                                                                                                             \
+public:                                                                                                                                                                                      \
+	template <typename T> void mark_dirty(soa::SoaVector<T> m_class_name::*p_member, SoaVectorSizeType p_index) {                                                                            \
+		soa_mark_dirty(soa_dirty_mask(*this, &(this->*p_member)), p_index);                                                                                                                  \
+	}                                                                                                                                                                                        \
+	template <typename T, typename Func> void for_each_dirty(soa::SoaVector<T> m_class_name::*p_member, Func &&p_func) const {                                                               \
+		using policy = soa::dirty_policy_of<m_class_name>::type;                                                                                                                             \
+		static_assert(soa::tracks_dirty_rows<m_class_name, T>, "for_each_dirty needs a soa_dirty_policy that tracks rows");                                                                  \
+		soa_dirty_mask(*this, &(this->*p_member)).for_each_row(policy::rows_per_bit, (this->*p_member).size(), p_func);                                                                      \
+	}                                                                                                                                                                                        \
+	void clear_dirty() { FOR_EACH_TWO_ARGS(SOA_CLEAR_DIRTY, __VA_OPT__(__VA_ARGS__, )) }                                                                                                     \
+	template <std::derived_from<std::ostream> Stream> void export_delta(Stream &p_stream) const {                                                                                            \
+		using policy = soa::dirty_policy_of<m_class_name>::type;                                                                                                                             \
+		static_assert(soa::tracks_dirty_rows<m_class_name, Stream>, "export_delta needs a soa_dirty_policy that tracks rows");                                                               \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		soa::write_delta_header(p_stream, m_total_columns, row_size);                                                                                                                        \
+		FOR_EACH_TWO_ARGS(SOA_EXPORT_DIRTY_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                \
+		m_export_ids;                                                                                                                                                                        \
+	}                                                                                                                                                                                        \
+	template <std::derived_from<std::istream> Stream> void apply_delta(Stream &p_stream) {                                                                                                   \
+		const SoaVectorSizeType rows = soa::read_delta_header(p_stream, m_total_columns);                                                                                                    \
+		m_prepare_apply;                                                                                                                                                                     \
+		FOR_EACH_TWO_ARGS(SOA_APPLY_DIRTY_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+		m_apply_ids;                                                                                                                                                                         \
+	}                                                                                                                                                                                        \
+	void merge_dirty(const m_class_name &p_other) { FOR_EACH_TWO_ARGS(SOA_MERGE_OTHER_DIRTY, __VA_OPT__(__VA_ARGS__, )) }                                                                    \
+	void pull_dirty(const m_class_name &p_from) {                                                                                                                                            \
+		using policy = soa::dirty_policy_of<m_class_name>::type;                                                                                                                             \
+		SoaVectorSizeType rows = 0;                                                                                                                                                          \
+		FOR_EACH_TWO_ARGS(SOA_FROM_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                      \
+		m_prepare_apply;                                                                                                                                                                     \
+		FOR_EACH_TWO_ARGS(SOA_PULL_DIRTY_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                  \
+		m_pull_ids;                                                                                                                                                                          \
+		clear_dirty();                                                                                                                                                                       \
 	}
 
+// Used by soa::ConcurrentAppendSOA (see SoaConcurrentAppend.hpp). emplace_row_at(row, ...) constructs row p_row in the spare capacity without changing the size, so different threads
+// can fill different rows at once, emplace_default_row_at does the same with default constructed members. commit_rows(count) then adds the next count constructed rows to every
+// column. append_rows(from, first, count) moves the rows [first, first + count) of another table to the end of this one with at most 1 soa_realloc.
+#define SOA_EMPLACE_ROW_AT_MEMBER(m_type, m_name) m_name.emplace_soa_member_at(p_row, std::forward<P_##m_name>(p_##m_name));
+#define SOA_EMPLACE_DEFAULT_AT_MEMBER(m_type, m_name) static_cast<Self *>(this)->m_name.emplace_soa_member_at(p_row);
+#define SOA_COMMIT_ROWS_MEMBER(m_type, m_name) m_name.commit_soa_members(p_count);
+#define SOA_APPEND_ROWS_MEMBER(m_type, m_name)                                                                                                                                               \
+	for (SoaVectorSizeType i = p_first; i < p_first + p_count; ++i) {                                                                                                                        \
+		m_name.emplace_soa_member(std::move(p_from.m_name[i]));                                                                                                                              \
+	}
+#define SOA_APPEND(m_class_name, ...)                                                                                                                                                        \
+	template <FOR_EACH_TWO_ARGS_LIST(SOA_ROW_TEMPLATE_PARAM, __VA_OPT__(__VA_ARGS__, ))>                                                                                                     \
+	void emplace_row_at(SoaVectorSizeType p_row, FOR_EACH_TWO_ARGS_LIST(SOA_ROW_FORWARD_PARAM, __VA_OPT__(__VA_ARGS__, ))) {                                                                 \
+		FOR_EACH_TWO_ARGS(SOA_EMPLACE_ROW_AT_MEMBER, __VA_OPT__(__VA_ARGS__, ))                                                                                                              \
+	}                                                                                                                                                                                        \
+	template <typename Self = m_class_name> void emplace_default_row_at(SoaVectorSizeType p_row) { FOR_EACH_TWO_ARGS(SOA_EMPLACE_DEFAULT_AT_MEMBER, __VA_OPT__(__VA_ARGS__, )) }             \
+	void commit_rows(SoaVectorSizeType p_count) {                                                                                                                                            \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		FOR_EACH_TWO_ARGS(SOA_COMMIT_ROWS_MEMBER, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+		for (SoaVectorSizeType row = row_size; row < row_size + p_count; ++row) {                                                                                                            \
+			soa_mark_row_dirty(row);                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void append_rows(m_class_name &p_from, SoaVectorSizeType p_first, SoaVectorSizeType p_count) {                                                                                           \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		if (row_size + p_count > soa_capacity) {                                                                                                                                             \
+			soa_realloc(soa::growth_policy_of<m_class_name>::type::grow(soa_capacity, row_size + p_count));                                                                                  \
+		}                                                                                                                                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_APPEND_ROWS_MEMBER, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+		for (SoaVectorSizeType row = row_size; row < row_size + p_count; ++row) {                                                                                                            \
+			soa_mark_row_dirty(row);                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}
+
+// Only FixedSizeSOA constructs its elements up front, dynamic SOAs construct each element when it's pushed so their memory is never zeroed.
 #define SOA_DEFAULT_CONSTRUCT(m_type, m_name)                                                                                                                                                \
 	if constexpr (!std::is_trivially_constructible_v<m_type>) {                                                                                                                              \
 		for (SoaVectorSizeType i = 0; i < p_size; ++i) {                                                                                                                                     \
-			new (&m_name[i]) m_type();                                                                                                                                                       \
+			new (m_name.ptr() + i) m_type();                                                                                                                                                 \
 		}                                                                                                                                                                                    \
+	} else {                                                                                                                                                                                 \
+		memset(static_cast<void *>(m_name.ptr()), 0, soa::SoaVector<m_type>::column_bytes(p_size));                                                                                          \
 	}
 
 #define SOA_REALLOC(m_type, m_name)                                                                                                                                                          \
-	m_name.soa_realloc(new_data, memory_offsets[current_column], starting_capacity);                                                                                                         \
+	m_name.soa_realloc(new_data, memory_offsets[current_column]);                                                                                                                            \
 	current_column++;
 
 #define SOA_DESTROY(m_type, m_name) m_name.reset();
@@ -84,56 +381,375 @@
 
 #define SOA_POST_ERASE(m_type, m_name) m_name.post_erase(index_to_erase, end_index);
 
+#define SOA_COMPACT_MEMBER(m_type, m_name) m_name.compact_soa_member(p_erased, moves, new_size);
+
+// memory_report() lists the size and capacity of every column (see SoaStats.hpp), m_capacity is the capacity expression of the macro, m_block_bytes the size of its block and
+// m_index_bytes the memory of its ids. With SOA_ENABLE_STATS defined every macro also counts its allocations: soa_realloc calls soa_stats_realloc with the bytes it allocated and
+// moved, erase calls soa_stats_erase and stats() adds the current capacity, size and m_index_probes to the counters. m_column_memory and m_column_bytes read the size of a column.
+#define SOA_COLUMN_MEMORY(m_type, m_name)                                                                                                                                                    \
+	report.columns.push_back({ #m_type " " #m_name, m_name.size(), capacity, soa::SoaVector<m_type>::column_bytes(m_name.size()),                                                            \
+			soa::SoaVector<m_type>::column_bytes(capacity) });
+#define SOA_COLUMN_BYTES(m_type, m_name) bytes += soa::SoaVector<m_type>::column_bytes(m_name.size());
+#define SOA_CAPACITY_BYTES(m_type, m_name) +soa::SoaVector<m_type>::column_bytes(p_rows)
+#ifdef SOA_ENABLE_STATS
+#define SOA_STATS_MEMBERS(m_class_name, m_capacity, m_index_probes, m_column_bytes, ...)                                                                                                     \
+private:                                                                                                                                                                                     \
+	soa::SoaStats soa_stats;                                                                                                                                                                 \
+	soa::GrowthHook soa_growth_hook;                                                                                                                                                         \
+	static constexpr uint64_t soa_capacity_bytes(uint64_t p_rows) { return 0 FOR_EACH_TWO_ARGS(SOA_CAPACITY_BYTES, __VA_OPT__(__VA_ARGS__, )); }                                             \
+	[[nodiscard]] uint64_t soa_column_bytes() const {                                                                                                                                        \
+		uint64_t bytes = 0;                                                                                                                                                                  \
+		FOR_EACH_TWO_ARGS(m_column_bytes, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
+		return bytes;                                                                                                                                                                        \
+	}                                                                                                                                                                                        \
+	void soa_stats_sample() { soa_stats.peak_size = std::max(soa_stats.peak_size, soa_row_count()); }                                                                                        \
+	void soa_stats_realloc(SoaVectorSizeType p_old_capacity, SoaVectorSizeType p_new_capacity, uint64_t p_bytes_allocated, uint64_t p_bytes_moved) {                                         \
+		soa_stats_sample();                                                                                                                                                                  \
+		soa_stats.realloc_calls++;                                                                                                                                                           \
+		soa_stats.bytes_allocated += p_bytes_allocated;                                                                                                                                      \
+		soa_stats.bytes_moved += p_bytes_moved;                                                                                                                                              \
+		soa_stats.peak_capacity = std::max(soa_stats.peak_capacity, p_new_capacity);                                                                                                         \
+		if (soa_growth_hook) {                                                                                                                                                               \
+			soa_growth_hook({ #m_class_name, p_old_capacity, p_new_capacity, soa_row_count(), p_bytes_allocated, p_bytes_moved });                                                           \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void soa_stats_erase(uint64_t p_rows) {                                                                                                                                                  \
+		soa_stats_sample();                                                                                                                                                                  \
+		soa_stats.erase_calls++;                                                                                                                                                             \
+		soa_stats.erased_rows += p_rows;                                                                                                                                                     \
+	}                                                                                                                                                                                        \
+                                                                                                                                                                                             \
+public:                                                                                                                                                                                      \
+	[[nodiscard]] soa::SoaStats stats() const {                                                                                                                                              \
+		soa::SoaStats result = soa_stats;                                                                                                                                                    \
+		result.capacity = m_capacity;                                                                                                                                                        \
+		result.size = soa_row_count();                                                                                                                                                       \
+		result.peak_capacity = std::max(result.peak_capacity, result.capacity);                                                                                                              \
+		result.peak_size = std::max(result.peak_size, result.size);                                                                                                                          \
+		result.index_probes = m_index_probes;                                                                                                                                                \
+		return result;                                                                                                                                                                       \
+	}                                                                                                                                                                                        \
+	void reset_stats() { soa_stats = {}; }                                                                                                                                                   \
+	void set_growth_hook(soa::GrowthHook p_hook) { soa_growth_hook = std::move(p_hook); }
+#else
+#define SOA_STATS_MEMBERS(m_class_name, m_capacity, m_index_probes, m_column_bytes, ...)
+#endif
+#define SOA_STATS(m_class_name, m_capacity, m_block_bytes, m_index_bytes, m_index_probes, m_column_memory, m_column_bytes, ...)                                                              \
+	[[nodiscard]] soa::MemoryReport memory_report() const {                                                                                                                                  \
+		soa::MemoryReport report;                                                                                                                                                            \
+		const SoaVectorSizeType capacity = m_capacity;                                                                                                                                       \
+		FOR_EACH_TWO_ARGS(m_column_memory, __VA_OPT__(__VA_ARGS__, ))                                                                                                                        \
+		report.block_bytes = m_block_bytes;                                                                                                                                                  \
+		report.index_bytes = m_index_bytes;                                                                                                                                                  \
+		return report;                                                                                                                                                                       \
+	}                                                                                                                                                                                        \
+	SOA_STATS_MEMBERS(m_class_name, m_capacity, m_index_probes, m_column_bytes, __VA_ARGS__)
+
+// Every macro except MappedSOA gets its column block from the allocator policy of the struct (see SoaAllocatorPolicy.hpp). soa_set_block gives the old block back with the
+// alignment and size it was allocated with and remembers them for the new one.
+#define SOA_BLOCK(m_class_name, m_data)                                                                                                                                                      \
+	uint64_t soa_allocation_alignment = 0;                                                                                                                                                   \
+	uint64_t soa_allocation_size = 0;                                                                                                                                                        \
+	static void *soa_allocate_block(uint64_t p_alignment, uint64_t p_size) { return soa::allocator_policy_of<m_class_name>::type::allocate(p_alignment, p_size); }                           \
+	void soa_set_block(void *p_data, uint64_t p_alignment, uint64_t p_size) {                                                                                                                \
+		if (m_data != nullptr) {                                                                                                                                                             \
+			soa::allocator_policy_of<m_class_name>::type::deallocate(m_data, soa_allocation_alignment, soa_allocation_size);                                                                 \
+		}                                                                                                                                                                                    \
+		m_data = static_cast<decltype(m_data)>(p_data);                                                                                                                                      \
+		soa_allocation_alignment = p_alignment;                                                                                                                                              \
+		soa_allocation_size = p_size;                                                                                                                                                        \
+	}
+
+// With an allocator policy that reserves rows (see soa::VirtualReserveAllocator) DynamicSOA, MutableSOA and SparseSOA reserve max_rows rows for every column the first time they
+// need memory, each column starting on a new page, and after that soa_realloc only commits or decommits the pages between the old and the new capacity instead of moving anything.
+// The capacity never goes over max_rows, growing a full table throws std::length_error.
+#define SOA_RESERVE_COLUMN(m_type, m_name)                                                                                                                                                   \
+	total_size = soa::align_up(total_size, std::max(page_size, soa::column_alignment<m_type>()));                                                                                            \
+	block_alignment = std::max(block_alignment, soa::column_alignment<m_type>());                                                                                                            \
+	memory_offsets[mem_offset_idx] = total_size;                                                                                                                                             \
+	total_size += soa::SoaVector<m_type>::column_bytes(soa_policy::max_rows);                                                                                                                \
+	mem_offset_idx++;
+
+#define SOA_COMMIT_COLUMN(m_type, m_name)                                                                                                                                                    \
+	soa_policy::commit(m_name.get_data(), soa::SoaVector<m_type>::column_bytes(soa_capacity), soa::SoaVector<m_type>::column_bytes(capacity));
+
+#define SOA_RESERVED_REALLOC(m_class_name, m_total_columns, ...)                                                                                                                             \
+	template <typename Self = m_class_name> void soa_commit_rows(const SoaVectorSizeType p_size) {                                                                                           \
+		using soa_policy = typename soa::allocator_policy_of<Self>::type;                                                                                                                    \
+		if (p_size > soa_policy::max_rows and soa_capacity == soa_policy::max_rows) {                                                                                                        \
+			throw std::length_error(#m_class_name ": every row reserved by the allocator policy is used");                                                                                   \
+		}                                                                                                                                                                                    \
+		const SoaVectorSizeType capacity = std::min(p_size, soa_policy::max_rows);                                                                                                           \
+		if (data == nullptr) {                                                                                                                                                               \
+			const uint64_t page_size = soa_policy::page_size();                                                                                                                              \
+			uint64_t total_size = 0;                                                                                                                                                         \
+			int mem_offset_idx = 0;                                                                                                                                                          \
+			uint64_t block_alignment = page_size;                                                                                                                                            \
+			uint64_t memory_offsets[m_total_columns];                                                                                                                                        \
+			FOR_EACH_TWO_ARGS(SOA_RESERVE_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+			void *new_data = soa_allocate_block(block_alignment, total_size);                                                                                                                \
+			int current_column = 0;                                                                                                                                                          \
+			FOR_EACH_TWO_ARGS(SOA_REALLOC, __VA_OPT__(__VA_ARGS__, ))                                                                                                                        \
+			soa_set_block(new_data, block_alignment, total_size);                                                                                                                            \
+		}                                                                                                                                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_COMMIT_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                      \
+		SOA_STATS_CALL(soa_stats_realloc(soa_capacity, capacity, capacity > soa_capacity ? soa_capacity_bytes(capacity) - soa_capacity_bytes(soa_capacity) : 0, 0);)                         \
+		soa_capacity = capacity;                                                                                                                                                             \
+	}
+
+// index_map maps entity id -> row index and index_ids is the reverse (row index -> entity id) so erase can find which entity owns the last row without a map lookup.
+// Entity ids are handed out in push order and are never reused.
+// erase_batch removes many ids at once: their rows are set in soa_tombstones and every column is compacted once (see soa::plan_compaction) instead of once per id. With
+// `using soa_erase_policy = soa::TombstoneErase<>;` erase and erase_batch only set the rows in soa_tombstones and compact() runs once enough of them pile up, for_each_row skips them.
 #define MutableSOA(m_class_name, m_total_columns, ...)                                                                                                                                       \
 	FOR_EACH_TWO_ARGS(SOA_DYNAMIC_TYPES, __VA_OPT__(__VA_ARGS__, ))                                                                                                                          \
 private:                                                                                                                                                                                     \
 	void *data{};                                                                                                                                                                            \
+	SOA_BLOCK(m_class_name, data)                                                                                                                                                            \
 	SoaVectorSizeType soa_capacity = 0;                                                                                                                                                      \
 	SoaVectorSizeType soa_size = 0;                                                                                                                                                          \
+	using soa_id_type = SoaVectorSizeType;                                                                                                                                                   \
+	SoaVectorSizeType soa_next_id = 0;                                                                                                                                                       \
 	SOA_MAP_TYPE index_map;                                                                                                                                                                  \
-	void soa_realloc() {                                                                                                                                                                     \
-		const SoaVectorSizeType starting_capacity = soa_capacity;                                                                                                                            \
-		soa_capacity = static_cast<SoaVectorSizeType>(soa_capacity * 1.5);                                                                                                                   \
-		const SoaVectorSizeType p_size = soa_capacity;                                                                                                                                       \
-                                                                                                                                                                                             \
-		uint64_t total_size = 0;                                                                                                                                                             \
-		int mem_offset_idx = 0;                                                                                                                                                              \
-		uint64_t memory_offsets[m_total_columns];                                                                                                                                            \
-		FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                    \
-                                                                                                                                                                                             \
-		void *new_data = calloc(soa_capacity, total_size / p_size);                                                                                                                          \
-		int current_column = 0;                                                                                                                                                              \
-		FOR_EACH_TWO_ARGS(SOA_REALLOC, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
-		free(data);                                                                                                                                                                          \
-		data = new_data;                                                                                                                                                                     \
+	std::vector<SoaVectorSizeType> index_ids;                                                                                                                                                \
+	SoaVectorSizeType soa_insert_entity() {                                                                                                                                                  \
+		const SoaVectorSizeType entity_id = soa_next_id++;                                                                                                                                   \
+		index_map[entity_id] = soa_size++;                                                                                                                                                   \
+		index_ids.push_back(entity_id);                                                                                                                                                      \
+		return entity_id;                                                                                                                                                                    \
 	}                                                                                                                                                                                        \
+	SOA_RESERVED_REALLOC(m_class_name, m_total_columns, __VA_ARGS__)                                                                                                                         \
+	void soa_realloc(const SoaVectorSizeType p_size) {                                                                                                                                       \
+		if constexpr (soa::reserves_rows<typename soa::allocator_policy_of<m_class_name>::type>) {                                                                                           \
+			soa_commit_rows(p_size);                                                                                                                                                         \
+		} else {                                                                                                                                                                             \
+			uint64_t total_size = 0;                                                                                                                                                         \
+			int mem_offset_idx = 0;                                                                                                                                                          \
+			uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;                                                                                                                                 \
+			uint64_t memory_offsets[m_total_columns];                                                                                                                                        \
+			FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                \
                                                                                                                                                                                              \
+			void *new_data = soa_allocate_block(block_alignment, total_size);                                                                                                                \
+			int current_column = 0;                                                                                                                                                          \
+			FOR_EACH_TWO_ARGS(SOA_REALLOC, __VA_OPT__(__VA_ARGS__, ))                                                                                                                        \
+			soa_set_block(new_data, block_alignment, total_size);                                                                                                                            \
+			SOA_STATS_CALL(soa_stats_realloc(soa_capacity, p_size, total_size, soa_column_bytes());)                                                                                         \
+			soa_capacity = p_size;                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+		index_map.reserve(soa_capacity);                                                                                                                                                     \
+		index_ids.reserve(soa_capacity);                                                                                                                                                     \
+	}                                                                                                                                                                                        \
+	void soa_permute_ids(const soa::Permutation &p_permutation) {                                                                                                                            \
+		soa::permute_columns(p_permutation, index_ids.data());                                                                                                                               \
+		if (soa_tombstone_count != 0) {                                                                                                                                                      \
+			const soa::simd::BitMask old_tombstones = std::exchange(soa_tombstones, soa::simd::BitMask((soa_size + 63) / 64));                                                               \
+			for (SoaVectorSizeType i = 0; i < p_permutation.size(); ++i) {                                                                                                                   \
+				const SoaVectorSizeType old_row = p_permutation[i];                                                                                                                          \
+				if (old_row / 64 < old_tombstones.size() and ((old_tombstones[old_row / 64] >> (old_row % 64)) & 1)) {                                                                       \
+					soa_tombstones[i / 64] |= uint64_t(1) << (i % 64);                                                                                                                       \
+				}                                                                                                                                                                            \
+			}                                                                                                                                                                                \
+		}                                                                                                                                                                                    \
+		for_each_row([&](SoaVectorSizeType p_index) { index_map[index_ids[p_index]] = p_index; });                                                                                           \
+	}                                                                                                                                                                                        \
+	void soa_grow() { soa_realloc(soa::growth_policy_of<m_class_name>::type::grow(soa_capacity, soa_capacity + 1)); }                                                                        \
+	soa::simd::BitMask soa_tombstones;                                                                                                                                                       \
+	SoaVectorSizeType soa_tombstone_count = 0;                                                                                                                                               \
+	bool soa_mark_erased(SoaVectorSizeType p_entity_id, soa::simd::BitMask &r_erased) {                                                                                                      \
+		auto entity = index_map.find(p_entity_id);                                                                                                                                           \
+		if (entity == index_map.end()) {                                                                                                                                                     \
+			return false;                                                                                                                                                                    \
+		}                                                                                                                                                                                    \
+		const SoaVectorSizeType row = entity SOA_MAP_VALUE_NAME;                                                                                                                             \
+		index_map.erase(p_entity_id);                                                                                                                                                        \
+		soa_mark_row_dirty(row);                                                                                                                                                             \
+		if (row / 64 >= r_erased.size()) {                                                                                                                                                   \
+			r_erased.resize(row / 64 + 1);                                                                                                                                                   \
+		}                                                                                                                                                                                    \
+		r_erased[row / 64] |= uint64_t(1) << (row % 64);                                                                                                                                     \
+		return true;                                                                                                                                                                         \
+	}                                                                                                                                                                                        \
+	void soa_compact_rows(const soa::simd::BitMask &p_erased) {                                                                                                                              \
+		std::vector<soa::RowMove> moves;                                                                                                                                                     \
+		const SoaVectorSizeType new_size = soa::plan_compaction(p_erased, soa_size, moves);                                                                                                  \
+		FOR_EACH_TWO_ARGS(SOA_COMPACT_MEMBER, __VA_OPT__(__VA_ARGS__, ))                                                                                                                     \
+		for (const soa::RowMove &move : moves) {                                                                                                                                             \
+			index_ids[move.to] = index_ids[move.from];                                                                                                                                       \
+			index_map[index_ids[move.to]] = move.to;                                                                                                                                         \
+			soa_mark_row_dirty(move.to);                                                                                                                                                     \
+		}                                                                                                                                                                                    \
+		index_ids.resize(new_size);                                                                                                                                                          \
+		soa_size = new_size;                                                                                                                                                                 \
+	}                                                                                                                                                                                        \
+	void soa_save_ids(std::ostream &p_stream) const {                                                                                                                                        \
+		soa::write_column(p_stream, "soa_next_id", &soa_next_id, 1);                                                                                                                         \
+		soa::write_column(p_stream, "index_ids", index_ids.data(), soa_size);                                                                                                                \
+		soa::write_column(p_stream, "soa_tombstones", soa_tombstones.data(), SoaVectorSizeType(soa_tombstones.size()));                                                                      \
+	}                                                                                                                                                                                        \
+	void soa_load_ids(std::istream &p_stream, SoaVectorSizeType p_rows) {                                                                                                                    \
+		soa::read_column(p_stream, "soa_next_id", &soa_next_id, 1);                                                                                                                          \
+		index_ids.resize(p_rows);                                                                                                                                                            \
+		soa_size = soa::read_column(p_stream, "index_ids", index_ids.data(), p_rows);                                                                                                        \
+		index_ids.resize(soa_size);                                                                                                                                                          \
+		soa_tombstones.resize((p_rows + 63) / 64);                                                                                                                                           \
+		soa_tombstones.resize(soa::read_column(p_stream, "soa_tombstones", soa_tombstones.data(), SoaVectorSizeType(soa_tombstones.size())));                                                \
+		soa_tombstone_count = 0;                                                                                                                                                             \
+		for (const uint64_t word : soa_tombstones) {                                                                                                                                         \
+			soa_tombstone_count += SoaVectorSizeType(std::popcount(word));                                                                                                                   \
+		}                                                                                                                                                                                    \
+		for_each_row([&](SoaVectorSizeType p_index) { index_map[index_ids[p_index]] = p_index; });                                                                                           \
+	}                                                                                                                                                                                        \
+	void soa_export_ids(std::ostream &p_stream) const {                                                                                                                                      \
+		constexpr SoaVectorSizeType rows_per_bit = soa::dirty_policy_of<m_class_name>::type::rows_per_bit;                                                                                   \
+		soa::DirtyMask rows;                                                                                                                                                                 \
+		soa_dirty_rows(rows);                                                                                                                                                                \
+		soa::write_column(p_stream, "soa_next_id", &soa_next_id, 1);                                                                                                                         \
+		soa::write_delta_rows<SoaVectorSizeType>(p_stream, "index_ids", rows, rows_per_bit, soa_size, [&](SoaVectorSizeType p_row) { return index_ids[p_row]; });                            \
+		soa::write_delta_rows<bool>(p_stream, "soa_tombstones", rows, rows_per_bit, soa_size, [&](SoaVectorSizeType p_row) { return is_tombstone(p_row); });                                 \
+	}                                                                                                                                                                                        \
+	void soa_unmap_row(SoaVectorSizeType p_row) {                                                                                                                                            \
+		auto entity = index_map.find(index_ids[p_row]);                                                                                                                                      \
+		if (entity != index_map.end() and entity SOA_MAP_VALUE_NAME == p_row) {                                                                                                              \
+			index_map.erase(index_ids[p_row]);                                                                                                                                               \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void soa_set_tombstone(SoaVectorSizeType p_row, bool p_tombstone) {                                                                                                                      \
+		if (is_tombstone(p_row) == p_tombstone) {                                                                                                                                            \
+			return;                                                                                                                                                                          \
+		}                                                                                                                                                                                    \
+		if (p_row / 64 >= soa_tombstones.size()) {                                                                                                                                           \
+			soa_tombstones.resize(p_row / 64 + 1);                                                                                                                                           \
+		}                                                                                                                                                                                    \
+		soa_tombstones[p_row / 64] ^= uint64_t(1) << (p_row % 64);                                                                                                                           \
+		soa_tombstone_count = p_tombstone ? soa_tombstone_count + 1 : soa_tombstone_count - 1;                                                                                               \
+	}                                                                                                                                                                                        \
+	void soa_assign_id(SoaVectorSizeType p_row, SoaVectorSizeType p_entity_id) {                                                                                                             \
+		if (p_row < index_ids.size()) {                                                                                                                                                      \
+			soa_unmap_row(p_row);                                                                                                                                                            \
+			index_ids[p_row] = p_entity_id;                                                                                                                                                  \
+		} else if (p_row == index_ids.size()) {                                                                                                                                              \
+			index_ids.push_back(p_entity_id);                                                                                                                                                \
+		} else {                                                                                                                                                                             \
+			throw std::runtime_error("soa::apply_delta: the delta skips rows the table doesn't have");                                                                                       \
+		}                                                                                                                                                                                    \
+		index_map[p_entity_id] = p_row;                                                                                                                                                      \
+	}                                                                                                                                                                                        \
+	void soa_assign_tombstone(SoaVectorSizeType p_row, bool p_tombstone) {                                                                                                                   \
+		soa_set_tombstone(p_row, p_tombstone);                                                                                                                                               \
+		if (p_tombstone) {                                                                                                                                                                   \
+			soa_unmap_row(p_row);                                                                                                                                                            \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void soa_truncate_ids(SoaVectorSizeType p_size) {                                                                                                                                        \
+		for (SoaVectorSizeType row = p_size; row < index_ids.size(); ++row) {                                                                                                                \
+			soa_unmap_row(row);                                                                                                                                                              \
+			soa_set_tombstone(row, false);                                                                                                                                                   \
+		}                                                                                                                                                                                    \
+		index_ids.resize(p_size);                                                                                                                                                            \
+		soa_size = p_size;                                                                                                                                                                   \
+	}                                                                                                                                                                                        \
+	void soa_apply_ids(std::istream &p_stream) {                                                                                                                                             \
+		soa::read_column(p_stream, "soa_next_id", &soa_next_id, 1);                                                                                                                          \
+		const SoaVectorSizeType new_size = soa::read_delta_rows<SoaVectorSizeType>(p_stream, "index_ids", [&](SoaVectorSizeType p_row, SoaVectorSizeType p_entity_id) {                      \
+			soa_assign_id(p_row, p_entity_id);                                                                                                                                               \
+		});                                                                                                                                                                                  \
+		if (new_size > index_ids.size()) {                                                                                                                                                   \
+			throw std::runtime_error("soa::apply_delta: the table is missing rows the delta expects");                                                                                       \
+		}                                                                                                                                                                                    \
+		soa_truncate_ids(new_size);                                                                                                                                                          \
+		soa::read_delta_rows<bool>(p_stream, "soa_tombstones", [&](SoaVectorSizeType p_row, bool p_tombstone) { soa_assign_tombstone(p_row, p_tombstone); });                                \
+	}                                                                                                                                                                                        \
+	void soa_pull_ids(const m_class_name &p_from) {                                                                                                                                          \
+		constexpr SoaVectorSizeType rows_per_bit = soa::dirty_policy_of<m_class_name>::type::rows_per_bit;                                                                                   \
+		soa::DirtyMask rows;                                                                                                                                                                 \
+		soa_dirty_rows(rows);                                                                                                                                                                \
+		auto pull_row = [&](SoaVectorSizeType p_row) {                                                                                                                                       \
+			soa_assign_id(p_row, p_from.index_ids[p_row]);                                                                                                                                   \
+			soa_assign_tombstone(p_row, p_from.is_tombstone(p_row));                                                                                                                         \
+		};                                                                                                                                                                                   \
+		soa_next_id = p_from.soa_next_id;                                                                                                                                                    \
+		rows.for_each_row(rows_per_bit, std::min(soa_size, p_from.soa_size), pull_row);                                                                                                      \
+		if (p_from.soa_size < soa_size) {                                                                                                                                                    \
+			soa_truncate_ids(p_from.soa_size);                                                                                                                                               \
+		}                                                                                                                                                                                    \
+		for (SoaVectorSizeType row = soa_size; row < p_from.soa_size; ++row) {                                                                                                               \
+			pull_row(row);                                                                                                                                                                   \
+		}                                                                                                                                                                                    \
+		soa_size = p_from.soa_size;                                                                                                                                                          \
+	}                                                                                                                                                                                        \
 public:                                                                                                                                                                                      \
 	void init(const SoaVectorSizeType p_size) {                                                                                                                                              \
-		uint64_t total_size = 0;                                                                                                                                                             \
-		int mem_offset_idx = 0;                                                                                                                                                              \
-		uint64_t memory_offsets[m_total_columns];                                                                                                                                            \
-		FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                    \
-		data = calloc(p_size, total_size / p_size);                                                                                                                                          \
-		soa_capacity = p_size;                                                                                                                                                               \
-		int current_column = 0;                                                                                                                                                              \
-		FOR_EACH_TWO_ARGS(SOA_INIT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                               \
-		FOR_EACH_TWO_ARGS(SOA_DEFAULT_CONSTRUCT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                  \
+		SOA_STATS_CALL(soa_stats.init_calls++;)                                                                                                                                              \
+		soa_realloc(p_size);                                                                                                                                                                 \
+	}                                                                                                                                                                                        \
+	void reserve(const SoaVectorSizeType p_capacity) {                                                                                                                                       \
+		if (p_capacity > soa_capacity) {                                                                                                                                                     \
+			soa_realloc(p_capacity);                                                                                                                                                         \
+		}                                                                                                                                                                                    \
 	}                                                                                                                                                                                        \
+	void shrink_to_fit() {                                                                                                                                                                   \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		if (row_size < soa_capacity) {                                                                                                                                                       \
+			soa_realloc(row_size);                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] SoaVectorSizeType capacity() const { return soa_capacity; }                                                                                                                \
 	void erase(SoaVectorSizeType p_entity_id) {                                                                                                                                              \
-		if (!index_map.contains(p_entity_id)) {                                                                                                                                              \
+		if constexpr (soa::erase_policy_of<m_class_name>::type::tombstones) {                                                                                                                \
+			erase_batch(std::span(&p_entity_id, 1));                                                                                                                                         \
 			return;                                                                                                                                                                          \
 		}                                                                                                                                                                                    \
+		auto entity = index_map.find(p_entity_id);                                                                                                                                           \
+		if (entity == index_map.end()) {                                                                                                                                                     \
+			return;                                                                                                                                                                          \
+		}                                                                                                                                                                                    \
+		SOA_STATS_CALL(soa_stats_erase(1);)                                                                                                                                                  \
                                                                                                                                                                                              \
-		SoaVectorSizeType index_to_erase = SOA_MAP_AT_FUNC(p_entity_id);                                                                                                                     \
-		const SoaVectorSizeType end_index = soa_size - 1;                                                                                                                                    \
-		SoaVectorSizeType entity_id_to_move = index_map.find(end_index) SOA_MAP_VALUE_NAME;                                                                                                  \
+		const SoaVectorSizeType index_to_erase = entity SOA_MAP_VALUE_NAME;                                                                                                                  \
+		const SoaVectorSizeType end_index = --soa_size;                                                                                                                                      \
+		const SoaVectorSizeType entity_id_to_move = index_ids[end_index];                                                                                                                    \
                                                                                                                                                                                              \
 		index_map.erase(p_entity_id);                                                                                                                                                        \
-		index_map[entity_id_to_move] = index_to_erase;                                                                                                                                       \
+		if (entity_id_to_move != p_entity_id) {                                                                                                                                              \
+			index_map[entity_id_to_move] = index_to_erase;                                                                                                                                   \
+			index_ids[index_to_erase] = entity_id_to_move;                                                                                                                                   \
+		}                                                                                                                                                                                    \
+		index_ids.pop_back();                                                                                                                                                                \
 		FOR_EACH_TWO_ARGS(SOA_DESTROY_AT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
-		if (index_to_erase < --soa_size) {                                                                                                                                                   \
-			FOR_EACH_TWO_ARGS(SOA_POST_ERASE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                     \
+		FOR_EACH_TWO_ARGS(SOA_POST_ERASE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
+		if (index_to_erase != end_index) {                                                                                                                                                   \
+			soa_mark_row_dirty(index_to_erase);                                                                                                                                              \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void erase_batch(std::span<const SoaVectorSizeType> p_entity_ids) {                                                                                                                      \
+		SOA_STATS_CALL(const SoaVectorSizeType tombstones_before = soa_tombstone_count;)                                                                                                     \
+		for (const SoaVectorSizeType entity_id : p_entity_ids) {                                                                                                                             \
+			soa_tombstone_count += soa_mark_erased(entity_id, soa_tombstones);                                                                                                               \
+		}                                                                                                                                                                                    \
+		SOA_STATS_CALL(soa_stats_erase(soa_tombstone_count - tombstones_before);)                                                                                                            \
+		if (soa::erase_policy_of<m_class_name>::type::should_compact(soa_tombstone_count, soa_size)) {                                                                                       \
+			compact();                                                                                                                                                                       \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void compact() {                                                                                                                                                                         \
+		if (soa_tombstone_count != 0) {                                                                                                                                                      \
+			soa_compact_rows(soa_tombstones);                                                                                                                                                \
+		}                                                                                                                                                                                    \
+		soa_tombstones.clear();                                                                                                                                                              \
+		soa_tombstone_count = 0;                                                                                                                                                             \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] SoaVectorSizeType tombstone_count() const { return soa_tombstone_count; }                                                                                                  \
+	[[nodiscard]] bool is_tombstone(SoaVectorSizeType p_index) const {                                                                                                                       \
+		return p_index / 64 < soa_tombstones.size() and ((soa_tombstones[p_index / 64] >> (p_index % 64)) & 1);                                                                              \
+	}                                                                                                                                                                                        \
+	template <typename Func> void for_each_row(Func &&p_func) const {                                                                                                                        \
+		if (soa_tombstone_count == 0) {                                                                                                                                                      \
+			for (SoaVectorSizeType i = 0; i < soa_size; ++i) {                                                                                                                               \
+				p_func(i);                                                                                                                                                                   \
+			}                                                                                                                                                                                \
+		} else {                                                                                                                                                                             \
+			soa::for_each_unset_row(soa_tombstones, soa_size, p_func);                                                                                                                       \
 		}                                                                                                                                                                                    \
 	}                                                                                                                                                                                        \
 	~m_class_name() {                                                                                                                                                                        \
@@ -142,8 +758,16 @@ public:
 		}                                                                                                                                                                                    \
 	}                                                                                                                                                                                        \
 	void clear() {                                                                                                                                                                           \
+		SOA_STATS_CALL(soa_stats_sample();)                                                                                                                                                  \
 		FOR_EACH_TWO_ARGS(SOA_DESTROY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
-		free(data);                                                                                                                                                                          \
+		soa_set_block(nullptr, 0, 0);                                                                                                                                                        \
+		soa_capacity = 0;                                                                                                                                                                    \
+		soa_size = 0;                                                                                                                                                                        \
+		index_map.clear();                                                                                                                                                                   \
+		index_ids.clear();                                                                                                                                                                   \
+		soa_tombstones.clear();                                                                                                                                                              \
+		soa_tombstone_count = 0;                                                                                                                                                             \
+		clear_dirty();                                                                                                                                                                       \
 	}                                                                                                                                                                                        \
 	m_class_name() = default;                                                                                                                                                                \
 	m_class_name(const m_class_name &) = default;                                                                                                                                            \
@@ -151,50 +775,173 @@ public:
 	m_class_name(m_class_name &&) = default;                                                                                                                                                 \
 	m_class_name &operator=(m_class_name &&) = default;                                                                                                                                      \
 	FOR_EACH_TWO_ARGS(SOA_MUTABLE_SETGET, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
-	FOR_EACH_TWO_ARGS(SOA_MUTABLE_PUSH, __VA_OPT__(__VA_ARGS__, ))
+	FOR_EACH_TWO_ARGS(SOA_MUTABLE_PUSH, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+	SOA_MUTABLE_PUSH_ROW(__VA_ARGS__)                                                                                                                                                        \
+	SOA_QUERY(m_class_name)                                                                                                                                                                  \
+	SOA_ROWS(m_class_name, SoaVectorSizeType, SOA_MAP_AT_FUNC(p_id), SOA_ROW_ELEMENT, SOA_MIN_ROW_SIZE, __VA_ARGS__)                                                                         \
+	SOA_SORT(m_class_name, soa_permute_ids(p_permutation), __VA_ARGS__)                                                                                                                      \
+	SOA_SERIALIZE(m_total_columns, clear(); reserve(rows), soa_save_ids(p_stream), soa_load_ids(p_stream, rows), __VA_ARGS__)                                                                \
+	SOA_DIRTY(m_class_name, m_total_columns, reserve(rows), soa_export_ids(p_stream), soa_apply_ids(p_stream), soa_pull_ids(p_from), __VA_ARGS__)                                            \
+	SOA_STATS(m_class_name, soa_capacity, soa_allocation_size, soa::index_memory_bytes(index_map) + index_ids.capacity() * sizeof(SoaVectorSizeType),                                        \
+			soa::index_probe_stats(index_map), SOA_COLUMN_MEMORY, SOA_COLUMN_BYTES, __VA_ARGS__)
 
-#define DynamicSOA(m_class_name, m_total_columns, ...)                                                                                                                                       \
+// Same as MutableSOA but rows are identified by generational soa::SoaHandle's that index a soa::SparseSet instead of entity ids in a hashmap. Use it when ids are dense, lookups
+// and erase are 2 array reads with no hashing, and using a handle after its row was erased throws std::out_of_range instead of returning another row.
+#define SparseSOA(m_class_name, m_total_columns, ...)                                                                                                                                        \
 	FOR_EACH_TWO_ARGS(SOA_DYNAMIC_TYPES, __VA_OPT__(__VA_ARGS__, ))                                                                                                                          \
 private:                                                                                                                                                                                     \
 	void *data{};                                                                                                                                                                            \
+	SOA_BLOCK(m_class_name, data)                                                                                                                                                            \
 	SoaVectorSizeType soa_capacity = 0;                                                                                                                                                      \
-	void soa_realloc() {                                                                                                                                                                     \
-		const SoaVectorSizeType starting_capacity = soa_capacity;                                                                                                                            \
-		soa_capacity = static_cast<SoaVectorSizeType>(soa_capacity * 1.5);                                                                                                                   \
-		const SoaVectorSizeType p_size = soa_capacity;                                                                                                                                       \
+	SoaVectorSizeType soa_size = 0;                                                                                                                                                          \
+	using soa_id_type = soa::SoaHandle;                                                                                                                                                      \
+	soa::SparseSet index_set;                                                                                                                                                                \
+	soa::SoaHandle soa_insert_entity() {                                                                                                                                                     \
+		soa_size++;                                                                                                                                                                          \
+		return index_set.insert();                                                                                                                                                           \
+	}                                                                                                                                                                                        \
+	SOA_RESERVED_REALLOC(m_class_name, m_total_columns, __VA_ARGS__)                                                                                                                         \
+	void soa_realloc(const SoaVectorSizeType p_size) {                                                                                                                                       \
+		if constexpr (soa::reserves_rows<typename soa::allocator_policy_of<m_class_name>::type>) {                                                                                           \
+			soa_commit_rows(p_size);                                                                                                                                                         \
+		} else {                                                                                                                                                                             \
+			uint64_t total_size = 0;                                                                                                                                                         \
+			int mem_offset_idx = 0;                                                                                                                                                          \
+			uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;                                                                                                                                 \
+			uint64_t memory_offsets[m_total_columns];                                                                                                                                        \
+			FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                \
                                                                                                                                                                                              \
-		uint64_t total_size = 0;                                                                                                                                                             \
-		int mem_offset_idx = 0;                                                                                                                                                              \
-		uint64_t memory_offsets[m_total_columns];                                                                                                                                            \
-		FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                    \
+			void *new_data = soa_allocate_block(block_alignment, total_size);                                                                                                                \
+			int current_column = 0;                                                                                                                                                          \
+			FOR_EACH_TWO_ARGS(SOA_REALLOC, __VA_OPT__(__VA_ARGS__, ))                                                                                                                        \
+			soa_set_block(new_data, block_alignment, total_size);                                                                                                                            \
+			SOA_STATS_CALL(soa_stats_realloc(soa_capacity, p_size, total_size, soa_column_bytes());)                                                                                         \
+			soa_capacity = p_size;                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+		index_set.reserve(soa_capacity);                                                                                                                                                     \
+	}                                                                                                                                                                                        \
+	void soa_grow() { soa_realloc(soa::growth_policy_of<m_class_name>::type::grow(soa_capacity, soa_capacity + 1)); }                                                                        \
                                                                                                                                                                                              \
-		void *new_data = calloc(soa_capacity, total_size / p_size);                                                                                                                          \
-		int current_column = 0;                                                                                                                                                              \
-		FOR_EACH_TWO_ARGS(SOA_REALLOC, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
-		free(data);                                                                                                                                                                          \
-		data = new_data;                                                                                                                                                                     \
+public:                                                                                                                                                                                      \
+	void init(const SoaVectorSizeType p_size) {                                                                                                                                              \
+		SOA_STATS_CALL(soa_stats.init_calls++;)                                                                                                                                              \
+		soa_realloc(p_size);                                                                                                                                                                 \
+	}                                                                                                                                                                                        \
+	void reserve(const SoaVectorSizeType p_capacity) {                                                                                                                                       \
+		if (p_capacity > soa_capacity) {                                                                                                                                                     \
+			soa_realloc(p_capacity);                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void shrink_to_fit() {                                                                                                                                                                   \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		if (row_size < soa_capacity) {                                                                                                                                                       \
+			soa_realloc(row_size);                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] SoaVectorSizeType capacity() const { return soa_capacity; }                                                                                                                \
+	void erase(soa::SoaHandle p_handle) {                                                                                                                                                    \
+		SoaVectorSizeType index_to_erase = 0;                                                                                                                                                \
+		if (!index_set.erase(p_handle, index_to_erase)) {                                                                                                                                    \
+			return;                                                                                                                                                                          \
+		}                                                                                                                                                                                    \
+		SOA_STATS_CALL(soa_stats_erase(1);)                                                                                                                                                  \
+                                                                                                                                                                                             \
+		const SoaVectorSizeType end_index = --soa_size;                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_DESTROY_AT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
+		FOR_EACH_TWO_ARGS(SOA_POST_ERASE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
+		if (index_to_erase != end_index) {                                                                                                                                                   \
+			soa_mark_row_dirty(index_to_erase);                                                                                                                                              \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] bool contains(soa::SoaHandle p_handle) const { return index_set.contains(p_handle); }                                                                                      \
+	[[nodiscard]] soa::SoaHandle get_handle(SoaVectorSizeType p_index) const { return index_set.handle_at(p_index); }                                                                        \
+	~m_class_name() {                                                                                                                                                                        \
+		if (data != nullptr) {                                                                                                                                                               \
+			clear();                                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void clear() {                                                                                                                                                                           \
+		SOA_STATS_CALL(soa_stats_sample();)                                                                                                                                                  \
+		FOR_EACH_TWO_ARGS(SOA_DESTROY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
+		soa_set_block(nullptr, 0, 0);                                                                                                                                                        \
+		soa_capacity = 0;                                                                                                                                                                    \
+		soa_size = 0;                                                                                                                                                                        \
+		index_set.clear();                                                                                                                                                                   \
+		clear_dirty();                                                                                                                                                                       \
+	}                                                                                                                                                                                        \
+	m_class_name() = default;                                                                                                                                                                \
+	m_class_name(const m_class_name &) = default;                                                                                                                                            \
+	m_class_name &operator=(const m_class_name &) = default;                                                                                                                                 \
+	m_class_name(m_class_name &&) = default;                                                                                                                                                 \
+	m_class_name &operator=(m_class_name &&) = default;                                                                                                                                      \
+	FOR_EACH_TWO_ARGS(SOA_SPARSE_SETGET, __VA_OPT__(__VA_ARGS__, ))                                                                                                                          \
+	FOR_EACH_TWO_ARGS(SOA_MUTABLE_PUSH, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+	SOA_MUTABLE_PUSH_ROW(__VA_ARGS__)                                                                                                                                                        \
+	SOA_QUERY(m_class_name)                                                                                                                                                                  \
+	SOA_ROWS(m_class_name, soa::SoaHandle, index_set.at(p_id), SOA_ROW_ELEMENT, SOA_MIN_ROW_SIZE, __VA_ARGS__)                                                                               \
+	SOA_SORT(m_class_name, index_set.permute(p_permutation), __VA_ARGS__)                                                                                                                    \
+	SOA_SERIALIZE(m_total_columns, clear(); reserve(rows), index_set.save(p_stream), index_set.load(p_stream); soa_size = index_set.size(), __VA_ARGS__)                                     \
+	SOA_DIRTY(m_class_name, m_total_columns, reserve(rows), index_set.save(p_stream), index_set.load(p_stream); soa_size = index_set.size(),                                                 \
+			index_set = p_from.index_set; soa_size = p_from.soa_size, __VA_ARGS__)                                                                                                           \
+	SOA_STATS(m_class_name, soa_capacity, soa_allocation_size, index_set.memory_bytes(), soa::ProbeStats(), SOA_COLUMN_MEMORY, SOA_COLUMN_BYTES, __VA_ARGS__)
+
+#define DynamicSOA(m_class_name, m_total_columns, ...)                                                                                                                                       \
+	FOR_EACH_TWO_ARGS(SOA_DYNAMIC_TYPES, __VA_OPT__(__VA_ARGS__, ))                                                                                                                          \
+private:                                                                                                                                                                                     \
+	void *data{};                                                                                                                                                                            \
+	SOA_BLOCK(m_class_name, data)                                                                                                                                                            \
+	SoaVectorSizeType soa_capacity = 0;                                                                                                                                                      \
+	SOA_RESERVED_REALLOC(m_class_name, m_total_columns, __VA_ARGS__)                                                                                                                         \
+	void soa_realloc(const SoaVectorSizeType p_size) {                                                                                                                                       \
+		if constexpr (soa::reserves_rows<typename soa::allocator_policy_of<m_class_name>::type>) {                                                                                           \
+			soa_commit_rows(p_size);                                                                                                                                                         \
+		} else {                                                                                                                                                                             \
+			uint64_t total_size = 0;                                                                                                                                                         \
+			int mem_offset_idx = 0;                                                                                                                                                          \
+			uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;                                                                                                                                 \
+			uint64_t memory_offsets[m_total_columns];                                                                                                                                        \
+			FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                \
+                                                                                                                                                                                             \
+			void *new_data = soa_allocate_block(block_alignment, total_size);                                                                                                                \
+			int current_column = 0;                                                                                                                                                          \
+			FOR_EACH_TWO_ARGS(SOA_REALLOC, __VA_OPT__(__VA_ARGS__, ))                                                                                                                        \
+			soa_set_block(new_data, block_alignment, total_size);                                                                                                                            \
+			SOA_STATS_CALL(soa_stats_realloc(soa_capacity, p_size, total_size, soa_column_bytes());)                                                                                         \
+			soa_capacity = p_size;                                                                                                                                                           \
+		}                                                                                                                                                                                    \
 	}                                                                                                                                                                                        \
+	void soa_grow() { soa_realloc(soa::growth_policy_of<m_class_name>::type::grow(soa_capacity, soa_capacity + 1)); }                                                                        \
                                                                                                                                                                                              \
 public:                                                                                                                                                                                      \
 	void init(const SoaVectorSizeType p_size) {                                                                                                                                              \
-		uint64_t total_size = 0;                                                                                                                                                             \
-		int mem_offset_idx = 0;                                                                                                                                                              \
-		uint64_t memory_offsets[m_total_columns];                                                                                                                                            \
-		FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                    \
-		data = calloc(p_size, total_size / p_size);                                                                                                                                          \
-		soa_capacity = p_size;                                                                                                                                                               \
-		int current_column = 0;                                                                                                                                                              \
-		FOR_EACH_TWO_ARGS(SOA_INIT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                               \
-		FOR_EACH_TWO_ARGS(SOA_DEFAULT_CONSTRUCT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                  \
+		SOA_STATS_CALL(soa_stats.init_calls++;)                                                                                                                                              \
+		soa_realloc(p_size);                                                                                                                                                                 \
 	}                                                                                                                                                                                        \
+	void reserve(const SoaVectorSizeType p_capacity) {                                                                                                                                       \
+		if (p_capacity > soa_capacity) {                                                                                                                                                     \
+			soa_realloc(p_capacity);                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void shrink_to_fit() {                                                                                                                                                                   \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		if (row_size < soa_capacity) {                                                                                                                                                       \
+			soa_realloc(row_size);                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] SoaVectorSizeType capacity() const { return soa_capacity; }                                                                                                                \
 	~m_class_name() {                                                                                                                                                                        \
 		if (data != nullptr) {                                                                                                                                                               \
 			clear();                                                                                                                                                                         \
 		}                                                                                                                                                                                    \
 	}                                                                                                                                                                                        \
 	void clear() {                                                                                                                                                                           \
+		SOA_STATS_CALL(soa_stats_sample();)                                                                                                                                                  \
 		FOR_EACH_TWO_ARGS(SOA_DESTROY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
-		free(data);                                                                                                                                                                          \
+		soa_set_block(nullptr, 0, 0);                                                                                                                                                        \
+		soa_capacity = 0;                                                                                                                                                                    \
+		clear_dirty();                                                                                                                                                                       \
 	}                                                                                                                                                                                        \
 	m_class_name() = default;                                                                                                                                                                \
 	m_class_name(const m_class_name &) = default;                                                                                                                                            \
@@ -202,23 +949,210 @@ public:
 	m_class_name(m_class_name &&) = default;                                                                                                                                                 \
 	m_class_name &operator=(m_class_name &&) = default;                                                                                                                                      \
 	FOR_EACH_TWO_ARGS(SOA_SETGET, __VA_OPT__(__VA_ARGS__, ))                                                                                                                                 \
-	FOR_EACH_TWO_ARGS(SOA_PUSH, __VA_OPT__(__VA_ARGS__, ))
+	FOR_EACH_TWO_ARGS(SOA_PUSH, __VA_OPT__(__VA_ARGS__, ))                                                                                                                                   \
+	SOA_PUSH_ROW(__VA_ARGS__)                                                                                                                                                                \
+	SOA_QUERY(m_class_name)                                                                                                                                                                  \
+	SOA_ROWS(m_class_name, SoaVectorSizeType, p_id, SOA_ROW_ELEMENT, SOA_MIN_ROW_SIZE, __VA_ARGS__)                                                                                          \
+	SOA_SORT(m_class_name, (void)0, __VA_ARGS__)                                                                                                                                             \
+	SOA_SERIALIZE(m_total_columns, clear(); reserve(rows), (void)0, (void)0, __VA_ARGS__)                                                                                                    \
+	SOA_DIRTY(m_class_name, m_total_columns, reserve(rows), (void)0, (void)0, (void)0, __VA_ARGS__)                                                                                          \
+	SOA_APPEND(m_class_name, __VA_ARGS__)                                                                                                                                                    \
+	SOA_STATS(m_class_name, soa_capacity, soa_allocation_size, 0, soa::ProbeStats(), SOA_COLUMN_MEMORY, SOA_COLUMN_BYTES, __VA_ARGS__)
+
+// MappedSOA is a DynamicSOA whose memory block is a memory mapped file (see SoaMapped.hpp for the layout), so every member has to be trivially copyable.
+// create(path, capacity) makes a new file and open(path) maps an existing one without reading or copying anything, the OS pages the columns in as they are used so tables can be
+// bigger than RAM. Growing extends the file and moves the columns to their new offsets inside it. The column sizes are only written to the header by sync(), close() and the
+// destructor, the rows themselves are written back by the OS (sync() also flushes them). clear() empties the columns but keeps the file and its capacity.
+// Every column offset grows with the capacity, so soa_realloc moves the columns last one first when growing and first one first when shrinking so a column is never overwritten
+// before it has moved.
+#define SOA_MAPPED_CHECK_TYPE(m_type, m_name)                                                                                                                                                \
+	static_assert(std::is_trivially_copyable_v<m_type> and !soa::is_encoded_column_v<m_type>, "MappedSOA members have to be trivially copyable and can't be encoded columns");
+#define SOA_MAPPED_ALIGNMENT(m_type, m_name) block_alignment = std::max(block_alignment, soa::column_alignment<m_type>());
+
+#define SOA_MAPPED_NEW_COLUMN(m_type, m_name)                                                                                                                                                \
+	columns[current_column] = { 0, 0, soa::column_name_hash(#m_type " " #m_name), sizeof(m_type), uint32_t(soa::column_alignment<m_type>()) };                                               \
+	current_column++;
+
+#define SOA_MAPPED_CHECK_COLUMN(m_type, m_name)                                                                                                                                              \
+	valid &= columns[current_column].name_hash == soa::column_name_hash(#m_type " " #m_name) and columns[current_column].element_size == sizeof(m_type) and                                  \
+			columns[current_column].count <= header->capacity and columns[current_column].offset + header->capacity * sizeof(m_type) <= soa_file.size() - header->header_size;               \
+	current_column++;
+
+#define SOA_MAPPED_OPEN_COLUMN(m_type, m_name)                                                                                                                                               \
+	m_name.init_fixed(base, SoaVectorSizeType(columns[current_column].count), columns[current_column].offset);                                                                               \
+	current_column++;
+
+#define SOA_MAPPED_STORE_COUNT(m_type, m_name)                                                                                                                                               \
+	columns[current_column].count = m_name.size();                                                                                                                                           \
+	current_column++;
+
+#define SOA_MAPPED_REMAP(m_type, m_name)                                                                                                                                                     \
+	m_name.init(base, p_size, memory_offsets[current_column]);                                                                                                                               \
+	current_column++;
+
+#define MappedSOA(m_class_name, m_total_columns, ...)                                                                                                                                        \
+	FOR_EACH_TWO_ARGS(SOA_DYNAMIC_TYPES, __VA_OPT__(__VA_ARGS__, ))                                                                                                                          \
+	FOR_EACH_TWO_ARGS(SOA_MAPPED_CHECK_TYPE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                      \
+private:                                                                                                                                                                                     \
+	soa::MappedFile soa_file;                                                                                                                                                                \
+	SoaVectorSizeType soa_capacity = 0;                                                                                                                                                      \
+	static uint64_t soa_header_size() {                                                                                                                                                      \
+		uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;                                                                                                                                     \
+		FOR_EACH_TWO_ARGS(SOA_MAPPED_ALIGNMENT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                   \
+		return soa::mapped_header_size(m_total_columns, block_alignment);                                                                                                                    \
+	}                                                                                                                                                                                        \
+	soa::MappedHeader *soa_header() const { return reinterpret_cast<soa::MappedHeader *>(soa_file.data()); }                                                                                 \
+	soa::MappedColumn *soa_columns() const { return reinterpret_cast<soa::MappedColumn *>(soa_file.data() + sizeof(soa::MappedHeader)); }                                                    \
+	void soa_store_counts() {                                                                                                                                                                \
+		soa::MappedColumn *columns = soa_columns();                                                                                                                                          \
+		int current_column = 0;                                                                                                                                                              \
+		FOR_EACH_TWO_ARGS(SOA_MAPPED_STORE_COUNT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+	}                                                                                                                                                                                        \
+	void soa_realloc(const SoaVectorSizeType p_size) {                                                                                                                                       \
+		if (!soa_file.is_open()) {                                                                                                                                                           \
+			throw std::logic_error("MappedSOA has no file, call create() or open() first");                                                                                                  \
+		}                                                                                                                                                                                    \
+		uint64_t total_size = 0;                                                                                                                                                             \
+		int mem_offset_idx = 0;                                                                                                                                                              \
+		uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;                                                                                                                                     \
+		uint64_t memory_offsets[m_total_columns];                                                                                                                                            \
+		FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                    \
+                                                                                                                                                                                             \
+		soa_store_counts();                                                                                                                                                                  \
+		const uint64_t header_size = soa_header_size();                                                                                                                                      \
+		const bool growing = p_size >= soa_capacity;                                                                                                                                         \
+		if (growing) {                                                                                                                                                                       \
+			soa_file.resize(header_size + total_size);                                                                                                                                       \
+		}                                                                                                                                                                                    \
+		soa::MappedColumn *columns = soa_columns();                                                                                                                                          \
+		std::byte *base = soa_file.data() + header_size;                                                                                                                                     \
+		SOA_STATS_CALL(uint64_t moved_bytes = 0;)                                                                                                                                            \
+		for (int i = 0; i < m_total_columns; ++i) {                                                                                                                                          \
+			soa::MappedColumn &column = columns[growing ? m_total_columns - 1 - i : i];                                                                                                      \
+			const uint64_t new_offset = memory_offsets[growing ? m_total_columns - 1 - i : i];                                                                                               \
+			if (column.count != 0 and column.offset != new_offset) {                                                                                                                         \
+				memmove(base + new_offset, base + column.offset, column.count * column.element_size);                                                                                        \
+				SOA_STATS_CALL(moved_bytes += column.count * column.element_size;)                                                                                                           \
+			}                                                                                                                                                                                \
+			column.offset = new_offset;                                                                                                                                                      \
+		}                                                                                                                                                                                    \
+		soa_header()->capacity = p_size;                                                                                                                                                     \
+		if (!growing) {                                                                                                                                                                      \
+			soa_file.resize(header_size + total_size);                                                                                                                                       \
+			base = soa_file.data() + header_size;                                                                                                                                            \
+		}                                                                                                                                                                                    \
+		int current_column = 0;                                                                                                                                                              \
+		FOR_EACH_TWO_ARGS(SOA_MAPPED_REMAP, __VA_OPT__(__VA_ARGS__, ))                                                                                                                       \
+		SOA_STATS_CALL(soa_stats_realloc(soa_capacity, p_size, growing ? soa_capacity_bytes(p_size) - soa_capacity_bytes(soa_capacity) : 0, moved_bytes);)                                   \
+		soa_capacity = p_size;                                                                                                                                                               \
+	}                                                                                                                                                                                        \
+	void soa_grow() { soa_realloc(soa::growth_policy_of<m_class_name>::type::grow(soa_capacity, soa_capacity + 1)); }                                                                        \
+                                                                                                                                                                                             \
+public:                                                                                                                                                                                      \
+	void create(const char *p_path, const SoaVectorSizeType p_capacity = 0) {                                                                                                                \
+		close();                                                                                                                                                                             \
+		const uint64_t header_size = soa_header_size();                                                                                                                                      \
+		soa_file.open(p_path, true, header_size);                                                                                                                                            \
+		*soa_header() = { soa::MappedHeader::MAGIC, soa::MappedHeader::VERSION, m_total_columns, 0, header_size };                                                                           \
+		soa::MappedColumn *columns = soa_columns();                                                                                                                                          \
+		int current_column = 0;                                                                                                                                                              \
+		FOR_EACH_TWO_ARGS(SOA_MAPPED_NEW_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                  \
+		soa_realloc(p_capacity);                                                                                                                                                             \
+	}                                                                                                                                                                                        \
+	void open(const char *p_path) {                                                                                                                                                          \
+		close();                                                                                                                                                                             \
+		soa_file.open(p_path, false);                                                                                                                                                        \
+		const soa::MappedHeader *header = soa_header();                                                                                                                                      \
+		const soa::MappedColumn *columns = soa_columns();                                                                                                                                    \
+		bool valid = soa_file.size() >= soa_header_size() and header->magic == soa::MappedHeader::MAGIC and header->version == soa::MappedHeader::VERSION and                                \
+				header->column_count == m_total_columns and header->header_size == soa_header_size() and header->capacity <= std::numeric_limits<SoaVectorSizeType>::max();                  \
+		if (valid) {                                                                                                                                                                         \
+			int current_column = 0;                                                                                                                                                          \
+			FOR_EACH_TWO_ARGS(SOA_MAPPED_CHECK_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                            \
+		}                                                                                                                                                                                    \
+		if (!valid) {                                                                                                                                                                        \
+			soa_file.close();                                                                                                                                                                \
+			throw std::runtime_error(std::string("MappedSOA file doesn't match the layout of " #m_class_name ": ") + p_path);                                                                \
+		}                                                                                                                                                                                    \
+		std::byte *base = soa_file.data() + header->header_size;                                                                                                                             \
+		int current_column = 0;                                                                                                                                                              \
+		FOR_EACH_TWO_ARGS(SOA_MAPPED_OPEN_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+		soa_capacity = SoaVectorSizeType(header->capacity);                                                                                                                                  \
+	}                                                                                                                                                                                        \
+	void sync() {                                                                                                                                                                            \
+		if (soa_file.is_open()) {                                                                                                                                                            \
+			soa_store_counts();                                                                                                                                                              \
+			soa_file.sync();                                                                                                                                                                 \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void close() {                                                                                                                                                                           \
+		if (soa_file.is_open()) {                                                                                                                                                            \
+			soa_store_counts();                                                                                                                                                              \
+			soa_file.close();                                                                                                                                                                \
+		}                                                                                                                                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_DESTROY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
+		soa_capacity = 0;                                                                                                                                                                    \
+		clear_dirty();                                                                                                                                                                       \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] bool is_open() const { return soa_file.is_open(); }                                                                                                                        \
+	void init(const SoaVectorSizeType p_size) {                                                                                                                                              \
+		SOA_STATS_CALL(soa_stats.init_calls++;)                                                                                                                                              \
+		soa_realloc(p_size);                                                                                                                                                                 \
+	}                                                                                                                                                                                        \
+	void reserve(const SoaVectorSizeType p_capacity) {                                                                                                                                       \
+		if (p_capacity > soa_capacity) {                                                                                                                                                     \
+			soa_realloc(p_capacity);                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void shrink_to_fit() {                                                                                                                                                                   \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+		if (row_size < soa_capacity) {                                                                                                                                                       \
+			soa_realloc(row_size);                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] SoaVectorSizeType capacity() const { return soa_capacity; }                                                                                                                \
+	~m_class_name() { close(); }                                                                                                                                                             \
+	void clear() {                                                                                                                                                                           \
+		SOA_STATS_CALL(soa_stats_sample();)                                                                                                                                                  \
+		FOR_EACH_TWO_ARGS(SOA_CLEAR_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                       \
+		clear_dirty();                                                                                                                                                                       \
+	}                                                                                                                                                                                        \
+	m_class_name() = default;                                                                                                                                                                \
+	m_class_name(const m_class_name &) = delete;                                                                                                                                             \
+	m_class_name &operator=(const m_class_name &) = delete;                                                                                                                                  \
+	m_class_name(m_class_name &&) = default;                                                                                                                                                 \
+	m_class_name &operator=(m_class_name &&) = delete;                                                                                                                                       \
+	FOR_EACH_TWO_ARGS(SOA_SETGET, __VA_OPT__(__VA_ARGS__, ))                                                                                                                                 \
+	FOR_EACH_TWO_ARGS(SOA_PUSH, __VA_OPT__(__VA_ARGS__, ))                                                                                                                                   \
+	SOA_PUSH_ROW(__VA_ARGS__)                                                                                                                                                                \
+	SOA_QUERY(m_class_name)                                                                                                                                                                  \
+	SOA_ROWS(m_class_name, SoaVectorSizeType, p_id, SOA_ROW_ELEMENT, SOA_MIN_ROW_SIZE, __VA_ARGS__)                                                                                          \
+	SOA_SORT(m_class_name, (void)0, __VA_ARGS__)                                                                                                                                             \
+	SOA_SERIALIZE(m_total_columns, clear(); reserve(rows), (void)0, (void)0, __VA_ARGS__)                                                                                                    \
+	SOA_DIRTY(m_class_name, m_total_columns, reserve(rows), (void)0, (void)0, (void)0, __VA_ARGS__)                                                                                          \
+	SOA_STATS(m_class_name, soa_capacity, soa_file.size(), 0, soa::ProbeStats(), SOA_COLUMN_MEMORY, SOA_COLUMN_BYTES, __VA_ARGS__)
 
 #define FixedSizeSOA(m_class_name, m_total_columns, ...)                                                                                                                                     \
 	FOR_EACH_TWO_ARGS(SOA_FIXED_TYPES, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
 private:                                                                                                                                                                                     \
 	void *data{};                                                                                                                                                                            \
+	SOA_BLOCK(m_class_name, data)                                                                                                                                                            \
                                                                                                                                                                                              \
 public:                                                                                                                                                                                      \
 	void init(const SoaVectorSizeType p_size) {                                                                                                                                              \
+		static_assert(!soa::reserves_rows<typename soa::allocator_policy_of<m_class_name>::type>, "FixedSizeSOA can't use an allocator policy that reserves rows");                          \
 		uint64_t total_size = 0;                                                                                                                                                             \
 		int mem_offset_idx = 0;                                                                                                                                                              \
+		uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;                                                                                                                                     \
 		uint64_t memory_offsets[m_total_columns];                                                                                                                                            \
 		FOR_EACH_TWO_ARGS(SOA_GET_MALLOC_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                    \
-		data = calloc(p_size, total_size / p_size);                                                                                                                                          \
+		soa_set_block(soa_allocate_block(block_alignment, total_size), block_alignment, total_size);                                                                                         \
 		int current_column = 0;                                                                                                                                                              \
 		FOR_EACH_TWO_ARGS(SOA_INIT_FIXED, __VA_OPT__(__VA_ARGS__, ))                                                                                                                         \
+		SOA_STATS_CALL(soa_stats.init_calls++; soa_stats_realloc(0, p_size, total_size, 0);)                                                                                                 \
 		FOR_EACH_TWO_ARGS(SOA_DEFAULT_CONSTRUCT, __VA_OPT__(__VA_ARGS__, ))                                                                                                                  \
+		soa_mark_all_dirty();                                                                                                                                                                \
 	}                                                                                                                                                                                        \
 	~m_class_name() {                                                                                                                                                                        \
 		if (data != nullptr) {                                                                                                                                                               \
@@ -226,14 +1160,185 @@ public:
 		}                                                                                                                                                                                    \
 	}                                                                                                                                                                                        \
 	void clear() {                                                                                                                                                                           \
+		SOA_STATS_CALL(soa_stats_sample();)                                                                                                                                                  \
 		FOR_EACH_TWO_ARGS(SOA_DESTROY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                            \
-		if (data != nullptr) {                                                                                                                                                               \
-			free(data);                                                                                                                                                                      \
-		}                                                                                                                                                                                    \
+		soa_set_block(nullptr, 0, 0);                                                                                                                                                        \
+		clear_dirty();                                                                                                                                                                       \
 	}                                                                                                                                                                                        \
 	m_class_name() = default;                                                                                                                                                                \
 	m_class_name(const m_class_name &) = default;                                                                                                                                            \
 	m_class_name &operator=(const m_class_name &) = default;                                                                                                                                 \
 	m_class_name(m_class_name &&) = default;                                                                                                                                                 \
 	m_class_name &operator=(m_class_name &&) = default;                                                                                                                                      \
-	FOR_EACH_TWO_ARGS(SOA_SETGET, __VA_OPT__(__VA_ARGS__, ))
+	FOR_EACH_TWO_ARGS(SOA_SETGET, __VA_OPT__(__VA_ARGS__, ))                                                                                                                                 \
+	SOA_QUERY(m_class_name)                                                                                                                                                                  \
+	SOA_ROWS(m_class_name, SoaVectorSizeType, p_id, SOA_ROW_ELEMENT, SOA_MIN_ROW_SIZE, __VA_ARGS__)                                                                                          \
+	SOA_SORT(m_class_name, (void)0, __VA_ARGS__)                                                                                                                                             \
+	SOA_SERIALIZE(m_total_columns, clear(); init(rows), (void)0, (void)0, __VA_ARGS__)                                                                                                       \
+	SOA_DIRTY(m_class_name, m_total_columns, if (soa_row_count() != rows) { clear(); init(rows); }, (void)0, (void)0, (void)0, __VA_ARGS__)                                                  \
+	SOA_STATS(m_class_name, soa_row_count(), soa_allocation_size, 0, soa::ProbeStats(), SOA_COLUMN_MEMORY, SOA_COLUMN_BYTES, __VA_ARGS__)
+
+#define SOA_TILE_COLUMN(m_type, m_name) soa::TileColumn<m_type, soa_block_size> m_name;
+#define SOA_TILED_BLOCK_COLUMN(m_type, m_name) [[nodiscard]] auto m_name() const { return tile->m_name.ptr(); }
+#define SOA_TILED_SIZE(m_type, m_name) SoaVectorSizeType soa_size_##m_name = 0;
+#define SOA_TILED_RESET_SIZE(m_type, m_name) soa_size_##m_name = 0;
+#define SOA_TILED_INCREMENT_SIZE(m_type, m_name) soa_size_##m_name++;
+#define SOA_TILED_ROW_ELEMENT(m_type, m_name) soa_tiles[p_index / soa_block_size].m_name[p_index % soa_block_size]
+#define SOA_TILED_MIN_ROW_SIZE(m_type, m_name) row_count = std::min(row_count, soa_size_##m_name);
+#define SOA_TILED_ROW_SIZE(m_type, m_name) row_size = std::max(row_size, soa_size_##m_name);
+#define SOA_TILED_COLUMN_MEMORY(m_type, m_name)                                                                                                                                              \
+	report.columns.push_back({ #m_type " " #m_name, soa_size_##m_name, capacity, sizeof(m_type) * uint64_t(soa_size_##m_name), sizeof(m_type) * uint64_t(capacity) });
+#define SOA_TILED_CHECK_TYPE(m_type, m_name) static_assert(!soa::is_encoded_column_v<m_type>, "TiledSOA members can't be encoded columns");
+#define SOA_TILED_COLUMN_BYTES(m_type, m_name) bytes += uint64_t(sizeof(m_type)) * soa_size_##m_name;
+
+// Tiles aren't contiguous columns so save copies each column out of the tiles and load decodes it into a buffer before pushing it into the tiles.
+#define SOA_TILED_SAVE_COLUMN(m_type, m_name)                                                                                                                                                \
+	{                                                                                                                                                                                        \
+		std::vector<m_type> column;                                                                                                                                                          \
+		column.reserve(soa_size_##m_name);                                                                                                                                                   \
+		for (SoaVectorSizeType i = 0; i < soa_size_##m_name; ++i) {                                                                                                                          \
+			column.push_back(get_##m_name(i));                                                                                                                                               \
+		}                                                                                                                                                                                    \
+		soa::write_column(p_stream, #m_type " " #m_name, column.data(), soa_size_##m_name);                                                                                                  \
+	}
+
+#define SOA_TILED_LOAD_COLUMN(m_type, m_name)                                                                                                                                                \
+	{                                                                                                                                                                                        \
+		soa::detail::UninitializedBuffer<m_type> column(rows);                                                                                                                               \
+		column.constructed = soa::read_column(p_stream, #m_type " " #m_name, column.data(), rows);                                                                                           \
+		for (SoaVectorSizeType i = 0; i < column.constructed; ++i) {                                                                                                                         \
+			push_##m_name(column.data()[i]);                                                                                                                                                 \
+		}                                                                                                                                                                                    \
+	}
+#define SOA_TILED_REALLOC(m_type, m_name) soa::tiled_move_column(soa_tiles, new_tiles, &soa_tile::m_name, soa_size_##m_name);
+#define SOA_TILED_DESTROY(m_type, m_name) soa::tiled_destroy_column(soa_tiles, &soa_tile::m_name, soa_size_##m_name);
+#define SOA_TILED_MOVE_SIZE(m_type, m_name) soa_size_##m_name = std::exchange(p_other.soa_size_##m_name, 0);
+#define SOA_TILED_EMPLACE_ROW_MEMBER(m_type, m_name) soa_tiles[row_size / soa_block_size].m_name.construct_at(row_size % soa_block_size, std::forward<P_##m_name>(p_##m_name));
+
+#define SOA_TILED_SETGET(m_type, m_name)                                                                                                                                                     \
+	void set_##m_name(SoaVectorSizeType p_index, const m_type &p_item) { soa_tiles[p_index / soa_block_size].m_name[p_index % soa_block_size] = p_item; }                                    \
+	[[nodiscard]] m_type get_##m_name(SoaVectorSizeType p_index) { return soa_tiles[p_index / soa_block_size].m_name[p_index % soa_block_size]; }                                            \
+	[[nodiscard]] const m_type &get_##m_name(SoaVectorSizeType p_index) const { return soa_tiles[p_index / soa_block_size].m_name[p_index % soa_block_size]; }
+
+#define SOA_TILED_PUSH(m_type, m_name)                                                                                                                                                       \
+	void push_##m_name(const m_type &p_elem) {                                                                                                                                               \
+		if (soa_size_##m_name == soa_capacity) [[unlikely]] {                                                                                                                                \
+			soa_grow();                                                                                                                                                                      \
+		}                                                                                                                                                                                    \
+		soa_tiles[soa_size_##m_name / soa_block_size].m_name.construct_at(soa_size_##m_name % soa_block_size, p_elem);                                                                       \
+		soa_size_##m_name++;                                                                                                                                                                 \
+	}
+
+// AoSoA layout: rows are stored in tiles of m_block_size rows and each tile holds the m_block_size values of every member next to each other. A whole row is in 1 tile (usually
+// a few cache lines) while each member is still contiguous inside a tile so blocks() can hand out column pointers for vectorized loops.
+// Same get_X/set_X/push_X/push_row API as DynamicSOA but there are no SoaVector members, use blocks() to work on columns:
+// for (auto block : soa.blocks()) { float *x = block.x(); for (SoaVectorSizeType i = 0; i < block.count; ++i) x[i] *= 2; }
+// blocks() returns 1 block per tile with block.first_row, block.count and a block.X() function for each member X, so members can't be named tile, first_row or count.
+// size() is the row count of the largest member, push_row assumes every member has the same size like it does for DynamicSOA.
+// m_block_size has to be a power of 2, 8-64 rows is the useful range. Unlike the other macros copying is deleted and moving transfers the tiles.
+#define TiledSOA(m_class_name, m_total_columns, m_block_size, ...)                                                                                                                           \
+	static constexpr SoaVectorSizeType soa_block_size = m_block_size;                                                                                                                        \
+	static_assert(std::has_single_bit(soa_block_size), "TiledSOA block size must be a power of 2");                                                                                          \
+	FOR_EACH_TWO_ARGS(SOA_TILED_CHECK_TYPE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                       \
+	struct soa_tile {                                                                                                                                                                        \
+		FOR_EACH_TWO_ARGS(SOA_TILE_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                        \
+	};                                                                                                                                                                                       \
+	template <bool Const> struct soa_block {                                                                                                                                                 \
+		std::conditional_t<Const, const soa_tile, soa_tile> *tile;                                                                                                                           \
+		SoaVectorSizeType first_row;                                                                                                                                                         \
+		SoaVectorSizeType count;                                                                                                                                                             \
+		FOR_EACH_TWO_ARGS(SOA_TILED_BLOCK_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                 \
+	};                                                                                                                                                                                       \
+                                                                                                                                                                                             \
+private:                                                                                                                                                                                     \
+	soa_tile *soa_tiles = nullptr;                                                                                                                                                           \
+	SOA_BLOCK(m_class_name, soa_tiles)                                                                                                                                                       \
+	SoaVectorSizeType soa_capacity = 0;                                                                                                                                                      \
+	FOR_EACH_TWO_ARGS(SOA_TILED_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                             \
+	void soa_realloc(const SoaVectorSizeType p_size) {                                                                                                                                       \
+		static_assert(!soa::reserves_rows<typename soa::allocator_policy_of<m_class_name>::type>, "TiledSOA can't use an allocator policy that reserves rows");                              \
+		const uint64_t tile_count = (uint64_t(p_size) + soa_block_size - 1) / soa_block_size;                                                                                                \
+		const uint64_t tile_alignment = std::max<uint64_t>(SOA_COLUMN_ALIGNMENT, alignof(soa_tile));                                                                                         \
+		soa_tile *new_tiles = static_cast<soa_tile *>(soa_allocate_block(tile_alignment, tile_count * sizeof(soa_tile)));                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_TILED_REALLOC, __VA_OPT__(__VA_ARGS__, ))                                                                                                                      \
+		soa_set_block(new_tiles, tile_alignment, tile_count * sizeof(soa_tile));                                                                                                             \
+		SOA_STATS_CALL(soa_stats_realloc(soa_capacity, soa::detail::clamp_capacity(tile_count * soa_block_size), tile_count * sizeof(soa_tile), soa_column_bytes());)                        \
+		soa_capacity = soa::detail::clamp_capacity(tile_count * soa_block_size);                                                                                                             \
+	}                                                                                                                                                                                        \
+	void soa_grow() { soa_realloc(soa::growth_policy_of<m_class_name>::type::grow(soa_capacity, soa_capacity + 1)); }                                                                        \
+                                                                                                                                                                                             \
+public:                                                                                                                                                                                      \
+	void init(const SoaVectorSizeType p_size) {                                                                                                                                              \
+		SOA_STATS_CALL(soa_stats.init_calls++;)                                                                                                                                              \
+		soa_realloc(p_size);                                                                                                                                                                 \
+	}                                                                                                                                                                                        \
+	void reserve(const SoaVectorSizeType p_capacity) {                                                                                                                                       \
+		if (p_capacity > soa_capacity) {                                                                                                                                                     \
+			soa_realloc(p_capacity);                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void shrink_to_fit() {                                                                                                                                                                   \
+		const SoaVectorSizeType row_size = size();                                                                                                                                           \
+		if (row_size < soa_capacity) {                                                                                                                                                       \
+			soa_realloc(row_size);                                                                                                                                                           \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] SoaVectorSizeType capacity() const { return soa_capacity; }                                                                                                                \
+	[[nodiscard]] SoaVectorSizeType size() const {                                                                                                                                           \
+		SoaVectorSizeType row_size = 0;                                                                                                                                                      \
+		FOR_EACH_TWO_ARGS(SOA_TILED_ROW_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                     \
+		return row_size;                                                                                                                                                                     \
+	}                                                                                                                                                                                        \
+	~m_class_name() {                                                                                                                                                                        \
+		if (soa_tiles != nullptr) {                                                                                                                                                          \
+			clear();                                                                                                                                                                         \
+		}                                                                                                                                                                                    \
+	}                                                                                                                                                                                        \
+	void clear() {                                                                                                                                                                           \
+		SOA_STATS_CALL(soa_stats_sample();)                                                                                                                                                  \
+		FOR_EACH_TWO_ARGS(SOA_TILED_DESTROY, __VA_OPT__(__VA_ARGS__, ))                                                                                                                      \
+		soa_set_block(nullptr, 0, 0);                                                                                                                                                        \
+		soa_capacity = 0;                                                                                                                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_TILED_RESET_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                   \
+	}                                                                                                                                                                                        \
+	m_class_name() = default;                                                                                                                                                                \
+	m_class_name(const m_class_name &) = delete;                                                                                                                                             \
+	m_class_name &operator=(const m_class_name &) = delete;                                                                                                                                  \
+	m_class_name(m_class_name &&p_other) noexcept { *this = std::move(p_other); }                                                                                                            \
+	m_class_name &operator=(m_class_name &&p_other) noexcept {                                                                                                                               \
+		if (this != &p_other) {                                                                                                                                                              \
+			clear();                                                                                                                                                                         \
+			soa_tiles = std::exchange(p_other.soa_tiles, nullptr);                                                                                                                           \
+			soa_allocation_alignment = std::exchange(p_other.soa_allocation_alignment, 0);                                                                                                   \
+			soa_allocation_size = std::exchange(p_other.soa_allocation_size, 0);                                                                                                             \
+			soa_capacity = std::exchange(p_other.soa_capacity, 0);                                                                                                                           \
+			FOR_EACH_TWO_ARGS(SOA_TILED_MOVE_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                                \
+			SOA_STATS_CALL(soa_stats = std::exchange(p_other.soa_stats, {}); soa_growth_hook = std::move(p_other.soa_growth_hook);)                                                          \
+		}                                                                                                                                                                                    \
+		return *this;                                                                                                                                                                        \
+	}                                                                                                                                                                                        \
+	[[nodiscard]] soa::TiledBlockRange<soa_block<false>, soa_tile, soa_block_size> blocks() { return { soa_tiles, size() }; }                                                                \
+	[[nodiscard]] soa::TiledBlockRange<soa_block<true>, const soa_tile, soa_block_size> blocks() const { return { soa_tiles, size() }; }                                                     \
+	FOR_EACH_TWO_ARGS(SOA_TILED_SETGET, __VA_OPT__(__VA_ARGS__, ))                                                                                                                           \
+	FOR_EACH_TWO_ARGS(SOA_TILED_PUSH, __VA_OPT__(__VA_ARGS__, ))                                                                                                                             \
+	void push_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_PARAM, __VA_OPT__(__VA_ARGS__, ))) { emplace_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_ARG, __VA_OPT__(__VA_ARGS__, ))); }                         \
+	template <FOR_EACH_TWO_ARGS_LIST(SOA_ROW_TEMPLATE_PARAM, __VA_OPT__(__VA_ARGS__, ))> void emplace_row(FOR_EACH_TWO_ARGS_LIST(SOA_ROW_FORWARD_PARAM, __VA_OPT__(__VA_ARGS__, ))) {        \
+		const SoaVectorSizeType row_size = size();                                                                                                                                           \
+		if (row_size == soa_capacity) [[unlikely]] {                                                                                                                                         \
+			soa_grow();                                                                                                                                                                      \
+		}                                                                                                                                                                                    \
+		FOR_EACH_TWO_ARGS(SOA_TILED_EMPLACE_ROW_MEMBER, __VA_OPT__(__VA_ARGS__, ))                                                                                                           \
+		FOR_EACH_TWO_ARGS(SOA_TILED_INCREMENT_SIZE, __VA_OPT__(__VA_ARGS__, ))                                                                                                               \
+	}                                                                                                                                                                                        \
+	SOA_ROWS(m_class_name, SoaVectorSizeType, p_id, SOA_TILED_ROW_ELEMENT, SOA_TILED_MIN_ROW_SIZE, __VA_ARGS__)                                                                              \
+	template <std::derived_from<std::ostream> Stream> void save(Stream &p_stream) const {                                                                                                    \
+		soa::write_table_header(p_stream, m_total_columns, size());                                                                                                                          \
+		FOR_EACH_TWO_ARGS(SOA_TILED_SAVE_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                  \
+	}                                                                                                                                                                                        \
+	template <std::derived_from<std::istream> Stream> void load(Stream &p_stream) {                                                                                                          \
+		const SoaVectorSizeType rows = soa::read_table_header(p_stream, m_total_columns);                                                                                                    \
+		clear();                                                                                                                                                                             \
+		reserve(rows);                                                                                                                                                                       \
+		FOR_EACH_TWO_ARGS(SOA_TILED_LOAD_COLUMN, __VA_OPT__(__VA_ARGS__, ))                                                                                                                  \
+	}                                                                                                                                                                                        \
+	SOA_STATS(m_class_name, soa_capacity, soa_allocation_size, 0, soa::ProbeStats(), SOA_TILED_COLUMN_MEMORY, SOA_TILED_COLUMN_BYTES, __VA_ARGS__)
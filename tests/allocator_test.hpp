@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+struct AllocatorTestFrame {};
+struct AllocatorTestBigAlignment {};
+
+struct AllocatorArenaTestStruct {
+	using soa_allocator_policy = soa::ArenaAllocator<AllocatorTestFrame, 4096>;
+	DynamicSOA(
+		AllocatorArenaTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct AllocatorPoolTestStruct {
+	using soa_allocator_policy = soa::PoolAllocator<>;
+	MutableSOA(
+		AllocatorPoolTestStruct, 2,
+		int, a,
+		double, b
+	)
+};
+
+struct AllocatorPoolTiledTestStruct {
+	using soa_allocator_policy = soa::PoolAllocator<>;
+	TiledSOA(
+		AllocatorPoolTiledTestStruct, 2, 8,
+		int, a,
+		float, b
+	)
+};
+
+// Tiny threshold so the test tables are mapped too.
+struct AllocatorHugePageTestStruct {
+	using soa_allocator_policy = soa::HugePageAllocator<4096>;
+	FixedSizeSOA(
+		AllocatorHugePageTestStruct, 2,
+		int, a,
+		double, b
+	)
+};
+
+inline void allocator_test() {
+	bool passed = true;
+	{
+		AllocatorArenaTestStruct frame_struct;
+		for (int i = 0; i < 1000; ++i) {
+			frame_struct.push_row(i, std::to_string(i));
+		}
+		passed &= frame_struct.get_b(999) == "999" and frame_struct.get_a(500) == 500 and uint64_t(frame_struct.a.ptr()) % SOA_COLUMN_ALIGNMENT == 0;
+	}
+	// Growing left the old blocks behind in the arena, after a reset the next table starts at the first block again.
+	const uint64_t reserved = soa::ArenaAllocator<AllocatorTestFrame, 4096>::reserved_bytes();
+	soa::ArenaAllocator<AllocatorTestFrame, 4096>::reset();
+	{
+		AllocatorArenaTestStruct next_frame;
+		for (int i = 0; i < 1000; ++i) {
+			next_frame.push_row(-i, "");
+		}
+		passed &= next_frame.get_a(999) == -999 and soa::ArenaAllocator<AllocatorTestFrame, 4096>::reserved_bytes() == reserved;
+	}
+	soa::ArenaAllocator<AllocatorTestFrame, 4096>::release();
+	passed &= soa::ArenaAllocator<AllocatorTestFrame, 4096>::reserved_bytes() == 0;
+	// Alignments over a page still hold when a reused block was only page aligned.
+	using BigAlignmentArena = soa::ArenaAllocator<AllocatorTestBigAlignment, uint64_t(1) << 17>;
+	for (uint64_t alignment = 8192; alignment <= 65536; alignment *= 2) {
+		BigAlignmentArena::reset();
+		passed &= uint64_t(BigAlignmentArena::allocate(64, 100)) % 64 == 0 and uint64_t(BigAlignmentArena::allocate(alignment, 100)) % alignment == 0;
+	}
+	BigAlignmentArena::release();
+	std::cout << "ArenaAllocator: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// A table of the same size gets the block the last one gave back.
+	const int *first_block = nullptr;
+	{
+		AllocatorPoolTestStruct pool_struct;
+		pool_struct.reserve(100);
+		for (int i = 0; i < 100; ++i) {
+			pool_struct.push_row(i, i * 0.5);
+		}
+		pool_struct.erase(10);
+		passed = pool_struct.get_b(99) == 49.5 and pool_struct.a.size() == 99;
+		first_block = pool_struct.a.ptr();
+	}
+	const uint64_t pool_allocations = soa::PoolAllocator<>::system_allocations();
+	{
+		AllocatorPoolTestStruct pool_struct;
+		pool_struct.reserve(100);
+		passed &= pool_struct.a.ptr() == first_block and soa::PoolAllocator<>::system_allocations() == pool_allocations;
+		AllocatorPoolTiledTestStruct tiled_struct;
+		for (int i = 0; i < 100; ++i) {
+			tiled_struct.push_row(i, float(i));
+		}
+		passed &= tiled_struct.get_a(77) == 77 and tiled_struct.get_b(99) == 99.0f;
+	}
+	std::cout << "PoolAllocator: " << (passed ? "Passed\n" : "Failed.\n");
+
+	AllocatorHugePageTestStruct huge_struct;
+	huge_struct.init(10000);
+	for (SoaVectorSizeType i = 0; i < 10000; ++i) {
+		huge_struct.set_a(i, int(i));
+		huge_struct.set_b(i, i * 2.0);
+	}
+	passed = huge_struct.get_b(9999) == 19998.0 and huge_struct.get_a(1234) == 1234;
+#ifdef SOA_HAS_HUGE_PAGES
+	passed &= uint64_t(huge_struct.a.ptr()) % soa::HugePageAllocator<>::huge_page_size == 0;
+#endif
+	huge_struct.clear();
+	huge_struct.init(10);
+	passed &= huge_struct.a.size() == 10;
+	std::cout << "HugePageAllocator: " << (passed ? "Passed\n" : "Failed.\n");
+}
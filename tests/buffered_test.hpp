@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../src/soa.hpp"
+#include "test_types.hpp"
+#include "dirty_test.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BufferedTicksTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	DynamicSOA(
+		BufferedTicksTestStruct, 3,
+		int, a,
+		Vector2, b,
+		int, c
+	)
+};
+
+template <typename S> bool buffered_columns_match(const S &p_a, const S &p_b) {
+	return std::ranges::equal(p_a.a, p_b.a) and std::ranges::equal(p_a.b, p_b.b);
+}
+
+inline void buffered_test() {
+	// 3 buffers so a snapshot can be kept over a publish on the same thread, with 2 the publish would wait for it forever.
+	soa::BufferedSOA<DirtyTestStruct, 3> buffered;
+	auto reader = buffered.reader();
+	for (int i = 0; i < 100; ++i) {
+		buffered.back().push_row(i, std::to_string(i));
+	}
+	bool passed = reader.read()->a.size() == 0;
+	{
+		// A snapshot taken before a publish keeps showing the old rows, a read after it shows the new ones.
+		auto old_snapshot = reader.read();
+		buffered.publish();
+		auto other_reader = buffered.reader();
+		passed &= old_snapshot->a.size() == 0 and other_reader.read()->a.size() == 100;
+	}
+	// The next back buffer was caught up by publish and writes to it don't show until the next one.
+	passed &= buffered.back().a.size() == 100 and buffered.back().get_b(99) == "99";
+	buffered.back().set_a(5, -5);
+	passed &= reader.read()->get_a(5) == 5;
+	buffered.publish();
+	passed &= reader.read()->get_a(5) == -5 and buffered.back().get_a(5) == -5;
+	std::cout << "BufferedSOA read/publish: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// Every published buffer has to match a table that got the same changes, with 3 buffers each one misses 2 publishes worth of changes before it's reused.
+	soa::BufferedSOA<DirtyMutableTestStruct, 3> buffered_mutable;
+	DirtyMutableTestStruct reference;
+	auto mutable_reader = buffered_mutable.reader();
+	std::mt19937 rng(11);
+	SoaVectorSizeType next_id = 0;
+	std::vector<bool> erased;
+	passed = true;
+	for (int tick = 0; tick < 40; ++tick) {
+		for (int i = 0; i < 10; ++i) {
+			buffered_mutable.back().push_row(int(next_id), std::to_string(next_id));
+			reference.push_row(int(next_id), std::to_string(next_id));
+			next_id++;
+			erased.push_back(false);
+		}
+		for (int i = 0; i < 5; ++i) {
+			const SoaVectorSizeType id = rng() % next_id;
+			if (!erased[id]) {
+				buffered_mutable.back().set_b(id, "tick " + std::to_string(tick));
+				reference.set_b(id, "tick " + std::to_string(tick));
+				if (i % 2 == 0) {
+					buffered_mutable.back().erase(id);
+					reference.erase(id);
+					erased[id] = true;
+				}
+			}
+		}
+		buffered_mutable.publish();
+		auto snapshot = mutable_reader.read();
+		passed &= buffered_columns_match(*snapshot, reference) and snapshot->tombstone_count() == reference.tombstone_count();
+		passed &= buffered_columns_match(buffered_mutable.back(), reference);
+		for (SoaVectorSizeType id = 0; id < next_id; ++id) {
+			try {
+				passed &= snapshot->get_b(id) == reference.get_b(id) and !erased[id];
+			} catch (const std::out_of_range &) {
+				passed &= erased[id];
+			}
+		}
+	}
+	passed &= buffered_mutable.back().push_row(-1, "") == next_id;
+	std::cout << "BufferedSOA MutableSOA 3 buffers: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// Every tick sets every row to the tick number, a torn read would show 2 different numbers in one snapshot.
+	soa::BufferedSOA<BufferedTicksTestStruct> buffered_ticks;
+	for (int i = 0; i < 1000; ++i) {
+		buffered_ticks.back().push_row(0, Vector2(), 0);
+	}
+	buffered_ticks.publish();
+	std::atomic<bool> done = false;
+	std::atomic<bool> consistent = true;
+	std::vector<std::thread> readers;
+	for (int r = 0; r < 3; ++r) {
+		readers.emplace_back([&]() {
+			auto tick_reader = buffered_ticks.reader();
+			int last_tick = 0;
+			while (!done.load()) {
+				auto snapshot = tick_reader.read();
+				const int tick = snapshot->a[0];
+				bool same = tick >= last_tick and snapshot->a.size() == 1000;
+				for (SoaVectorSizeType i = 0; i < snapshot->a.size(); ++i) {
+					same &= snapshot->a[i] == tick and snapshot->c[i] == -tick;
+				}
+				if (!same) {
+					consistent = false;
+				}
+				last_tick = tick;
+			}
+		});
+	}
+	for (int tick = 1; tick <= 300; ++tick) {
+		for (SoaVectorSizeType i = 0; i < 1000; ++i) {
+			buffered_ticks.back().set_a(i, tick);
+			buffered_ticks.back().set_c(i, -tick);
+		}
+		buffered_ticks.publish();
+	}
+	done = true;
+	for (std::thread &thread : readers) {
+		thread.join();
+	}
+	passed = consistent and buffered_ticks.reader().read()->a[999] == 300;
+	std::cout << "BufferedSOA concurrent readers: " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,130 @@
+// Compile time benchmark of soa::Table against the DynamicSOA macro. Defines 10 tables with SOA_BENCH_COLUMNS (8, 32 or 100) columns each and pushes, sets and gets a row of
+// every one of them, time building it with each of the table kinds:
+//   time g++ -std=c++23 -O2 -c -DSOA_BENCH_COLUMNS=100 tests/compile_time_bench.cpp                           DynamicSOA
+//   time g++ -std=c++23 -O2 -c -DSOA_BENCH_COLUMNS=100 -DSOA_BENCH_TABLE tests/compile_time_bench.cpp         soa::Table of soa::Columns
+//   time g++ -std=c++23 -O2 -c -DSOA_BENCH_COLUMNS=32 -DSOA_BENCH_TABLE_AGGREGATE tests/compile_time_bench.cpp soa::Table of an aggregate struct, up to 32 columns
+// It isn't part of the test executable.
+
+#include "../src/soa.hpp"
+
+#include <cstdint>
+
+#ifndef SOA_BENCH_COLUMNS
+#define SOA_BENCH_COLUMNS 8
+#endif
+
+#if SOA_BENCH_COLUMNS == 8
+#define SOA_BENCH_MEMBERS                                                                                                                                                                    \
+	int, c0, float, c1, double, c2, uint64_t, c3, int, c4, float, c5, double, c6, uint64_t, c7
+#define SOA_BENCH_TYPES                                                                                                                                                                      \
+	int, float, double, uint64_t, int, float, double, uint64_t
+#define SOA_BENCH_FIELDS                                                                                                                                                                     \
+	int c0; float c1; double c2; uint64_t c3; int c4; float c5; double c6; uint64_t c7;
+#define SOA_BENCH_ROW                                                                                                                                                                        \
+	0, 0, 0, 0, 0, 0, 0, 0
+#define SOA_BENCH_GET_LAST get_c7
+#endif
+#if SOA_BENCH_COLUMNS == 32
+#define SOA_BENCH_MEMBERS                                                                                                                                                                    \
+	int, c0, float, c1, double, c2, uint64_t, c3, int, c4, float, c5, double, c6, uint64_t, c7, int, c8, float, c9,                                                                          \
+	double, c10, uint64_t, c11, int, c12, float, c13, double, c14, uint64_t, c15, int, c16, float, c17, double, c18, uint64_t, c19,                                                          \
+	int, c20, float, c21, double, c22, uint64_t, c23, int, c24, float, c25, double, c26, uint64_t, c27, int, c28, float, c29,                                                                \
+	double, c30, uint64_t, c31
+#define SOA_BENCH_TYPES                                                                                                                                                                      \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t,                                                                  \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t
+#define SOA_BENCH_FIELDS                                                                                                                                                                     \
+	int c0; float c1; double c2; uint64_t c3; int c4; float c5; double c6; uint64_t c7; int c8; float c9;                                                                                    \
+	double c10; uint64_t c11; int c12; float c13; double c14; uint64_t c15; int c16; float c17; double c18; uint64_t c19;                                                                    \
+	int c20; float c21; double c22; uint64_t c23; int c24; float c25; double c26; uint64_t c27; int c28; float c29;                                                                          \
+	double c30; uint64_t c31;
+#define SOA_BENCH_ROW                                                                                                                                                                        \
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+#define SOA_BENCH_GET_LAST get_c31
+#endif
+#if SOA_BENCH_COLUMNS == 100
+#define SOA_BENCH_MEMBERS                                                                                                                                                                    \
+	int, c0, float, c1, double, c2, uint64_t, c3, int, c4, float, c5, double, c6, uint64_t, c7, int, c8, float, c9,                                                                          \
+	double, c10, uint64_t, c11, int, c12, float, c13, double, c14, uint64_t, c15, int, c16, float, c17, double, c18, uint64_t, c19,                                                          \
+	int, c20, float, c21, double, c22, uint64_t, c23, int, c24, float, c25, double, c26, uint64_t, c27, int, c28, float, c29,                                                                \
+	double, c30, uint64_t, c31, int, c32, float, c33, double, c34, uint64_t, c35, int, c36, float, c37, double, c38, uint64_t, c39,                                                          \
+	int, c40, float, c41, double, c42, uint64_t, c43, int, c44, float, c45, double, c46, uint64_t, c47, int, c48, float, c49,                                                                \
+	double, c50, uint64_t, c51, int, c52, float, c53, double, c54, uint64_t, c55, int, c56, float, c57, double, c58, uint64_t, c59,                                                          \
+	int, c60, float, c61, double, c62, uint64_t, c63, int, c64, float, c65, double, c66, uint64_t, c67, int, c68, float, c69,                                                                \
+	double, c70, uint64_t, c71, int, c72, float, c73, double, c74, uint64_t, c75, int, c76, float, c77, double, c78, uint64_t, c79,                                                          \
+	int, c80, float, c81, double, c82, uint64_t, c83, int, c84, float, c85, double, c86, uint64_t, c87, int, c88, float, c89,                                                                \
+	double, c90, uint64_t, c91, int, c92, float, c93, double, c94, uint64_t, c95, int, c96, float, c97, double, c98, uint64_t, c99
+#define SOA_BENCH_TYPES                                                                                                                                                                      \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t,                                                                  \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t,                                                                  \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t,                                                                  \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t,                                                                  \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t,                                                                  \
+	int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t, int, float, double, uint64_t,                                                                  \
+	int, float, double, uint64_t
+#define SOA_BENCH_FIELDS                                                                                                                                                                     \
+	int c0; float c1; double c2; uint64_t c3; int c4; float c5; double c6; uint64_t c7; int c8; float c9;                                                                                    \
+	double c10; uint64_t c11; int c12; float c13; double c14; uint64_t c15; int c16; float c17; double c18; uint64_t c19;                                                                    \
+	int c20; float c21; double c22; uint64_t c23; int c24; float c25; double c26; uint64_t c27; int c28; float c29;                                                                          \
+	double c30; uint64_t c31; int c32; float c33; double c34; uint64_t c35; int c36; float c37; double c38; uint64_t c39;                                                                    \
+	int c40; float c41; double c42; uint64_t c43; int c44; float c45; double c46; uint64_t c47; int c48; float c49;                                                                          \
+	double c50; uint64_t c51; int c52; float c53; double c54; uint64_t c55; int c56; float c57; double c58; uint64_t c59;                                                                    \
+	int c60; float c61; double c62; uint64_t c63; int c64; float c65; double c66; uint64_t c67; int c68; float c69;                                                                          \
+	double c70; uint64_t c71; int c72; float c73; double c74; uint64_t c75; int c76; float c77; double c78; uint64_t c79;                                                                    \
+	int c80; float c81; double c82; uint64_t c83; int c84; float c85; double c86; uint64_t c87; int c88; float c89;                                                                          \
+	double c90; uint64_t c91; int c92; float c93; double c94; uint64_t c95; int c96; float c97; double c98; uint64_t c99;
+#define SOA_BENCH_ROW                                                                                                                                                                        \
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,                                                                  \
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,                                                                  \
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+#define SOA_BENCH_GET_LAST get_c99
+#endif
+
+#if defined(SOA_BENCH_TABLE)
+#define SOA_BENCH_STRUCT(m_name)                                                                                                                                                             \
+	struct m_name : soa::Columns<SOA_BENCH_TYPES> {};                                                                                                                                        \
+	inline int use_##m_name() {                                                                                                                                                              \
+		soa::Table<m_name> table;                                                                                                                                                            \
+		table.push_row(SOA_BENCH_ROW);                                                                                                                                                       \
+		table.set<0>(0, 1);                                                                                                                                                                  \
+		return int(table.get<SOA_BENCH_COLUMNS - 1>(0)) + table.get<0>(0);                                                                                                                   \
+	}
+#elif defined(SOA_BENCH_TABLE_AGGREGATE)
+#define SOA_BENCH_STRUCT(m_name)                                                                                                                                                             \
+	struct m_name {                                                                                                                                                                          \
+		SOA_BENCH_FIELDS                                                                                                                                                                     \
+	};                                                                                                                                                                                       \
+	inline int use_##m_name() {                                                                                                                                                              \
+		soa::Table<m_name> table;                                                                                                                                                            \
+		table.push_row(SOA_BENCH_ROW);                                                                                                                                                       \
+		table.set<0>(0, 1);                                                                                                                                                                  \
+		return int(table.get<SOA_BENCH_COLUMNS - 1>(0)) + table.get<0>(0);                                                                                                                   \
+	}
+#else
+#define SOA_BENCH_STRUCT(m_name)                                                                                                                                                             \
+	struct m_name {                                                                                                                                                                          \
+		DynamicSOA(m_name, SOA_BENCH_COLUMNS, SOA_BENCH_MEMBERS)                                                                                                                             \
+	};                                                                                                                                                                                       \
+	inline int use_##m_name() {                                                                                                                                                              \
+		m_name table;                                                                                                                                                                        \
+		table.push_row(SOA_BENCH_ROW);                                                                                                                                                       \
+		table.set_c0(0, 1);                                                                                                                                                                  \
+		return int(table.SOA_BENCH_GET_LAST(0)) + table.get_c0(0);                                                                                                                           \
+	}
+#endif
+
+SOA_BENCH_STRUCT(BenchTable0)
+SOA_BENCH_STRUCT(BenchTable1)
+SOA_BENCH_STRUCT(BenchTable2)
+SOA_BENCH_STRUCT(BenchTable3)
+SOA_BENCH_STRUCT(BenchTable4)
+SOA_BENCH_STRUCT(BenchTable5)
+SOA_BENCH_STRUCT(BenchTable6)
+SOA_BENCH_STRUCT(BenchTable7)
+SOA_BENCH_STRUCT(BenchTable8)
+SOA_BENCH_STRUCT(BenchTable9)
+
+int main() {
+	return use_BenchTable0() + use_BenchTable1() + use_BenchTable2() + use_BenchTable3() + use_BenchTable4() + use_BenchTable5() + use_BenchTable6() + use_BenchTable7() +
+			use_BenchTable8() + use_BenchTable9();
+}
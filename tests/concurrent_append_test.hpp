@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ConcurrentAppendTestStruct {
+	DynamicSOA(
+		ConcurrentAppendTestStruct, 3,
+		int, producer,
+		int, sequence,
+		std::string, name
+	)
+};
+
+inline void concurrent_append_test() {
+	// Tiny segments and only 4 of them so producers run into the segment ends and have to wait for the consumer to reuse them.
+	soa::ConcurrentAppendSOA<ConcurrentAppendTestStruct, 64, 4> appender;
+	ConcurrentAppendTestStruct target;
+	const int producer_count = 4;
+	const int rows_per_producer = 20000;
+	std::atomic<int> producers_done = 0;
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < producer_count; ++producer) {
+		producers.emplace_back([&, producer]() {
+			int sequence = 0;
+			while (sequence < rows_per_producer) {
+				// Single rows and batches of up to 100 rows, which cross segment ends.
+				const int batch_size = std::min(sequence % 7 == 0 ? 1 : sequence % 100 + 1, rows_per_producer - sequence);
+				if (batch_size == 1) {
+					appender.push_row(producer, sequence, std::to_string(sequence));
+					sequence++;
+					continue;
+				}
+				auto batch = appender.reserve_rows(uint64_t(batch_size));
+				for (int i = 0; i < batch_size; ++i, ++sequence) {
+					batch.emplace_row(producer, sequence, std::to_string(sequence));
+				}
+			}
+			producers_done++;
+		});
+	}
+	uint64_t drained = 0;
+	while (producers_done.load() < producer_count) {
+		drained += appender.drain_into(target);
+	}
+	for (std::thread &thread : producers) {
+		thread.join();
+	}
+	drained += appender.drain_into(target);
+
+	bool passed = drained == producer_count * rows_per_producer and target.producer.size() == drained and target.name.size() == drained;
+	// Every producer's rows show up in the order it wrote them.
+	std::vector<int> next_sequence(producer_count, 0);
+	for (SoaVectorSizeType i = 0; i < target.producer.size(); ++i) {
+		const int producer = target.producer[i];
+		passed &= target.sequence[i] == next_sequence[producer]++ and target.name[i] == std::to_string(target.sequence[i]);
+	}
+	std::cout << "ConcurrentAppendSOA producers/drain_into: " << (passed ? "Passed\n" : "Failed.\n");
+
+	soa::ConcurrentAppendSOA<ConcurrentAppendTestStruct, 64, 4> partial_appender;
+	{
+		auto batch = partial_appender.reserve_rows(3);
+		batch.emplace_row(1, 2, "3");
+		try {
+			batch.emplace_row(4, 5, "6");
+			batch.emplace_row(7, 8, "9");
+			batch.emplace_row(0, 0, "too many");
+			passed = false;
+		} catch (const std::out_of_range &) {
+		}
+		// Nothing is drained until the batch is published.
+		ConcurrentAppendTestStruct early_target;
+		passed &= partial_appender.drain_into(early_target) == 0;
+	}
+	{
+		// Rows that weren't written are default constructed.
+		auto batch = partial_appender.reserve_rows(2);
+		batch.emplace_row(10, 11, "12");
+	}
+	ConcurrentAppendTestStruct partial_target;
+	passed &= partial_appender.drain_into(partial_target) == 5 and partial_target.sequence.size() == 5 and partial_target.get_name(2) == "9";
+	passed &= partial_target.get_producer(3) == 10 and partial_target.get_producer(4) == 0 and partial_target.get_name(4).empty();
+	// Published rows that weren't drained are destroyed with the appender.
+	partial_appender.push_row(0, 0, std::string(100, 'x'));
+	std::cout << "ConcurrentAppendSOA batches: " << (passed ? "Passed\n" : "Failed.\n");
+}
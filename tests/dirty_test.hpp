@@ -0,0 +1,175 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct DirtyTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	DynamicSOA(
+		DirtyTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct DirtyBlockTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<64>;
+	DynamicSOA(
+		DirtyBlockTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct DirtyMutableTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	using soa_erase_policy = soa::TombstoneErase<30, 10>;
+	MutableSOA(
+		DirtyMutableTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct DirtySparseTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	SparseSOA(
+		DirtySparseTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct DirtyFixedTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	FixedSizeSOA(
+		DirtyFixedTestStruct, 2,
+		int, a,
+		double, b
+	)
+};
+
+template <typename S, typename T> std::vector<SoaVectorSizeType> dirty_rows(const S &p_soa, soa::SoaVector<T> S::*p_member) {
+	std::vector<SoaVectorSizeType> rows;
+	p_soa.for_each_dirty(p_member, [&](SoaVectorSizeType p_row) { rows.push_back(p_row); });
+	return rows;
+}
+
+// Sends the changes since the last sync to r_replica and starts over, returns the size of the delta.
+template <typename S> uint64_t dirty_sync(S &r_primary, S &r_replica) {
+	std::stringstream delta;
+	r_primary.export_delta(delta);
+	r_replica.apply_delta(delta);
+	r_primary.clear_dirty();
+	return delta.str().size();
+}
+
+inline void dirty_test() {
+	DirtyTestStruct soa_struct;
+	for (int i = 0; i < 100; ++i) {
+		soa_struct.push_row(i, std::to_string(i));
+	}
+	bool passed = dirty_rows(soa_struct, &DirtyTestStruct::a).size() == 100;
+	soa_struct.clear_dirty();
+	soa_struct.set_a(5, -5);
+	soa_struct.set_b(7, "seven");
+	soa_struct.push_row(100, "100");
+	// Direct writes have to be marked by hand.
+	soa_struct.a[9] = -9;
+	soa_struct.mark_dirty(&DirtyTestStruct::a, 9);
+	passed &= dirty_rows(soa_struct, &DirtyTestStruct::a) == std::vector<SoaVectorSizeType>{ 5, 9, 100 };
+	passed &= dirty_rows(soa_struct, &DirtyTestStruct::b) == std::vector<SoaVectorSizeType>{ 7, 100 };
+
+	DirtyBlockTestStruct block_struct;
+	for (int i = 0; i < 100; ++i) {
+		block_struct.push_row(i, std::to_string(i));
+	}
+	block_struct.clear_dirty();
+	block_struct.set_a(70, 0);
+	// The block of row 70 is rows 64-127 but the table ends at 99.
+	const std::vector<SoaVectorSizeType> block_rows = dirty_rows(block_struct, &DirtyBlockTestStruct::a);
+	passed &= block_rows.size() == 36 and block_rows.front() == 64 and block_rows.back() == 99 and dirty_rows(block_struct, &DirtyBlockTestStruct::b).empty();
+	std::cout << "SOA for_each_dirty/mark_dirty/clear_dirty: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// A replica that starts out empty gets every row from the first delta and only the changed ones after that.
+	DirtyTestStruct replica;
+	soa_struct.sort_by(&DirtyTestStruct::a);
+	const uint64_t full_size = dirty_sync(soa_struct, replica);
+	passed = std::ranges::equal(replica.a, soa_struct.a) and std::ranges::equal(replica.b, soa_struct.b);
+	soa_struct.set_a(50, 500);
+	soa_struct.push_row(101, "101");
+	const uint64_t delta_size = dirty_sync(soa_struct, replica);
+	passed &= std::ranges::equal(replica.a, soa_struct.a) and std::ranges::equal(replica.b, soa_struct.b) and delta_size < full_size / 2;
+	// A shorter column is truncated.
+	soa_struct.push_a(102);
+	dirty_sync(soa_struct, replica);
+	passed &= replica.a.size() == 103 and replica.b.size() == 102 and replica.get_a(102) == 102;
+
+	std::stringstream delta;
+	soa_struct.set_a(0, 0);
+	soa_struct.export_delta(delta);
+	DirtyTestStruct stale;
+	try {
+		stale.apply_delta(delta);
+		passed = false;
+	} catch (const std::runtime_error &) {
+	}
+	std::cout << "DynamicSOA export_delta/apply_delta: " << (passed ? "Passed\n" : "Failed.\n");
+
+	DirtyMutableTestStruct mutable_struct;
+	DirtyMutableTestStruct mutable_replica;
+	for (int i = 0; i < 100; ++i) {
+		mutable_struct.push_row(i, std::to_string(i));
+	}
+	dirty_sync(mutable_struct, mutable_replica);
+	// Tombstones first, then enough of them to compact.
+	for (SoaVectorSizeType id = 0; id < 20; id += 2) {
+		mutable_struct.erase(id);
+	}
+	mutable_struct.set_a(51, -51);
+	dirty_sync(mutable_struct, mutable_replica);
+	passed = mutable_replica.tombstone_count() == 10 and mutable_replica.a.size() == 100;
+	for (SoaVectorSizeType id = 20; id < 60; id += 2) {
+		mutable_struct.erase(id);
+	}
+	mutable_struct.push_row(100, "100");
+	dirty_sync(mutable_struct, mutable_replica);
+	passed &= mutable_replica.tombstone_count() == 0 and mutable_replica.a.size() == 71 and std::ranges::equal(mutable_replica.b, mutable_struct.b);
+	for (SoaVectorSizeType id = 0; id <= 100; ++id) {
+		const bool erased = id < 60 and id % 2 == 0;
+		try {
+			passed &= mutable_replica.get_a(id) == mutable_struct.get_a(id) and mutable_replica.get_b(id) == std::to_string(id) and !erased;
+		} catch (const std::out_of_range &) {
+			passed &= erased;
+		}
+	}
+	passed &= mutable_replica.push_row(101, "101") == 101;
+
+	DirtySparseTestStruct sparse_struct;
+	DirtySparseTestStruct sparse_replica;
+	std::vector<soa::SoaHandle> handles;
+	for (int i = 0; i < 50; ++i) {
+		handles.push_back(sparse_struct.push_row(i, std::to_string(i)));
+	}
+	dirty_sync(sparse_struct, sparse_replica);
+	sparse_struct.erase(handles[3]);
+	sparse_struct.set_b(handles[10], "ten");
+	dirty_sync(sparse_struct, sparse_replica);
+	passed &= !sparse_replica.contains(handles[3]) and sparse_replica.get_b(handles[10]) == "ten" and sparse_replica.get_a(handles[49]) == 49 and sparse_replica.a.size() == 49;
+
+	DirtyFixedTestStruct fixed_struct;
+	DirtyFixedTestStruct fixed_replica;
+	fixed_struct.init(64);
+	fixed_struct.set_b(63, 6.3);
+	dirty_sync(fixed_struct, fixed_replica);
+	fixed_struct.set_a(1, 1);
+	dirty_sync(fixed_struct, fixed_replica);
+	passed &= fixed_replica.a.size() == 64 and fixed_replica.get_a(1) == 1 and fixed_replica.get_b(63) == 6.3;
+	std::cout << "MutableSOA/SparseSOA/FixedSizeSOA export_delta/apply_delta: " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct EraseTestStruct {
+	MutableSOA(
+		EraseTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct TombstoneTestStruct {
+	using soa_erase_policy = soa::TombstoneErase<50, 1>;
+	MutableSOA(
+		TombstoneTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+// Every id that wasn't erased still reads its own values and every erased one throws.
+template <typename S> bool rows_match_ids(const S &p_soa, SoaVectorSizeType p_id_count, const std::vector<bool> &p_erased) {
+	bool passed = true;
+	for (SoaVectorSizeType id = 0; id < p_id_count; ++id) {
+		try {
+			passed &= p_soa.get_a(id) == int(id) and p_soa.get_b(id) == std::string(24, 'x') + std::to_string(id) and !p_erased[id];
+		} catch (const std::out_of_range &) {
+			passed &= p_erased[id];
+		}
+	}
+	return passed;
+}
+
+inline void erase_test() {
+	const SoaVectorSizeType size = 1000;
+	EraseTestStruct batch_struct;
+	EraseTestStruct loop_struct;
+	for (SoaVectorSizeType i = 0; i < size; ++i) {
+		batch_struct.push_row(int(i), std::string(24, 'x') + std::to_string(i));
+		loop_struct.push_row(int(i), std::string(24, 'x') + std::to_string(i));
+	}
+
+	// Includes a duplicate and an id that doesn't exist, both are ignored.
+	std::vector<SoaVectorSizeType> ids = { 999, 5, 5, 123456 };
+	std::vector<bool> erased(size);
+	erased[999] = erased[5] = true;
+	for (SoaVectorSizeType i = 0; i < size; i += 3) {
+		ids.push_back(i);
+		erased[i] = true;
+	}
+	batch_struct.erase_batch(ids);
+	for (const SoaVectorSizeType id : ids) {
+		loop_struct.erase(id);
+	}
+
+	const SoaVectorSizeType expected_size = SoaVectorSizeType(std::ranges::count(erased, false));
+	bool passed = batch_struct.a.size() == expected_size and batch_struct.b.size() == expected_size and batch_struct.rows().size() == expected_size;
+	passed &= rows_match_ids(batch_struct, size, erased) and rows_match_ids(loop_struct, size, erased);
+	batch_struct.erase_batch({});
+	batch_struct.erase_batch(ids);
+	passed &= batch_struct.a.size() == expected_size;
+
+	// Erasing every row leaves nothing to move.
+	ids.clear();
+	for (SoaVectorSizeType i = 0; i < size; ++i) {
+		ids.push_back(i);
+	}
+	batch_struct.erase_batch(ids);
+	passed &= batch_struct.a.size() == 0 and batch_struct.b.size() == 0 and batch_struct.push_row(7, "7") == size;
+	std::cout << "MutableSOA erase_batch: " << (passed ? "Passed\n" : "Failed.\n");
+
+	TombstoneTestStruct tombstone_struct;
+	for (SoaVectorSizeType i = 0; i < 200; ++i) {
+		tombstone_struct.push_row(int(i), std::string(24, 'x') + std::to_string(i));
+	}
+	std::fill(erased.begin(), erased.end(), false);
+	for (SoaVectorSizeType i = 0; i < 200; i += 4) {
+		tombstone_struct.erase(i);
+		erased[i] = true;
+	}
+	tombstone_struct.erase(0);
+
+	// The rows are still there until the threshold (half the rows) is crossed, only for_each_row skips them.
+	passed = tombstone_struct.tombstone_count() == 50 and tombstone_struct.a.size() == 200 and tombstone_struct.is_tombstone(4) and !tombstone_struct.is_tombstone(5);
+	int64_t sum = 0;
+	SoaVectorSizeType visited = 0;
+	tombstone_struct.for_each_row([&](SoaVectorSizeType p_index) {
+		sum += tombstone_struct.a[p_index];
+		visited++;
+	});
+	passed &= visited == 150 and sum == 19900 - 4900 and rows_match_ids(tombstone_struct, 200, erased);
+
+	// Sorting keeps the tombstones on their rows.
+	tombstone_struct.sort_by(&TombstoneTestStruct::a, std::greater<>());
+	passed &= tombstone_struct.a[0] == 199 and tombstone_struct.is_tombstone(3) and !tombstone_struct.is_tombstone(4) and rows_match_ids(tombstone_struct, 200, erased);
+
+	std::vector<SoaVectorSizeType> more_ids;
+	for (SoaVectorSizeType i = 1; i < 200; i += 4) {
+		more_ids.push_back(i);
+		erased[i] = true;
+	}
+	tombstone_struct.erase_batch(more_ids);
+	passed &= tombstone_struct.tombstone_count() == 0 and tombstone_struct.a.size() == 100 and tombstone_struct.b.size() == 100 and rows_match_ids(tombstone_struct, 200, erased);
+
+	tombstone_struct.erase(2);
+	erased[2] = true;
+	tombstone_struct.compact();
+	passed &= tombstone_struct.tombstone_count() == 0 and tombstone_struct.a.size() == 99 and rows_match_ids(tombstone_struct, 200, erased);
+	std::cout << "MutableSOA tombstone erase/compact/for_each_row: " << (passed ? "Passed\n" : "Failed.\n");
+}
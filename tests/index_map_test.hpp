@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../src/FlatIndexMap.hpp"
+#include "../src/soa.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+
+struct IndexMapMutableTestStruct {
+	MutableSOA(
+		IndexMapMutableTestStruct, 1,
+		int, a
+	)
+};
+
+inline void index_map_test() {
+	soa::FlatIndexMap map;
+	std::unordered_map<SoaVectorSizeType, SoaVectorSizeType> reference;
+	std::mt19937 rng(42);
+
+	bool passed = true;
+	for (int i = 0; i < 100000; ++i) {
+		const SoaVectorSizeType key = rng() % 5000;
+		if (rng() % 3 == 0) {
+			passed &= map.erase(key) == reference.erase(key);
+		} else {
+			map[key] = i;
+			reference[key] = i;
+		}
+	}
+
+	passed &= map.size() == reference.size();
+	for (SoaVectorSizeType key = 0; key < 5000; ++key) {
+		const auto *slot = map.find(key);
+		const auto it = reference.find(key);
+		passed &= (slot == map.end()) == (it == reference.end());
+		if (slot != map.end() and it != reference.end()) {
+			passed &= slot->second == it->second;
+		}
+	}
+	std::cout << "FlatIndexMap matches std::unordered_map: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// The sequential inserts, random lookups and erases the index_map benchmarks of soa_bench time, at a size that keeps the test fast.
+	const SoaVectorSizeType size = 100000;
+	soa::FlatIndexMap large_map;
+	for (SoaVectorSizeType i = 0; i < size; ++i) {
+		large_map[i] = i;
+	}
+	uint64_t sum = 0;
+	uint64_t expected_sum = 0;
+	for (int i = 0; i < 100000; ++i) {
+		const SoaVectorSizeType key = rng() % size;
+		sum += large_map.at(key);
+		expected_sum += key;
+	}
+	for (SoaVectorSizeType i = 0; i < size; i += 2) {
+		large_map.erase(i);
+	}
+	passed = sum == expected_sum and large_map.size() == size / 2 and large_map.find(2) == large_map.end() and large_map.at(99999) == 99999;
+	std::cout << "FlatIndexMap 100k rows insert/lookup/erase: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// EMPTY_KEY marks empty slots, it is never found and can't be inserted. It's also SoaVector::NOT_FOUND, so erase(find(missing)) has to do nothing.
+	soa::FlatIndexMap small_map;
+	small_map[5] = 7;
+	passed = !small_map.contains(soa::FlatIndexMap::EMPTY_KEY) and small_map.find(soa::FlatIndexMap::EMPTY_KEY) == small_map.end();
+	passed &= small_map.erase(soa::FlatIndexMap::EMPTY_KEY) == 0 and small_map.size() == 1 and small_map.at(5) == 7;
+	try {
+		(void)small_map.at(soa::FlatIndexMap::EMPTY_KEY);
+		passed = false;
+	} catch (const std::out_of_range &) {
+	}
+	try {
+		small_map[soa::FlatIndexMap::EMPTY_KEY] = 1;
+		passed = false;
+	} catch (const std::invalid_argument &) {
+	}
+	passed &= small_map.size() == 1;
+
+	IndexMapMutableTestStruct mutable_struct;
+	for (int i = 0; i < 3; ++i) {
+		mutable_struct.push_row(i * 10);
+	}
+	mutable_struct.erase(0);
+	mutable_struct.erase(mutable_struct.a.find(12345));
+	passed &= mutable_struct.a.size() == 2 and mutable_struct.get_a(1) == 10 and mutable_struct.get_a(2) == 20;
+	std::cout << "FlatIndexMap EMPTY_KEY and MutableSOA erase(NOT_FOUND): " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#ifdef SOA_HAS_MMAP
+
+struct MappedTestStruct {
+	MappedSOA(
+		MappedTestStruct, 3,
+		int, a,
+		double, b,
+		uint8_t, c
+	)
+};
+
+// Same member sizes as MappedTestStruct but a different type, open has to reject its files.
+struct MappedOtherTestStruct {
+	MappedSOA(
+		MappedOtherTestStruct, 3,
+		int, a,
+		int64_t, b,
+		uint8_t, c
+	)
+};
+
+inline std::string mapped_test_path(const char *p_name) { return (std::filesystem::temp_directory_path() / p_name).string(); }
+
+inline void mapped_test() {
+	const std::string path = mapped_test_path("soa_mapped_test.bin");
+	bool passed = true;
+	{
+		MappedTestStruct soa_struct;
+		try {
+			soa_struct.push_row(1, 1, 1);
+			passed = false;
+		} catch (const std::logic_error &) {
+		}
+
+		// Grows the file many times from an empty one.
+		soa_struct.create(path.c_str());
+		for (int i = 0; i < 10000; ++i) {
+			soa_struct.push_row(i, i * 0.5, uint8_t(i));
+		}
+		soa_struct.set_b(5, -1);
+		passed &= soa_struct.capacity() >= 10000 and soa_struct.get_a(9999) == 9999 and soa_struct.get_b(5) == -1 and soa_struct.get_c(300) == uint8_t(300);
+		passed &= reinterpret_cast<uintptr_t>(soa_struct.b.ptr()) % SOA_COLUMN_ALIGNMENT == 0;
+	}
+
+	MappedTestStruct opened;
+	opened.open(path.c_str());
+	passed &= opened.is_open() and opened.a.size() == 10000 and opened.c.size() == 10000 and opened.get_a(1234) == 1234 and opened.get_b(5) == -1 and opened.get_b(9999) == 4999.5;
+
+	// Columns move inside the file when it grows or shrinks.
+	opened.push_a(10000);
+	opened.reserve(50000);
+	passed &= opened.capacity() == 50000 and opened.get_a(10000) == 10000 and opened.get_c(9999) == uint8_t(9999) and opened.b.size() == 10000;
+	opened.shrink_to_fit();
+	passed &= opened.capacity() == 10001 and opened.get_a(7777) == 7777 and opened.get_b(7777) == 3888.5;
+	opened.sync();
+	opened.close();
+	passed &= !opened.is_open() and opened.a.size() == 0;
+
+	opened.open(path.c_str());
+	passed &= opened.a.size() == 10001 and opened.b.size() == 10000 and opened.capacity() == 10001 and opened.get_a(10000) == 10000;
+	opened.clear();
+	opened.close();
+	opened.open(path.c_str());
+	passed &= opened.a.size() == 0 and opened.capacity() == 10001;
+	opened.close();
+
+	MappedOtherTestStruct other;
+	try {
+		other.open(path.c_str());
+		passed = false;
+	} catch (const std::runtime_error &) {
+		passed &= !other.is_open();
+	}
+	std::remove(path.c_str());
+	std::cout << "MappedSOA create/open/grow/close: " << (passed ? "Passed\n" : "Failed.\n");
+}
+
+#else
+
+inline void mapped_test() {}
+
+#endif
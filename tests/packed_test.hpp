@@ -0,0 +1,128 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+enum class PackedTestState : uint8_t {
+	Idle,
+	Moving,
+	Attacking,
+	Dead,
+};
+
+// Template arguments with a comma can't be passed to the SOA macros directly.
+using PackedTestStateColumn = soa::Packed<PackedTestState, 2>;
+using PackedTestLevelColumn = soa::Packed<uint8_t, 4>;
+
+struct PackedTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	DynamicSOA(
+		PackedTestStruct, 3,
+		int, a,
+		soa::PackedBool, visible,
+		PackedTestStateColumn, state
+	)
+};
+
+struct PackedMutableTestStruct {
+	MutableSOA(
+		PackedMutableTestStruct, 2,
+		int, a,
+		soa::PackedBool, visible
+	)
+};
+
+struct PackedFixedTestStruct {
+	FixedSizeSOA(
+		PackedFixedTestStruct, 2,
+		soa::PackedBool, visible,
+		PackedTestLevelColumn, level
+	)
+};
+
+inline void packed_test() {
+	using soa::simd::Compare;
+
+	PackedTestStruct soa_struct;
+	for (int i = 0; i < 1000; ++i) {
+		soa_struct.push_row(i, i % 3 == 0, PackedTestState(i % 4));
+	}
+	bool passed = soa_struct.visible.size() == 1000 and soa_struct.get_visible(999) and !soa_struct.get_visible(998) and soa_struct.get_state(6) == PackedTestState::Attacking;
+	soa_struct.set_state(6, PackedTestState::Dead);
+	soa_struct.visible[1] = true;
+	soa_struct.state[7] = soa_struct.state[4];
+	passed &= soa_struct.get_state(6) == PackedTestState::Dead and soa_struct.get_visible(1) and soa_struct.state[7] == PackedTestState::Idle;
+	passed &= soa_struct.get_state(5) == PackedTestState::Moving and soa_struct.get_state(8) == PackedTestState::Idle and soa_struct.get_a(7) == 7;
+	// Every 3rd row plus row 1, row 6 became Dead and row 7 stopped being Dead.
+	passed &= soa_struct.visible.count() == 335 and soa_struct.visible.any() and !soa_struct.visible.all() and !soa_struct.visible.none();
+	passed &= soa_struct.state.count(PackedTestState::Dead) == 250 and soa_struct.state.count(PackedTestState::Attacking) == 249;
+	passed &= soa_struct.visible.find_first() == 0 and soa_struct.visible.find_first(true, 2) == 3 and soa_struct.visible.find_first(false, 0) == 2;
+	passed &= soa_struct.state.find_first(PackedTestState::Dead, 8) == 11 and soa_struct.state.find(PackedTestState::Dead, 1000) == soa::SoaVector<uint8_t>::NOT_FOUND;
+	passed &= soa_struct.memory_report().columns[1].used_bytes() == 16 * 8 and soa_struct.memory_report().columns[2].used_bytes() == 32 * 8;
+	std::cout << "Packed push/get/set/count/find: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// The mask is the one the simd compare and where use, bits after the last row stay 0.
+	soa::simd::BitMask mask;
+	passed = soa_struct.state.equal_mask(PackedTestState::Moving, mask) == 250 and mask.size() == 16 and (mask[0] & 0x3f) == 0x22 and mask[15] >> 40 == 0;
+	passed &= soa_struct.visible.to_mask(true)[0] == soa_struct.visible.words()[0];
+	const soa::Selection<PackedTestStruct> moving = soa_struct.where(&PackedTestStruct::state, Compare::Equal, PackedTestState::Moving);
+	passed &= moving.size() == 250 and moving.indices()[1] == 5;
+	passed &= soa_struct.where(&PackedTestStruct::state, Compare::NotEqual, PackedTestState::Moving).size() == 750;
+	passed &= soa_struct.where(&PackedTestStruct::state, Compare::Greater, PackedTestState::Moving).size() == 499;
+	const auto [visible_a] = soa_struct.where(&PackedTestStruct::visible, [](bool p_visible) { return p_visible; }).select(&PackedTestStruct::a);
+	passed &= visible_a.size() == 335 and visible_a[1] == 1 and visible_a[2] == 3;
+	std::cout << "Packed equal_mask/where: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// Rows, permute, save/load and deltas move the bits with their rows. Only row 6 of the even rows is Dead, 168 odd rows stay visible.
+	for (auto [a, visible, state] : soa_struct.rows()) {
+		if (a % 2 == 0) {
+			visible = state == PackedTestState::Dead;
+		}
+	}
+	soa_struct.sort_by(&PackedTestStruct::a, std::greater<>());
+	passed = soa_struct.get_a(0) == 999 and soa_struct.get_visible(0) and soa_struct.get_state(993) == PackedTestState::Dead and soa_struct.get_visible(993);
+	passed &= !soa_struct.get_visible(994) and soa_struct.get_state(999) == PackedTestState::Idle and soa_struct.visible.count() == 169;
+	std::stringstream stream;
+	soa_struct.save(stream);
+	PackedTestStruct loaded;
+	loaded.load(stream);
+	passed &= std::ranges::equal(loaded.visible, soa_struct.visible) and std::ranges::equal(loaded.state, soa_struct.state) and loaded.a.size() == 1000;
+	loaded.clear_dirty();
+	soa_struct.clear_dirty();
+	soa_struct.set_visible(500, !soa_struct.get_visible(500));
+	soa_struct.push_row(1000, true, PackedTestState::Moving);
+	std::stringstream delta;
+	soa_struct.export_delta(delta);
+	loaded.apply_delta(delta);
+	passed &= std::ranges::equal(loaded.visible, soa_struct.visible) and std::ranges::equal(loaded.state, soa_struct.state) and loaded.visible.size() == 1001;
+	std::cout << "Packed rows/sort/save/load/delta: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// Erase moves the last row's bits into the hole, erase_batch compacts them.
+	PackedMutableTestStruct mutable_struct;
+	std::vector<SoaVectorSizeType> ids;
+	for (int i = 0; i < 200; ++i) {
+		ids.push_back(mutable_struct.push_row(i, i >= 150));
+	}
+	mutable_struct.erase(ids[3]);
+	passed = mutable_struct.get_visible(ids[199]) and mutable_struct.visible[3] and mutable_struct.visible.count() == 50 and mutable_struct.visible.size() == 199;
+	mutable_struct.erase_batch(std::vector<SoaVectorSizeType>(ids.begin() + 140, ids.begin() + 160));
+	passed &= mutable_struct.visible.size() == 179 and mutable_struct.visible.count() == 40;
+	for (int i = 160; i < 200; ++i) {
+		passed &= mutable_struct.get_visible(ids[i]) and mutable_struct.get_a(ids[i]) == i;
+	}
+	passed &= !mutable_struct.get_visible(ids[0]) and !mutable_struct.get_visible(ids[139]);
+
+	// FixedSizeSOA zeroes the words, 4 bit values are masked to 4 bits.
+	PackedFixedTestStruct fixed_struct;
+	fixed_struct.init(100);
+	passed &= fixed_struct.visible.none() and fixed_struct.level.all(0) and fixed_struct.level.size() == 100;
+	fixed_struct.set_level(17, 12);
+	fixed_struct.set_level(18, 0x1f);
+	passed &= fixed_struct.get_level(17) == 12 and fixed_struct.get_level(18) == 15 and fixed_struct.get_level(16) == 0 and fixed_struct.level.count(15) == 1;
+	std::cout << "Packed MutableSOA erase and FixedSizeSOA: " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+struct ParallelTestVector3 {
+	float x{};
+	float y{};
+	float z{};
+};
+
+struct ParallelTestStruct {
+	DynamicSOA(
+		ParallelTestStruct, 3,
+		ParallelTestVector3, position,
+		ParallelTestVector3, velocity,
+		int, id
+	)
+};
+
+inline void parallel_test() {
+	const SoaVectorSizeType size = 100003;
+	ParallelTestStruct soa_struct;
+	soa_struct.reserve(size);
+	for (SoaVectorSizeType i = 0; i < size; ++i) {
+		soa_struct.push_row(ParallelTestVector3{ float(i), 0, 0 }, ParallelTestVector3{ 1, 2, 3 }, int(i));
+	}
+
+	soa::ThreadPool pool(4);
+	std::mutex chunk_mutex;
+	std::vector<SoaVectorSizeType> chunk_starts;
+	uint64_t rows_seen = 0;
+	soa::parallel_for<1000>(
+			pool, soa_struct,
+			[&](SoaVectorSizeType p_first, SoaVectorSizeType p_count, ParallelTestVector3 *p_position, const ParallelTestVector3 *p_velocity, int *p_id) {
+				for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+					p_position[i].x += p_velocity[i].x;
+					p_position[i].y += p_velocity[i].y;
+					p_id[i] -= int(p_first + i);
+				}
+				std::lock_guard lock(chunk_mutex);
+				chunk_starts.push_back(p_first);
+				rows_seen += p_count;
+			},
+			&ParallelTestStruct::position, &ParallelTestStruct::velocity, &ParallelTestStruct::id);
+
+	bool passed = rows_seen == size and chunk_starts.size() > 1;
+	for (const SoaVectorSizeType first : chunk_starts) {
+		// 12 and 4 byte columns, every chunk has to start on a cache line in both.
+		passed &= (first * sizeof(ParallelTestVector3)) % soa::cache_line_size == 0 and (first * sizeof(int)) % soa::cache_line_size == 0;
+	}
+	for (SoaVectorSizeType i = 0; i < size; ++i) {
+		passed &= soa_struct.position[i].x == float(i) + 1 and soa_struct.position[i].y == 2 and soa_struct.id[i] == 0;
+	}
+	std::cout << "Parallel for chunks: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// Read only pass over a const struct, and a nested run on the same pool which has to run on the calling thread instead of deadlocking.
+	const ParallelTestStruct &const_struct = soa_struct;
+	std::atomic<uint64_t> nested_tasks = 0;
+	std::atomic<int64_t> sum = 0;
+	soa::parallel_for<1000>(
+			pool, const_struct,
+			[&](SoaVectorSizeType, SoaVectorSizeType p_count, const ParallelTestVector3 *p_velocity) {
+				int64_t chunk_sum = 0;
+				for (SoaVectorSizeType i = 0; i < p_count; ++i) {
+					chunk_sum += int64_t(p_velocity[i].z);
+				}
+				sum += chunk_sum;
+				pool.run(2, [&](uint64_t) { nested_tasks++; });
+			},
+			&ParallelTestStruct::velocity);
+
+	ParallelTestStruct empty_struct;
+	bool empty_called = false;
+	soa::parallel_for(pool, empty_struct, [&](SoaVectorSizeType, SoaVectorSizeType, int *) { empty_called = true; }, &ParallelTestStruct::id);
+	std::cout << "Parallel for const/nested/empty: " << ((sum == int64_t(size) * 3 and nested_tasks == chunk_starts.size() * 2 and !empty_called) ? "Passed\n" : "Failed.\n");
+}
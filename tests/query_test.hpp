@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum class QueryTestKind : uint8_t {
+	Unit,
+	Building,
+};
+
+struct QueryTestStruct {
+	DynamicSOA(
+		QueryTestStruct, 4,
+		int, a,
+		float, b,
+		std::string, c,
+		QueryTestKind, kind
+	)
+};
+
+struct QueryBoolTestStruct {
+	DynamicSOA(
+		QueryBoolTestStruct, 3,
+		int, a,
+		bool, flag,
+		soa::PackedBool, packed_flag
+	)
+};
+
+struct QueryMutableTestStruct {
+	MutableSOA(
+		QueryMutableTestStruct, 2,
+		int, a,
+		int, b
+	)
+};
+
+inline void query_test() {
+	using soa::simd::Compare;
+
+	QueryTestStruct soa_struct;
+	soa_struct.init(0);
+	for (int i = 0; i < 1000; ++i) {
+		soa_struct.push_row(i % 100, float(i) * 0.5f, std::to_string(i), i % 2 == 0 ? QueryTestKind::Unit : QueryTestKind::Building);
+	}
+
+	bool passed = true;
+	const auto less_than_10 = soa_struct.where(&QueryTestStruct::a, Compare::Less, 10);
+	passed &= less_than_10.size() == 100 and less_than_10.indices()[10] == 100;
+
+	auto [b, c] = less_than_10.select(&QueryTestStruct::b, &QueryTestStruct::c);
+	passed &= b.size() == 100 and c.size() == 100 and b[1] == 0.5f and c[10] == "100" and c.back() == "909";
+
+	// Predicate on 1 column, then refined with 2 more.
+	const auto refined = soa_struct.where(&QueryTestStruct::b, [](float p_b) { return p_b >= 100.0f; })
+								 .where(&QueryTestStruct::kind, Compare::Equal, QueryTestKind::Building)
+								 .where(&QueryTestStruct::c, [](const std::string &p_c) { return p_c.ends_with('1'); });
+	const auto [refined_a] = refined.select(&QueryTestStruct::a);
+	passed &= refined.size() == 80 and refined.indices()[0] == 201 and refined_a[0] == 1;
+
+	// Non arithmetic column with a Compare.
+	passed &= soa_struct.where(&QueryTestStruct::c, Compare::Equal, std::string("500")).indices() == soa::simd::SelectionVector{ 500 };
+	passed &= soa_struct.where(&QueryTestStruct::kind, Compare::NotEqual, QueryTestKind::Unit).size() == 500;
+	passed &= soa_struct.where(&QueryTestStruct::a, Compare::Greater, 1000).empty();
+	std::cout << "Query where/select: " << (passed ? "Passed\n" : "Failed.\n");
+
+	float batch_sum = 0;
+	SoaVectorSizeType batches = 0;
+	SoaVectorSizeType batch_rows = 0;
+	less_than_10.for_each_batch<16>(
+			[&](std::span<const SoaVectorSizeType> p_rows, std::span<const float> p_b, std::span<const int> p_a) {
+				batches++;
+				batch_rows += SoaVectorSizeType(p_rows.size());
+				for (uint64_t i = 0; i < p_rows.size(); ++i) {
+					batch_sum += p_b[i] + float(p_a[i]);
+				}
+			},
+			&QueryTestStruct::b, &QueryTestStruct::a);
+	float expected_sum = 0;
+	for (const SoaVectorSizeType row : less_than_10.indices()) {
+		expected_sum += soa_struct.b[row] + float(soa_struct.a[row]);
+	}
+	passed = batches == 7 and batch_rows == 100 and batch_sum == expected_sum;
+
+	// bool and PackedBool columns are gathered into bool arrays.
+	QueryBoolTestStruct bool_struct;
+	for (int i = 0; i < 100; ++i) {
+		bool_struct.push_row(i, i % 3 == 0, i % 5 == 0);
+	}
+	SoaVectorSizeType flags = 0;
+	SoaVectorSizeType packed_flags = 0;
+	bool_struct.where(&QueryBoolTestStruct::a, Compare::GreaterEqual, 10)
+			.for_each_batch<32>(
+					[&](std::span<const SoaVectorSizeType> p_rows, std::span<const bool> p_flag, std::span<const bool> p_packed_flag) {
+						for (uint64_t i = 0; i < p_rows.size(); ++i) {
+							flags += p_flag[i];
+							packed_flags += p_packed_flag[i];
+						}
+					},
+					&QueryBoolTestStruct::flag, &QueryBoolTestStruct::packed_flag);
+	passed &= flags == 30 and packed_flags == 18;
+	std::cout << "Query for_each_batch: " << (passed ? "Passed\n" : "Failed.\n");
+
+	QueryMutableTestStruct mutable_struct;
+	mutable_struct.init(0);
+	for (int i = 0; i < 10; ++i) {
+		mutable_struct.push_row(i, i * 10);
+	}
+	mutable_struct.erase(0);
+	// Selections hold row indices, the last row was moved into row 0 by the erase.
+	const auto mutable_selection = mutable_struct.where(&QueryMutableTestStruct::a, Compare::GreaterEqual, 8);
+	const auto [mutable_b] = mutable_selection.select(&QueryMutableTestStruct::b);
+	std::cout << "Query on MutableSOA: " << ((mutable_selection.indices() == soa::simd::SelectionVector{ 0, 8 } and mutable_b == std::vector<int>{ 90, 80 }) ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../src/soa.hpp"
+#include "test_types.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct ReserveTestStruct {
+	using soa_allocator_policy = soa::VirtualReserveAllocator<1 << 20>;
+	DynamicSOA(
+		ReserveTestStruct, 3,
+		int, a,
+		std::string, b,
+		Vector2, c
+	)
+};
+
+struct ReserveMutableTestStruct {
+	using soa_allocator_policy = soa::VirtualReserveAllocator<1 << 16>;
+	MutableSOA(
+		ReserveMutableTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct ReserveSparseTestStruct {
+	using soa_allocator_policy = soa::VirtualReserveAllocator<1 << 16>;
+	SparseSOA(
+		ReserveSparseTestStruct, 2,
+		int, a,
+		double, b
+	)
+};
+
+struct alignas(8192) ReservePageAlignedValue {
+	int value;
+};
+
+struct ReserveAlignedTestStruct {
+	using soa_allocator_policy = soa::VirtualReserveAllocator<64>;
+	DynamicSOA(
+		ReserveAlignedTestStruct, 2,
+		char, a,
+		ReservePageAlignedValue, b
+	)
+};
+
+inline void reserve_test() {
+	ReserveTestStruct soa_struct;
+	soa_struct.push_row(0, "0", Vector2{ 0, 0 });
+	const int *a_start = soa_struct.a.ptr();
+	const std::string *b_start = soa_struct.b.ptr();
+	const std::string *first_b = &soa_struct.b[0];
+	bool passed = true;
+	for (int i = 1; i < 100000; ++i) {
+		soa_struct.push_row(i, std::to_string(i), Vector2{ float(i), 0 });
+		passed &= soa_struct.a.ptr() == a_start and soa_struct.b.ptr() == b_start;
+	}
+	passed &= *first_b == "0" and soa_struct.get_b(99999) == "99999" and soa_struct.get_c(5000).x == 5000.0f and uint64_t(a_start) % 4096 == 0;
+	// Giving pages back and committing them again keeps the columns where they are.
+	soa_struct.shrink_to_fit();
+	soa_struct.reserve(200000);
+	soa_struct.push_row(-1, "last", Vector2{});
+	passed &= soa_struct.a.ptr() == a_start and soa_struct.get_a(100000) == -1 and soa_struct.get_b(12345) == "12345";
+	std::cout << "VirtualReserveAllocator DynamicSOA: " << (passed ? "Passed\n" : "Failed.\n");
+
+	ReserveMutableTestStruct mutable_struct;
+	std::vector<SoaVectorSizeType> ids;
+	for (int i = 0; i < 5000; ++i) {
+		ids.push_back(mutable_struct.push_row(i, std::to_string(i)));
+	}
+	const int *mutable_start = mutable_struct.a.ptr();
+	for (int i = 0; i < 5000; i += 2) {
+		mutable_struct.erase(ids[i]);
+	}
+	for (int i = 0; i < 5000; ++i) {
+		mutable_struct.push_row(i, "again");
+	}
+	passed = mutable_struct.a.ptr() == mutable_start and mutable_struct.a.size() == 7500 and mutable_struct.get_b(ids[4999]) == "4999";
+	// clear gives the whole reservation back, the next push reserves a new one.
+	mutable_struct.clear();
+	mutable_struct.push_row(1, "1");
+	passed &= mutable_struct.a.size() == 1 and mutable_struct.a[0] == 1;
+
+	ReserveSparseTestStruct sparse_struct;
+	std::vector<soa::SoaHandle> handles;
+	for (int i = 0; i < 3000; ++i) {
+		handles.push_back(sparse_struct.push_row(i, i * 0.25));
+	}
+	sparse_struct.erase(handles[0]);
+	passed &= sparse_struct.get_b(handles[2999]) == 2999 * 0.25 and sparse_struct.a.size() == 2999;
+
+	ReserveAlignedTestStruct aligned_struct;
+	for (int i = 0; i < 64; ++i) {
+		aligned_struct.push_row(char(i), ReservePageAlignedValue{ i });
+	}
+	passed &= aligned_struct.get_b(63).value == 63 and uint64_t(aligned_struct.b.ptr()) % 8192 == 0 and aligned_struct.capacity() == 64;
+	try {
+		aligned_struct.push_row('x', ReservePageAlignedValue{ 64 });
+		passed = false;
+	} catch (const std::length_error &) {
+	}
+	std::cout << "VirtualReserveAllocator MutableSOA/SparseSOA: " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <ranges>
+#include <string>
+
+struct RowsTestStruct {
+	DynamicSOA(
+		RowsTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct RowsMutableTestStruct {
+	MutableSOA(
+		RowsMutableTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct RowsSparseTestStruct {
+	SparseSOA(
+		RowsSparseTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct RowsTiledTestStruct {
+	TiledSOA(
+		RowsTiledTestStruct, 2, 8,
+		int, a,
+		std::string, b
+	)
+};
+
+static_assert(std::ranges::random_access_range<decltype(std::declval<RowsTestStruct &>().rows())>);
+static_assert(std::ranges::random_access_range<decltype(std::declval<const RowsTiledTestStruct &>().rows())>);
+
+inline void rows_test() {
+	RowsTestStruct soa_struct;
+	for (int i = 0; i < 20; ++i) {
+		soa_struct.push_row(i, std::to_string(i));
+	}
+
+	// The proxy only holds references, writing through it writes the columns.
+	auto [a, b] = soa_struct.row(3);
+	a = 30;
+	b += "!";
+	bool passed = soa_struct.a[3] == 30 and soa_struct.b[3] == "3!" and &soa_struct.row(5).b == &soa_struct.b[5];
+
+	int sum = 0;
+	for (auto [row_a, row_b] : soa_struct.rows()) {
+		sum += row_a;
+		row_b.clear();
+	}
+	const RowsTestStruct &const_struct = soa_struct;
+	passed &= sum == 217 and soa_struct.b[19].empty() and const_struct.rows().size() == 20 and const_struct.rows()[19].a == 19;
+	passed &= std::ranges::count_if(const_struct.rows(), [](auto p_row) { return p_row.a % 2 == 0; }) == 11 and (*(const_struct.rows().end() - 1)).a == 19;
+	std::cout << "Rows DynamicSOA row/rows: " << (passed ? "Passed\n" : "Failed.\n");
+
+	RowsMutableTestStruct mutable_struct;
+	RowsSparseTestStruct sparse_struct;
+	RowsTiledTestStruct tiled_struct;
+	soa::SoaHandle first_handle{};
+	soa::SoaHandle handle{};
+	for (int i = 0; i < 20; ++i) {
+		mutable_struct.push_row(i, std::to_string(i));
+		const soa::SoaHandle new_handle = sparse_struct.push_row(i, std::to_string(i));
+		tiled_struct.push_row(i, std::to_string(i));
+		if (i == 0) {
+			first_handle = new_handle;
+		} else if (i == 10) {
+			handle = new_handle;
+		}
+	}
+	mutable_struct.erase(0);
+	sparse_struct.erase(first_handle);
+
+	// row() takes an entity id or handle like get_X, rows() goes over the rows in storage order.
+	passed = mutable_struct.row(19).b == "19" and mutable_struct.rows().size() == 19 and mutable_struct.rows()[0].a == 19;
+	passed &= sparse_struct.row(handle).b == "10" and sparse_struct.rows().size() == 19;
+	const auto second_block = *++tiled_struct.blocks().begin();
+	passed &= tiled_struct.row(17).b == "17" and tiled_struct.rows().size() == 20 and &tiled_struct.rows()[9].a == &second_block.a()[1];
+	std::cout << "Rows Mutable/Sparse/Tiled row/rows: " << (passed ? "Passed\n" : "Failed.\n");
+}
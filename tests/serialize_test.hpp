@@ -0,0 +1,268 @@
+#pragma once
+
+#include "../src/soa.hpp"
+#include "mapped_test.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+enum class SerializeTestColor : uint8_t {
+	Red,
+	Green,
+	Blue,
+};
+
+struct SerializeTestStruct {
+	DynamicSOA(
+		SerializeTestStruct, 8,
+		int, id,
+		int, category,
+		int64_t, noise,
+		float, value,
+		SerializeTestColor, color,
+		bool, flag,
+		std::string, name,
+		std::vector<int>, tags
+	)
+};
+
+// Same columns as SerializeTestStruct except the last one, load has to reject its streams.
+struct SerializeOtherTestStruct {
+	DynamicSOA(
+		SerializeOtherTestStruct, 8,
+		int, id,
+		int, category,
+		int64_t, noise,
+		float, value,
+		SerializeTestColor, color,
+		bool, flag,
+		std::string, name,
+		std::vector<float>, tags
+	)
+};
+
+// Counts the live allocations of the vectors using it and throws std::bad_alloc once serialize_test_allocations_left runs out.
+inline int serialize_test_live_allocations = 0;
+inline int serialize_test_allocations_left = 0;
+
+template <typename T> struct SerializeTestAllocator {
+	using value_type = T;
+
+	SerializeTestAllocator() = default;
+	template <typename U> SerializeTestAllocator(const SerializeTestAllocator<U> &) {}
+
+	T *allocate(size_t p_count) {
+		if (serialize_test_allocations_left-- <= 0) {
+			throw std::bad_alloc();
+		}
+		serialize_test_live_allocations++;
+		return std::allocator<T>().allocate(p_count);
+	}
+	void deallocate(T *p_data, size_t p_count) {
+		serialize_test_live_allocations--;
+		std::allocator<T>().deallocate(p_data, p_count);
+	}
+	template <typename U> bool operator==(const SerializeTestAllocator<U> &) const { return true; }
+};
+
+struct SerializeMutableTestStruct {
+	using soa_erase_policy = soa::TombstoneErase<90>;
+	MutableSOA(
+		SerializeMutableTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct SerializeSparseTestStruct {
+	SparseSOA(
+		SerializeSparseTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct SerializeFixedTestStruct {
+	FixedSizeSOA(
+		SerializeFixedTestStruct, 2,
+		uint16_t, a,
+		double, b
+	)
+};
+
+struct SerializeTiledTestStruct {
+	TiledSOA(
+		SerializeTiledTestStruct, 2, 8,
+		int, a,
+		std::string, b
+	)
+};
+
+template <typename S> bool serialize_columns_match(const S &p_a, const S &p_b) {
+	return std::ranges::equal(p_a.id, p_b.id) and std::ranges::equal(p_a.category, p_b.category) and std::ranges::equal(p_a.noise, p_b.noise) and
+			std::ranges::equal(p_a.value, p_b.value) and std::ranges::equal(p_a.color, p_b.color) and std::ranges::equal(p_a.flag, p_b.flag) and
+			std::ranges::equal(p_a.name, p_b.name) and std::ranges::equal(p_a.tags, p_b.tags);
+}
+
+inline void serialize_test() {
+	std::mt19937_64 rng(5);
+	SerializeTestStruct soa_struct;
+	const int size = 5000;
+	uint64_t raw_size = 0;
+	for (int i = 0; i < size; ++i) {
+		// Extreme values so the deltas wrap around.
+		const int64_t noise = i % 7 == 0 ? std::numeric_limits<int64_t>::min() : i % 11 == 0 ? std::numeric_limits<int64_t>::max() : int64_t(rng());
+		std::vector<int> tags(size_t(i % 4), -i);
+		std::string name = "name" + std::to_string(i);
+		raw_size += sizeof(int) * 2 + sizeof(int64_t) + sizeof(float) + 2 + name.size() + tags.size() * sizeof(int);
+		soa_struct.push_row(i, i / 1000, noise, float(i) * 0.25f, SerializeTestColor(i % 3), i % 2 == 0, std::move(name), tags);
+	}
+	// A shorter column is saved with its own size.
+	soa_struct.push_id(size);
+
+	std::stringstream stream;
+	soa_struct.save(stream);
+	const uint64_t stream_size = stream.str().size();
+	SerializeTestStruct loaded;
+	loaded.push_row(-1, -1, -1, -1, SerializeTestColor::Red, true, "old row", {});
+	loaded.load(stream);
+	bool passed = serialize_columns_match(soa_struct, loaded) and loaded.id.size() == size + 1 and loaded.name.size() == size and loaded.capacity() >= size + 1;
+	// Sequential ids are delta encoded into a few bits and category is 5 runs, that pays for the lengths of name and tags.
+	passed &= stream_size < raw_size;
+
+	SerializeTestStruct empty_struct;
+	std::stringstream empty_stream;
+	empty_struct.save(empty_stream);
+	loaded.load(empty_stream);
+	passed &= loaded.id.size() == 0 and loaded.tags.size() == 0;
+
+	stream.seekg(0);
+	SerializeOtherTestStruct other;
+	try {
+		other.load(stream);
+		passed = false;
+	} catch (const std::runtime_error &) {
+	}
+	// A stream that fails partway through clears the table, no column keeps rows the others don't have.
+	for (const uint64_t truncated_size : { stream_size / 2, stream_size - 10 }) {
+		std::stringstream truncated(stream.str().substr(0, truncated_size));
+		try {
+			loaded.load(truncated);
+			passed = false;
+		} catch (const std::runtime_error &) {
+		}
+		passed &= loaded.id.size() == 0 and loaded.name.size() == 0 and loaded.tags.size() == 0;
+	}
+	loaded.push_row(1, 2, 3, 4.0f, SerializeTestColor::Blue, false, "after", { 5 });
+	passed &= loaded.id.size() == 1 and loaded.get_id(0) == 1 and loaded.get_name(0) == "after" and loaded.get_tags(0).size() == 1;
+	// A row that throws while it's constructed takes the rows before it with it instead of leaking them.
+	using CountedVector = std::vector<int, SerializeTestAllocator<int>>;
+	serialize_test_allocations_left = 100;
+	{
+		const std::vector<CountedVector> counted_rows(10, CountedVector { 1, 2, 3 });
+		std::stringstream counted_stream;
+		soa::write_column(counted_stream, "counted", counted_rows.data(), 10);
+		const int live_allocations = serialize_test_live_allocations;
+		serialize_test_allocations_left = 5;
+		soa::detail::UninitializedBuffer<CountedVector> counted_loaded(10);
+		try {
+			counted_loaded.constructed = soa::read_column(counted_stream, "counted", counted_loaded.data(), 10);
+			passed = false;
+		} catch (const std::bad_alloc &) {
+		}
+		passed &= counted_loaded.constructed == 0 and serialize_test_live_allocations == live_allocations;
+	}
+	passed &= serialize_test_live_allocations == 0;
+	std::cout << "DynamicSOA save/load: " << (passed ? "Passed\n" : "Failed.\n");
+
+	SerializeMutableTestStruct mutable_struct;
+	SerializeSparseTestStruct sparse_struct;
+	std::vector<soa::SoaHandle> handles;
+	for (int i = 0; i < 100; ++i) {
+		mutable_struct.push_row(i, std::to_string(i));
+		handles.push_back(sparse_struct.push_row(i, std::to_string(i)));
+	}
+	for (int i = 0; i < 100; i += 3) {
+		mutable_struct.erase(SoaVectorSizeType(i));
+		sparse_struct.erase(handles[i]);
+	}
+	std::stringstream mutable_stream;
+	std::stringstream sparse_stream;
+	mutable_struct.save(mutable_stream);
+	sparse_struct.save(sparse_stream);
+	SerializeMutableTestStruct loaded_mutable;
+	SerializeSparseTestStruct loaded_sparse;
+	loaded_mutable.load(mutable_stream);
+	loaded_sparse.load(sparse_stream);
+
+	// Ids, handles and tombstones are saved with the rows, new ids and handles continue where they were.
+	passed = loaded_mutable.tombstone_count() == 34 and loaded_mutable.push_row(100, "100") == 100 and loaded_sparse.rows().size() == 66;
+	for (int i = 0; i < 100; ++i) {
+		if (i % 3 == 0) {
+			passed &= !loaded_sparse.contains(handles[i]);
+		} else {
+			passed &= loaded_mutable.get_b(SoaVectorSizeType(i)) == std::to_string(i) and loaded_sparse.get_b(handles[i]) == std::to_string(i);
+		}
+	}
+	// The ids and handles are the last thing in the stream, a load that fails on them clears them with the columns.
+	std::stringstream truncated_mutable(mutable_stream.str().substr(0, mutable_stream.str().size() - 10));
+	std::stringstream truncated_sparse(sparse_stream.str().substr(0, sparse_stream.str().size() - 10));
+	try {
+		loaded_mutable.load(truncated_mutable);
+		passed = false;
+	} catch (const std::runtime_error &) {
+	}
+	try {
+		loaded_sparse.load(truncated_sparse);
+		passed = false;
+	} catch (const std::runtime_error &) {
+	}
+	passed &= loaded_mutable.a.size() == 0 and loaded_mutable.b.size() == 0 and loaded_sparse.a.size() == 0 and loaded_sparse.rows().size() == 0;
+	const SoaVectorSizeType new_id = loaded_mutable.push_row(7, "7");
+	const soa::SoaHandle new_handle = loaded_sparse.push_row(7, "7");
+	passed &= loaded_mutable.get_b(new_id) == "7" and loaded_mutable.a.size() == 1 and loaded_sparse.get_b(new_handle) == "7" and !loaded_sparse.contains(handles[1]);
+	std::cout << "MutableSOA/SparseSOA save/load: " << (passed ? "Passed\n" : "Failed.\n");
+
+	SerializeFixedTestStruct fixed_struct;
+	fixed_struct.init(300);
+	SerializeTiledTestStruct tiled_struct;
+	for (int i = 0; i < 300; ++i) {
+		fixed_struct.set_a(SoaVectorSizeType(i), uint16_t(i * 7));
+		fixed_struct.set_b(SoaVectorSizeType(i), i * 0.5);
+		tiled_struct.push_row(i, std::to_string(i));
+	}
+	std::stringstream fixed_stream;
+	std::stringstream tiled_stream;
+	fixed_struct.save(fixed_stream);
+	tiled_struct.save(tiled_stream);
+	SerializeFixedTestStruct loaded_fixed;
+	SerializeTiledTestStruct loaded_tiled;
+	loaded_fixed.load(fixed_stream);
+	loaded_tiled.load(tiled_stream);
+	passed = loaded_fixed.a.size() == 300 and std::ranges::equal(loaded_fixed.a, fixed_struct.a) and std::ranges::equal(loaded_fixed.b, fixed_struct.b);
+	passed &= loaded_tiled.size() == 300 and loaded_tiled.get_a(299) == 299 and loaded_tiled.get_b(123) == "123";
+#ifdef SOA_HAS_MMAP
+	const std::string path = mapped_test_path("soa_serialize_test.bin");
+	MappedTestStruct mapped_struct;
+	mapped_struct.create(path.c_str());
+	for (int i = 0; i < 1000; ++i) {
+		mapped_struct.push_row(i, i * 2.0, uint8_t(i % 4));
+	}
+	std::stringstream mapped_stream;
+	mapped_struct.save(mapped_stream);
+	mapped_struct.clear();
+	mapped_struct.load(mapped_stream);
+	passed &= mapped_struct.a.size() == 1000 and mapped_struct.get_b(999) == 1998.0 and mapped_struct.get_c(7) == 3;
+	mapped_struct.close();
+	std::remove(path.c_str());
+#endif
+	std::cout << "FixedSizeSOA/TiledSOA/MappedSOA save/load: " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "../src/SoaSimd.hpp"
+#include "../src/soa.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct SimdTestStruct {
+	DynamicSOA(
+		SimdTestStruct, 2,
+		float, x,
+		int, id
+	)
+};
+
+template <typename T> bool simd_kernels_match_scalar() {
+	using namespace soa::simd;
+	std::mt19937 rng(42);
+
+	bool passed = true;
+	for (const uint64_t size : { 0, 1, 7, 64, 65, 1000, 1031 }) {
+		std::vector<T> x(size);
+		std::vector<T> y(size);
+		for (uint64_t i = 0; i < size; ++i) {
+			// Small whole numbers so float sums are exact no matter what order they are added in.
+			x[i] = static_cast<T>(std::is_signed_v<T> ? int(rng() % 200) - 100 : int(rng() % 200));
+			y[i] = static_cast<T>(rng() % 50);
+		}
+
+		sum_type<T> expected_sum = 0;
+		T expected_min = std::numeric_limits<T>::max();
+		T expected_max = std::numeric_limits<T>::lowest();
+		for (const T value : x) {
+			expected_sum += value;
+			expected_min = std::min(expected_min, value);
+			expected_max = std::max(expected_max, value);
+		}
+		passed &= sum(x.data(), size) == expected_sum;
+		passed &= min(x.data(), size) == expected_min;
+		passed &= max(x.data(), size) == expected_max;
+
+		const T value = static_cast<T>(10);
+		BitMask mask;
+		for (const Compare op : { Compare::Equal, Compare::NotEqual, Compare::Less, Compare::LessEqual, Compare::Greater, Compare::GreaterEqual }) {
+			const uint64_t matches = compare(x.data(), size, op, value, mask);
+			uint64_t expected_matches = 0;
+			passed &= mask.size() == (size + 63) / 64;
+			for (uint64_t i = 0; i < mask.size() * 64; ++i) {
+				bool expected = false;
+				if (i < size) {
+					switch (op) {
+						case Compare::Equal:        expected = x[i] == value; break;
+						case Compare::NotEqual:     expected = x[i] != value; break;
+						case Compare::Less:         expected = x[i] < value; break;
+						case Compare::LessEqual:    expected = x[i] <= value; break;
+						case Compare::Greater:      expected = x[i] > value; break;
+						case Compare::GreaterEqual: expected = x[i] >= value; break;
+					}
+				}
+				expected_matches += expected;
+				passed &= bool((mask[i / 64] >> (i % 64)) & 1) == expected;
+			}
+			passed &= matches == expected_matches;
+		}
+
+		std::vector<T> expected_y = y;
+		for (uint64_t i = 0; i < size; ++i) {
+			expected_y[i] = static_cast<T>(T(3) * x[i] + expected_y[i]);
+		}
+		axpy(T(3), x.data(), y.data(), size);
+		passed &= y == expected_y;
+
+		fill(y.data(), size, T(7));
+		passed &= std::ranges::all_of(y, [](T p_value) { return p_value == T(7); });
+	}
+	return passed;
+}
+
+template <typename T> bool simd_search_matches_scalar() {
+	using namespace soa::simd;
+	std::mt19937 rng(7);
+
+	bool passed = true;
+	for (const uint64_t size : { 0, 1, 7, 64, 65, 1000, 1031 }) {
+		std::vector<T> x(size);
+		for (uint64_t i = 0; i < size; ++i) {
+			x[i] = static_cast<T>(rng() % 100);
+		}
+
+		for (const T value : { T(0), T(42), T(99), T(100) }) {
+			const uint64_t expected_find = std::ranges::find(x, value) - x.begin();
+			passed &= find(x.data(), size, value) == expected_find;
+			passed &= count_equal(x.data(), size, value) == uint64_t(std::ranges::count(x, value));
+
+			SelectionVector indices;
+			find_all(x.data(), size, value, indices);
+			SelectionVector expected_indices;
+			for (uint64_t i = 0; i < size; ++i) {
+				if (x[i] == value) {
+					expected_indices.push_back(SoaVectorSizeType(i));
+				}
+			}
+			passed &= indices == expected_indices;
+		}
+
+		// More than 8 values so find_any_of needs more than 1 pass.
+		std::vector<T> values;
+		for (int k = 0; k < 11; ++k) {
+			values.push_back(static_cast<T>(rng() % 120));
+		}
+		for (const uint64_t values_count : { 0, 1, 3, 11 }) {
+			uint64_t expected = size;
+			for (uint64_t i = 0; i < size and expected == size; ++i) {
+				if (std::find(values.begin(), values.begin() + values_count, x[i]) != values.begin() + values_count) {
+					expected = i;
+				}
+			}
+			passed &= find_any_of(x.data(), size, values.data(), values_count) == expected;
+		}
+	}
+	return passed;
+}
+
+enum class SimdTestEnum : uint16_t {
+	A,
+	B,
+	C,
+};
+
+struct SimdSearchTestStruct {
+	DynamicSOA(
+		SimdSearchTestStruct, 3,
+		int, id,
+		SimdTestEnum, kind,
+		std::string, name
+	)
+};
+
+inline void simd_search_test() {
+	using namespace soa::simd;
+
+	bool passed = true;
+	for (const Isa isa : { Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512 }) {
+		if (isa > detected_isa()) {
+			break;
+		}
+		set_isa(isa);
+		passed &= simd_search_matches_scalar<int8_t>() and simd_search_matches_scalar<uint16_t>() and simd_search_matches_scalar<int32_t>();
+		passed &= simd_search_matches_scalar<uint64_t>() and simd_search_matches_scalar<float>() and simd_search_matches_scalar<double>();
+	}
+	set_isa(detected_isa());
+	std::cout << "SIMD search kernels match scalar: " << (passed ? "Passed\n" : "Failed.\n");
+
+	SimdSearchTestStruct soa_struct;
+	soa_struct.init(0);
+	for (int i = 0; i < 200; ++i) {
+		soa_struct.push_row(i, SimdTestEnum(i % 3), std::to_string(i % 5));
+	}
+	constexpr auto NOT_FOUND = soa::SoaVector<int>::NOT_FOUND;
+	bool column_passed = soa_struct.id.find(150) == 150 and soa_struct.id.find(5, 6) == NOT_FOUND and soa_struct.id.find(-1) == NOT_FOUND and soa_struct.id.find(0, 500) == NOT_FOUND;
+	column_passed &= soa_struct.id.has(199) and !soa_struct.id.has(200);
+	column_passed &= soa_struct.kind.count_equal(SimdTestEnum::C) == 66 and soa_struct.kind.find(SimdTestEnum::C, 3) == 5;
+	const SelectionVector kind_b = soa_struct.kind.find_all(SimdTestEnum::B);
+	column_passed &= kind_b.size() == 67 and kind_b[0] == 1 and kind_b[1] == 4 and kind_b.back() == 199;
+	column_passed &= soa_struct.id.find_any_of({ 300, 120, 80 }) == 80 and soa_struct.id.find_any_of({ 300, 120, 80 }, 81) == 120 and soa_struct.id.find_any_of({}) == NOT_FOUND;
+	// Non arithmetic columns use the plain loops.
+	column_passed &= soa_struct.name.find("3") == 3 and soa_struct.name.count_equal("4") == 40;
+	column_passed &= soa_struct.name.find_all("0").size() == 40 and soa_struct.name.find_any_of({ "9", "2" }) == 2;
+	std::cout << "SoaVector find/has/count_equal/find_all/find_any_of: " << (column_passed ? "Passed\n" : "Failed.\n");
+}
+
+inline void simd_test() {
+	using namespace soa::simd;
+
+	bool passed = true;
+	for (const Isa isa : { Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512 }) {
+		if (isa > detected_isa()) {
+			break;
+		}
+		set_isa(isa);
+		passed &= active_isa() == isa;
+		passed &= simd_kernels_match_scalar<int8_t>() and simd_kernels_match_scalar<uint8_t>() and simd_kernels_match_scalar<int16_t>();
+		passed &= simd_kernels_match_scalar<int32_t>() and simd_kernels_match_scalar<uint32_t>() and simd_kernels_match_scalar<int64_t>();
+		passed &= simd_kernels_match_scalar<float>() and simd_kernels_match_scalar<double>();
+	}
+	set_isa(detected_isa());
+	std::cout << "SIMD kernels match scalar: " << (passed ? "Passed\n" : "Failed.\n");
+
+	SimdTestStruct soa_struct;
+	soa_struct.init(0);
+	for (int i = 0; i < 100; ++i) {
+		soa_struct.push_row(float(i), i % 10);
+	}
+	BitMask mask;
+	bool column_passed = sum(soa_struct.id) == 450 and max(soa_struct.x) == 99.0f and compare(soa_struct.id, Compare::Equal, 3, mask) == 10;
+	fill(soa_struct.x, 2.0f);
+	axpy(2, soa_struct.id, soa_struct.id);
+	column_passed &= sum(soa_struct.x) == 200.0f and sum(soa_struct.id) == 1350;
+	std::cout << "SIMD kernels on SoaVector columns: " << (column_passed ? "Passed\n" : "Failed.\n");
+}
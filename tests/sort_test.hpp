@@ -0,0 +1,139 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct SortTestStruct {
+	DynamicSOA(
+		SortTestStruct, 3,
+		int, key,
+		float, weight,
+		std::string, name
+	)
+};
+
+struct SortMutableTestStruct {
+	MutableSOA(
+		SortMutableTestStruct, 2,
+		int, key,
+		std::string, name
+	)
+};
+
+struct SortSparseTestStruct {
+	SparseSOA(
+		SortSparseTestStruct, 2,
+		int, key,
+		std::string, name
+	)
+};
+
+// The radix sort has to give the exact same order as a stable comparison sort.
+template <typename T> bool radix_sort_matches_stable_sort(std::mt19937 &p_rng) {
+	bool passed = true;
+	for (const SoaVectorSizeType size : { 0, 1, 2, 100, 5000 }) {
+		std::vector<T> keys(size);
+		for (T &key : keys) {
+			if constexpr (std::is_floating_point_v<T>) {
+				key = T(std::uniform_real_distribution<double>(-1000, 1000)(p_rng));
+			} else {
+				// Only a few distinct values so there are lots of ties.
+				key = T(int64_t(p_rng() % 64) - (std::is_signed_v<T> ? 32 : 0));
+			}
+		}
+
+		soa::Permutation expected(size);
+		std::iota(expected.begin(), expected.end(), SoaVectorSizeType(0));
+		std::ranges::stable_sort(expected, [&](SoaVectorSizeType p_a, SoaVectorSizeType p_b) { return keys[p_a] < keys[p_b]; });
+		passed &= soa::sort_permutation(keys.data(), size) == expected;
+
+		std::iota(expected.begin(), expected.end(), SoaVectorSizeType(0));
+		std::ranges::stable_sort(expected, [&](SoaVectorSizeType p_a, SoaVectorSizeType p_b) { return keys[p_a] > keys[p_b]; });
+		passed &= soa::sort_permutation(keys.data(), size, std::greater<>()) == expected;
+	}
+	return passed;
+}
+
+inline void sort_test() {
+	std::mt19937 rng(7);
+	bool passed = radix_sort_matches_stable_sort<int8_t>(rng) and radix_sort_matches_stable_sort<uint16_t>(rng) and radix_sort_matches_stable_sort<int>(rng) and
+			radix_sort_matches_stable_sort<uint64_t>(rng) and radix_sort_matches_stable_sort<int64_t>(rng) and radix_sort_matches_stable_sort<float>(rng) and
+			radix_sort_matches_stable_sort<double>(rng);
+	std::cout << "Sort radix matches stable_sort: " << (passed ? "Passed\n" : "Failed.\n");
+
+	SortTestStruct soa_struct;
+	for (int i = 0; i < 1000; ++i) {
+		const int key = int(rng() % 200) - 100;
+		soa_struct.push_row(key, float(i), std::string(20, 'x') + std::to_string(key));
+	}
+
+	soa_struct.sort_by(&SortTestStruct::key);
+	passed = std::ranges::is_sorted(soa_struct.key);
+	for (SoaVectorSizeType i = 0; i < 1000; ++i) {
+		// Every row still has its own name and equal keys kept their push order.
+		passed &= soa_struct.name[i] == std::string(20, 'x') + std::to_string(soa_struct.key[i]);
+		if (i > 0 and soa_struct.key[i] == soa_struct.key[i - 1]) {
+			passed &= soa_struct.weight[i] > soa_struct.weight[i - 1];
+		}
+	}
+
+	soa_struct.sort_by(&SortTestStruct::weight, std::greater<>());
+	passed &= soa_struct.weight[0] == 999 and soa_struct.weight[999] == 0 and soa_struct.name[0] == std::string(20, 'x') + std::to_string(soa_struct.key[0]);
+
+	soa_struct.sort_by(&SortTestStruct::name, [](const std::string &p_a, const std::string &p_b) { return p_a.size() < p_b.size(); });
+	passed &= soa_struct.name[0].size() == 21 and soa_struct.name[999].size() == 24;
+
+	// Sort by 2 keys with sort_permutation + permute: key ascending, then weight descending.
+	soa::Permutation permutation(soa_struct.key.size());
+	std::iota(permutation.begin(), permutation.end(), SoaVectorSizeType(0));
+	std::ranges::sort(permutation, [&](SoaVectorSizeType p_a, SoaVectorSizeType p_b) {
+		return std::tuple(soa_struct.key[p_a], -soa_struct.weight[p_a]) < std::tuple(soa_struct.key[p_b], -soa_struct.weight[p_b]);
+	});
+	soa_struct.permute(permutation);
+	for (SoaVectorSizeType i = 1; i < 1000; ++i) {
+		passed &= soa_struct.key[i - 1] < soa_struct.key[i] or (soa_struct.key[i - 1] == soa_struct.key[i] and soa_struct.weight[i - 1] > soa_struct.weight[i]);
+	}
+	// An order that misses a row or repeats one is rejected before any column is touched.
+	const std::vector<int> keys_before(soa_struct.key.begin(), soa_struct.key.end());
+	for (soa::Permutation bad_permutation : { soa::Permutation(permutation.begin(), permutation.end() - 1), permutation }) {
+		bad_permutation.back() = bad_permutation.front();
+		try {
+			soa_struct.permute(bad_permutation);
+			passed = false;
+		} catch (const std::invalid_argument &) {
+		}
+	}
+	passed &= std::ranges::equal(soa_struct.key, keys_before);
+	std::cout << "Sort DynamicSOA sort_by/permute: " << (passed ? "Passed\n" : "Failed.\n");
+
+	SortMutableTestStruct mutable_struct;
+	SortSparseTestStruct sparse_struct;
+	std::vector<soa::SoaHandle> handles;
+	for (int i = 0; i < 100; ++i) {
+		mutable_struct.push_row(100 - i, std::to_string(i));
+		handles.push_back(sparse_struct.push_row(100 - i, std::to_string(i)));
+	}
+	mutable_struct.erase(5);
+	sparse_struct.erase(handles[5]);
+	mutable_struct.sort_by(&SortMutableTestStruct::key);
+	sparse_struct.sort_by(&SortSparseTestStruct::key);
+
+	// Entity ids and handles still point at the same row after it moved.
+	passed = mutable_struct.key[0] == 1 and sparse_struct.key[0] == 1;
+	for (int i = 0; i < 100; ++i) {
+		if (i != 5) {
+			passed &= mutable_struct.get_name(SoaVectorSizeType(i)) == std::to_string(i) and sparse_struct.get_name(handles[i]) == std::to_string(i);
+			passed &= mutable_struct.get_key(SoaVectorSizeType(i)) == 100 - i and sparse_struct.get_key(handles[i]) == 100 - i;
+		}
+	}
+	std::cout << "Sort Mutable/Sparse keeps ids: " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -0,0 +1,5 @@
+// The only translation unit of the test binary with SOA_ENABLE_STATS, every other test uses the default struct layout without the stats members.
+#define SOA_ENABLE_STATS
+#include "stats_test.hpp"
+
+void run_stats_test() { stats_test(); }
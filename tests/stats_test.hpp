@@ -0,0 +1,145 @@
+#pragma once
+
+// Only included by stats_test.cpp, the rest of the tests check the structs without SOA_ENABLE_STATS.
+#ifndef SOA_ENABLE_STATS
+#error "stats_test.hpp needs SOA_ENABLE_STATS defined before soa.hpp is included"
+#endif
+
+#include "../src/soa.hpp"
+#include "test_types.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct StatsTestStruct {
+	using soa_growth_policy = soa::PowerOfTwoGrowth<8>;
+	DynamicSOA(
+		StatsTestStruct, 2,
+		int, a,
+		double, b
+	)
+};
+
+struct StatsMutableTestStruct {
+	MutableSOA(
+		StatsMutableTestStruct, 2,
+		int, a,
+		std::string, b
+	)
+};
+
+struct StatsSparseTestStruct {
+	SparseSOA(
+		StatsSparseTestStruct, 1,
+		int, a
+	)
+};
+
+struct StatsReserveTestStruct {
+	using soa_allocator_policy = soa::VirtualReserveAllocator<1 << 16>;
+	DynamicSOA(
+		StatsReserveTestStruct, 2,
+		int, a,
+		Vector2, b
+	)
+};
+
+struct StatsFixedTestStruct {
+	FixedSizeSOA(
+		StatsFixedTestStruct, 2,
+		char, a,
+		double, b
+	)
+};
+
+struct StatsTiledTestStruct {
+	TiledSOA(
+		StatsTiledTestStruct, 2, 16,
+		int, a,
+		float, b
+	)
+};
+
+inline void stats_test() {
+	StatsTestStruct soa_struct;
+	std::vector<soa::GrowthEvent> events;
+	soa_struct.set_growth_hook([&](const soa::GrowthEvent &p_event) { events.push_back(p_event); });
+	for (int i = 0; i < 1000; ++i) {
+		soa_struct.push_row(i, i * 0.5);
+	}
+	soa::SoaStats stats = soa_struct.stats();
+	// 8, 16, ... 1024 rows, every realloc moves the rows pushed before it.
+	bool passed = stats.realloc_calls == 8 and events.size() == 8 and stats.init_calls == 0 and stats.bytes_moved == 1016 * (sizeof(int) + sizeof(double));
+	passed &= stats.bytes_allocated >= 2040 * (sizeof(int) + sizeof(double)) and stats.capacity == 1024 and stats.size == 1000 and stats.peak_capacity == 1024;
+	passed &= std::string(events[3].table) == "StatsTestStruct" and events[3].old_capacity == 32 and events[3].new_capacity == 64 and events[3].size == 32;
+	soa_struct.shrink_to_fit();
+	stats = soa_struct.stats();
+	passed &= stats.realloc_calls == 9 and stats.capacity == 1000 and stats.peak_capacity == 1024 and events.back().new_capacity == 1000;
+	const soa::MemoryReport report = soa_struct.memory_report();
+	passed &= report.columns.size() == 2 and std::string(report.columns[1].name) == "double b" and report.columns[1].used_bytes() == 8000;
+	passed &= report.used_bytes() == 12000 and report.wasted_bytes() == 0 and report.block_bytes >= 12000 and report.index_bytes == 0;
+	soa_struct.reset_stats();
+	soa_struct.init(2000);
+	stats = soa_struct.stats();
+	passed &= stats.init_calls == 1 and stats.realloc_calls == 1 and stats.bytes_moved == 12000 and stats.peak_size == 1000;
+	std::cout << "Stats DynamicSOA growth: " << (passed ? "Passed\n" : "Failed.\n");
+
+	StatsMutableTestStruct mutable_struct;
+	std::vector<SoaVectorSizeType> ids;
+	for (int i = 0; i < 500; ++i) {
+		ids.push_back(mutable_struct.push_row(i, std::to_string(i)));
+	}
+	for (int i = 0; i < 10; ++i) {
+		mutable_struct.erase(ids[i]);
+	}
+	// Erasing an id that is gone doesn't count.
+	mutable_struct.erase(ids[0]);
+	mutable_struct.erase_batch(std::vector<SoaVectorSizeType>(ids.begin() + 10, ids.begin() + 15));
+	stats = mutable_struct.stats();
+	passed = stats.erase_calls == 11 and stats.erased_rows == 15 and stats.size == 485 and stats.peak_size == 500;
+	passed &= stats.index_probes.entries == 485 and stats.index_probes.max_probe_length < 16 and stats.index_probes.mean() < 1;
+	passed &= mutable_struct.memory_report().index_bytes >= 485 * 2 * sizeof(SoaVectorSizeType);
+
+	StatsSparseTestStruct sparse_struct;
+	std::vector<soa::SoaHandle> handles;
+	for (int i = 0; i < 100; ++i) {
+		handles.push_back(sparse_struct.push_row(i));
+	}
+	sparse_struct.erase(handles[5]);
+	sparse_struct.erase(handles[5]);
+	stats = sparse_struct.stats();
+	passed &= stats.erase_calls == 1 and stats.erased_rows == 1 and stats.index_probes.entries == 0 and sparse_struct.memory_report().index_bytes != 0;
+	std::cout << "Stats MutableSOA/SparseSOA erase: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// Committing more rows of the reservation allocates without moving anything.
+	StatsReserveTestStruct reserve_struct;
+	for (int i = 0; i < 10000; ++i) {
+		reserve_struct.push_row(i, Vector2{ float(i), 0 });
+	}
+	stats = reserve_struct.stats();
+	passed = stats.realloc_calls > 1 and stats.bytes_moved == 0 and stats.bytes_allocated == uint64_t(stats.capacity) * (sizeof(int) + sizeof(Vector2));
+	passed &= reserve_struct.memory_report().block_bytes >= (1 << 16) * (sizeof(int) + sizeof(Vector2));
+
+	StatsFixedTestStruct fixed_struct;
+	fixed_struct.init(64);
+	stats = fixed_struct.stats();
+	passed &= stats.init_calls == 1 and stats.realloc_calls == 1 and stats.capacity == 64 and fixed_struct.memory_report().used_bytes() == 64 * 9;
+
+	StatsTiledTestStruct tiled_struct;
+	for (int i = 0; i < 100; ++i) {
+		tiled_struct.push_row(i, float(i));
+	}
+	tiled_struct.push_a(100);
+	StatsTiledTestStruct moved_tiled = std::move(tiled_struct);
+	stats = moved_tiled.stats();
+	const soa::MemoryReport tiled_report = moved_tiled.memory_report();
+	passed &= stats.realloc_calls != 0 and stats.capacity % 16 == 0 and tiled_report.columns[0].size == 101 and tiled_report.columns[1].size == 100;
+	passed &= tiled_report.block_bytes == uint64_t(stats.capacity) * (sizeof(int) + sizeof(float)) and tiled_struct.stats().realloc_calls == 0;
+	std::ostringstream printed;
+	tiled_report.print(printed);
+	passed &= printed.str().find("int a: 101 / ") == 0;
+	std::cout << "Stats reserved, fixed and tiled: " << (passed ? "Passed\n" : "Failed.\n");
+}
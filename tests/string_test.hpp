@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct StringTestStruct {
+	using soa_dirty_policy = soa::TrackDirty<>;
+	DynamicSOA(
+		StringTestStruct, 3,
+		int, a,
+		soa::ArenaString, name,
+		soa::DictString, tag
+	)
+};
+
+struct StringMutableTestStruct {
+	MutableSOA(
+		StringMutableTestStruct, 2,
+		int, a,
+		soa::ArenaString, name
+	)
+};
+
+struct StringFixedTestStruct {
+	FixedSizeSOA(
+		StringFixedTestStruct, 2,
+		soa::ArenaString, name,
+		soa::DictString, tag
+	)
+};
+
+inline const char *string_test_tag(int p_index) {
+	static const char *const tags[] = { "idle", "moving", "attacking" };
+	return tags[p_index % 3];
+}
+
+inline void string_test() {
+	using soa::simd::Compare;
+
+	StringTestStruct soa_struct;
+	for (int i = 0; i < 1000; ++i) {
+		soa_struct.push_row(i, "unit_" + std::to_string(i), string_test_tag(i));
+	}
+	bool passed = soa_struct.name.size() == 1000 and soa_struct.get_name(123) == "unit_123" and soa_struct.get_tag(5) == "attacking" and soa_struct.tag.dictionary_size() == 4;
+	// Shorter strings are written over the old characters, longer ones are appended. A row can be set to another row of the same column.
+	soa_struct.set_name(7, "x");
+	soa_struct.set_name(8, "a much longer name than before");
+	soa_struct.name[9] = soa_struct.name[8];
+	soa_struct.tag[10] = "dead";
+	passed &= soa_struct.get_name(7) == "x" and soa_struct.name[8] == "a much longer name than before" and soa_struct.get_name(9) == soa_struct.get_name(8);
+	passed &= soa_struct.get_name(10) == "unit_10" and soa_struct.get_tag(10) == "dead" and soa_struct.tag.dictionary_size() == 5 and soa_struct.name.garbage_bytes() == 17;
+	passed &= soa_struct.name.find("unit_500") == 500 and soa_struct.name.count_equal("unit_999") == 1 and !soa_struct.name.has("unit_1000");
+	passed &= soa_struct.tag.count_equal("moving") == 332 and soa_struct.tag.find("idle", 1) == 3 and soa_struct.tag.find("missing") == soa::SoaVector<uint8_t>::NOT_FOUND;
+	passed &= soa_struct.memory_report().columns[1].used_bytes() == 8000 and soa_struct.memory_report().columns[2].used_bytes() == 4000;
+	std::cout << "String push/get/set/find: " << (passed ? "Passed\n" : "Failed.\n");
+
+	const soa::Selection<StringTestStruct> moving = soa_struct.where(&StringTestStruct::tag, Compare::Equal, "moving");
+	passed = moving.size() == 332 and moving.indices()[0] == 1 and soa_struct.where(&StringTestStruct::tag, Compare::NotEqual, "moving").size() == 668;
+	passed &= soa_struct.where(&StringTestStruct::name, Compare::Equal, "x").size() == 1 and soa_struct.where(&StringTestStruct::name, Compare::Less, "unit_2").size() == 114;
+	const auto [moving_names, moving_a] = moving.select(&StringTestStruct::name, &StringTestStruct::a);
+	passed &= moving_names.size() == 332 and moving_names[1] == "unit_4" and moving_a[1] == 4;
+	std::cout << "String where/select: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// rows() hands out the same proxies as x[i]. Sorting permutes the slots and codes, the characters stay where they are.
+	for (auto [a, name, tag] : soa_struct.rows()) {
+		if (a % 100 == 0) {
+			tag = "hundred";
+		}
+	}
+	soa_struct.sort_by(&StringTestStruct::name);
+	passed = soa_struct.tag.count_equal("hundred") == 10 and soa_struct.get_name(0) == "a much longer name than before" and soa_struct.get_name(1) == soa_struct.get_name(0);
+	passed &= soa_struct.get_name(2) == "unit_0" and soa_struct.get_name(999) == "x" and std::ranges::is_sorted(soa_struct.name) and soa_struct.get_tag(999) == "moving";
+	std::stringstream stream;
+	soa_struct.save(stream);
+	StringTestStruct loaded;
+	loaded.load(stream);
+	passed &= std::ranges::equal(loaded.name, soa_struct.name) and std::ranges::equal(loaded.tag, soa_struct.tag) and loaded.name.garbage_bytes() == 0;
+	passed &= loaded.tag.dictionary_size() == 6 and loaded.tag.count_equal("dead") == 1;
+	loaded.clear_dirty();
+	soa_struct.clear_dirty();
+	soa_struct.set_name(500, "renamed");
+	soa_struct.set_tag(501, "new tag");
+	soa_struct.push_row(1000, "unit_1000", "idle");
+	std::stringstream delta;
+	soa_struct.export_delta(delta);
+	loaded.apply_delta(delta);
+	passed &= std::ranges::equal(loaded.name, soa_struct.name) and std::ranges::equal(loaded.tag, soa_struct.tag) and loaded.name.size() == 1001;
+	std::cout << "String sort/save/load/delta: " << (passed ? "Passed\n" : "Failed.\n");
+
+	// Erasing leaves the characters in the arena until they are more than half of it.
+	StringMutableTestStruct mutable_struct;
+	std::vector<SoaVectorSizeType> ids;
+	for (int i = 0; i < 1000; ++i) {
+		ids.push_back(mutable_struct.push_row(i, "name_" + std::to_string(1000 + i)));
+	}
+	for (int i = 0; i < 400; ++i) {
+		mutable_struct.erase(ids[i]);
+	}
+	passed = mutable_struct.name.size() == 600 and mutable_struct.name.arena_bytes() == 9000 and mutable_struct.name.garbage_bytes() == 3600;
+	passed &= mutable_struct.get_name(ids[999]) == "name_1999" and mutable_struct.get_name(ids[400]) == "name_1400";
+	mutable_struct.erase_batch(std::vector<SoaVectorSizeType>(ids.begin() + 400, ids.begin() + 510));
+	passed &= mutable_struct.name.size() == 490 and mutable_struct.name.arena_bytes() == 4410 and mutable_struct.name.garbage_bytes() == 0;
+	for (int i = 510; i < 1000; ++i) {
+		passed &= mutable_struct.get_name(ids[i]) == "name_" + std::to_string(1000 + i) and mutable_struct.get_a(ids[i]) == i;
+	}
+
+	// FixedSizeSOA zeroes the slots and codes so every row starts empty.
+	StringFixedTestStruct fixed_struct;
+	fixed_struct.init(100);
+	passed &= fixed_struct.name.count_equal("") == 100 and fixed_struct.tag.count_equal("") == 100 and fixed_struct.name.arena_bytes() == 0;
+	fixed_struct.set_name(17, "seventeen");
+	fixed_struct.set_tag(17, "odd");
+	passed &= fixed_struct.get_name(17) == "seventeen" and fixed_struct.get_tag(17) == "odd" and fixed_struct.get_tag(16).empty() and fixed_struct.tag.row_codes()[17] == 1;
+	std::cout << "String MutableSOA erase and FixedSizeSOA: " << (passed ? "Passed\n" : "Failed.\n");
+}
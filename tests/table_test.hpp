@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../src/soa.hpp"
+#include "test_types.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+struct TableTestRow {
+	int a;
+	std::string b;
+	Vector2 c;
+	double d;
+};
+
+struct TableTestColumns : soa::Columns<int, double, std::string> {
+	using soa_growth_policy = soa::FixedChunkGrowth<100>;
+	using soa_allocator_policy = soa::PoolAllocator<>;
+};
+
+struct alignas(128) TableTestAlignedValue {
+	int value;
+};
+
+struct TableTestAligned {
+	char a;
+	TableTestAlignedValue b;
+	short c;
+};
+
+inline void table_test() {
+	soa::Table<TableTestRow> table;
+	static_assert(soa::Table<TableTestRow>::column_count == 4 and std::is_same_v<soa::Table<TableTestRow>::column_type<2>, Vector2>);
+	static_assert(soa::Table<TableTestRow>::row_offsets[2] == sizeof(int) + sizeof(std::string));
+	for (int i = 0; i < 1000; ++i) {
+		table.push_row(TableTestRow{ i, std::to_string(i), Vector2{ float(i), 1 }, i * 0.5 });
+	}
+	table.emplace_row(1000, "1000", Vector2{ 1000, 1 }, 500.0);
+	table.set<1>(3, "three");
+	bool passed = table.size() == 1001 and table.get<0>(1000) == 1000 and table.get<1>(3) == "three" and table.get<2>(999).x == 999.0f;
+	passed &= table.capacity() % soa::Table<TableTestRow>::capacity_step == 0 and uint64_t(table.column<3>().ptr()) % SOA_COLUMN_ALIGNMENT == 0;
+	// A field picks the same column as its index.
+	static_assert(soa::detail::field_index<&TableTestRow::a>() == 0 and soa::detail::field_index<&TableTestRow::c>() == 2);
+	table.set<&TableTestRow::d>(4, -1.0);
+	passed &= table.get<&TableTestRow::b>(3) == "three" and table.get<3>(4) == -1.0 and &table.column<&TableTestRow::c>() == &table.column<2>();
+	const TableTestRow row = table.get_row(500);
+	passed &= row.a == 500 and row.b == "500" and row.d == 250.0;
+	// Erase moves the last row into the erased one.
+	table.erase(0);
+	passed &= table.size() == 1000 and table.get<0>(0) == 1000 and table.get<1>(0) == "1000" and table.column<0>().find(999) == 999;
+	try {
+		table.erase(1000);
+		passed = false;
+	} catch (const std::out_of_range &) {
+	}
+	table.shrink_to_fit();
+	passed &= table.capacity() == 1024 and table.get<1>(999) == "999";
+	soa::Table<TableTestRow> moved = std::move(table);
+	passed &= moved.size() == 1000 and table.size() == 0 and table.capacity() == 0;
+	std::cout << "soa::Table aggregate schema: " << (passed ? "Passed\n" : "Failed.\n");
+
+	soa::Table<TableTestColumns> column_table;
+	for (int i = 0; i < 150; ++i) {
+		column_table.push_row(i, i * 2.0, std::to_string(i));
+	}
+	const std::tuple<int, double, std::string> column_row = column_table.get_row(149);
+	passed = std::get<0>(column_row) == 149 and std::get<2>(column_row) == "149" and column_table.capacity() == 256;
+	column_table.push<0>(150);
+	column_table.push<1>(300.0);
+	column_table.push<2>("150");
+	passed &= column_table.size() == 151 and column_table.get<1>(150) == 300.0;
+	column_table.clear();
+	passed &= column_table.size() == 0 and column_table.capacity() == 0;
+
+	soa::Table<TableTestAligned> aligned_table;
+	for (int i = 0; i < 200; ++i) {
+		aligned_table.push_row(TableTestAligned{ char(i), TableTestAlignedValue{ i }, short(i) });
+	}
+	passed &= uint64_t(aligned_table.column<1>().ptr()) % 128 == 0 and uint64_t(aligned_table.column<2>().ptr()) % SOA_COLUMN_ALIGNMENT == 0;
+	passed &= aligned_table.get<1>(199).value == 199 and aligned_table.get<2>(150) == 150;
+	std::cout << "soa::Table column list schema: " << (passed ? "Passed\n" : "Failed.\n");
+}
@@ -1,6 +1,23 @@
 #include "../src/soa.hpp"
-#include "AoSvsSoA_test.hpp"
+#include "allocator_test.hpp"
+#include "buffered_test.hpp"
+#include "concurrent_append_test.hpp"
+#include "dirty_test.hpp"
+#include "erase_test.hpp"
+#include "index_map_test.hpp"
+#include "mapped_test.hpp"
+#include "packed_test.hpp"
+#include "parallel_test.hpp"
+#include "query_test.hpp"
 #include "ranges_test.hpp"
+#include "reserve_test.hpp"
+#include "rows_test.hpp"
+#include "serialize_test.hpp"
+#include "simd_test.hpp"
+#include "sort_test.hpp"
+#include "string_test.hpp"
+#include "table_test.hpp"
+#include "tiled_test.hpp"
 
 #include <algorithm>
 #include <iostream>
@@ -18,16 +35,21 @@ public:
 	void init(SoaVectorSizeType p_size) {
 		uint64_t total_size = 0;
 		int mem_offset_idx = 0;
+		uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;
 		uint64_t memory_offsets[2];
 
+		total_size = soa::align_up(total_size, soa::column_alignment<int>());
+		block_alignment = std::max(block_alignment, soa::column_alignment<int>());
 		memory_offsets[mem_offset_idx] = total_size;
 		total_size += sizeof(int) * p_size;
 		mem_offset_idx++;
 
+		total_size = soa::align_up(total_size, soa::column_alignment<std::string>());
+		block_alignment = std::max(block_alignment, soa::column_alignment<std::string>());
 		memory_offsets[mem_offset_idx] = total_size;
 		total_size += sizeof(std::string) * p_size;
 
-		data = calloc(p_size, total_size / p_size);
+		data = soa::aligned_calloc(block_alignment, total_size);
 		x.init_fixed(data, p_size, memory_offsets[0]);
 		y.init_fixed(data, p_size, memory_offsets[1]);
 
@@ -68,6 +90,19 @@ struct FixedSOAMacroTestStruct {
 	)
 };
 
+// SOA_ENABLE_STATS is only defined in stats_test.cpp, without it the macros add no stats members or functions. FixedSOAMacroTestStruct is the members of FixedTestStruct plus
+// the allocation size and alignment of its block and a dirty mask per column.
+template <typename T>
+concept HasSoaStats = requires(T &p_soa) {
+	p_soa.stats();
+	p_soa.reset_stats();
+};
+static_assert(sizeof(FixedSOAMacroTestStruct) == sizeof(FixedTestStruct) + 2 * sizeof(uint64_t) + 2 * sizeof(soa::DirtyMask));
+static_assert(!HasSoaStats<FixedSOAMacroTestStruct>);
+
+// Defined in stats_test.cpp.
+void run_stats_test();
+
 struct TestVecStruct {
 	DynamicSOA(
 		TestVecStruct, 4,
@@ -78,6 +113,16 @@ struct TestVecStruct {
 	)
 };
 
+struct PowerOfTwoTestStruct {
+	using soa_growth_policy = soa::PowerOfTwoGrowth<>;
+
+	DynamicSOA(
+		PowerOfTwoTestStruct, 2,
+		int, x,
+		std::string, y
+	)
+};
+
 struct DynamicTestStruct {
 	soa::SoaVector<int> x;
 	soa::SoaVector<std::string> y;
@@ -85,50 +130,37 @@ struct DynamicTestStruct {
 private:
 	SoaVectorSizeType soa_capacity = 0;
 	void *data{};
-	void soa_realloc() {
-		const SoaVectorSizeType starting_capacity = soa_capacity;
-		soa_capacity = static_cast<SoaVectorSizeType>(soa_capacity * 1.5);
-		const SoaVectorSizeType p_size = soa_capacity;
-
+	void soa_realloc(const SoaVectorSizeType p_size) {
 		uint64_t total_size = 0;
 		int mem_offset_idx = 0;
+		uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;
 		uint64_t memory_offsets[2];
 
+		total_size = soa::align_up(total_size, soa::column_alignment<int>());
+		block_alignment = std::max(block_alignment, soa::column_alignment<int>());
 		memory_offsets[mem_offset_idx] = total_size;
 		total_size += sizeof(int) * p_size;
 		mem_offset_idx++;
 
+		total_size = soa::align_up(total_size, soa::column_alignment<std::string>());
+		block_alignment = std::max(block_alignment, soa::column_alignment<std::string>());
 		memory_offsets[mem_offset_idx] = total_size;
 		total_size += sizeof(std::string) * p_size;
-		void *new_data = calloc(soa_capacity, total_size / p_size);
+		void *new_data = soa::aligned_malloc(block_alignment, total_size);
 
 		int current_column = 0;
-		x.soa_realloc(new_data, memory_offsets[current_column], starting_capacity);
+		x.soa_realloc(new_data, memory_offsets[current_column]);
 		current_column++;
-		y.soa_realloc(new_data, memory_offsets[current_column], starting_capacity);
+		y.soa_realloc(new_data, memory_offsets[current_column]);
 
 		free(data);
 		data = new_data;
+		soa_capacity = p_size;
 	}
+	void soa_grow() { soa_realloc(soa::growth_policy_of<DynamicTestStruct>::type::grow(soa_capacity, soa_capacity + 1)); }
 
 public:
-	void init(int p_size) {
-		uint64_t total_size = 0;
-		int mem_offset_idx = 0;
-		uint64_t memory_offsets[2];
-
-		memory_offsets[mem_offset_idx] = total_size;
-		total_size += sizeof(int) * p_size;
-		mem_offset_idx++;
-
-		memory_offsets[mem_offset_idx] = total_size;
-		total_size += sizeof(std::string) * p_size;
-
-		data = calloc(p_size, total_size / p_size);
-		soa_capacity = p_size;
-		x.init(data, p_size, memory_offsets[0]);
-		y.init(data, p_size, memory_offsets[1]);
-	}
+	void init(const SoaVectorSizeType p_size) { soa_realloc(p_size); }
 
 	void set_x(int p_index, const int &p_item) { x[p_index] = p_item; }
 	[[nodiscard]] int get_x(int p_index) { return x[p_index]; }
@@ -153,14 +185,14 @@ public:
 
 	void push_x(const int &p_elem) {
 		if (x.size() == soa_capacity) {
-			[[unlikely]] soa_realloc();
+			[[unlikely]] soa_grow();
 		}
 		x.push_soa_member(p_elem);
 	}
 
 	void push_y(const std::string &p_elem) {
 		if (y.size() == soa_capacity) {
-			[[unlikely]] soa_realloc();
+			[[unlikely]] soa_grow();
 		}
 		y.push_soa_member(p_elem);
 	}
@@ -183,50 +215,37 @@ private:
 	SoaVectorSizeType soa_capacity = 0;
 	SoaVectorSizeType soa_size = 0;
 	void *data{};
-	void soa_realloc() {
-		const SoaVectorSizeType starting_capacity = soa_capacity;
-		soa_capacity = static_cast<SoaVectorSizeType>(soa_capacity * 1.5);
-		const SoaVectorSizeType p_size = soa_capacity;
-
+	void soa_realloc(const SoaVectorSizeType p_size) {
 		uint64_t total_size = 0;
 		int mem_offset_idx = 0;
+		uint64_t block_alignment = SOA_COLUMN_ALIGNMENT;
 		uint64_t memory_offsets[2];
 
+		total_size = soa::align_up(total_size, soa::column_alignment<int>());
+		block_alignment = std::max(block_alignment, soa::column_alignment<int>());
 		memory_offsets[mem_offset_idx] = total_size;
 		total_size += sizeof(int) * p_size;
 		mem_offset_idx++;
 
+		total_size = soa::align_up(total_size, soa::column_alignment<std::string>());
+		block_alignment = std::max(block_alignment, soa::column_alignment<std::string>());
 		memory_offsets[mem_offset_idx] = total_size;
 		total_size += sizeof(std::string) * p_size;
-		void *new_data = calloc(soa_capacity, total_size / p_size);
+		void *new_data = soa::aligned_malloc(block_alignment, total_size);
 
 		int current_column = 0;
-		x.soa_realloc(new_data, memory_offsets[current_column], starting_capacity);
+		x.soa_realloc(new_data, memory_offsets[current_column]);
 		current_column++;
-		y.soa_realloc(new_data, memory_offsets[current_column], starting_capacity);
+		y.soa_realloc(new_data, memory_offsets[current_column]);
 
 		free(data);
 		data = new_data;
+		soa_capacity = p_size;
 	}
+	void soa_grow() { soa_realloc(soa::growth_policy_of<MutableTestStruct>::type::grow(soa_capacity, soa_capacity + 1)); }
 
 public:
-	void init(int p_size) {
-		uint64_t total_size = 0;
-		int mem_offset_idx = 0;
-		uint64_t memory_offsets[2];
-
-		memory_offsets[mem_offset_idx] = total_size;
-		total_size += sizeof(int) * p_size;
-		mem_offset_idx++;
-
-		memory_offsets[mem_offset_idx] = total_size;
-		total_size += sizeof(std::string) * p_size;
-
-		data = calloc(p_size, total_size / p_size);
-		soa_capacity = p_size;
-		x.init(data, p_size, memory_offsets[0]);
-		y.init(data, p_size, memory_offsets[1]);
-	}
+	void init(const SoaVectorSizeType p_size) { soa_realloc(p_size); }
 
 	// NOTE: This does not work like the std::vector::erase. It moved the last element in the vector to the removed spot instead of shifting everything down.
 	// This makes erase of SoaVector O(1) instead of O(N) like std::vector.
@@ -296,7 +315,7 @@ public:
 
 	void push_x(const int &p_elem) {
 		if (x.size() == soa_capacity) {
-			[[unlikely]] soa_realloc();
+			[[unlikely]] soa_grow();
 		}
 		SoaVectorSizeType new_index = x.push_soa_member(p_elem) - 1;
 		soa_size = std::max(soa_size, new_index + 1);
@@ -305,7 +324,7 @@ public:
 
 	void push_y(const std::string &p_elem) {
 		if (y.size() == soa_capacity) {
-			[[unlikely]] soa_realloc();
+			[[unlikely]] soa_grow();
 		}
 
 		SoaVectorSizeType new_index = y.push_soa_member(p_elem) - 1;
@@ -322,6 +341,14 @@ struct MutableTestStructMacro {
 	)
 };
 
+struct SparseTestStructMacro {
+	SparseSOA(
+		SparseTestStructMacro, 2,
+		int, x,
+		std::string, y
+	)
+};
+
 void test_fixed_sized_macro() {
 	FixedTestStruct test;
 	test.init(2);
@@ -404,7 +431,32 @@ void test_dynamic_sized_macro() {
 	vec_test.push_x(9);
 	vec_test.set_x(0, 999);
 
-	std::cout << "DynamicSizeSOA with vector: " << ((vec_test.get_a(0).at(1) == 5) ? "Passed\n\n" : "Failed.\n\n");
+	std::cout << "DynamicSizeSOA with vector: " << ((vec_test.get_a(0).at(1) == 5) ? "Passed\n" : "Failed.\n");
+
+	DynamicSOAMacroTestStruct row_test;
+	row_test.init(2);
+	for (int i = 0; i < 5; ++i) {
+		row_test.push_row(i, std::to_string(i));
+	}
+	row_test.emplace_row(5, "aaa");
+
+	const bool columns_aligned = reinterpret_cast<uintptr_t>(row_test.x.ptr()) % SOA_COLUMN_ALIGNMENT == 0 and reinterpret_cast<uintptr_t>(row_test.y.ptr()) % SOA_COLUMN_ALIGNMENT == 0;
+	std::cout << "DynamicSizeSOA column alignment: " << (columns_aligned ? "Passed\n" : "Failed.\n");
+	PowerOfTwoTestStruct growth_test;
+	growth_test.init(0);
+	for (int i = 0; i < 9; ++i) {
+		growth_test.push_row(i, std::to_string(i));
+	}
+	const bool grew_to_power_of_two = growth_test.capacity() == 16;
+	growth_test.reserve(100);
+	const bool reserved = growth_test.capacity() == 100 and growth_test.get_y(8) == "8";
+	growth_test.shrink_to_fit();
+	const bool shrunk = growth_test.capacity() == 9 and growth_test.get_x(8) == 8 and growth_test.get_y(3) == "3";
+	std::cout << "DynamicSizeSOA reserve/shrink_to_fit/growth policy: " << ((grew_to_power_of_two and reserved and shrunk) ? "Passed\n" : "Failed.\n");
+
+	std::cout << "DynamicSizeSOA push_row: "
+			  << ((row_test.x.size() == 6 and row_test.y.size() == 6 and row_test.get_x(4) == 4 and row_test.get_y(4) == "4" and row_test.get_y(5) == "aaa") ? "Passed\n\n"
+																																	 : "Failed.\n\n");
 }
 
 void test_mutable_macro() {
@@ -451,13 +503,85 @@ void test_mutable_macro() {
 	mutable_macro_test.erase(2);
 
 	std::cout << "MutableSOA equality test: " << ((mutable_test.get_x(5) == 888 and mutable_macro_test.get_x(5) == 888) ? "Passed\n" : "Failed.\n");
+
+	MutableTestStructMacro mutable_row_test;
+	mutable_row_test.init(2);
+	for (int i = 0; i < 5; ++i) {
+		mutable_row_test.push_row(i, std::to_string(i));
+	}
+	const SoaVectorSizeType emplaced_id = mutable_row_test.emplace_row(5, "5");
+	mutable_row_test.erase(1);
+
+	std::cout << "MutableSOA push_row: "
+			  << ((mutable_row_test.x.size() == 5 and mutable_row_test.y.size() == 5 and mutable_row_test.get_x(emplaced_id) == 5 and mutable_row_test.get_y(4) == "4")
+								 ? "Passed\n"
+								 : "Failed.\n");
+}
+
+void test_sparse_macro() {
+	SparseTestStructMacro sparse_test;
+	sparse_test.init(2);
+
+	soa::SoaHandle handles[5];
+	for (int i = 0; i < 5; ++i) {
+		handles[i] = sparse_test.push_row(i, std::to_string(i));
+	}
+
+	sparse_test.erase(handles[1]);
+	sparse_test.erase(handles[1]); // stale handle, does nothing
+	const soa::SoaHandle reused = sparse_test.push_row(10, "10");
+
+	bool stale_detected = false;
+	try {
+		(void)sparse_test.get_x(handles[1]);
+	} catch (const std::out_of_range &) {
+		stale_detected = true;
+	}
+
+	std::cout << "SparseSOA size test: " << ((sparse_test.x.size() == 5 and sparse_test.y.size() == 5) ? "Passed\n" : "Failed.\n");
+	const bool get_after_erase = sparse_test.get_x(handles[4]) == 4 and sparse_test.get_y(handles[4]) == "4" and sparse_test.get_x(reused) == 10;
+	std::cout << "SparseSOA get after erase: " << (get_after_erase ? "Passed\n" : "Failed.\n");
+	std::cout << "SparseSOA stale handle: " << ((reused.index == handles[1].index and !sparse_test.contains(handles[1]) and stale_detected) ? "Passed\n" : "Failed.\n");
+
+	// A free slot already has the generation of the handle it will hand out next, a handle guessing it must not reach the free list link.
+	sparse_test.erase(handles[0]);
+	const soa::SoaHandle free_slot_handle = { handles[0].index, handles[0].generation + 1 };
+	sparse_test.erase(free_slot_handle);
+	bool free_slot_detected = false;
+	try {
+		(void)sparse_test.get_x(free_slot_handle);
+	} catch (const std::out_of_range &) {
+		free_slot_detected = true;
+	}
+	const bool free_slot_passed = !sparse_test.contains(free_slot_handle) and free_slot_detected and sparse_test.x.size() == 4 and sparse_test.get_x(handles[4]) == 4;
+	std::cout << "SparseSOA handle to a free slot: " << ((free_slot_passed and sparse_test.push_row(20, "20") == free_slot_handle) ? "Passed\n\n" : "Failed.\n\n");
 }
 
 int main() {
 	test_fixed_sized_macro();
 	test_dynamic_sized_macro();
 	test_mutable_macro();
-	soa_perf_test();
+	test_sparse_macro();
+	index_map_test();
+	simd_test();
+	simd_search_test();
+	query_test();
+	parallel_test();
+	tiled_test();
+	rows_test();
+	sort_test();
+	erase_test();
+	mapped_test();
+	serialize_test();
+	dirty_test();
+	buffered_test();
+	concurrent_append_test();
+	allocator_test();
+	reserve_test();
+	table_test();
+	run_stats_test();
+	packed_test();
+	string_test();
 	soa_ranges_test();
 	std::cout << "\nTests finished.";
 	return 0;
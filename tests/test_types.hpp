@@ -0,0 +1,7 @@
+#pragma once
+
+// Small value types the test structs use as members.
+struct Vector2 {
+	float x = 1;
+	float y = 1;
+};
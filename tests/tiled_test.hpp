@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../src/soa.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+struct TiledTestStruct {
+	TiledSOA(
+		TiledTestStruct, 3, 8,
+		int, a,
+		float, b,
+		std::string, c
+	)
+};
+
+inline void tiled_test() {
+	TiledTestStruct soa_struct;
+	soa_struct.init(4);
+	bool passed = soa_struct.capacity() == 8;
+	for (int i = 0; i < 100; ++i) {
+		// Long strings so the non trivially copyable path has to move heap allocations when the tiles are reallocated.
+		soa_struct.push_row(i, float(i) * 2, std::string(32, char('a' + i % 26)));
+	}
+	soa_struct.set_b(50, -1);
+	passed &= soa_struct.size() == 100 and soa_struct.get_a(99) == 99 and soa_struct.get_b(50) == -1 and soa_struct.get_c(27) == std::string(32, 'b');
+
+	uint64_t block_count = 0;
+	int64_t a_sum = 0;
+	SoaVectorSizeType last_count = 0;
+	for (auto block : soa_struct.blocks()) {
+		const int *a = block.a();
+		float *b = block.b();
+		// 8 floats, the column inside each tile starts on a 32 byte boundary.
+		passed &= reinterpret_cast<uintptr_t>(b) % 32 == 0 and a[0] == int(block.first_row);
+		for (SoaVectorSizeType i = 0; i < block.count; ++i) {
+			a_sum += a[i];
+			b[i] += 1;
+		}
+		block_count++;
+		last_count = block.count;
+	}
+	passed &= block_count == 13 and last_count == 4 and a_sum == 4950 and soa_struct.get_b(99) == 199;
+	std::cout << "TiledSOA push_row/get/set/blocks: " << (passed ? "Passed\n" : "Failed.\n");
+
+	TiledTestStruct push_struct;
+	for (int i = 0; i < 20; ++i) {
+		push_struct.push_a(i);
+		push_struct.push_c(std::to_string(i));
+	}
+	push_struct.push_b(0.5f);
+	passed = push_struct.size() == 20 and push_struct.get_c(19) == "19" and push_struct.get_b(0) == 0.5f;
+
+	push_struct.reserve(100);
+	passed &= push_struct.capacity() == 104;
+	push_struct.shrink_to_fit();
+	passed &= push_struct.capacity() == 24 and push_struct.get_c(10) == "10";
+
+	TiledTestStruct moved_struct(std::move(push_struct));
+	passed &= moved_struct.size() == 20 and moved_struct.get_a(19) == 19 and push_struct.size() == 0 and push_struct.capacity() == 0;
+	moved_struct.clear();
+	passed &= moved_struct.size() == 0 and moved_struct.blocks().size() == 0;
+	std::cout << "TiledSOA push_X/reserve/move/clear: " << (passed ? "Passed\n" : "Failed.\n");
+}